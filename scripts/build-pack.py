@@ -0,0 +1,196 @@
+import os
+import struct
+import sys
+
+# Must match source/io/ContentPack.hpp
+MAGIC = 0x4b415043
+VERSION = 1
+ALIGNMENT = 64
+EMPTY_SLOT = 0xffffffff
+COMPRESSION_NONE = 0
+COMPRESSION_LZ4 = 1
+
+HEADER_FORMAT = "<4I4Q"
+ENTRY_FORMAT = "<4Q3I4x"
+
+# Cooked textures are already block compressed and are streamed straight from the pack, so they stay as they are
+UNCOMPRESSED_EXTENSIONS = {".tex"}
+# Compressed entries have to be decompressed into a copy, only worth it when they get this much smaller
+MIN_COMPRESSION_RATIO = 0.9
+
+LZ4_MIN_MATCH = 4
+LZ4_MAX_OFFSET = 65535
+# The block format ends on at least 5 literals, and the last match starts 12 bytes before the end or earlier
+LZ4_LAST_LITERALS = 5
+LZ4_MATCH_LIMIT = 12
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+def hash_path(path):
+    # FNV-1a, see HashContentPackPath
+    value = 0xcbf29ce484222325
+    for byte in path.encode("utf-8"):
+        value ^= byte
+        value = (value * 0x100000001b3) & 0xffffffffffffffff
+    return value
+
+def normalize_path(path):
+    path = path.replace("\\", "/")
+    while path.startswith("./"):
+        path = path[2:]
+    return path
+
+def write_lz4_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+def write_lz4_sequence(out, literals, offset, match_length):
+    literal_length = len(literals)
+    token = min(literal_length, 15) << 4
+    if offset > 0:
+        token |= min(match_length - LZ4_MIN_MATCH, 15)
+
+    out.append(token)
+    if literal_length >= 15:
+        write_lz4_length(out, literal_length - 15)
+    out.extend(literals)
+
+    if offset > 0:
+        out.extend(struct.pack("<H", offset))
+        if match_length - LZ4_MIN_MATCH >= 15:
+            write_lz4_length(out, match_length - LZ4_MIN_MATCH - 15)
+
+def compress_lz4(data):
+    # Greedy matching against the last position every 4 bytes were seen at
+    out = bytearray()
+    table = {}
+    anchor = 0
+    position = 0
+    limit = len(data) - LZ4_MATCH_LIMIT
+
+    while position < limit:
+        key = data[position:position + LZ4_MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = position
+
+        if candidate is None or position - candidate > LZ4_MAX_OFFSET:
+            position += 1
+            continue
+
+        match_length = LZ4_MIN_MATCH
+        max_length = len(data) - LZ4_LAST_LITERALS - position
+        while match_length < max_length and data[candidate + match_length] == data[position + match_length]:
+            match_length += 1
+
+        write_lz4_sequence(out, data[anchor:position], position - candidate, match_length)
+        position += match_length
+        anchor = position
+
+    write_lz4_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+def collect_files(paths, output_path):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            for directory, _, names in os.walk(path):
+                for name in sorted(names):
+                    files.append(os.path.join(directory, name))
+        else:
+            files.append(path)
+
+    # Never pack a previous pack into the new one
+    output = os.path.abspath(output_path)
+    return sorted(set(normalize_path(f) for f in files if os.path.abspath(f) != output))
+
+def build_pack(output_path, paths):
+    files = collect_files(paths, output_path)
+    if not files:
+        print("Error: no files to pack")
+        sys.exit(1)
+
+    # At least half of the slots stay empty, so probes are short and lookups of missing paths end
+    slot_count = 1
+    while slot_count < len(files) * 2:
+        slot_count *= 2
+
+    entries = []
+    path_table = bytearray()
+    for path in files:
+        with open(path, "rb") as f:
+            data = f.read()
+
+        compression = COMPRESSION_NONE
+        stored = data
+        if os.path.splitext(path)[1].lower() not in UNCOMPRESSED_EXTENSIONS and len(data) > LZ4_MATCH_LIMIT:
+            compressed = compress_lz4(data)
+            if len(compressed) <= len(data) * MIN_COMPRESSION_RATIO:
+                compression = COMPRESSION_LZ4
+                stored = compressed
+
+        encoded_path = path.encode("utf-8")
+        entries.append({
+            "path": path,
+            "hash": hash_path(path),
+            "path_offset": len(path_table),
+            "path_length": len(encoded_path),
+            "compression": compression,
+            "data": stored,
+            "original_size": len(data),
+        })
+        path_table.extend(encoded_path + b"\0")
+
+    slots = [EMPTY_SLOT] * slot_count
+    for index, entry in enumerate(entries):
+        slot = entry["hash"] & (slot_count - 1)
+        while slots[slot] != EMPTY_SLOT:
+            slot = (slot + 1) & (slot_count - 1)
+        slots[slot] = index
+
+    entry_offset = align(struct.calcsize(HEADER_FORMAT))
+    slot_offset = entry_offset + len(entries) * struct.calcsize(ENTRY_FORMAT)
+    path_offset = slot_offset + slot_count * 4
+    offset = align(path_offset + len(path_table))
+
+    for entry in entries:
+        entry["offset"] = offset
+        offset = align(offset + len(entry["data"]))
+
+    data = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(entries), slot_count, entry_offset, slot_offset, path_offset, len(path_table)))
+    data.extend(bytes(entry_offset - len(data)))
+
+    for entry in entries:
+        data.extend(struct.pack(ENTRY_FORMAT, entry["hash"], entry["offset"], len(entry["data"]), entry["original_size"],
+                                entry["path_offset"], entry["path_length"], entry["compression"]))
+
+    data.extend(struct.pack(f"<{slot_count}I", *slots))
+    data.extend(path_table)
+
+    for entry in entries:
+        data.extend(bytes(entry["offset"] - len(data)))
+        data.extend(entry["data"])
+
+    output_directory = os.path.dirname(output_path)
+    if output_directory:
+        os.makedirs(output_directory, exist_ok=True)
+
+    with open(output_path, "wb") as f:
+        f.write(data)
+
+    original_size = sum(entry["original_size"] for entry in entries)
+    compressed_count = sum(1 for entry in entries if entry["compression"] == COMPRESSION_LZ4)
+    print(f"{output_path}: {len(entries)} files ({compressed_count} compressed), {original_size} bytes packed into {len(data)}")
+
+def main():
+    if len(sys.argv) < 3:
+        print("Usage: python build-pack.py <output.pack> <file|directory>...")
+        print("Paths are stored as given and are looked up relative to the engine executable, so run this from its directory")
+        sys.exit(1)
+
+    build_pack(sys.argv[1], sys.argv[2:])
+
+if __name__ == "__main__":
+    main()
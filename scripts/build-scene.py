@@ -0,0 +1,111 @@
+import struct
+import sys
+
+# Must match source/SceneFile.hpp
+MAGIC = 0x4e435343
+VERSION = 1
+ALIGNMENT = 16
+NONE = 0xffffffff
+MESH_PATH_LENGTH = 128
+
+SHAPE_BOX = 1
+SHAPE_SPHERE = 2
+
+HEADER_FORMAT = "<6I4Q"
+MESH_FORMAT = f"<{MESH_PATH_LENGTH}s"
+MATERIAL_FORMAT = "<16f"
+OBJECT_FORMAT = "<3f4f3fIIBB2x"
+LIGHT_FORMAT = "<4fI"
+
+CUBE_MESH = 0
+CUBE_MATERIAL = (
+    1.0, 0.5, 0.31, 0.0,
+    1.0, 0.5, 0.31, 0.0,
+    0.5, 0.5, 0.5, 0.0,
+    8.0, 8.0, 8.0, 8.0,
+)
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+def box(position, half_extent, is_dynamic, mesh=NONE, material=NONE):
+    return (*position, 0.0, 0.0, 0.0, 1.0, *half_extent, mesh, material, SHAPE_BOX, 1 if is_dynamic else 0)
+
+def default_scene():
+    objects = [box((0.0, -2.0, 0.0), (100.0, 0.1, 100.0), False)]
+
+    for position in [
+        (0.0, 0.0, 0.0),
+        (1.0, 0.0, 0.0),
+        (0.0, 1.0, 0.0),
+        (0.0, -1.0, 0.0),
+        (0.0, 0.0, 1.0),
+        (0.0, 0.0, -1.0),
+        (0.55, 5.0, 0.0),
+    ]:
+        objects.append(box(position, (0.5, 0.5, 0.5), True, CUBE_MESH, 0))
+
+    lights = [
+        (2.0, 0.2, 2.0, 0.2, CUBE_MESH),
+        (-2.0, 0.2, 2.0, 0.2, CUBE_MESH),
+        (2.0, 0.2, -2.0, 0.2, CUBE_MESH),
+        (-2.0, 0.2, -2.0, 0.2, CUBE_MESH),
+    ]
+
+    return objects, lights
+
+def grid_scene(count):
+    objects, lights = default_scene()
+    objects = objects[:1]
+
+    # Stack cubes in a square grid with a small gap, so they settle without exploding
+    side = max(1, int(count ** (1.0 / 3.0)) + 1)
+    for i in range(count):
+        x = i % side
+        z = (i // side) % side
+        y = i // (side * side)
+        position = ((x - side / 2) * 1.1, y * 1.1 - 1.3, (z - side / 2) * 1.1)
+        objects.append(box(position, (0.5, 0.5, 0.5), True, CUBE_MESH, 0))
+
+    return objects, lights
+
+def write_scene(path, meshes, materials, objects, lights):
+    mesh_offset = align(struct.calcsize(HEADER_FORMAT))
+    material_offset = align(mesh_offset + len(meshes) * struct.calcsize(MESH_FORMAT))
+    object_offset = align(material_offset + len(materials) * struct.calcsize(MATERIAL_FORMAT))
+    light_offset = align(object_offset + len(objects) * struct.calcsize(OBJECT_FORMAT))
+
+    data = bytearray(struct.pack(
+        HEADER_FORMAT,
+        MAGIC, VERSION,
+        len(meshes), len(materials), len(objects), len(lights),
+        mesh_offset, material_offset, object_offset, light_offset
+    ))
+
+    def write_section(offset, records):
+        data.extend(bytes(offset - len(data)))
+        for record in records:
+            data.extend(record)
+
+    write_section(mesh_offset, [struct.pack(MESH_FORMAT, mesh.encode()) for mesh in meshes])
+    write_section(material_offset, [struct.pack(MATERIAL_FORMAT, *material) for material in materials])
+    write_section(object_offset, [struct.pack(OBJECT_FORMAT, *o) for o in objects])
+    write_section(light_offset, [struct.pack(LIGHT_FORMAT, *l) for l in lights])
+
+    with open(path, "wb") as f:
+        f.write(data)
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print("Usage: python build-scene.py <output_file> [cube_count]")
+        sys.exit(1)
+
+    if len(sys.argv) == 3:
+        objects, lights = grid_scene(int(sys.argv[2]))
+    else:
+        objects, lights = default_scene()
+
+    write_scene(sys.argv[1], ["content/1x1.glb"], [CUBE_MATERIAL], objects, lights)
+
+if __name__ == "__main__":
+    main()
@@ -1,3 +1,4 @@
+import itertools
 import os
 import subprocess
 import sys
@@ -5,6 +6,69 @@ import sys
 # Path to the glslc compiler
 GLSLC = "glslc"
 
+# Bit layout of the shader key for every feature define, must match source/graphics/ShaderKey.hpp
+# Shaders opt into a feature with a "// @variant NAME value value ..." line listing the values that are used
+FEATURES = {
+    "POINT_LIGHT_COUNT": (0, 3),
+    "LIGHTING_MODEL": (3, 1),
+    "ALBEDO_TEXTURE": (4, 1),
+}
+
+def parse_variants(input_path):
+    variants = []
+    with open(input_path, "r") as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) >= 3 and parts[0] == "//" and parts[1] == "@variant":
+                name = parts[2]
+                if name not in FEATURES:
+                    print(f"Error: unknown shader feature {name} in {input_path}")
+                    sys.exit(1)
+                variants.append((name, [int(value) for value in parts[3:]]))
+    return variants
+
+def make_key(defines):
+    key = 0
+    for name, value in defines:
+        shift, bits = FEATURES[name]
+        if value >= (1 << bits):
+            print(f"Error: value {value} does not fit shader feature {name}")
+            sys.exit(1)
+        key |= value << shift
+    return key
+
+def compile_variant(input_path, output_dir, filename, defines):
+    key = make_key(defines)
+    suffix = f"{key:04x}"
+    output_path = os.path.join(output_dir, f"{filename}.{suffix}.spv")
+
+    # Ensure output path is deleted first
+    if os.path.exists(output_path):
+        os.remove(output_path)
+
+    define_flags = [f"-D{name}={value}" for name, value in defines]
+    subprocess.run([GLSLC, *define_flags, input_path, "-o", output_path], check=False)
+
+    # Check if output file was created
+    if not os.path.exists(output_path):
+        print("Error: output file was not created")
+        sys.exit(1)
+
+    # Generate variable name such as BASIC_TRIANGLE_FRAG_SHADER_0013
+    variable_name = filename.upper().replace(".", "_") + "_SHADER_" + suffix.upper()
+
+    # Convert the compiled shader to a header file
+    with open(output_path, "rb") as f:
+        spv_data = f.read()
+
+    header_name = f"{filename}.{suffix}.h"
+    with open(os.path.join(output_dir, header_name), "w") as f:
+        f.write("unsigned char " + variable_name + "[] = {\n")
+        f.write(", ".join(f"0x{byte:02x}" for byte in spv_data))
+        f.write("\n};\n")
+
+    return key, variable_name, header_name
+
 def main():
     if len(sys.argv) != 3:
         print("Usage: python compile_shaders.py <shaders_directory> <output_directory>")
@@ -23,32 +87,27 @@ def main():
     for filename in os.listdir(shaders_dir):
         if filename.endswith(".vert") or filename.endswith(".frag"):
             input_path = os.path.join(shaders_dir, filename)
-            output_path = os.path.join(output_dir, filename + ".spv")
-
-            # Ensure output path is deleted first
-            if os.path.exists(output_path):
-                os.remove(output_path)
-
-            subprocess.run([GLSLC, input_path, "-o", output_path], check=False)
-
-            # Check if output file was created
-            if not os.path.exists(output_path):
-                print("Error: output file was not created")
-                sys.exit(1)
+            variants = parse_variants(input_path)
 
-            # Generate variable name such as BASIC_TRIANGLE_SHADER_VERT
-            variable_name = filename.upper().replace(".", "_") + "_SHADER"
+            # Every combination of the declared values gets its own SPIR-V header
+            names = [name for name, _ in variants]
+            compiled = []
+            for values in itertools.product(*[values for _, values in variants]):
+                compiled.append(compile_variant(input_path, output_dir, filename, list(zip(names, values))))
 
-            # Convert the compiled shader to a header file
-            with open(output_path, "rb") as f:
-                spv_data = f.read()
+            # The shader's own header lists all of its variants by key, such as BASIC_TRIANGLE_FRAG_SHADER_VARIANTS
+            table_name = filename.upper().replace(".", "_") + "_SHADER_VARIANTS"
 
             header_path = os.path.join(output_dir, filename + ".h")
             with open(header_path, "w") as f:
-                f.write("unsigned char " + variable_name + "[] = {\n")
-                f.write(", ".join(f"0x{byte:02x}" for byte in spv_data))
-                f.write("\n};\n")
-                f.write(f"unsigned int " + variable_name + "_SIZE = sizeof(" + variable_name + ");\n")
+                f.write("#include \"graphics/ShaderVariant.hpp\"\n\n")
+                for _, _, header_name in compiled:
+                    f.write(f"#include \"{header_name}\"\n")
+                f.write("\nShaderVariantCode " + table_name + "[] = {\n")
+                for key, variable_name, _ in compiled:
+                    f.write(f"    {{ 0x{key:04x}, {variable_name}, sizeof({variable_name}) }},\n")
+                f.write("};\n")
+                f.write("unsigned int " + table_name + "_COUNT = sizeof(" + table_name + ") / sizeof(ShaderVariantCode);\n")
 
 if __name__ == "__main__":
     main()
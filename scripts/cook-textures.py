@@ -0,0 +1,320 @@
+import base64
+import json
+import os
+import struct
+import sys
+import zlib
+
+# Must match source/graphics/TextureFile.hpp
+MAGIC = 0x58455443
+VERSION = 1
+ALIGNMENT = 16
+FORMAT_BC1 = 1
+FORMAT_BC3 = 2
+
+HEADER_FORMAT = "<6IQ"
+MIP_FORMAT = "<Q3I4x"
+
+GLB_MAGIC = 0x46546c67
+GLB_CHUNK_JSON = 0x4e4f534a
+GLB_CHUNK_BIN = 0x004e4942
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa = abs(p - a)
+    pb = abs(p - b)
+    pc = abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+def decode_png(data):
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("not a PNG image, only PNG textures can be cooked")
+
+    offset = 8
+    idat = bytearray()
+    palette = None
+    transparency = None
+
+    while offset < len(data):
+        length, chunk_type = struct.unpack_from(">I4s", data, offset)
+        chunk = data[offset + 8:offset + 8 + length]
+        offset += length + 12
+
+        if chunk_type == b"IHDR":
+            width, height, bit_depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif chunk_type == b"PLTE":
+            palette = chunk
+        elif chunk_type == b"tRNS":
+            transparency = chunk
+        elif chunk_type == b"IDAT":
+            idat.extend(chunk)
+        elif chunk_type == b"IEND":
+            break
+
+    if bit_depth != 8 or interlace != 0:
+        raise ValueError("only 8 bit, non-interlaced PNG images are supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    stride = width * channels
+    raw = zlib.decompress(bytes(idat))
+
+    # Undo the per-row filters
+    rows = []
+    previous = bytearray(stride)
+    for y in range(height):
+        filter_type = raw[y * (stride + 1)]
+        row = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for x in range(stride):
+            left = row[x - channels] if x >= channels else 0
+            up = previous[x]
+            up_left = previous[x - channels] if x >= channels else 0
+            if filter_type == 1:
+                row[x] = (row[x] + left) & 0xff
+            elif filter_type == 2:
+                row[x] = (row[x] + up) & 0xff
+            elif filter_type == 3:
+                row[x] = (row[x] + ((left + up) >> 1)) & 0xff
+            elif filter_type == 4:
+                row[x] = (row[x] + paeth(left, up, up_left)) & 0xff
+        rows.append(row)
+        previous = row
+
+    pixels = bytearray(width * height * 4)
+    for y, row in enumerate(rows):
+        for x in range(width):
+            i = (y * width + x) * 4
+            if color_type == 0:
+                pixels[i:i + 4] = bytes((row[x], row[x], row[x], 255))
+            elif color_type == 2:
+                pixels[i:i + 4] = bytes((row[x * 3], row[x * 3 + 1], row[x * 3 + 2], 255))
+            elif color_type == 3:
+                index = row[x]
+                alpha = transparency[index] if transparency is not None and index < len(transparency) else 255
+                pixels[i:i + 4] = bytes((palette[index * 3], palette[index * 3 + 1], palette[index * 3 + 2], alpha))
+            elif color_type == 4:
+                pixels[i:i + 4] = bytes((row[x * 2], row[x * 2], row[x * 2], row[x * 2 + 1]))
+            else:
+                pixels[i:i + 4] = row[x * 4:x * 4 + 4]
+
+    return width, height, pixels
+
+def downsample(width, height, pixels):
+    # Box filter, odd sizes repeat their last row or column
+    new_width = max(width // 2, 1)
+    new_height = max(height // 2, 1)
+    result = bytearray(new_width * new_height * 4)
+
+    for y in range(new_height):
+        y0 = min(y * 2, height - 1)
+        y1 = min(y * 2 + 1, height - 1)
+        for x in range(new_width):
+            x0 = min(x * 2, width - 1)
+            x1 = min(x * 2 + 1, width - 1)
+            for c in range(4):
+                total = (pixels[(y0 * width + x0) * 4 + c] + pixels[(y0 * width + x1) * 4 + c] +
+                         pixels[(y1 * width + x0) * 4 + c] + pixels[(y1 * width + x1) * 4 + c])
+                result[(y * new_width + x) * 4 + c] = (total + 2) // 4
+
+    return new_width, new_height, result
+
+def to_565(color):
+    return ((color[0] * 31 + 127) // 255 << 11) | ((color[1] * 63 + 127) // 255 << 5) | ((color[2] * 31 + 127) // 255)
+
+def from_565(value):
+    r = (value >> 11) & 0x1f
+    g = (value >> 5) & 0x3f
+    b = value & 0x1f
+    return ((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))
+
+def encode_color_block(block):
+    # Endpoints span the block's bounding box, inset a little so the extremes land on the interpolated colors
+    low = [min(p[c] for p in block) for c in range(3)]
+    high = [max(p[c] for p in block) for c in range(3)]
+    inset = [(high[c] - low[c]) // 16 for c in range(3)]
+    color0 = to_565([high[c] - inset[c] for c in range(3)])
+    color1 = to_565([low[c] + inset[c] for c in range(3)])
+
+    if color0 == color1:
+        return struct.pack("<HHI", color0, color1, 0)
+
+    # The first endpoint has to be larger, otherwise the block switches to three colors
+    if color0 < color1:
+        color0, color1 = color1, color0
+
+    p0 = from_565(color0)
+    p1 = from_565(color1)
+    palette = [
+        p0,
+        p1,
+        tuple((2 * p0[c] + p1[c]) // 3 for c in range(3)),
+        tuple((p0[c] + 2 * p1[c]) // 3 for c in range(3)),
+    ]
+
+    indices = 0
+    for i, p in enumerate(block):
+        best = min(range(4), key=lambda j: sum((p[c] - palette[j][c]) ** 2 for c in range(3)))
+        indices |= best << (i * 2)
+
+    return struct.pack("<HHI", color0, color1, indices)
+
+def encode_alpha_block(block):
+    alpha0 = max(p[3] for p in block)
+    alpha1 = min(p[3] for p in block)
+
+    indices = 0
+    if alpha0 != alpha1:
+        palette = [alpha0, alpha1] + [((7 - i) * alpha0 + i * alpha1) // 7 for i in range(1, 7)]
+        for i, p in enumerate(block):
+            best = min(range(8), key=lambda j: abs(p[3] - palette[j]))
+            indices |= best << (i * 3)
+
+    return struct.pack("<BB", alpha0, alpha1) + indices.to_bytes(6, "little")
+
+def encode_mip(width, height, pixels, texture_format):
+    data = bytearray()
+    for block_y in range(0, height, 4):
+        for block_x in range(0, width, 4):
+            # Blocks hanging over the edge repeat the last pixels
+            block = []
+            for y in range(4):
+                for x in range(4):
+                    i = (min(block_y + y, height - 1) * width + min(block_x + x, width - 1)) * 4
+                    block.append(pixels[i:i + 4])
+
+            if texture_format == FORMAT_BC3:
+                data.extend(encode_alpha_block(block))
+            data.extend(encode_color_block(block))
+
+    return data
+
+def cook_image(image_data, output_path):
+    width, height, pixels = decode_png(image_data)
+    has_alpha = any(pixels[i] != 255 for i in range(3, len(pixels), 4))
+    texture_format = FORMAT_BC3 if has_alpha else FORMAT_BC1
+
+    # Full chain down to 1x1, finest first
+    mips = [(width, height, encode_mip(width, height, pixels, texture_format))]
+    while width > 1 or height > 1:
+        width, height, pixels = downsample(width, height, pixels)
+        mips.append((width, height, encode_mip(width, height, pixels, texture_format)))
+
+    mip_offset = align(struct.calcsize(HEADER_FORMAT))
+    offset = align(mip_offset + len(mips) * struct.calcsize(MIP_FORMAT))
+
+    data = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, texture_format, mips[0][0], mips[0][1], len(mips), mip_offset))
+    data.extend(bytes(mip_offset - len(data)))
+
+    for mip_width, mip_height, mip_data in mips:
+        data.extend(struct.pack(MIP_FORMAT, offset, len(mip_data), mip_width, mip_height))
+        offset = align(offset + len(mip_data))
+
+    for _, _, mip_data in mips:
+        data.extend(bytes(align(len(data)) - len(data)))
+        data.extend(mip_data)
+
+    with open(output_path, "wb") as f:
+        f.write(data)
+
+    format_name = "BC3" if texture_format == FORMAT_BC3 else "BC1"
+    print(f"{output_path}: {mips[0][0]}x{mips[0][1]} {format_name}, {len(mips)} mips, {len(data)} bytes")
+
+def load_gltf(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) >= 12 and struct.unpack_from("<I", data)[0] == GLB_MAGIC:
+        gltf = None
+        binary = None
+        offset = 12
+        while offset < len(data):
+            length, chunk_type = struct.unpack_from("<II", data, offset)
+            chunk = data[offset + 8:offset + 8 + length]
+            if chunk_type == GLB_CHUNK_JSON:
+                gltf = json.loads(chunk)
+            elif chunk_type == GLB_CHUNK_BIN:
+                binary = chunk
+            offset += 8 + length
+        return gltf, binary
+
+    return json.loads(data), None
+
+def read_buffer(gltf, binary, directory, index):
+    buffer = gltf["buffers"][index]
+    if "uri" not in buffer:
+        return binary
+
+    uri = buffer["uri"]
+    if uri.startswith("data:"):
+        return base64.b64decode(uri.split(",", 1)[1])
+
+    with open(os.path.join(directory, uri), "rb") as f:
+        return f.read()
+
+def cook_model(path):
+    gltf, binary = load_gltf(path)
+    directory = os.path.dirname(path)
+    stem = os.path.splitext(path)[0]
+
+    # Only images used as base color are cooked, the engine has no other texture slots yet
+    used_images = set()
+    for material in gltf.get("materials", []):
+        texture = material.get("pbrMetallicRoughness", {}).get("baseColorTexture")
+        if texture is not None:
+            used_images.add(gltf["textures"][texture["index"]]["source"])
+
+    # Assimp numbers embedded images in order, external ones keep their file name
+    embedded_index = 0
+    for index, image in enumerate(gltf.get("images", [])):
+        uri = image.get("uri")
+        is_embedded = uri is None or uri.startswith("data:")
+
+        if index in used_images:
+            if uri is None:
+                view = gltf["bufferViews"][image["bufferView"]]
+                buffer = read_buffer(gltf, binary, directory, view["buffer"])
+                start = view.get("byteOffset", 0)
+                image_data = buffer[start:start + view["byteLength"]]
+                output_path = f"{stem}.{embedded_index}.tex"
+            elif is_embedded:
+                image_data = base64.b64decode(uri.split(",", 1)[1])
+                output_path = f"{stem}.{embedded_index}.tex"
+            else:
+                with open(os.path.join(directory, uri), "rb") as f:
+                    image_data = f.read()
+                output_path = os.path.splitext(os.path.join(directory, uri))[0] + ".tex"
+
+            try:
+                cook_image(image_data, output_path)
+            except ValueError as error:
+                print(f"Warning: skipping image {index} of {path}: {error}")
+
+        if is_embedded:
+            embedded_index += 1
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: python cook-textures.py <model.glb|model.gltf>...")
+        print("       python cook-textures.py <image.png> <output.tex>")
+        print("Only 8 bit, non-interlaced PNG images are cooked. Other images, JPEG included, are skipped with a warning")
+        print("and have no .tex file, so convert them to PNG first.")
+        sys.exit(1)
+
+    if sys.argv[1].lower().endswith(".png"):
+        if len(sys.argv) != 3:
+            print("Error: a PNG image needs an output file")
+            sys.exit(1)
+
+        with open(sys.argv[1], "rb") as f:
+            cook_image(f.read(), sys.argv[2])
+        return
+
+    for path in sys.argv[1:]:
+        cook_model(path)
+
+if __name__ == "__main__":
+    main()
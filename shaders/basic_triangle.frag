@@ -1,5 +1,24 @@
 #version 450
 
+// @variant POINT_LIGHT_COUNT 0 1 2 4
+// @variant LIGHTING_MODEL 0 1
+// @variant ALBEDO_TEXTURE 0 1
+
+// Defaults for compiling without the build script, the most general variant
+#ifndef POINT_LIGHT_COUNT
+#define POINT_LIGHT_COUNT 4
+#endif
+
+// 0 is Blinn-Phong, 1 is Lambert which skips the specular term
+#ifndef LIGHTING_MODEL
+#define LIGHTING_MODEL 0
+#endif
+
+// 1 multiplies the diffuse color with a streamed albedo texture
+#ifndef ALBEDO_TEXTURE
+#define ALBEDO_TEXTURE 0
+#endif
+
 struct Material {
     vec4 ambient;
     vec4 diffuse;
@@ -30,6 +49,8 @@ struct PointLight {
 
 layout (location = 0) in vec3 FragPos;
 layout (location = 1) in vec3 Normal;
+layout (location = 2) flat in uint MaterialIndex;
+layout (location = 3) in vec2 TexCoords;
 
 layout (location = 0) out vec4 FragColor;
 
@@ -39,22 +60,45 @@ layout (binding = 0, set = 3) uniform SceneBuffer {
     PointLight point_lights[4];
 };
 
-layout (binding = 1, set = 3) uniform MaterialBuffer {
-    Material material;
+// Samplers come before storage buffers in the fragment resource set, so the material buffer moves up when the
+// texture is bound
+#if ALBEDO_TEXTURE
+layout (binding = 0, set = 2) uniform sampler2D AlbedoTexture;
+#endif
+
+layout (std430, binding = ALBEDO_TEXTURE, set = 2) readonly buffer MaterialBuffer {
+    Material materials[];
 };
 
+// Material of the current fragment, looked up once in main
+Material material;
+// Diffuse color of the current fragment, with the texture applied
+vec3 albedo;
+
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 void main() {
+    material = materials[MaterialIndex];
+    albedo = vec3(material.diffuse);
+
+#if ALBEDO_TEXTURE
+    albedo *= texture(AlbedoTexture, TexCoords).rgb;
+#endif
+
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos.xyz - FragPos);
 
-    vec3 result = CalcDirectionalLight(directional_light, norm, viewDir);
+    vec3 result = vec3(0.0);
 
-    for (int i = 0; i < 4; i++) {
+    // The scene always has its sun, so the directional light isn't a variant
+    result += CalcDirectionalLight(directional_light, norm, viewDir);
+
+#if POINT_LIGHT_COUNT > 0
+    for (int i = 0; i < POINT_LIGHT_COUNT; i++) {
         result += CalcPointLight(point_lights[i], norm, FragPos, viewDir);
     }
+#endif
 
     FragColor = vec4(result, 1.0);
 }
@@ -63,33 +107,41 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir) {
     vec3 lightDir = normalize(-light.direction.xyz);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
+    // combine results
+    vec3 ambient = light.ambient.xyz * albedo;
+    vec3 diffuse = light.diffuse.xyz * diff * albedo;
+#if LIGHTING_MODEL == 0
     // specular shading
     vec3 halfwayDir = normalize(lightDir + viewDir);
     float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-    // combine results
-    vec3 ambient = light.ambient.xyz * vec3(material.diffuse);
-    vec3 diffuse = light.diffuse.xyz * diff * vec3(material.diffuse);
     vec3 specular = light.specular.xyz * spec * vec3(material.specular);
 
     return (ambient + diffuse + specular);
+#else
+    return (ambient + diffuse);
+#endif
 }
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     vec3 lightDir = normalize(light.position.xyz - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 halfwayDir = normalize(lightDir + viewDir);
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
     // attenuation
     float distance = length(light.position.xyz - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     // combine results
-    vec3 ambient = light.ambient.xyz * vec3(material.diffuse);
-    vec3 diffuse  = light.diffuse.xyz * diff * vec3(material.diffuse);
-    vec3 specular = light.specular.xyz * spec * vec3(material.specular);
+    vec3 ambient = light.ambient.xyz * albedo;
+    vec3 diffuse  = light.diffuse.xyz * diff * albedo;
     ambient  *= attenuation;
     diffuse  *= attenuation;
+#if LIGHTING_MODEL == 0
+    // specular shading
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    vec3 specular = light.specular.xyz * spec * vec3(material.specular);
     specular *= attenuation;
     return (ambient + diffuse + specular);
+#else
+    return (ambient + diffuse);
+#endif
 }
@@ -1,20 +1,42 @@
 #version 450
 
+struct Instance {
+    mat4x4 model;
+    mat4x4 model_inverse_transpose;
+};
+
 layout (location = 0) in vec3 Position;
 layout (location = 1) in vec3 Normal;
+layout (location = 2) in vec2 TexCoords;
 
 layout (location = 0) out vec3 outFragPos;
 layout (location = 1) out vec3 outNormal;
+layout (location = 2) flat out uint outMaterialIndex;
+layout (location = 3) out vec2 outTexCoords;
+
+// Must match depth_only.vert bit for bit, the main pass tests against the pre-pass depth with EQUAL
+invariant gl_Position;
+
+layout (std430, binding = 0, set = 0) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
 
-layout (binding = 0, set = 1) uniform UBO {
+layout (binding = 0, set = 1) uniform ViewBuffer {
     mat4x4 projection;
     mat4x4 view;
-    mat4x4 model;
-    mat4x4 model_inverse_transpose;
+};
+
+layout (binding = 1, set = 1) uniform DrawBuffer {
+    uint instance_index;
+    uint material_index;
 };
 
 void main() {
-    outNormal = mat3(model_inverse_transpose) * Normal;  
-    outFragPos = vec3(model * vec4(Position, 1.0));
-    gl_Position = projection * view * model * vec4(Position, 1);
+    Instance instance = instances[instance_index];
+
+    outNormal = mat3(instance.model_inverse_transpose) * Normal;
+    outFragPos = vec3(instance.model * vec4(Position, 1.0));
+    outMaterialIndex = material_index;
+    outTexCoords = TexCoords;
+    gl_Position = projection * view * vec4(outFragPos, 1.0);
 }
@@ -0,0 +1,5 @@
+#version 450
+
+// The pre-pass only writes depth, the pipeline masks out the color target
+void main() {
+}
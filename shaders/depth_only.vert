@@ -0,0 +1,30 @@
+#version 450
+
+struct Instance {
+    mat4x4 model;
+    mat4x4 model_inverse_transpose;
+};
+
+layout (location = 0) in vec3 Position;
+
+layout (std430, binding = 0, set = 0) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+layout (binding = 0, set = 1) uniform ViewBuffer {
+    mat4x4 projection;
+    mat4x4 view;
+};
+
+layout (binding = 1, set = 1) uniform DrawBuffer {
+    uint instance_index;
+    uint material_index;
+};
+
+// Must match basic_triangle.vert bit for bit, the main pass tests against this depth with EQUAL
+invariant gl_Position;
+
+void main() {
+    vec3 frag_pos = vec3(instances[instance_index].model * vec4(Position, 1.0));
+    gl_Position = projection * view * vec4(frag_pos, 1.0);
+}
@@ -1,15 +1,30 @@
 #version 450
 
+struct Instance {
+    mat4x4 model;
+    mat4x4 model_inverse_transpose;
+};
+
 layout (location = 0) in vec3 Position;
 layout (location = 1) in vec3 Normal;
 layout (location = 2) in vec4 Color;
 
 layout (location = 0) out vec4 outColor;
 
-layout (binding = 0, set = 1) uniform UBO {
-    mat4 mvp;
+layout (std430, binding = 0, set = 0) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+layout (binding = 0, set = 1) uniform ViewBuffer {
+    mat4x4 projection;
+    mat4x4 view;
+};
+
+layout (binding = 1, set = 1) uniform DrawBuffer {
+    uint instance_index;
+    uint material_index;
 };
 
 void main() {
-    gl_Position = mvp * vec4(Position, 1);
+    gl_Position = projection * view * instances[instance_index].model * vec4(Position, 1);
 }
@@ -0,0 +1,8 @@
+#version 450
+
+layout (location = 0) out vec4 FragColor;
+
+// Every shaded fragment adds one step to an additively blended R8 target, so each texel counts its fragments
+void main() {
+    FragColor = vec4(1.0 / 255.0, 0.0, 0.0, 0.0);
+}
@@ -0,0 +1,69 @@
+#include "AllocationCheck.hpp"
+
+#include "macros/log.hpp"
+
+#include "memory/FrameMemoryService.hpp"
+
+// Frames before counting, long enough for the bodies to settle, the textures to stream in and every buffer to reach
+// its steady size
+static constexpr Uint32 cWarmupFrameCount = 300;
+
+static void GetAllocations(Uint64 *outTagAllocations) {
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::Count); i++) {
+        outTagAllocations[i] = MemoryService::Get().GetTagStats(static_cast<MemoryTag>(i)).mTotalAllocations;
+    }
+}
+
+void AllocationCheck::Start(Uint32 inFrameCount) {
+    mFrameCount = inFrameCount;
+    mFrame = 0;
+}
+
+bool AllocationCheck::EndFrame() {
+    mFrame++;
+
+    if (mFrame == cWarmupFrameCount) {
+        GetAllocations(mStartAllocations);
+        mStartOverflowCount = FrameMemoryService::Get().GetTotalOverflowCount();
+        mStartTime = SDL_GetTicksNS();
+    }
+
+    return mFrame == cWarmupFrameCount + mFrameCount;
+}
+
+bool AllocationCheck::Report() const {
+    double frame_ms = static_cast<double>(SDL_GetTicksNS() - mStartTime) / 1e6 / mFrameCount;
+
+    Uint64 end_allocations[static_cast<size_t>(MemoryTag::Count)] = {};
+    GetAllocations(end_allocations);
+
+    Uint64 allocation_count = 0;
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::Count); i++) {
+        allocation_count += end_allocations[i] - mStartAllocations[i];
+    }
+
+    // Overflow blocks go through the MemoryService as well, they are reported on their own since they mean the
+    // frame arena is too small rather than a system allocating
+    size_t overflow_count = FrameMemoryService::Get().GetTotalOverflowCount() - mStartOverflowCount;
+
+    if (allocation_count == 0 && overflow_count == 0) {
+        LOG_INFO("No heap allocations in %u steady frames, %.2f ms/frame, %zu bytes of frame memory\n",
+            mFrameCount,
+            frame_ms,
+            FrameMemoryService::Get().GetCurrentArena().GetPeakSize());
+        return true;
+    }
+
+    LOG_ERROR("%llu heap allocations and %zu frame arena overflows in %u steady frames:\n",
+        static_cast<unsigned long long>(allocation_count),
+        overflow_count,
+        mFrameCount);
+
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::Count); i++) {
+        if (end_allocations[i] != mStartAllocations[i]) {
+            LOG_ERROR("  %-10s %llu\n", MemoryService::GetTagName(static_cast<MemoryTag>(i)), static_cast<unsigned long long>(end_allocations[i] - mStartAllocations[i]));
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "memory/MemoryService.hpp"
+
+// Counts the heap allocations of the real game's frames, the full frame graph on the loaded scene. After a warm-up
+// long enough for every buffer to reach its steady size, any MemoryService allocation or frame arena overflow in the
+// counted frames fails the check.
+class AllocationCheck {
+private:
+    Uint32 mFrameCount = 0;
+    Uint32 mFrame = 0;
+
+    Uint64 mStartAllocations[static_cast<size_t>(MemoryTag::Count)] = {};
+    size_t mStartOverflowCount = 0;
+    Uint64 mStartTime = 0;
+
+public:
+    // Check inFrameCount frames after the warm-up
+    void Start(Uint32 inFrameCount);
+
+    // Call after every frame, returns true once the last counted frame is done
+    bool EndFrame();
+
+    // Log the allocations made by the counted frames, returns whether there were none
+    bool Report() const;
+
+    inline bool IsActive() const {
+        return mFrameCount > 0;
+    }
+};
@@ -8,10 +8,12 @@
 
 #include "macros/log.hpp"
 
-#include "Context.hpp"
 #include "graphics/RenderService.hpp"
 #include "graphics/vertices/PositionNormalTextureVertex.hpp"
+#include "io/ContentIOSystem.hpp"
+#include "io/FileService.hpp"
 #include "MeshData.hpp"
+#include "memory/MemoryService.hpp"
 
 SDL_GPUShader *ContentManager::LoadShader(
     const eastl::string &inPath,
@@ -26,25 +28,23 @@ SDL_GPUShader *ContentManager::LoadShader(
         return it->second;
     }
 
-    size_t code_size;
-    void *code = SDL_LoadFile((Context::Get().GetBasePath() + inPath).c_str(), &code_size);
-    if (code == nullptr) {
-        LOG_ERROR("Unable to load shader file: %s", SDL_GetError());
+    // Shaders in the pack are handed to the device straight from the mapping
+    FileData code;
+    if (!FileService::Get().ReadFile(inPath.c_str(), code)) {
+        LOG_ERROR("Unable to load shader file: %s\n", inPath.c_str());
         return nullptr;
     }
 
     SDL_GPUShader *shader = RenderService::Get().CreateShader(
         inStage,
-        (const Uint8 *)code,
-        code_size,
+        code.GetData(),
+        code.GetSize(),
         inSamplerCount,
         inUniformBufferCount,
         inStorageBufferCount,
         inStorageTextureCount
     );
 
-    SDL_free(code);
-
     mShaders[inPath] = shader;
     return shader;
 }
@@ -57,9 +57,32 @@ void ContentManager::UnloadShader(const eastl::string &inPath) {
     }
 }
 
-static MeshData AssimpProcessMesh(const aiMesh *mesh) {
-    eastl::vector<PositionNormalTextureVertex> vertices;
-    eastl::vector<Uint16> indices;
+// Textures are cooked next to the model by scripts/cook-textures.py. Assimp names embedded textures *N, those are
+// cooked to <model>.N.tex, external textures keep their name with the extension swapped.
+static eastl::string GetCookedTexturePath(const eastl::string &inModelPath, const eastl::string &inTexturePath) {
+    size_t directory_end = inModelPath.find_last_of("/\\");
+    size_t directory_length = directory_end == eastl::string::npos ? 0 : directory_end + 1;
+
+    eastl::string path;
+    if (inTexturePath[0] == '*') {
+        size_t extension = inModelPath.find_last_of('.');
+        path = extension != eastl::string::npos && extension >= directory_length ? inModelPath.substr(0, extension) : inModelPath;
+        path += ".";
+        path += inTexturePath.substr(1);
+    } else {
+        path = inModelPath.substr(0, directory_length) + inTexturePath;
+        size_t extension = path.find_last_of('.');
+        if (extension != eastl::string::npos && extension > path.find_last_of("/\\") + 1) {
+            path.resize(extension);
+        }
+    }
+
+    return path + ".tex";
+}
+
+static void AssimpProcessMesh(const aiMesh *mesh, const aiScene *scene, MeshData &mesh_data) {
+    mesh_data.vertices.reserve(mesh->mNumVertices);
+    mesh_data.indices.reserve(mesh->mNumFaces * 3);
 
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         PositionNormalTextureVertex vertex;
@@ -79,44 +102,97 @@ static MeshData AssimpProcessMesh(const aiMesh *mesh) {
             vertex.mTexCoords = glm::vec2(0.0f, 0.0f);
         }
 
-        vertices.push_back(vertex);
+        mesh_data.vertices.push_back(vertex);
     }
 
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
         aiFace face = mesh->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++) {
-            indices.push_back(static_cast<Uint16>(face.mIndices[j]));
+            mesh_data.indices.push_back(static_cast<Uint16>(face.mIndices[j]));
         }
     }
 
-    return {
-        .vertices = vertices,
-        .indices = indices
-    };
+    // glTF materials have a base color texture, older formats a diffuse one
+    const aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+    aiString texture_path;
+    if (material->GetTexture(aiTextureType_BASE_COLOR, 0, &texture_path) == AI_SUCCESS ||
+        material->GetTexture(aiTextureType_DIFFUSE, 0, &texture_path) == AI_SUCCESS) {
+        mesh_data.albedo_texture = texture_path.C_Str();
+    }
 }
 
-static MeshData AssimpProcessNode(const aiNode *node, const aiScene *scene) {
-    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        // Only process the first mesh in the model file
-        return AssimpProcessMesh(mesh);
+// Walk the nodes depth first, so parents are added before their children
+static void AssimpProcessNode(const aiNode *node, Uint32 parent, const aiScene *scene, MeshData &mesh_data) {
+    aiVector3D scaling;
+    aiQuaternion rotation;
+    aiVector3D position;
+    node->mTransformation.Decompose(scaling, rotation, position);
+
+    MeshNode mesh_node;
+    mesh_node.parent = parent;
+    mesh_node.transform.mPosition = glm::vec3(position.x, position.y, position.z);
+    mesh_node.transform.mRotation = glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+    mesh_node.transform.mScale = glm::vec3(scaling.x, scaling.y, scaling.z);
+
+    Uint32 index = static_cast<Uint32>(mesh_data.hierarchy.nodes.size());
+    mesh_data.hierarchy.nodes.push_back(mesh_node);
+
+    // Only process the first mesh in the model file
+    if (node->mNumMeshes > 0 && mesh_data.hierarchy.mesh_node == cInvalidMeshNode) {
+        AssimpProcessMesh(scene->mMeshes[node->mMeshes[0]], scene, mesh_data);
+        mesh_data.hierarchy.mesh_node = index;
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        return AssimpProcessNode(node->mChildren[i], scene);
+        AssimpProcessNode(node->mChildren[i], index, scene, mesh_data);
     }
 }
 
-MeshHandle *ContentManager::LoadMesh(const eastl::string &inPath) {
+bool ContentManager::ImportMesh(const eastl::string &inPath) {
+    if (mMeshes.find(inPath) != mMeshes.end() || mImportedMeshes.find(inPath) != mImportedMeshes.end()) {
+        return true;
+    }
 
+    // Account everything Assimp allocates while importing to content
+    MemoryTagScope memory_scope(MemoryTag::Content);
+
+    // Assimp reads the model and any files it refers to through the content pack, the importer owns the IO system
     Assimp::Importer importer;
+    importer.SetIOHandler(new ContentIOSystem());
     const aiScene *scene = importer.ReadFile(inPath.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs);
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         LOG_ERROR("Failed to import model file:%s\n", importer.GetErrorString());
+        return false;
+    }
+
+    MeshData mesh_data;
+    AssimpProcessNode(scene->mRootNode, cInvalidMeshNode, scene, mesh_data);
+    if (mesh_data.hierarchy.mesh_node == cInvalidMeshNode) {
+        LOG_ERROR("Model file has no mesh: %s\n", inPath.c_str());
+        return false;
+    }
+
+    if (!mesh_data.albedo_texture.empty()) {
+        mesh_data.albedo_texture = GetCookedTexturePath(inPath, mesh_data.albedo_texture);
+    }
+
+    mImportedMeshes[inPath] = eastl::move(mesh_data);
+    return true;
+}
+
+MeshHandle *ContentManager::LoadMesh(const eastl::string &inPath) {
+    auto it = mMeshes.find(inPath);
+    if (it != mMeshes.end()) {
+        return it->second;
+    }
+
+    // Meshes that weren't imported up front are imported now
+    if (!ImportMesh(inPath)) {
         return nullptr;
     }
 
-    MeshData mesh_data = AssimpProcessNode(scene->mRootNode, scene);
+    auto imported_it = mImportedMeshes.find(inPath);
+    MeshData &mesh_data = imported_it->second;
 
     // Create a mesh from the data
     // TODO: Clean up input parameters (separate unit sizes from counts to ease things up)
@@ -129,17 +205,64 @@ MeshHandle *ContentManager::LoadMesh(const eastl::string &inPath) {
         static_cast<Uint32>(mesh_data.indices.size())
     );
 
+    // Meshes whose texture wasn't cooked are drawn with their material color
+    if (mesh_handle != nullptr && !mesh_data.albedo_texture.empty()) {
+        mesh_handle->mAlbedoTexture = LoadTexture(mesh_data.albedo_texture);
+    }
+
+    if (mesh_handle != nullptr) {
+        mMeshes[inPath] = mesh_handle;
+        mMeshHierarchies[inPath] = eastl::move(mesh_data.hierarchy);
+    }
+
+    mImportedMeshes.erase(imported_it);
+
     return mesh_handle;
 }
 
+TextureID ContentManager::LoadTexture(const eastl::string &inPath) {
+    auto it = mTextures.find(inPath);
+    if (it != mTextures.end()) {
+        return it->second;
+    }
+
+    TextureID texture = RenderService::Get().GetTextureStreamer().Load(inPath.c_str());
+    if (texture != cInvalidTexture) {
+        mTextures[inPath] = texture;
+    }
+
+    return texture;
+}
+
+const MeshData *ContentManager::GetImportedMesh(const eastl::string &inPath) const {
+    auto it = mImportedMeshes.find(inPath);
+    return it != mImportedMeshes.end() ? &it->second : nullptr;
+}
+
 void ContentManager::UnloadMesh(const eastl::string &inPath) {
     auto it = mMeshes.find(inPath);
     if (it != mMeshes.end()) {
         RenderService::Get().DestroyMesh(it->second);
         mMeshes.erase(it);
+        mMeshHierarchies.erase(inPath);
     }
 }
 
+const MeshHierarchy *ContentManager::GetMeshHierarchy(const eastl::string &inPath) const {
+    auto it = mMeshHierarchies.find(inPath);
+    return it != mMeshHierarchies.end() ? &it->second : nullptr;
+}
+
+const eastl::string *ContentManager::GetMeshPath(const MeshHandle *inMesh) const {
+    for (const auto &pair : mMeshes) {
+        if (pair.second == inMesh) {
+            return &pair.first;
+        }
+    }
+
+    return nullptr;
+}
+
 void ContentManager::Unload() {
     for (auto &pair : mShaders) {
         RenderService::Get().DestroyShader(pair.second);
@@ -148,4 +271,14 @@ void ContentManager::Unload() {
     for (auto &pair : mMeshes) {
         RenderService::Get().DestroyMesh(pair.second);
     }
+
+    for (auto &pair : mTextures) {
+        RenderService::Get().GetTextureStreamer().Destroy(pair.second);
+    }
+
+    mShaders.clear();
+    mMeshes.clear();
+    mTextures.clear();
+    mMeshHierarchies.clear();
+    mImportedMeshes.clear();
 }
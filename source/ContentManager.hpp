@@ -6,11 +6,17 @@
 #include <SDL3/SDL_gpu.h>
 
 #include "graphics/MeshHandle.hpp"
+#include "MeshData.hpp"
 
 class ContentManager {
 private:
     eastl::unordered_map<eastl::string, SDL_GPUShader *> mShaders;
     eastl::unordered_map<eastl::string, MeshHandle *> mMeshes;
+    eastl::unordered_map<eastl::string, TextureID> mTextures;
+    eastl::unordered_map<eastl::string, MeshHierarchy> mMeshHierarchies;
+
+    // Meshes imported on the CPU that haven't been uploaded yet
+    eastl::unordered_map<eastl::string, MeshData> mImportedMeshes;
 
 public:
     ContentManager() = default;
@@ -26,8 +32,21 @@ public:
     );
     void UnloadShader(const eastl::string &inPath);
 
+    // Import a mesh file without touching the GPU, so it can happen before the device exists.
+    // The data is kept until the mesh is loaded or everything is unloaded.
+    bool ImportMesh(const eastl::string &inPath);
     MeshHandle *LoadMesh(const eastl::string &inPath);
+    // Find the CPU data of a mesh that was imported but not loaded yet, or nullptr if there is none
+    const MeshData *GetImportedMesh(const eastl::string &inPath) const;
     void UnloadMesh(const eastl::string &inPath);
+    // Find the node hierarchy of a loaded mesh, or nullptr if it isn't loaded
+    const MeshHierarchy *GetMeshHierarchy(const eastl::string &inPath) const;
+
+    // Load a cooked texture into the texture streamer, meshes load their albedo texture along with them
+    TextureID LoadTexture(const eastl::string &inPath);
+
+    // Find the path a mesh was loaded from, or nullptr if it wasn't loaded by this manager
+    const eastl::string *GetMeshPath(const MeshHandle *inMesh) const;
 
     void Unload();
 };
@@ -0,0 +1,154 @@
+#include "ContentPackBenchmark.hpp"
+
+#include "macros/log.hpp"
+
+#include "io/ContentPack.hpp"
+#include "io/FileService.hpp"
+
+static constexpr Uint32 cBenchmarkRoundCount = 8;
+
+// Touches every byte, so the compiler can't skip reading the data
+static Uint64 Checksum(const Uint8 *inData, size_t inSize) {
+    Uint64 sum = 0;
+    size_t i = 0;
+    for (; i + sizeof(Uint64) <= inSize; i += sizeof(Uint64)) {
+        Uint64 word;
+        SDL_memcpy(&word, inData + i, sizeof(word));
+        sum = (sum ^ word) * 0x100000001b3ull;
+    }
+
+    for (; i < inSize; i++) {
+        sum = (sum ^ inData[i]) * 0x100000001b3ull;
+    }
+
+    return sum;
+}
+
+static bool ReadFromPack(const ContentPack &inPack, const ContentPackEntry &inEntry, Uint64 &outChecksum) {
+    if (inEntry.mCompression == ContentPackCompression::None) {
+        outChecksum = Checksum(inPack.GetData(inEntry), inEntry.mSize);
+        return true;
+    }
+
+    Uint8 *buffer = static_cast<Uint8 *>(SDL_malloc(SDL_max(inEntry.mOriginalSize, Uint64(1))));
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    bool is_successful = inPack.Decompress(inEntry, buffer);
+    if (is_successful) {
+        outChecksum = Checksum(buffer, inEntry.mOriginalSize);
+    }
+
+    SDL_free(buffer);
+    return is_successful;
+}
+
+static bool ReadLooseFile(const char *inPath, Uint64 &outChecksum, size_t &outSize) {
+    // Resolved the way FileService falls back to loose files
+    eastl::string path = FileService::Get().GetLoosePath(inPath);
+
+    void *data = SDL_LoadFile(path.c_str(), &outSize);
+    if (data == nullptr) {
+        LOG_ERROR("Unable to read loose file %s: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    outChecksum = Checksum(static_cast<const Uint8 *>(data), outSize);
+    SDL_free(data);
+    return true;
+}
+
+static void LogThroughput(const char *inName, Uint64 inCount, Uint64 inSize, Uint64 inTime) {
+    double seconds = SDL_max(static_cast<double>(inTime) / 1e9, 1e-9);
+    LOG_INFO("  %-6s %6llu reads, %8.2f MB in %8.2f ms, %8.1f MB/s, %7.1f us/file\n",
+        inName,
+        static_cast<unsigned long long>(inCount),
+        static_cast<double>(inSize) / (1024.0 * 1024.0),
+        static_cast<double>(inTime) / 1e6,
+        static_cast<double>(inSize) / (1024.0 * 1024.0) / seconds,
+        inCount > 0 ? static_cast<double>(inTime) / 1e3 / static_cast<double>(inCount) : 0.0);
+}
+
+bool RunContentPackBenchmark(const char *inPackPath) {
+    ContentPack pack;
+
+    Uint64 open_start_time = SDL_GetTicksNS();
+    if (!pack.Open(inPackPath)) {
+        return false;
+    }
+    Uint64 open_time = SDL_GetTicksNS() - open_start_time;
+
+    Uint64 stored_size = 0;
+    Uint64 original_size = 0;
+    Uint32 compressed_count = 0;
+    for (Uint32 i = 0; i < pack.GetEntryCount(); i++) {
+        const ContentPackEntry &entry = pack.GetEntry(i);
+        stored_size += entry.mSize;
+        original_size += entry.mOriginalSize;
+        compressed_count += entry.mCompression != ContentPackCompression::None ? 1 : 0;
+    }
+
+    Uint64 pack_time = 0;
+    Uint64 loose_time = 0;
+    Uint64 read_count = 0;
+    Uint64 read_size = 0;
+    bool is_successful = true;
+
+    for (Uint32 round = 0; round < cBenchmarkRoundCount && is_successful; round++) {
+        for (Uint32 i = 0; i < pack.GetEntryCount(); i++) {
+            const ContentPackEntry &entry = pack.GetEntry(i);
+            const char *path = pack.GetPath(entry);
+
+            // The lookup is part of what a read from the pack costs
+            Uint64 start_time = SDL_GetTicksNS();
+            const ContentPackEntry *found = pack.Find(path);
+            Uint64 pack_checksum = 0;
+            bool is_pack_read = found == &entry && ReadFromPack(pack, entry, pack_checksum);
+            Uint64 entry_pack_time = SDL_GetTicksNS() - start_time;
+
+            if (!is_pack_read) {
+                LOG_ERROR("Unable to read %s from the pack\n", path);
+                is_successful = false;
+                break;
+            }
+
+            start_time = SDL_GetTicksNS();
+            Uint64 loose_checksum = 0;
+            size_t loose_size = 0;
+            bool is_loose_read = ReadLooseFile(path, loose_checksum, loose_size);
+            Uint64 entry_loose_time = SDL_GetTicksNS() - start_time;
+
+            // Files missing on disk only leave them out of the comparison
+            if (!is_loose_read) {
+                continue;
+            }
+
+            if (loose_size != entry.mOriginalSize || loose_checksum != pack_checksum) {
+                LOG_ERROR("Packed %s doesn't match the loose file, the pack is out of date\n", path);
+                is_successful = false;
+                break;
+            }
+
+            pack_time += entry_pack_time;
+            loose_time += entry_loose_time;
+            read_count++;
+            read_size += loose_size;
+        }
+    }
+
+    if (is_successful) {
+        LOG_INFO("Content pack %s: %u files (%u compressed), %.2f MB stored for %.2f MB, opened in %.3f ms\n",
+            inPackPath,
+            pack.GetEntryCount(),
+            compressed_count,
+            static_cast<double>(stored_size) / (1024.0 * 1024.0),
+            static_cast<double>(original_size) / (1024.0 * 1024.0),
+            static_cast<double>(open_time) / 1e6);
+        LogThroughput("Pack", read_count, read_size, pack_time);
+        LogThroughput("Loose", read_count, read_size, loose_time);
+    }
+
+    pack.Close();
+    return is_successful;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Read every file of a content pack both from the pack and as the loose file it was built from, check that they
+// match and log the throughput of each. Every byte is touched, so zero-copy reads pay for their page faults. Files
+// are read a few times and the OS cache is not dropped, the numbers are for warm reads.
+bool RunContentPackBenchmark(const char *inPackPath);
@@ -4,6 +4,11 @@
 
 #include "graphics/RenderService.hpp"
 #include "InputService.hpp"
+#include "jobs/JobService.hpp"
+#include "memory/FrameMemoryService.hpp"
+
+// Size of each of the two frame arenas
+static constexpr size_t cFrameMemorySize = 4 * 1024 * 1024;
 
 bool Context::Initialize(const ContextCreateInfo &inCreateInfo) {
     // Initialize the SDL video subsystem, needed for window creation and rendering
@@ -19,11 +24,17 @@ bool Context::Initialize(const ContextCreateInfo &inCreateInfo) {
         return false;
     }
 
-    // Begin initializating services here
-    if (!RenderService::Get().Initialize(mWindow)) {
+    if (!FrameMemoryService::Get().Initialize(cFrameMemorySize)) {
         return false;
     }
 
+    // Start the engine's worker threads before anything else so every subsystem can use them
+    if (!JobService::Get().Initialize({ inCreateInfo.mWorkerCount, inCreateInfo.mWorkerAffinityMask })) {
+        return false;
+    }
+
+    // The RenderService is initialized by the startup task graph, so device creation can overlap with other work
+
     // Initialize input service
     InputService::Get();
 
@@ -32,6 +43,8 @@ bool Context::Initialize(const ContextCreateInfo &inCreateInfo) {
 
 void Context::Shutdown() {
     RenderService::Get().Shutdown();
+    JobService::Get().Shutdown();
+    FrameMemoryService::Get().Shutdown();
 
     if (mWindow != nullptr) {
         SDL_DestroyWindow(mWindow);
@@ -42,6 +55,12 @@ void Context::Shutdown() {
 }
 
 void Context::BeginFrame() {
+    // Release the transient memory of two frames ago
+    FrameMemoryService::Get().BeginFrame();
+
+    // Everything that arrived since the last frame is this frame's input
+    InputService::Get().BeginFrame();
+
     // Update and check window width and height
     int width, height;
     SDL_GetWindowSize(mWindow, &width, &height);
@@ -54,6 +73,9 @@ void Context::BeginFrame() {
         mIsWindowResized = false;
     }
 
+    // The CPU time of the frame feeds the resolution controller along with its GPU time
+    RenderService::Get().StartFrameTimer();
+
     // Calculate delta time (in milliseconds)
     Uint64 mCurrentTime = SDL_GetTicks();
     mDeltaTime = (mCurrentTime - mPreviousTime) / 1000.0f;
@@ -74,5 +96,8 @@ void Context::EndFrame() {
     // If the frame finished too quickly, add a delay to cap the frame rate
     if (frame_duration < target_frame_duration) {
         SDL_Delay(target_frame_duration - frame_duration);
+
+        // Frames the GPU finished during the delay are timed now, rather than when the next one is built
+        RenderService::Get().PollFrames();
     }
 }
@@ -11,6 +11,10 @@ struct ContextCreateInfo {
     const char *mTitle;
     int mWidth;
     int mHeight;
+
+    // Worker thread configuration, see JobServiceCreateInfo
+    int mWorkerCount = -1;
+    Uint64 mWorkerAffinityMask = 0;
 };
 
 class Context {
@@ -3,8 +3,27 @@
 #include "macros/singleton.hpp"
 #include <glm/glm.hpp>
 
+#include <SDL3/SDL.h>
+
+enum class InputEventType : Uint8 {
+    MouseMotion,
+    MouseButton,
+    MouseWheel,
+};
+
+// An input as it arrived, the timestamp is on the SDL_GetTicksNS clock
+struct InputEvent {
+    Uint64 mTimestamp;
+    InputEventType mType;
+    float mX;
+    float mY;
+};
+
 class InputService {
 MAKE_SINGLETON(InputService)
+public:
+    static constexpr Uint32 cEventCapacity = 256;
+
 private:
     glm::vec2 mMousePosition;
     glm::vec2 mMouseDelta;
@@ -14,25 +33,64 @@ private:
 
     float mScrollY;
 
+    // Recent events, older ones are overwritten once the buffer wraps around
+    InputEvent mEvents[cEventCapacity];
+    Uint64 mEventCount = 0;
+    // Events before this one were consumed by an earlier frame
+    Uint64 mFrameEventBegin = 0;
+    Uint64 mFrameEventEnd = 0;
+
+    // Timestamp of the oldest event not yet consumed by a frame, and of the oldest the current frame consumed
+    Uint64 mPendingInputTime = 0;
+    Uint64 mFrameInputTime = 0;
+
+    void AddEvent(Uint64 inTimestamp, InputEventType inType, float inX, float inY) {
+        mEvents[mEventCount % cEventCapacity] = { inTimestamp, inType, inX, inY };
+        mEventCount++;
+
+        if (mPendingInputTime == 0 || inTimestamp < mPendingInputTime) {
+            mPendingInputTime = inTimestamp;
+        }
+    }
+
 public:
-    void SetMousePosition(float inX, float inY) {
+    void SetMousePosition(Uint64 inTimestamp, float inX, float inY) {
         mMousePosition = glm::vec2(inX, inY);
+        AddEvent(inTimestamp, InputEventType::MouseMotion, inX, inY);
     }
 
-    void SetMouseDelta(float inX, float inY) {
-        mMouseDelta = glm::vec2(inX, inY);
+    // Several motion events can arrive within one frame, so their deltas add up
+    void AddMouseDelta(float inX, float inY) {
+        mMouseDelta += glm::vec2(inX, inY);
     }
 
-    void SetLeftMouseDown(bool inValue) {
+    void SetLeftMouseDown(Uint64 inTimestamp, bool inValue) {
         mIsLeftMouseDown = inValue;
+        AddEvent(inTimestamp, InputEventType::MouseButton, inValue ? 1.0f : 0.0f, 0.0f);
     }
 
-    void SetRightMouseDown(bool inValue) {
+    void SetRightMouseDown(Uint64 inTimestamp, bool inValue) {
         mIsRightMouseDown = inValue;
+        AddEvent(inTimestamp, InputEventType::MouseButton, inValue ? 1.0f : 0.0f, 1.0f);
+    }
+
+    void AddScrollY(Uint64 inTimestamp, float inValue) {
+        mScrollY += inValue;
+        AddEvent(inTimestamp, InputEventType::MouseWheel, 0.0f, inValue);
     }
 
-    void SetScrollY(float inValue) {
-        mScrollY = inValue;
+    // Hand the events that arrived since the last frame to the current one
+    void BeginFrame() {
+        mFrameEventBegin = mFrameEventEnd;
+        mFrameEventEnd = mEventCount;
+
+        // Events that were overwritten before the frame got to them are gone
+        if (mFrameEventEnd - mFrameEventBegin > cEventCapacity) {
+            mFrameEventBegin = mFrameEventEnd - cEventCapacity;
+        }
+
+        mFrameInputTime = mPendingInputTime;
+        mPendingInputTime = 0;
     }
 
     void Update() {
@@ -59,4 +117,18 @@ public:
     inline float GetScrollY() const {
         return mScrollY;
     }
+
+    // Events consumed by the current frame, in the order they arrived
+    inline Uint32 GetFrameEventCount() const {
+        return static_cast<Uint32>(mFrameEventEnd - mFrameEventBegin);
+    }
+
+    inline const InputEvent &GetFrameEvent(Uint32 inIndex) const {
+        return mEvents[(mFrameEventBegin + inIndex) % cEventCapacity];
+    }
+
+    // Timestamp of the oldest input the current frame consumed, zero when it had none
+    inline Uint64 GetFrameInputTime() const {
+        return mFrameInputTime;
+    }
 };
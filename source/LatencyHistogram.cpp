@@ -0,0 +1,54 @@
+#include "LatencyHistogram.hpp"
+
+#include "macros/log.hpp"
+
+void LatencyHistogram::Add(Uint64 inLatency) {
+    Uint64 bucket = inLatency / cBucketWidth;
+    mBuckets[bucket < cBucketCount ? bucket : cBucketCount - 1]++;
+
+    mCount++;
+    mTotal += inLatency;
+    if (inLatency > mMax) {
+        mMax = inLatency;
+    }
+}
+
+void LatencyHistogram::Reset() {
+    *this = {};
+}
+
+Uint64 LatencyHistogram::GetPercentile(float inFraction) const {
+    if (mCount == 0) {
+        return 0;
+    }
+
+    // Rank of the sample, counting from one
+    Uint64 rank = static_cast<Uint64>(SDL_ceil(static_cast<double>(mCount) * inFraction));
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    Uint64 seen = 0;
+    for (Uint32 i = 0; i < cBucketCount; i++) {
+        seen += mBuckets[i];
+        if (seen >= rank) {
+            // The overflow bucket has no upper edge, the largest sample is the best there is
+            return i + 1 < cBucketCount ? (i + 1) * cBucketWidth : mMax;
+        }
+    }
+
+    return mMax;
+}
+
+void LatencyHistogram::LogStats(const char *inName) const {
+    LOG_INFO(
+        "%s over %llu frames: mean %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+        inName,
+        static_cast<unsigned long long>(mCount),
+        static_cast<double>(GetMean()) / 1e6,
+        static_cast<double>(GetPercentile(0.5f)) / 1e6,
+        static_cast<double>(GetPercentile(0.95f)) / 1e6,
+        static_cast<double>(GetPercentile(0.99f)) / 1e6,
+        static_cast<double>(mMax) / 1e6
+    );
+}
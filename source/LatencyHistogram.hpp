@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Counts latencies in fixed-width buckets, so adding a sample is constant time and percentiles need no stored samples.
+// Samples past the last bucket are counted in it, times are in nanoseconds.
+class LatencyHistogram {
+public:
+    static constexpr Uint32 cBucketCount = 128;
+    static constexpr Uint64 cBucketWidth = 500000;
+
+private:
+    Uint64 mBuckets[cBucketCount] = {};
+    Uint64 mCount = 0;
+    Uint64 mTotal = 0;
+    Uint64 mMax = 0;
+
+public:
+    void Add(Uint64 inLatency);
+    void Reset();
+
+    // Upper edge of the bucket the given fraction of samples falls in, zero without samples
+    Uint64 GetPercentile(float inFraction) const;
+
+    // Log the mean, percentiles and maximum under a name
+    void LogStats(const char *inName) const;
+
+    inline Uint64 GetBucket(Uint32 inIndex) const {
+        return mBuckets[inIndex];
+    }
+
+    inline Uint64 GetCount() const {
+        return mCount;
+    }
+
+    inline Uint64 GetMean() const {
+        return mCount > 0 ? mTotal / mCount : 0;
+    }
+
+    inline Uint64 GetMax() const {
+        return mMax;
+    }
+};
@@ -4,9 +4,34 @@
 
 #include "graphics/vertices/PositionNormalTextureVertex.hpp"
 
+#include "memory/TaggedAllocator.hpp"
+#include "Transform.hpp"
+
+#include <EASTL/string.h>
 #include <EASTL/vector.h>
 
+static constexpr Uint32 cInvalidMeshNode = 0xffffffff;
+
+// A node of the hierarchy a model was imported with
+struct MeshNode {
+    // Index of the parent node, cInvalidMeshNode for roots. Parents always come before their children.
+    Uint32 parent;
+    Transform transform;
+};
+
+// The node hierarchy of a model, kept after the mesh is uploaded so it can be added to a TransformHierarchy
+struct MeshHierarchy {
+    eastl::vector<MeshNode> nodes;
+    // Node the vertices are relative to, cInvalidMeshNode when the model has no mesh
+    Uint32 mesh_node = cInvalidMeshNode;
+};
+
+// Mesh data lives from the import until the mesh is uploaded to the GPU, which can be any number of frames later,
+// so it's kept on the heap and accounted to content
 struct MeshData {
-    eastl::vector<PositionNormalTextureVertex> vertices;
-    eastl::vector<Uint16> indices;
+    eastl::vector<PositionNormalTextureVertex, TaggedAllocator<MemoryTag::Content>> vertices;
+    eastl::vector<Uint16, TaggedAllocator<MemoryTag::Content>> indices;
+    // Cooked albedo texture of the mesh's material, empty when it has none
+    eastl::string albedo_texture;
+    MeshHierarchy hierarchy;
 };
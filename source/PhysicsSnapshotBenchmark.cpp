@@ -0,0 +1,142 @@
+#include "PhysicsSnapshotBenchmark.hpp"
+
+#include <EASTL/vector.h>
+
+#include <cmath>
+
+#include "macros/log.hpp"
+
+#include "jobs/JobService.hpp"
+#include "physics/PhysicsManager.hpp"
+
+// Saves and restores timed per body count, the first one warms up the caches and is not measured
+static constexpr Uint32 cBenchmarkRoundCount = 17;
+// Steps simulated before measuring, so the boxes rest on the ground with contacts to save while still awake
+static constexpr int cBenchmarkSettleStepCount = 30;
+static constexpr int cDeterminismStepCount = 60;
+
+// Bodies are saved with their motion state and contacts, this leaves room for a few contacts each
+static constexpr size_t cSnapshotBytesPerBody = 1024;
+static constexpr size_t cSnapshotBaseSize = 1024 * 1024;
+
+static constexpr float cBoxSpacing = 2.0f;
+
+struct SnapshotTimes {
+    Uint64 mTotal = 0;
+    Uint64 mMax = 0;
+
+    void Add(Uint64 inTime) {
+        mTotal += inTime;
+        mMax = SDL_max(mMax, inTime);
+    }
+};
+
+static void LogTimes(const char *inName, const SnapshotTimes &inTimes, size_t inSize, Uint32 inBodyCount) {
+    double average_ms = static_cast<double>(inTimes.mTotal) / 1e6 / (cBenchmarkRoundCount - 1);
+
+    LOG_INFO("  %-14s %8.3f ms (max %.3f), %8.2f MB, %6.1f ns/body\n",
+        inName,
+        average_ms,
+        static_cast<double>(inTimes.mMax) / 1e6,
+        static_cast<double>(inSize) / (1024.0 * 1024.0),
+        average_ms * 1e6 / inBodyCount);
+}
+
+// Drop a square grid of boxes onto a static ground box, they land after a few steps
+static bool CreateBodies(PhysicsManager &ioPhysicsManager, Uint32 inBodyCount, eastl::vector<JPH::BodyID> &outBodyIDs) {
+    Uint32 columns = static_cast<Uint32>(std::ceil(std::sqrt(static_cast<float>(inBodyCount))));
+    float half_extent = static_cast<float>(columns) * cBoxSpacing * 0.5f + cBoxSpacing;
+
+    eastl::vector<JPH::BodyCreationSettings> settings;
+    settings.reserve(inBodyCount + 1);
+
+    settings.emplace_back(
+        ioPhysicsManager.GetShape(PhysicsShapeType::Box, JPH::Vec3(half_extent, 1.0f, half_extent)),
+        JPH::Vec3(0.0f, -1.0f, 0.0f),
+        JPH::Quat::sIdentity(),
+        JPH::EMotionType::Static,
+        Layers::NON_MOVING
+    );
+
+    JPH::ShapeRefC box_shape = ioPhysicsManager.GetShape(PhysicsShapeType::Box, JPH::Vec3(0.5f, 0.5f, 0.5f));
+    for (Uint32 i = 0; i < inBodyCount; i++) {
+        float x = (static_cast<float>(i % columns) - static_cast<float>(columns) * 0.5f) * cBoxSpacing;
+        float z = (static_cast<float>(i / columns) - static_cast<float>(columns) * 0.5f) * cBoxSpacing;
+
+        settings.emplace_back(box_shape, JPH::Vec3(x, 1.0f, z), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
+    }
+
+    outBodyIDs.resize(settings.size());
+    return ioPhysicsManager.CreateBodies(settings.data(), settings.size(), outBodyIDs.data());
+}
+
+static bool RunBodyCount(PhysicsManager &ioPhysicsManager, Uint32 inBodyCount) {
+    eastl::vector<JPH::BodyID> body_ids;
+    if (!CreateBodies(ioPhysicsManager, inBodyCount, body_ids)) {
+        return false;
+    }
+
+    ioPhysicsManager.OptimizeBroadPhase();
+    for (int i = 0; i < cBenchmarkSettleStepCount; i++) {
+        ioPhysicsManager.Update();
+    }
+
+    size_t capacity = cSnapshotBaseSize + inBodyCount * cSnapshotBytesPerBody;
+    PhysicsSnapshot full_snapshot(capacity);
+    PhysicsSnapshot delta_snapshot(capacity);
+
+    SnapshotTimes full_times;
+    SnapshotTimes delta_times;
+    SnapshotTimes restore_times;
+    bool is_successful = true;
+
+    for (Uint32 round = 0; round < cBenchmarkRoundCount && is_successful; round++) {
+        is_successful = ioPhysicsManager.SaveSnapshot(full_snapshot) &&
+            ioPhysicsManager.SaveSnapshot(delta_snapshot, true) &&
+            ioPhysicsManager.RestoreSnapshot(full_snapshot);
+
+        if (is_successful && round > 0) {
+            full_times.Add(full_snapshot.GetSaveTime());
+            delta_times.Add(delta_snapshot.GetSaveTime());
+            restore_times.Add(full_snapshot.GetRestoreTime());
+        }
+    }
+
+    if (is_successful) {
+        LOG_INFO("Physics snapshots of %u bodies, %zu active, %u rounds:\n", inBodyCount, ioPhysicsManager.GetActiveBodyCount(), cBenchmarkRoundCount - 1);
+        LogTimes("save full", full_times, full_snapshot.GetSize(), inBodyCount);
+        LogTimes("save delta", delta_times, delta_snapshot.GetSize(), inBodyCount);
+        LogTimes("restore full", restore_times, full_snapshot.GetSize(), inBodyCount);
+
+        // The snapshots are only scratch space from here on
+        is_successful = ioPhysicsManager.CheckDeterminism(full_snapshot, delta_snapshot, cDeterminismStepCount);
+        if (is_successful) {
+            LOG_INFO("  deterministic over %d steps\n", cDeterminismStepCount);
+        }
+    }
+
+    for (JPH::BodyID body_id : body_ids) {
+        ioPhysicsManager.DestroyBody(body_id);
+    }
+
+    return is_successful;
+}
+
+bool RunPhysicsSnapshotBenchmark(const Uint32 *inBodyCounts, size_t inCount) {
+    if (!JobService::Get().Initialize({})) {
+        return false;
+    }
+
+    bool is_successful = true;
+    for (size_t i = 0; i < inCount && is_successful; i++) {
+        // Every count gets a world of its own, so bodies and contacts of the last one don't carry over
+        PhysicsManager *physics_manager = new PhysicsManager();
+        is_successful = physics_manager->Initialize() && RunBodyCount(*physics_manager, inBodyCounts[i]);
+
+        physics_manager->Shutdown();
+        delete physics_manager;
+    }
+
+    JobService::Get().Shutdown();
+    return is_successful;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Fill a fresh physics world with every body count in turn and log how long full and delta snapshots take to save
+// and how long a full snapshot takes to restore, then check that the world simulates deterministically from a
+// restored snapshot. Starts the job service itself, so it runs before anything else is initialized.
+bool RunPhysicsSnapshotBenchmark(const Uint32 *inBodyCounts, size_t inCount);
@@ -0,0 +1,129 @@
+#include "RegistryBenchmark.hpp"
+
+#include <glm/glm.hpp>
+
+#include "macros/log.hpp"
+
+#include "ecs/Registry.hpp"
+#include "jobs/JobService.hpp"
+
+// Frames run per variant, the first one warms up the caches and is not measured
+static constexpr Uint32 cBenchmarkFrameCount = 21;
+static constexpr float cBenchmarkDeltaTime = 1.0f / 60.0f;
+
+struct BenchmarkPosition {
+    glm::vec3 mValue;
+};
+
+struct BenchmarkVelocity {
+    glm::vec3 mValue;
+};
+
+struct BenchmarkMass {
+    float mValue;
+};
+
+// Deterministic, so both registries get the same entities
+static Uint32 NextRandom(Uint32 &ioState) {
+    ioState ^= ioState << 13;
+    ioState ^= ioState >> 17;
+    ioState ^= ioState << 5;
+    return ioState;
+}
+
+static float NextRandomFloat(Uint32 &ioState) {
+    return static_cast<float>(NextRandom(ioState) >> 8) / static_cast<float>(1 << 24);
+}
+
+// Every third entity gets a mass as well, so the iteration crosses archetypes
+static void FillRegistry(Registry &ioRegistry, Uint32 inEntityCount) {
+    Uint32 random_state = 0x9e3779b9;
+
+    for (Uint32 i = 0; i < inEntityCount; i++) {
+        BenchmarkPosition position = { glm::vec3(NextRandomFloat(random_state), NextRandomFloat(random_state), NextRandomFloat(random_state)) };
+        BenchmarkVelocity velocity = { glm::vec3(NextRandomFloat(random_state), NextRandomFloat(random_state), NextRandomFloat(random_state)) - 0.5f };
+
+        if (i % 3 == 0) {
+            ioRegistry.Create(position, velocity, BenchmarkMass { 1.0f + NextRandomFloat(random_state) });
+        } else {
+            ioRegistry.Create(position, velocity);
+        }
+    }
+}
+
+static void LogTime(const char *inName, Uint64 inTotalTime, Uint64 inMaxTime, Uint64 inBaseTime, Uint32 inEntityCount) {
+    double frame_ms = static_cast<double>(inTotalTime) / 1e6 / (cBenchmarkFrameCount - 1);
+
+    LOG_INFO("  %-16s %8.3f ms/frame (max %.3f), %6.1f M entities/s, %.2fx ForEach\n",
+        inName,
+        frame_ms,
+        static_cast<double>(inMaxTime) / 1e6,
+        frame_ms > 0.0 ? static_cast<double>(inEntityCount) / frame_ms / 1e3 : 0.0,
+        inTotalTime > 0 ? static_cast<double>(inBaseTime) / static_cast<double>(inTotalTime) : 0.0);
+}
+
+bool RunRegistryBenchmark(Uint32 inEntityCount) {
+    if (inEntityCount == 0) {
+        return false;
+    }
+
+    if (!JobService::Get().Initialize({})) {
+        return false;
+    }
+
+    Registry serial_registry;
+    Registry parallel_registry;
+    FillRegistry(serial_registry, inEntityCount);
+    FillRegistry(parallel_registry, inEntityCount);
+
+    // A little damping and gravity, so the work per entity isn't just one add
+    auto integrate = [](Entity, BenchmarkPosition &ioPosition, BenchmarkVelocity &ioVelocity) {
+        ioVelocity.mValue *= 0.999f;
+        ioVelocity.mValue.y -= 9.81f * cBenchmarkDeltaTime;
+        ioPosition.mValue += ioVelocity.mValue * cBenchmarkDeltaTime;
+    };
+
+    Uint64 serial_time = 0;
+    Uint64 max_serial_time = 0;
+    Uint64 parallel_time = 0;
+    Uint64 max_parallel_time = 0;
+
+    for (Uint32 frame = 0; frame < cBenchmarkFrameCount; frame++) {
+        Uint64 start_time = SDL_GetTicksNS();
+        serial_registry.ForEach<BenchmarkPosition, BenchmarkVelocity>(integrate);
+        Uint64 frame_time = SDL_GetTicksNS() - start_time;
+
+        if (frame > 0) {
+            serial_time += frame_time;
+            max_serial_time = SDL_max(max_serial_time, frame_time);
+        }
+
+        start_time = SDL_GetTicksNS();
+        parallel_registry.ParallelForEach<BenchmarkPosition, BenchmarkVelocity>(JobService::Get(), integrate);
+        frame_time = SDL_GetTicksNS() - start_time;
+
+        if (frame > 0) {
+            parallel_time += frame_time;
+            max_parallel_time = SDL_max(max_parallel_time, frame_time);
+        }
+    }
+
+    // Entities were created in the same order, so the same handle refers to the same entity in both
+    bool is_successful = true;
+    serial_registry.ForEach<BenchmarkPosition>([&](Entity inEntity, BenchmarkPosition &inPosition) {
+        if (is_successful && parallel_registry.Get<BenchmarkPosition>(inEntity).mValue != inPosition.mValue) {
+            LOG_ERROR("Position of entity %u differs between ForEach and ParallelForEach\n", inEntity.mIndex);
+            is_successful = false;
+        }
+    });
+
+    if (is_successful) {
+        LOG_INFO("Registry of %u entities on %d threads, %u frames:\n", inEntityCount, JobService::Get().GetMaxConcurrency(), cBenchmarkFrameCount - 1);
+        LogTime("ForEach", serial_time, max_serial_time, serial_time, inEntityCount);
+        LogTime("ParallelForEach", parallel_time, max_parallel_time, serial_time, inEntityCount);
+    }
+
+    JobService::Get().Shutdown();
+
+    return is_successful;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Fill a registry with entities spread over a few archetypes and log how long it takes to integrate their positions
+// with ForEach and with ParallelForEach at the same work, checking that both end up with the same positions. Starts
+// the job service itself, so it runs before anything else is initialized.
+bool RunRegistryBenchmark(Uint32 inEntityCount);
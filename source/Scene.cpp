@@ -3,6 +3,8 @@
 #include "macros/log.hpp"
 
 #include <EASTL/vector.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,73 +12,657 @@
 
 #include "Context.hpp"
 #include "graphics/RenderService.hpp"
+#include "graphics/ShaderKey.hpp"
 #include "InputService.hpp"
 
+#include "graphics/uniforms/DrawIndices.hpp"
+#include "graphics/uniforms/InstanceData.hpp"
 #include "graphics/uniforms/Material.hpp"
-#include "graphics/uniforms/DirectionalLight.hpp"
-#include "graphics/uniforms/PointLight.hpp"
+#include "graphics/uniforms/SceneConstants.hpp"
+#include "graphics/uniforms/ViewConstants.hpp"
 
 #include "Transform.hpp"
+#include "ecs/Components.hpp"
+#include "memory/FrameAllocator.hpp"
 
-// Temp struct to just make things work
-struct FragmentUniform {
-    glm::vec4 camera_position;
-    //Material material;
-    DirectionalLight directional_light;
-    PointLight point_light[4];
-};
+#include <Jolt/Physics/Body/BodyLockMulti.h>
 
-static eastl::vector<JPH::Vec3> sBoxPositions = {
-    JPH::Vec3(0.0f, 0.0f, 0.0f),
-    JPH::Vec3(1.0f, 0.0f, 0.0f),
-    JPH::Vec3(0.0f, 1.0f, 0.0f),
-    JPH::Vec3(0.0f, -1.0f, 0.0f),
-    JPH::Vec3(0.0f, 0.0f, 1.0f),
-    JPH::Vec3(0.0f, 0.0f, -1.0f),
-    JPH::Vec3(0.55f, 5.0f, 0.0f),
+// A mesh to draw along with the shader variant it needs, its albedo texture and the indices pushed for it
+struct DrawItem {
+    MeshHandle *mMesh;
+    ShaderKey mKey;
+    TextureID mTexture;
+    DrawIndices mIndices;
 };
 
-static eastl::vector<glm::vec3> sLightPositions = {
-    glm::vec3(2.0f, 0.2f, 2.0f),
-    glm::vec3(-2.0f, 0.2f, 2.0f),
-    glm::vec3(2.0f, 0.2f, -2.0f),
-    glm::vec3(-2.0f, 0.2f, -2.0f)
-};
+// Draw the lit meshes into the overdraw counter and return how many fragments reached the fragment shader
+static Uint64 CountShadedFragments(
+    const ViewConstants &inViewConstants,
+    const eastl::vector<DrawItem, FrameAllocator> &inDraws,
+    bool inUsePrepass
+) {
+    RenderState *state = RenderService::Get().BeginOverdrawPass();
+    if (state == nullptr) {
+        return 0;
+    }
+
+    SDL_PushGPUVertexUniformData(state->mCommandBuffer, 0, &inViewConstants, sizeof(ViewConstants));
+
+    if (inUsePrepass) {
+        RenderService::Get().UsePipeline(state->mRenderPass, "overdraw_prepass");
+
+        for (const DrawItem &draw_item : inDraws) {
+            SDL_PushGPUVertexUniformData(state->mCommandBuffer, 1, &draw_item.mIndices, sizeof(DrawIndices));
+            RenderService::Get().DrawMesh(state->mRenderPass, draw_item.mMesh);
+        }
+    }
+
+    RenderService::Get().UsePipeline(state->mRenderPass, inUsePrepass ? "overdraw_equal" : "overdraw");
+
+    for (const DrawItem &draw_item : inDraws) {
+        SDL_PushGPUVertexUniformData(state->mCommandBuffer, 1, &draw_item.mIndices, sizeof(DrawIndices));
+        RenderService::Get().DrawMesh(state->mRenderPass, draw_item.mMesh);
+    }
+
+    return RenderService::Get().EndOverdrawPass(state);
+}
+
+static const char *cDefaultScenePath = "content/default.scene";
+
+// How far into the scene a pick ray reaches
+static constexpr float cPickDistance = 1000.0f;
+
+// Bodies are created and added to the broadphase in batches of this size while loading
+static const size_t cBodyBatchSize = 4096;
+
+// Whether any object lies outside the streaming radius around the origin, where a scene starts out being viewed
+static bool IsStreamedScene(const SceneFileView &inView, float inRadius) {
+    for (Uint32 i = 0; i < inView.mObjectCount; i++) {
+        const SceneFileObject &object = inView.mObjects[i];
+        if (object.mPosition[0] * object.mPosition[0] + object.mPosition[2] * object.mPosition[2] > inRadius * inRadius) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
 Scene::Scene() : mCamera(45.0f, 0.0f, -90.0f, 5.0f) {}
 
-void Scene::Initialize() {
+void Scene::SetBodyEntity(const JPH::BodyID &inBodyID, Entity inEntity) {
+    Uint32 index = inBodyID.GetIndex();
+    if (index >= mBodyEntities.size()) {
+        mBodyEntities.resize(index + 1);
+    }
+
+    mBodyEntities[index] = inEntity;
+}
+
+void Scene::SetStreamedEntity(StreamedBodyID inStreamedBody, Entity inEntity) {
+    if (inStreamedBody >= mStreamedEntities.size()) {
+        mStreamedEntities.resize(inStreamedBody + 1);
+    }
+
+    mStreamedEntities[inStreamedBody] = inEntity;
+}
+
+void Scene::SetEntityTransform(Entity inEntity, const JPH::Mat44 &inWorldTransform) {
+    // Both JPH::Mat44 and glm::mat4 are column-major, so the columns can be stored directly
+    // Bodies are rigid, so the normal matrix is simply the rotation part
+    TransformComponent &transform = mRegistry.Get<TransformComponent>(inEntity);
+    inWorldTransform.StoreFloat4x4(reinterpret_cast<JPH::Float4 *>(&transform.mModelMatrix));
+    inWorldTransform.GetRotation().StoreFloat4x4(reinterpret_cast<JPH::Float4 *>(&transform.mNormalMatrix));
+
+    if (mRegistry.Has<BoundsComponent>(inEntity)) {
+        mRegistry.Get<BoundsComponent>(inEntity).mCenter = glm::vec3(transform.mModelMatrix[3]);
+    }
+}
+
+void Scene::ExtractBodyTransforms(const JPH::BodyID *inBodies, const Entity *inEntities, size_t inCount) {
+    // Take the body locks once for the whole batch
+    JPH::BodyLockMultiRead lock(mPhysicsManager.GetBodyLockInterface(), inBodies, static_cast<int>(inCount));
+
+    for (size_t i = 0; i < inCount; i++) {
+        const JPH::Body *body = lock.GetBody(static_cast<int>(i));
+        if (body == nullptr) {
+            continue;
+        }
+
+        SetEntityTransform(inEntities[i], body->GetWorldTransform());
+    }
+}
+
+void Scene::ApplyStreamingEvents() {
+    // Removed bodies go first, their IDs may come back among the added ones
+    for (const StreamedBodyEvent &event : mPhysicsStreamer.GetRemovedBodies()) {
+        SetBodyEntity(event.mBodyID, Entity());
+    }
+
+    for (const StreamedBodyEvent &event : mPhysicsStreamer.GetAddedBodies()) {
+        SetBodyEntity(event.mBodyID, mStreamedEntities[event.mStreamedBody]);
+    }
+}
+
+void Scene::InitializePhysics() {
     mPhysicsManager.Initialize();
+    mPhysicsStreamer.Initialize(&mPhysicsManager);
+}
 
-    mCubeMesh = mContentManager.LoadMesh("content/1x1.glb");
-    mBallMesh = mContentManager.LoadMesh("content/ball.glb");
+void Scene::Prepare() {
+    mContentManager.ImportMesh("content/ball.glb");
 
-    mFloorID = mPhysicsManager.CreateBox(JPH::Vec3(0.0f, -2.0f, 0.0f), JPH::Vec3(100.0f, 0.1f, 100.0f));
-    mBallID = mPhysicsManager.CreateBall(JPH::Vec3(-5.0f, 0.0f, 0.0f), 0.5f);
+    if (!MapSceneFile(cDefaultScenePath)) {
+        LOG_ERROR("Unable to load scene: %s\n", cDefaultScenePath);
+        return;
+    }
 
-    for (const JPH::Vec3 &position : sBoxPositions) {
-        JPH::BodyID box_id = mPhysicsManager.CreateBox(position, JPH::Vec3(0.5f, 0.5f, 0.5f), true);
-        mPhysicsManager.GetBodyInterface().SetLinearVelocity(box_id, JPH::Vec3(0.0f, -1.0f, 0.0f));
-        mCubeBodies.push_back(box_id);
+    for (Uint32 i = 0; i < mSceneView.mMeshCount; i++) {
+        mContentManager.ImportMesh(mSceneView.mMeshes[i].mPath);
     }
 }
 
-void Scene::Shutdown() {
+void Scene::Initialize() {
+    MeshHandle *ball_mesh = mContentManager.LoadMesh("content/ball.glb");
+
+    // Balls are thrown every frame while the mouse is held, so recycle them through a pool
+    mBallPoolID = mPhysicsManager.CreateBallPool(0.5f, 4);
+    JPH::BodyID ball_id = mPhysicsManager.AcquireBody(
+        mBallPoolID,
+        JPH::Vec3(-5.0f, 0.0f, 0.0f),
+        JPH::Quat::sIdentity(),
+        JPH::Vec3::sZero(),
+        JPH::EActivation::DontActivate
+    );
+
+    mBallEntity = mRegistry.Create(
+        TransformComponent {},
+        MeshComponent { ball_mesh },
+        BodyComponent { ball_id },
+        BoundsComponent { glm::vec3(0.0f), 0.5f },
+        UnlitComponent {}
+    );
+    SetBodyEntity(ball_id, mBallEntity);
+
+    // The ball starts out asleep, so its transform is never reported as moved
+    ExtractBodyTransforms(&ball_id, &mBallEntity, 1);
+
+    if (mSceneFile.IsOpen()) {
+        InstantiateSceneFile(cDefaultScenePath);
+    }
+}
 
-    mPhysicsManager.DestroyBody(mFloorID);
-    mPhysicsManager.DestroyBody(mBallID);
+bool Scene::MapSceneFile(const char *inPath) {
+    Uint64 start_time = SDL_GetTicksNS();
+    mLoadStats = {};
 
-    for (const JPH::BodyID &body_id : mCubeBodies) {
-        mPhysicsManager.DestroyBody(body_id);
+    if (!mSceneFile.Open(inPath)) {
+        return false;
     }
 
-    mContentManager.UnloadMesh("content/1x1.glb");
-    mContentManager.UnloadMesh("content/ball.glb");
+    if (!ReadSceneFile(mSceneFile.GetData(), mSceneFile.GetSize(), mSceneView)) {
+        mSceneFile.Close();
+        return false;
+    }
+
+    mLoadStats.mFileSize = mSceneFile.GetSize();
+    mLoadStats.mMapTime = SDL_GetTicksNS() - start_time;
+
+    return true;
+}
+
+void Scene::InstantiateSceneFile(const char *inPath) {
+    Uint64 start_time = SDL_GetTicksNS();
+
+    Instantiate(mSceneView);
+    mSceneFile.Close();
+    mSceneView = {};
+
+    mLoadStats.mTotalTime = mLoadStats.mMapTime + (SDL_GetTicksNS() - start_time);
+
+    LOG_INFO(
+        "Loaded scene %s: %u objects, %u lights, %.2f MB in %.2f ms (map %.2f, meshes %.2f, bodies %.2f, entities %.2f, transforms %.2f)\n",
+        inPath,
+        mLoadStats.mObjectCount,
+        mLoadStats.mLightCount,
+        static_cast<double>(mLoadStats.mFileSize) / (1024.0 * 1024.0),
+        static_cast<double>(mLoadStats.mTotalTime) / 1e6,
+        static_cast<double>(mLoadStats.mMapTime) / 1e6,
+        static_cast<double>(mLoadStats.mMeshTime) / 1e6,
+        static_cast<double>(mLoadStats.mBodyTime) / 1e6,
+        static_cast<double>(mLoadStats.mEntityTime) / 1e6,
+        static_cast<double>(mLoadStats.mTransformTime) / 1e6
+    );
+}
+
+bool Scene::Load(const char *inPath) {
+    if (!MapSceneFile(inPath)) {
+        return false;
+    }
+
+    InstantiateSceneFile(inPath);
+    return true;
+}
+
+TransformNodeID Scene::CreateMeshNodes(const char *inPath, TransformNodeID inParent) {
+    const MeshHierarchy *hierarchy = mContentManager.GetMeshHierarchy(inPath);
+    if (hierarchy == nullptr || hierarchy->mesh_node == cInvalidMeshNode) {
+        return inParent;
+    }
+
+    // Parents come first, so their IDs are known by the time their children are added
+    eastl::vector<TransformNodeID> nodes;
+    nodes.reserve(hierarchy->nodes.size());
+    for (const MeshNode &node : hierarchy->nodes) {
+        TransformNodeID parent = node.parent == cInvalidMeshNode ? inParent : nodes[node.parent];
+        nodes.push_back(mTransforms.Create(parent, node.transform));
+    }
+
+    return nodes[hierarchy->mesh_node];
+}
+
+void Scene::Instantiate(const SceneFileView &inView) {
+    Uint64 mesh_start_time = SDL_GetTicksNS();
+
+    eastl::vector<MeshHandle *> meshes;
+    meshes.reserve(inView.mMeshCount);
+    for (Uint32 i = 0; i < inView.mMeshCount; i++) {
+        meshes.push_back(mContentManager.LoadMesh(inView.mMeshes[i].mPath));
+    }
+
+    // Materials go straight into the GPU material table, entities only keep their index
+    eastl::vector<MaterialID> materials;
+    materials.reserve(inView.mMaterialCount);
+    for (Uint32 i = 0; i < inView.mMaterialCount; i++) {
+        materials.push_back(RenderService::Get().CreateMaterial(inView.mMaterials[i]));
+    }
+
+    mLoadStats.mMeshTime = SDL_GetTicksNS() - mesh_start_time;
+
+    // Maps that reach past the streaming radius are streamed in cells around the camera, others are loaded whole
+    bool is_streamed = IsStreamedScene(inView, mPhysicsStreamer.GetSettings().mLoadRadius);
+
+    eastl::vector<JPH::BodyCreationSettings> body_settings;
+    eastl::vector<JPH::BodyID> body_ids;
+    eastl::vector<StreamedBodyID> streamed_ids;
+    eastl::vector<Entity> body_entities;
+    body_settings.reserve(cBodyBatchSize);
+    body_ids.resize(cBodyBatchSize);
+    streamed_ids.resize(cBodyBatchSize);
+    body_entities.reserve(cBodyBatchSize);
+
+    if (is_streamed) {
+        mStreamedEntities.reserve(mStreamedEntities.size() + inView.mObjectCount);
+    } else {
+        mBodyEntities.reserve(mBodyEntities.size() + inView.mObjectCount);
+    }
+
+    for (Uint32 batch_start = 0; batch_start < inView.mObjectCount; batch_start += cBodyBatchSize) {
+        Uint32 batch_count = static_cast<Uint32>(eastl::min<size_t>(cBodyBatchSize, inView.mObjectCount - batch_start));
+        const SceneFileObject *objects = inView.mObjects + batch_start;
+
+        Uint64 body_start_time = SDL_GetTicksNS();
+
+        body_settings.clear();
+        for (Uint32 i = 0; i < batch_count; i++) {
+            const SceneFileObject &object = objects[i];
+
+            PhysicsShapeType shape_type = object.mShapeType == SceneShapeType::Sphere ? PhysicsShapeType::Sphere : PhysicsShapeType::Box;
+            JPH::ShapeRefC shape = mPhysicsManager.GetShape(
+                shape_type,
+                JPH::Vec3(object.mShapeSize[0], object.mShapeSize[1], object.mShapeSize[2])
+            );
+
+            body_settings.emplace_back(
+                shape,
+                JPH::Vec3(object.mPosition[0], object.mPosition[1], object.mPosition[2]),
+                JPH::Quat(object.mRotation[0], object.mRotation[1], object.mRotation[2], object.mRotation[3]).Normalized(),
+                object.mIsDynamic ? JPH::EMotionType::Dynamic : JPH::EMotionType::Static,
+                object.mIsDynamic ? Layers::MOVING : Layers::NON_MOVING
+            );
+        }
+
+        if (is_streamed) {
+            // Streamed bodies are only registered here, they're created once their cell comes into range
+            for (Uint32 i = 0; i < batch_count; i++) {
+                streamed_ids[i] = mPhysicsStreamer.AddBody(body_settings[i]);
+            }
+        } else if (!mPhysicsManager.CreateBodies(body_settings.data(), batch_count, body_ids.data())) {
+            LOG_ERROR("Stopped loading scene after %u objects\n", batch_start);
+            break;
+        }
+
+        Uint64 entity_start_time = SDL_GetTicksNS();
+        mLoadStats.mBodyTime += entity_start_time - body_start_time;
+
+        body_entities.clear();
+        for (Uint32 i = 0; i < batch_count; i++) {
+            const SceneFileObject &object = objects[i];
+
+            MeshHandle *mesh = object.mMeshIndex < meshes.size() ? meshes[object.mMeshIndex] : nullptr;
+            float bounds_radius = object.mShapeType == SceneShapeType::Sphere ?
+                object.mShapeSize[0] :
+                glm::length(glm::vec3(object.mShapeSize[0], object.mShapeSize[1], object.mShapeSize[2]));
+
+            auto create_entity = [&](const auto &inBody) -> Entity {
+                if (mesh == nullptr) {
+                    // Objects without a mesh only exist in the physics world
+                    return mRegistry.Create(inBody);
+                }
+
+                if (object.mMaterialIndex < materials.size()) {
+                    return mRegistry.Create(
+                        TransformComponent {},
+                        MeshComponent { mesh },
+                        MaterialComponent { materials[object.mMaterialIndex] },
+                        inBody,
+                        BoundsComponent { glm::vec3(0.0f), bounds_radius }
+                    );
+                }
+
+                return mRegistry.Create(
+                    TransformComponent {},
+                    MeshComponent { mesh },
+                    UnlitComponent {},
+                    inBody,
+                    BoundsComponent { glm::vec3(0.0f), bounds_radius }
+                );
+            };
+
+            Entity entity;
+            if (is_streamed) {
+                entity = create_entity(StreamedBodyComponent { streamed_ids[i] });
+                SetStreamedEntity(streamed_ids[i], entity);
+            } else {
+                entity = create_entity(BodyComponent { body_ids[i] });
+                SetBodyEntity(body_ids[i], entity);
+            }
+
+            body_entities.push_back(entity);
+        }
+
+        Uint64 transform_start_time = SDL_GetTicksNS();
+        mLoadStats.mEntityTime += transform_start_time - entity_start_time;
+
+        if (is_streamed) {
+            // The bodies may not exist yet, so transforms come from the settings they'll be created with
+            for (Uint32 i = 0; i < batch_count; i++) {
+                if (mRegistry.Has<TransformComponent>(body_entities[i])) {
+                    const JPH::BodyCreationSettings &settings = body_settings[i];
+                    SetEntityTransform(body_entities[i], JPH::Mat44::sRotationTranslation(settings.mRotation, settings.mPosition));
+                }
+            }
+        } else {
+            // Static bodies never move, so every transform is extracted once up front
+            mMovedBodies.clear();
+            mMovedEntities.clear();
+            for (Uint32 i = 0; i < batch_count; i++) {
+                if (mRegistry.Has<TransformComponent>(body_entities[i])) {
+                    mMovedBodies.push_back(body_ids[i]);
+                    mMovedEntities.push_back(body_entities[i]);
+                }
+            }
+
+            if (!mMovedBodies.empty()) {
+                ExtractBodyTransforms(mMovedBodies.data(), mMovedEntities.data(), mMovedBodies.size());
+            }
+        }
+
+        mLoadStats.mTransformTime += SDL_GetTicksNS() - transform_start_time;
+        mLoadStats.mObjectCount += batch_count;
+    }
+
+    Uint64 entity_start_time = SDL_GetTicksNS();
+
+    for (Uint32 i = 0; i < inView.mLightCount; i++) {
+        const SceneFileLight &light = inView.mLights[i];
+        MeshHandle *mesh = light.mMeshIndex < meshes.size() ? meshes[light.mMeshIndex] : nullptr;
+
+        Transform light_transform;
+        light_transform.mPosition = glm::vec3(light.mPosition[0], light.mPosition[1], light.mPosition[2]);
+        light_transform.mScale = glm::vec3(light.mScale);
+
+        // The transform component follows the node from the next hierarchy update on
+        TransformNodeID light_node = mTransforms.Create(cInvalidTransformNode, light_transform);
+
+        if (mesh == nullptr) {
+            mRegistry.Create(
+                TransformComponent { light_transform.GetModelMatrix(), glm::mat4(1.0f) },
+                HierarchyComponent { light_node, light_node },
+                LightComponent {}
+            );
+        } else {
+            TransformNodeID mesh_node = CreateMeshNodes(inView.mMeshes[light.mMeshIndex].mPath, light_node);
+            mRegistry.Create(
+                TransformComponent { light_transform.GetModelMatrix(), glm::mat4(1.0f) },
+                HierarchyComponent { light_node, mesh_node },
+                MeshComponent { mesh },
+                BoundsComponent { light_transform.mPosition, light.mScale },
+                UnlitComponent {},
+                LightComponent {}
+            );
+        }
+    }
+
+    mLoadStats.mEntityTime += SDL_GetTicksNS() - entity_start_time;
+    mLoadStats.mLightCount = inView.mLightCount;
+
+    Uint64 body_start_time = SDL_GetTicksNS();
+
+    if (is_streamed) {
+        // The cells around the camera are loaded before the first step, so nothing falls through missing ground
+        glm::vec3 camera_position = mCamera.GetPosition();
+        JPH::Vec3 interest_point(camera_position.x, camera_position.y, camera_position.z);
+        mPhysicsStreamer.Prefetch(&interest_point, 1);
+        ApplyStreamingEvents();
+    }
+
+    // Bulk insertion leaves the broadphase tree unbalanced
+    mPhysicsManager.OptimizeBroadPhase();
+    mLoadStats.mBodyTime += SDL_GetTicksNS() - body_start_time;
+}
+
+bool Scene::Save(const char *inPath) {
+    eastl::vector<SceneFileMesh> meshes;
+    eastl::vector<MeshHandle *> mesh_handles;
+    eastl::vector<Material> materials;
+    eastl::vector<SceneFileObject> objects;
+    eastl::vector<SceneFileLight> lights;
+
+    auto find_mesh = [&](Entity inEntity) -> Uint32 {
+        if (!mRegistry.Has<MeshComponent>(inEntity)) {
+            return cSceneFileNone;
+        }
+
+        MeshHandle *mesh = mRegistry.Get<MeshComponent>(inEntity).mMesh;
+        for (size_t i = 0; i < mesh_handles.size(); i++) {
+            if (mesh_handles[i] == mesh) {
+                return static_cast<Uint32>(i);
+            }
+        }
+
+        const eastl::string *path = mContentManager.GetMeshPath(mesh);
+        if (path == nullptr || path->size() >= cSceneFileMeshPathLength) {
+            LOG_ERROR("Unable to save mesh reference, the mesh has no usable path\n");
+            return cSceneFileNone;
+        }
+
+        SceneFileMesh file_mesh = {};
+        SDL_strlcpy(file_mesh.mPath, path->c_str(), cSceneFileMeshPathLength);
+        meshes.push_back(file_mesh);
+        mesh_handles.push_back(mesh);
+
+        return static_cast<Uint32>(meshes.size() - 1);
+    };
+
+    auto find_material = [&](Entity inEntity) -> Uint32 {
+        if (!mRegistry.Has<MaterialComponent>(inEntity)) {
+            return cSceneFileNone;
+        }
+
+        const Material &material = RenderService::Get().GetMaterial(mRegistry.Get<MaterialComponent>(inEntity).mMaterialID);
+        for (size_t i = 0; i < materials.size(); i++) {
+            if (SDL_memcmp(&materials[i], &material, sizeof(Material)) == 0) {
+                return static_cast<Uint32>(i);
+            }
+        }
+
+        materials.push_back(material);
+        return static_cast<Uint32>(materials.size() - 1);
+    };
+
+    auto add_object = [&](Entity inEntity, const JPH::Shape *inShape, JPH::Vec3Arg inPosition, JPH::QuatArg inRotation, bool inIsDynamic) {
+        SceneFileObject object = {};
+
+        if (inShape->GetSubType() == JPH::EShapeSubType::Box) {
+            JPH::Vec3 half_extent = static_cast<const JPH::BoxShape *>(inShape)->GetHalfExtent();
+            object.mShapeType = SceneShapeType::Box;
+            object.mShapeSize[0] = half_extent.GetX();
+            object.mShapeSize[1] = half_extent.GetY();
+            object.mShapeSize[2] = half_extent.GetZ();
+        } else if (inShape->GetSubType() == JPH::EShapeSubType::Sphere) {
+            object.mShapeType = SceneShapeType::Sphere;
+            object.mShapeSize[0] = static_cast<const JPH::SphereShape *>(inShape)->GetRadius();
+        } else {
+            LOG_ERROR("Skipping body with an unsupported shape while saving\n");
+            return;
+        }
+
+        object.mPosition[0] = inPosition.GetX();
+        object.mPosition[1] = inPosition.GetY();
+        object.mPosition[2] = inPosition.GetZ();
+        object.mRotation[0] = inRotation.GetX();
+        object.mRotation[1] = inRotation.GetY();
+        object.mRotation[2] = inRotation.GetZ();
+        object.mRotation[3] = inRotation.GetW();
+        object.mIsDynamic = inIsDynamic ? 1 : 0;
+        object.mMeshIndex = find_mesh(inEntity);
+        object.mMaterialIndex = find_material(inEntity);
+
+        objects.push_back(object);
+    };
+
+    // The thrown ball is gameplay state, not part of the scene
+    mMovedBodies.clear();
+    mMovedEntities.clear();
+    mRegistry.ForEach<BodyComponent>([&](Entity inEntity, BodyComponent &inBody) {
+        if (inEntity != mBallEntity) {
+            mMovedBodies.push_back(inBody.mBodyID);
+            mMovedEntities.push_back(inEntity);
+        }
+    });
+
+    // Streamed bodies that are loaded are saved like any other, the rest as they were left when unloaded
+    mRegistry.ForEach<StreamedBodyComponent>([&](Entity inEntity, StreamedBodyComponent &inBody) {
+        JPH::BodyID body_id = mPhysicsStreamer.GetBodyID(inBody.mStreamedBody);
+        if (!body_id.IsInvalid()) {
+            mMovedBodies.push_back(body_id);
+            mMovedEntities.push_back(inEntity);
+            return;
+        }
+
+        const JPH::BodyCreationSettings &settings = mPhysicsStreamer.GetBodySettings(inBody.mStreamedBody);
+        add_object(inEntity, settings.GetShape(), settings.mPosition, settings.mRotation, settings.mMotionType == JPH::EMotionType::Dynamic);
+    });
+
+    objects.reserve(objects.size() + mMovedBodies.size());
+
+    {
+        JPH::BodyLockMultiRead lock(mPhysicsManager.GetBodyLockInterface(), mMovedBodies.data(), static_cast<int>(mMovedBodies.size()));
+
+        for (size_t i = 0; i < mMovedBodies.size(); i++) {
+            const JPH::Body *body = lock.GetBody(static_cast<int>(i));
+            if (body != nullptr) {
+                add_object(mMovedEntities[i], body->GetShape(), body->GetPosition(), body->GetRotation(), body->IsDynamic());
+            }
+        }
+    }
+
+    // Lights are saved as they were placed, without the node hierarchy of their model
+    mRegistry.ForEach<HierarchyComponent, LightComponent>([&](Entity inEntity, HierarchyComponent &inHierarchy, LightComponent &) {
+        Transform transform = mTransforms.GetLocalTransform(inHierarchy.mRoot);
+
+        SceneFileLight light = {};
+        light.mPosition[0] = transform.mPosition.x;
+        light.mPosition[1] = transform.mPosition.y;
+        light.mPosition[2] = transform.mPosition.z;
+        light.mScale = transform.mScale.x;
+        light.mMeshIndex = find_mesh(inEntity);
+
+        lights.push_back(light);
+    });
+
+    SceneFileView view;
+    view.mMeshes = meshes.data();
+    view.mMeshCount = static_cast<Uint32>(meshes.size());
+    view.mMaterials = materials.data();
+    view.mMaterialCount = static_cast<Uint32>(materials.size());
+    view.mObjects = objects.data();
+    view.mObjectCount = static_cast<Uint32>(objects.size());
+    view.mLights = lights.data();
+    view.mLightCount = static_cast<Uint32>(lights.size());
+
+    return WriteSceneFile(inPath, view);
+}
+
+void Scene::Shutdown() {
+    mPhysicsManager.ReleaseBody(mBallPoolID, mRegistry.Get<BodyComponent>(mBallEntity).mBodyID);
+    mRegistry.Destroy(mBallEntity);
+
+    // Streamed entities don't own a body, the streamer destroys whatever it has loaded
+    mPhysicsStreamer.Shutdown();
+
+    mRegistry.ForEach<BodyComponent>([&](Entity, BodyComponent &inBody) {
+        mPhysicsManager.DestroyBody(inBody.mBodyID);
+    });
+
+    mRegistry.Clear();
+    mTransforms.Clear();
+    mBodyEntities.clear();
+    mStreamedEntities.clear();
+
+    mContentManager.Unload();
+    RenderService::Get().ClearMaterials();
 
     mPhysicsManager.Shutdown();
 }
 
 void Scene::Update() {
+    UpdateInput();
+    UpdateStreaming();
+    UpdatePhysics();
+    UpdateTransforms();
+}
+
+Entity Scene::Pick(float inX, float inY, glm::vec3 *outPosition) {
+    // The throw direction points out of the screen, the pick ray goes the other way
+    glm::vec3 origin = mCamera.GetPosition();
+    glm::vec3 direction = -mCamera.GetThrowDirection(
+        inX, inY,
+        static_cast<float>(Context::Get().GetWindowWidth()),
+        static_cast<float>(Context::Get().GetWindowHeight())
+    ) * cPickDistance;
+
+    RayQuery query = {
+        JPH::Vec3(origin.x, origin.y, origin.z),
+        JPH::Vec3(direction.x, direction.y, direction.z)
+    };
+
+    RayHit hit;
+    mPhysicsManager.CastRays(&query, 1, &hit);
+
+    Uint32 index = hit.mBodyID.IsInvalid() ? 0xffffffff : hit.mBodyID.GetIndex();
+    if (index >= mBodyEntities.size()) {
+        return Entity();
+    }
+
+    if (outPosition != nullptr) {
+        *outPosition = origin + direction * hit.mFraction;
+    }
+
+    return mBodyEntities[index];
+}
+
+void Scene::UpdateInput() {
     if (Context::Get().IsWindowResized()) {
         mCamera.SetAspectRatio(
             static_cast<float>(Context::Get().GetWindowWidth()),
@@ -106,28 +692,204 @@ void Scene::Update() {
         // Invert the throw direction
         throw_direction = -throw_direction;
 
-        // Spawn a box at the camera position
-        mPhysicsManager.DestroyBody(mBallID);
-        mBallID = mPhysicsManager.CreateBall(JPH::Vec3(camera_position.x, camera_position.y, camera_position.z), 0.5f);
+        // Recycle the ball at the camera position and throw it towards the blocks
+        BodyComponent &ball_body = mRegistry.Get<BodyComponent>(mBallEntity);
+        SetBodyEntity(ball_body.mBodyID, Entity());
+        mPhysicsManager.ReleaseBody(mBallPoolID, ball_body.mBodyID);
 
-        // Throw the ball towards the blocks
-        mPhysicsManager.GetBodyInterface().AddLinearVelocity(mBallID, JPH::Vec3(throw_direction.x * 20.0f, throw_direction.y * 20.0f, throw_direction.z * 20.0f));
+        ball_body.mBodyID = mPhysicsManager.AcquireBody(
+            mBallPoolID,
+            JPH::Vec3(camera_position.x, camera_position.y, camera_position.z),
+            JPH::Quat::sIdentity(),
+            JPH::Vec3(throw_direction.x * 20.0f, throw_direction.y * 20.0f, throw_direction.z * 20.0f)
+        );
+        SetBodyEntity(ball_body.mBodyID, mBallEntity);
     }
+}
+
+void Scene::UpdateStreaming() {
+    // The thrown ball keeps the ground under it loaded too
+    glm::vec3 camera_position = mCamera.GetPosition();
+    JPH::Vec3 interest_points[2] = {
+        JPH::Vec3(camera_position.x, camera_position.y, camera_position.z),
+        mPhysicsManager.GetBodyInterface().GetPosition(mRegistry.Get<BodyComponent>(mBallEntity).mBodyID)
+    };
+
+    mPhysicsStreamer.Update(interest_points, 2);
+    ApplyStreamingEvents();
+}
 
+void Scene::UpdatePhysics() {
     mPhysicsManager.Update();
 }
 
+void Scene::UpdateTransforms() {
+    Uint64 start_time = SDL_GetTicksNS();
+
+    // Only bodies that were active during this step need new matrices
+    mMovedBodies.clear();
+    mMovedEntities.clear();
+
+    for (const JPH::BodyID &body_id : mPhysicsManager.GetMovedBodies()) {
+        Uint32 index = body_id.GetIndex();
+        if (index >= mBodyEntities.size() || !mRegistry.Has<TransformComponent>(mBodyEntities[index])) {
+            continue;
+        }
+
+        mMovedBodies.push_back(body_id);
+        mMovedEntities.push_back(mBodyEntities[index]);
+    }
+
+    Uint64 body_start_time = SDL_GetTicksNS();
+    if (!mMovedBodies.empty()) {
+        ExtractBodyTransforms(mMovedBodies.data(), mMovedEntities.data(), mMovedBodies.size());
+    }
+
+    Uint64 hierarchy_start_time = SDL_GetTicksNS();
+    mTransformStats.mBodyCount = static_cast<Uint32>(mMovedBodies.size());
+    mTransformStats.mBodyTime = hierarchy_start_time - body_start_time;
+
+    // Entities only need new matrices when their node or one above it changed
+    mTransforms.Update();
+    if (mTransforms.GetUpdatedCount() > 0) {
+        mRegistry.ForEach<TransformComponent, HierarchyComponent>([&](
+            Entity inEntity,
+            TransformComponent &inTransform,
+            HierarchyComponent &inHierarchy
+        ) {
+            if (!mTransforms.HasWorldChanged(inHierarchy.mNode)) {
+                return;
+            }
+
+            const glm::mat4 &world_matrix = mTransforms.GetWorldMatrix(inHierarchy.mNode);
+            inTransform.mModelMatrix = world_matrix;
+            inTransform.mNormalMatrix = Transform::ComposeNormalMatrix(world_matrix);
+
+            if (mRegistry.Has<BoundsComponent>(inEntity)) {
+                mRegistry.Get<BoundsComponent>(inEntity).mCenter = glm::vec3(world_matrix[3]);
+            }
+        });
+    }
+
+    Uint64 end_time = SDL_GetTicksNS();
+    mTransformStats.mNodeCount = mTransforms.GetUpdatedCount();
+    mTransformStats.mHierarchyTime = end_time - hierarchy_start_time;
+    mTransformStats.mTotalTime = end_time - start_time;
+}
+
+void Scene::LogTransformStats() const {
+    const TransformUpdateStats &stats = mTransformStats;
+    LOG_INFO("Transforms: %u bodies in %.3f ms (%.1f ns per body), %u hierarchy nodes in %.3f ms, %.3f ms in total\n",
+        stats.mBodyCount,
+        static_cast<double>(stats.mBodyTime) / 1e6,
+        stats.mBodyCount > 0 ? static_cast<double>(stats.mBodyTime) / static_cast<double>(stats.mBodyCount) : 0.0,
+        stats.mNodeCount,
+        static_cast<double>(stats.mHierarchyTime) / 1e6,
+        static_cast<double>(stats.mTotalTime) / 1e6);
+}
+
 void Scene::Draw() {
+    // The shader has a fixed number of point lights, so only the first ones are used
+    glm::vec3 light_positions[4] = {};
+    size_t light_count = 0;
+    mRegistry.ForEach<HierarchyComponent, LightComponent>([&](Entity, HierarchyComponent &inHierarchy, LightComponent &) {
+        if (light_count < 4) {
+            light_positions[light_count++] = glm::vec3(mTransforms.GetWorldMatrix(inHierarchy.mRoot)[3]);
+        }
+    });
 
-    RenderState *state = RenderService::Get().BeginPass();
+    // Materials without a specular color use the cheaper Lambert variant
+    auto get_shader_key = [&](MaterialID inMaterialID, bool inHasTexture) {
+        const Material &material = RenderService::Get().GetMaterial(inMaterialID);
+        bool is_lambert = material.specular.r == 0.0f && material.specular.g == 0.0f && material.specular.b == 0.0f;
+        return MakeLitShaderKey(static_cast<Uint32>(light_count), is_lambert, inHasTexture);
+    };
+
+    // Textures ask for the mip that matches the size of their mesh on screen, assuming the texture covers the mesh
+    // once. The bounding sphere's projected diameter stands in for the mesh's size.
+    TextureStreamer &texture_streamer = RenderService::Get().GetTextureStreamer();
+    glm::vec3 camera_position = mCamera.GetPosition();
+    float pixels_per_unit = mCamera.GetProjectionMatrix()[1][1] * static_cast<float>(Context::Get().GetWindowHeight());
+
+    auto request_texture = [&](Entity inEntity, TextureID inTexture, const TransformComponent &inTransform) {
+        // Without bounds, or with the camera inside them, the finest mip is requested
+        float pixels = static_cast<float>(SDL_MAX_UINT32);
+        if (mRegistry.Has<BoundsComponent>(inEntity)) {
+            const BoundsComponent &bounds = mRegistry.Get<BoundsComponent>(inEntity);
+            float distance = glm::length(glm::vec3(inTransform.mModelMatrix[3]) - camera_position);
+            if (distance > bounds.mRadius) {
+                pixels = bounds.mRadius * pixels_per_unit / distance;
+            }
+        }
+
+        texture_streamer.RequestScreenSize(inTexture, pixels);
+    };
+
+    // Every drawn entity goes into one instance array, so a draw only needs to push two indices
+    eastl::vector<InstanceData, FrameAllocator> instances;
+    eastl::vector<DrawItem, FrameAllocator> lit_draws;
+    eastl::vector<DrawItem, FrameAllocator> unlit_draws;
+
+    // Sized for every entity up front, so growing doesn't leave the outgrown buffers behind in the frame arena
+    size_t entity_count = mRegistry.GetEntityCount();
+    instances.reserve(entity_count);
+    lit_draws.reserve(entity_count);
+    unlit_draws.reserve(entity_count);
+
+    mRegistry.ForEach<TransformComponent, MeshComponent, MaterialComponent>([&](
+        Entity inEntity,
+        TransformComponent &inTransform,
+        MeshComponent &inMesh,
+        MaterialComponent &inMaterial
+    ) {
+        TextureID texture = inMesh.mMesh->mAlbedoTexture;
+        if (texture != cInvalidTexture) {
+            request_texture(inEntity, texture, inTransform);
+        }
+
+        DrawIndices indices = { static_cast<Uint32>(instances.size()), inMaterial.mMaterialID, 0, 0 };
+        instances.push_back({ inTransform.mModelMatrix, inTransform.mNormalMatrix });
+        lit_draws.push_back({ inMesh.mMesh, get_shader_key(inMaterial.mMaterialID, texture != cInvalidTexture), texture, indices });
+    });
+
+    mRegistry.ForEach<TransformComponent, MeshComponent, UnlitComponent>([&](
+        Entity,
+        TransformComponent &inTransform,
+        MeshComponent &inMesh,
+        UnlitComponent &
+    ) {
+        DrawIndices indices = { static_cast<Uint32>(instances.size()), 0, 0, 0 };
+        instances.push_back({ inTransform.mModelMatrix, inTransform.mNormalMatrix });
+        unlit_draws.push_back({ inMesh.mMesh, 0, cInvalidTexture, indices });
+    });
+
+    // Group draws by variant so each pipeline is bound once, and by texture within a variant
+    eastl::sort(lit_draws.begin(), lit_draws.end(), [](const DrawItem &inA, const DrawItem &inB) {
+        return inA.mKey != inB.mKey ? inA.mKey < inB.mKey : inA.mTexture < inB.mTexture;
+    });
+
+    // The first frame that draws a variant builds its pipelines
+    for (size_t i = 0; i < lit_draws.size(); i++) {
+        if (i == 0 || lit_draws[i].mKey != lit_draws[i - 1].mKey) {
+            RenderService::Get().PrepareLitPipelines(lit_draws[i].mKey);
+        }
+    }
+
+    RenderService::Get().SetInstances(instances.data(), static_cast<Uint32>(instances.size()));
+
+    RenderState *state = RenderService::Get().BeginFrame();
     if (state == nullptr) {
-        LOG_ERROR("Unable to begin render pass");
+        LOG_ERROR("Unable to begin frame");
         return;
     }
 
-    RenderService::Get().UsePipeline(state->mRenderPass, "default_mesh");
+    // Per-view constants are pushed once and used by every draw in the pass
+    ViewConstants view_constants = {
+        mCamera.GetProjectionMatrix(),
+        mCamera.GetViewMatrix()
+    };
 
-    FragmentUniform fragment_uniform = {
+    SceneConstants scene_constants = {
         glm::vec4(mCamera.GetPosition(), 1.0f),
         {
             glm::vec4(-0.2f, -1.0f, -0.3f, 1.0f),
@@ -137,7 +899,7 @@ void Scene::Draw() {
         },
         {
             {
-                glm::vec4(sLightPositions[0], 1.0f),
+                glm::vec4(light_positions[0], 1.0f),
                 1.0f,
                 0.09f,
                 0.032f,
@@ -147,7 +909,7 @@ void Scene::Draw() {
                 glm::vec4(0.7f, 0.7f, 0.7f, 1.0f)
             },
             {
-                glm::vec4(sLightPositions[1], 1.0f),
+                glm::vec4(light_positions[1], 1.0f),
                 1.0f,
                 0.09f,
                 0.032f,
@@ -157,7 +919,7 @@ void Scene::Draw() {
                 glm::vec4(0.7f, 0.7f, 0.7f, 1.0f)
             },
             {
-                glm::vec4(sLightPositions[2], 1.0f),
+                glm::vec4(light_positions[2], 1.0f),
                 1.0f,
                 0.09f,
                 0.032f,
@@ -167,7 +929,7 @@ void Scene::Draw() {
                 glm::vec4(0.7f, 0.7f, 0.7f, 1.0f)
             },
             {
-                glm::vec4(sLightPositions[3], 1.0f),
+                glm::vec4(light_positions[3], 1.0f),
                 1.0f,
                 0.09f,
                 0.032f,
@@ -179,61 +941,63 @@ void Scene::Draw() {
         }
     };
 
-    SDL_PushGPUFragmentUniformData(state->mCommandBuffer, 0, &fragment_uniform, sizeof(FragmentUniform));
+    SDL_PushGPUVertexUniformData(state->mCommandBuffer, 0, &view_constants, sizeof(ViewConstants));
+    SDL_PushGPUFragmentUniformData(state->mCommandBuffer, 0, &scene_constants, sizeof(SceneConstants));
 
-    JPH::BodyInterface &body_interface = mPhysicsManager.GetBodyInterface();
+    // The scene pass records when the frame's render graph executes in EndFrame
+    RenderService::Get().AddScenePass(state, [&](RenderState *inState) {
+        // The pre-pass lays down the closest depth, so the lit shaders below run once per pixel instead of once per layer
+        bool is_prepass_enabled = RenderService::Get().IsDepthPrepassEnabled();
+        if (is_prepass_enabled) {
+            RenderService::Get().UsePipeline(inState->mRenderPass, "depth_prepass");
 
-    for (const JPH::BodyID &body_id : mCubeBodies) {
-        Transform model_transform = Transform::FromBody(body_interface, body_id);
+            for (const DrawItem &draw_item : lit_draws) {
+                SDL_PushGPUVertexUniformData(inState->mCommandBuffer, 1, &draw_item.mIndices, sizeof(DrawIndices));
+                RenderService::Get().DrawMesh(inState->mRenderPass, draw_item.mMesh);
+            }
+        }
 
-        glm::mat4 model_matrix = model_transform.GetModelMatrix();
-        glm::mat4 model_inverse_transpose = glm::transpose(glm::inverse(model_matrix));
+        // Draw lit meshes
+        const char *lit_pipeline = is_prepass_enabled ? "default_mesh_equal" : "default_mesh";
 
-        glm::mat4 vertex_uniform[4] = {
-            mCamera.GetProjectionMatrix(),
-            mCamera.GetViewMatrix(),
-            model_matrix,
-            model_inverse_transpose,
-        };
+        for (size_t i = 0; i < lit_draws.size(); i++) {
+            const DrawItem &draw_item = lit_draws[i];
+            bool is_new_pipeline = i == 0 || draw_item.mKey != lit_draws[i - 1].mKey;
+            if (is_new_pipeline) {
+                RenderService::Get().UsePipeline(inState->mRenderPass, lit_pipeline, draw_item.mKey);
+            }
 
-        Material material = {
-            glm::vec4(1.0f, 0.5f, 0.31f, 0.0f),
-            glm::vec4(1.0f, 0.5f, 0.31f, 0.0f),
-            glm::vec4(0.5f, 0.5f, 0.5f, 0.0f),
-            glm::vec4(8.0f)
-        };
+            if (draw_item.mTexture != cInvalidTexture && (is_new_pipeline || draw_item.mTexture != lit_draws[i - 1].mTexture)) {
+                RenderService::Get().BindTexture(inState->mRenderPass, draw_item.mTexture);
+            }
 
-        SDL_PushGPUVertexUniformData(state->mCommandBuffer, 0, &vertex_uniform, sizeof(glm::mat4) * 4);
-        SDL_PushGPUFragmentUniformData(state->mCommandBuffer, 1, &material, sizeof(Material));
+            SDL_PushGPUVertexUniformData(inState->mCommandBuffer, 1, &draw_item.mIndices, sizeof(DrawIndices));
+            RenderService::Get().DrawMesh(inState->mRenderPass, draw_item.mMesh);
+        }
 
-        RenderService::Get().DrawMesh(state->mRenderPass, mCubeMesh);
-    }
+        // Draw unlit meshes, such as the light sources
+        RenderService::Get().UsePipeline(inState->mRenderPass, "light_source");
 
-    // Draw light sources
-    RenderService::Get().UsePipeline(state->mRenderPass, "light_source");
+        for (const DrawItem &draw_item : unlit_draws) {
+            SDL_PushGPUVertexUniformData(inState->mCommandBuffer, 1, &draw_item.mIndices, sizeof(DrawIndices));
+            RenderService::Get().DrawMesh(inState->mRenderPass, draw_item.mMesh);
+        }
+    });
 
-    for (const glm::vec3 &light_position : sLightPositions) {
+    RenderService::Get().EndFrame(state);
 
-        Transform model_transform;
-        model_transform.mPosition = light_position;
-        model_transform.mScale = glm::vec3(0.2f);
+    if (mIsOverdrawRequested) {
+        mIsOverdrawRequested = false;
 
-        glm::mat4 model_matrix = model_transform.GetModelMatrix();
-        glm::mat4 mvp = mCamera.GetProjectionMatrix() * mCamera.GetViewMatrix() * model_matrix;
+        mOverdrawStats.mShadedWithoutPrepass = CountShadedFragments(view_constants, lit_draws, false);
+        mOverdrawStats.mShadedWithPrepass = CountShadedFragments(view_constants, lit_draws, true);
+        mOverdrawStats.mOverdraw = mOverdrawStats.mShadedWithPrepass > 0 ?
+            static_cast<float>(mOverdrawStats.mShadedWithoutPrepass) / static_cast<float>(mOverdrawStats.mShadedWithPrepass) :
+            0.0f;
 
-        SDL_PushGPUVertexUniformData(state->mCommandBuffer, 0, &mvp, sizeof(glm::mat4));
-        RenderService::Get().DrawMesh(state->mRenderPass, mCubeMesh);
+        LOG_INFO("Overdraw: %llu fragments shaded without depth pre-pass, %llu with it (%.2fx)\n",
+            static_cast<unsigned long long>(mOverdrawStats.mShadedWithoutPrepass),
+            static_cast<unsigned long long>(mOverdrawStats.mShadedWithPrepass),
+            mOverdrawStats.mOverdraw);
     }
-
-    Transform ball_transform = Transform::FromBody(body_interface, mBallID);
-    glm::mat4 ball_model_matrix = ball_transform.GetModelMatrix();
-
-    glm::mat4 mvp = mCamera.GetProjectionMatrix() * mCamera.GetViewMatrix() * ball_model_matrix;
-
-    SDL_PushGPUVertexUniformData(state->mCommandBuffer, 0, &mvp, sizeof(glm::mat4));
-    RenderService::Get().DrawMesh(state->mRenderPass, mBallMesh);
-
-    RenderService::Get().EndPass(state);
-
-    SDL_SubmitGPUCommandBuffer(state->mCommandBuffer);
 }
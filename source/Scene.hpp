@@ -4,28 +4,145 @@
 
 #include "Camera.hpp"
 #include "ContentManager.hpp"
+#include "SceneFile.hpp"
+#include "TransformHierarchy.hpp"
+#include "ecs/Registry.hpp"
+#include "io/MappedFile.hpp"
 #include "physics/PhysicsManager.hpp"
+#include "physics/PhysicsStreamer.hpp"
+
+// Where the time went while loading a scene, in nanoseconds
+struct SceneLoadStats {
+    Uint32 mObjectCount;
+    Uint32 mLightCount;
+    size_t mFileSize;
+    Uint64 mMapTime;
+    Uint64 mMeshTime;
+    Uint64 mBodyTime;
+    Uint64 mEntityTime;
+    Uint64 mTransformTime;
+    Uint64 mTotalTime;
+};
+
+// Where the time of the last transform update went, in nanoseconds
+struct TransformUpdateStats {
+    // Bodies that moved during the step and had their world transforms extracted
+    Uint32 mBodyCount;
+    Uint64 mBodyTime;
+    // Hierarchy nodes whose world matrix changed and the entities that were given it
+    Uint32 mNodeCount;
+    Uint64 mHierarchyTime;
+    Uint64 mTotalTime;
+};
+
+// Fragments that reached the lit shaders with and without the depth pre-pass, measured on request
+struct OverdrawStats {
+    Uint64 mShadedWithoutPrepass;
+    Uint64 mShadedWithPrepass;
+    // Fragments shaded per visible fragment without the pre-pass, the work the pre-pass saves
+    float mOverdraw;
+};
 
 class Scene {
 private:
     Camera mCamera;
     ContentManager mContentManager;
     PhysicsManager mPhysicsManager;
+    PhysicsStreamer mPhysicsStreamer;
+    Registry mRegistry;
+    // Entities without a body, such as lights, and the node hierarchies of their models
+    TransformHierarchy mTransforms;
+
+    Entity mBallEntity;
+    BodyPoolID mBallPoolID;
+
+    // Entity that owns each body, indexed by body index
+    eastl::vector<Entity> mBodyEntities;
+    // Entity of each streamed body, indexed by streamed body ID
+    eastl::vector<Entity> mStreamedEntities;
+
+    // Scratch buffers for the transform update, kept around to avoid allocating every frame
+    eastl::vector<JPH::BodyID> mMovedBodies;
+    eastl::vector<Entity> mMovedEntities;
+
+    TransformUpdateStats mTransformStats = {};
+
+    SceneLoadStats mLoadStats = {};
 
-    MeshHandle *mCubeMesh;
-    MeshHandle *mBallMesh;
+    OverdrawStats mOverdrawStats = {};
+    bool mIsOverdrawRequested = false;
 
-    JPH::BodyID mFloorID;
-    JPH::BodyID mBallID;
+    // Scene file mapped by Prepare, instantiated by Initialize
+    MappedFile mSceneFile;
+    SceneFileView mSceneView;
 
-    eastl::vector<JPH::BodyID> mCubeBodies;
+    void SetBodyEntity(const JPH::BodyID &inBodyID, Entity inEntity);
+    void SetStreamedEntity(StreamedBodyID inStreamedBody, Entity inEntity);
+    void SetEntityTransform(Entity inEntity, const JPH::Mat44 &inWorldTransform);
+    void ExtractBodyTransforms(const JPH::BodyID *inBodies, const Entity *inEntities, size_t inCount);
+    // Add the node hierarchy of a loaded mesh below a node, returns the node the mesh is drawn with
+    TransformNodeID CreateMeshNodes(const char *inPath, TransformNodeID inParent);
+    void Instantiate(const SceneFileView &inView);
+    bool MapSceneFile(const char *inPath);
+    void InstantiateSceneFile(const char *inPath);
+    // Point the body lookup at the entities of the bodies the streamer added and removed
+    void ApplyStreamingEvents();
 
 public:
     Scene();
 
+    // Startup is split so the parts run as separate tasks. Physics and Prepare don't touch the GPU and can overlap
+    // with device creation, Initialize needs both of them and the device to be done.
+    void InitializePhysics();
+    void Prepare();
     void Initialize();
     void Shutdown();
 
+    // Add the contents of a scene file to the scene
+    bool Load(const char *inPath);
+    // Write the current scene to a file, the thrown ball is left out
+    bool Save(const char *inPath);
+
+    // Find the entity under a point in the window, the hit position is optional. Returns an invalid entity when
+    // nothing with a body is under the point within the pick distance.
+    Entity Pick(float inX, float inY, glm::vec3 *outPosition = nullptr);
+
     void Update();
+    void UpdateInput();
+    void UpdateStreaming();
+    void UpdatePhysics();
+    void UpdateTransforms();
     void Draw();
+
+    inline PhysicsManager &GetPhysicsManager() {
+        return mPhysicsManager;
+    }
+
+    inline const PhysicsStreamer &GetPhysicsStreamer() const {
+        return mPhysicsStreamer;
+    }
+
+    inline Registry &GetRegistry() {
+        return mRegistry;
+    }
+
+    inline const SceneLoadStats &GetLoadStats() const {
+        return mLoadStats;
+    }
+
+    // Count the shaded fragments with and without the depth pre-pass after the next frame is drawn
+    inline void RequestOverdrawMeasurement() {
+        mIsOverdrawRequested = true;
+    }
+
+    inline const OverdrawStats &GetOverdrawStats() const {
+        return mOverdrawStats;
+    }
+
+    inline const TransformUpdateStats &GetTransformStats() const {
+        return mTransformStats;
+    }
+
+    // Log the cost of the last transform update, per body for the extraction from physics
+    void LogTransformStats() const;
 };
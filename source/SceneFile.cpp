@@ -0,0 +1,118 @@
+#include "SceneFile.hpp"
+
+#include "macros/log.hpp"
+
+static inline Uint64 AlignOffset(Uint64 inOffset) {
+    return (inOffset + cSceneFileAlignment - 1) & ~Uint64(cSceneFileAlignment - 1);
+}
+
+static bool IsSectionValid(size_t inFileSize, Uint64 inOffset, Uint32 inCount, size_t inRecordSize) {
+    if (inCount == 0) {
+        return true;
+    }
+
+    // Counts are 32 bits, so the section size can't overflow 64 bits
+    Uint64 section_size = Uint64(inCount) * inRecordSize;
+    return inOffset % cSceneFileAlignment == 0 && inOffset <= inFileSize && section_size <= inFileSize - inOffset;
+}
+
+bool ReadSceneFile(const Uint8 *inData, size_t inSize, SceneFileView &outView) {
+    if (inSize < sizeof(SceneFileHeader)) {
+        LOG_ERROR("Scene file is too small\n");
+        return false;
+    }
+
+    const SceneFileHeader *header = reinterpret_cast<const SceneFileHeader *>(inData);
+    if (header->mMagic != cSceneFileMagic) {
+        LOG_ERROR("Not a scene file\n");
+        return false;
+    }
+
+    if (header->mVersion != cSceneFileVersion) {
+        LOG_ERROR("Unsupported scene file version %u, expected %u\n", header->mVersion, cSceneFileVersion);
+        return false;
+    }
+
+    if (!IsSectionValid(inSize, header->mMeshOffset, header->mMeshCount, sizeof(SceneFileMesh)) ||
+        !IsSectionValid(inSize, header->mMaterialOffset, header->mMaterialCount, sizeof(Material)) ||
+        !IsSectionValid(inSize, header->mObjectOffset, header->mObjectCount, sizeof(SceneFileObject)) ||
+        !IsSectionValid(inSize, header->mLightOffset, header->mLightCount, sizeof(SceneFileLight))) {
+        LOG_ERROR("Scene file sections are out of bounds\n");
+        return false;
+    }
+
+    outView.mMeshes = reinterpret_cast<const SceneFileMesh *>(inData + header->mMeshOffset);
+    outView.mMeshCount = header->mMeshCount;
+    outView.mMaterials = reinterpret_cast<const Material *>(inData + header->mMaterialOffset);
+    outView.mMaterialCount = header->mMaterialCount;
+    outView.mObjects = reinterpret_cast<const SceneFileObject *>(inData + header->mObjectOffset);
+    outView.mObjectCount = header->mObjectCount;
+    outView.mLights = reinterpret_cast<const SceneFileLight *>(inData + header->mLightOffset);
+    outView.mLightCount = header->mLightCount;
+
+    // Mesh paths are used as C strings, so make sure they are terminated
+    for (Uint32 i = 0; i < outView.mMeshCount; i++) {
+        if (outView.mMeshes[i].mPath[cSceneFileMeshPathLength - 1] != '\0') {
+            LOG_ERROR("Scene file mesh path %u is not terminated\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool WriteSection(SDL_IOStream *inStream, Uint64 &ioOffset, Uint64 inSectionOffset, const void *inData, size_t inSize) {
+    static const Uint8 padding[cSceneFileAlignment] = {};
+
+    size_t padding_size = static_cast<size_t>(inSectionOffset - ioOffset);
+    if (padding_size > 0 && SDL_WriteIO(inStream, padding, padding_size) != padding_size) {
+        return false;
+    }
+
+    if (inSize > 0 && SDL_WriteIO(inStream, inData, inSize) != inSize) {
+        return false;
+    }
+
+    ioOffset = inSectionOffset + inSize;
+    return true;
+}
+
+bool WriteSceneFile(const char *inPath, const SceneFileView &inView) {
+    SceneFileHeader header = {};
+    header.mMagic = cSceneFileMagic;
+    header.mVersion = cSceneFileVersion;
+    header.mMeshCount = inView.mMeshCount;
+    header.mMaterialCount = inView.mMaterialCount;
+    header.mObjectCount = inView.mObjectCount;
+    header.mLightCount = inView.mLightCount;
+
+    header.mMeshOffset = AlignOffset(sizeof(SceneFileHeader));
+    header.mMaterialOffset = AlignOffset(header.mMeshOffset + Uint64(inView.mMeshCount) * sizeof(SceneFileMesh));
+    header.mObjectOffset = AlignOffset(header.mMaterialOffset + Uint64(inView.mMaterialCount) * sizeof(Material));
+    header.mLightOffset = AlignOffset(header.mObjectOffset + Uint64(inView.mObjectCount) * sizeof(SceneFileObject));
+
+    SDL_IOStream *stream = SDL_IOFromFile(inPath, "wb");
+    if (stream == nullptr) {
+        LOG_ERROR("Unable to open scene file for writing: %s\n", SDL_GetError());
+        return false;
+    }
+
+    Uint64 offset = 0;
+    bool is_written =
+        WriteSection(stream, offset, 0, &header, sizeof(SceneFileHeader)) &&
+        WriteSection(stream, offset, header.mMeshOffset, inView.mMeshes, inView.mMeshCount * sizeof(SceneFileMesh)) &&
+        WriteSection(stream, offset, header.mMaterialOffset, inView.mMaterials, inView.mMaterialCount * sizeof(Material)) &&
+        WriteSection(stream, offset, header.mObjectOffset, inView.mObjects, inView.mObjectCount * sizeof(SceneFileObject)) &&
+        WriteSection(stream, offset, header.mLightOffset, inView.mLights, inView.mLightCount * sizeof(SceneFileLight));
+
+    if (!is_written) {
+        LOG_ERROR("Unable to write scene file: %s\n", SDL_GetError());
+    }
+
+    if (!SDL_CloseIO(stream)) {
+        LOG_ERROR("Unable to close scene file: %s\n", SDL_GetError());
+        return false;
+    }
+
+    return is_written;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "graphics/uniforms/Material.hpp"
+
+// Binary scene layout. A header is followed by sections of fixed-size records, each starting on a 16 byte boundary,
+// so a mapped file can be used in place without parsing. Bump the version whenever a record changes.
+static constexpr Uint32 cSceneFileMagic = 0x4e435343; // "CSCN"
+static constexpr Uint32 cSceneFileVersion = 1;
+static constexpr Uint32 cSceneFileAlignment = 16;
+static constexpr Uint32 cSceneFileNone = 0xffffffff;
+static constexpr Uint32 cSceneFileMeshPathLength = 128;
+
+enum class SceneShapeType : Uint8 {
+    None = 0,
+    Box = 1,
+    Sphere = 2,
+};
+
+struct SceneFileHeader {
+    Uint32 mMagic;
+    Uint32 mVersion;
+    Uint32 mMeshCount;
+    Uint32 mMaterialCount;
+    Uint32 mObjectCount;
+    Uint32 mLightCount;
+    Uint64 mMeshOffset;
+    Uint64 mMaterialOffset;
+    Uint64 mObjectOffset;
+    Uint64 mLightOffset;
+};
+
+struct SceneFileMesh {
+    char mPath[cSceneFileMeshPathLength];
+};
+
+struct SceneFileObject {
+    float mPosition[3];
+    float mRotation[4];
+    // Half extent for boxes, the radius is stored in the first component for spheres
+    float mShapeSize[3];
+    // Objects without a mesh are not drawn, objects without a material are drawn unlit
+    Uint32 mMeshIndex;
+    Uint32 mMaterialIndex;
+    SceneShapeType mShapeType;
+    Uint8 mIsDynamic;
+    Uint8 mPadding[2];
+};
+
+struct SceneFileLight {
+    float mPosition[3];
+    float mScale;
+    Uint32 mMeshIndex;
+};
+
+// The records are written as is, so their layout must not change without a version bump
+static_assert(sizeof(SceneFileHeader) == 56);
+static_assert(sizeof(SceneFileMesh) == 128);
+static_assert(sizeof(Material) == 64);
+static_assert(sizeof(SceneFileObject) == 52);
+static_assert(sizeof(SceneFileLight) == 20);
+
+// Sections of a scene, pointing either into a mapped file or into memory that is about to be written
+struct SceneFileView {
+    const SceneFileMesh *mMeshes = nullptr;
+    Uint32 mMeshCount = 0;
+    const Material *mMaterials = nullptr;
+    Uint32 mMaterialCount = 0;
+    const SceneFileObject *mObjects = nullptr;
+    Uint32 mObjectCount = 0;
+    const SceneFileLight *mLights = nullptr;
+    Uint32 mLightCount = 0;
+};
+
+// Validate a scene file in memory and point the view at its sections
+bool ReadSceneFile(const Uint8 *inData, size_t inSize, SceneFileView &outView);
+bool WriteSceneFile(const char *inPath, const SceneFileView &inView);
@@ -0,0 +1,243 @@
+#include "SoftwareBenchmark.hpp"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/vector.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "macros/log.hpp"
+
+#include "Camera.hpp"
+#include "ContentManager.hpp"
+#include "SceneFile.hpp"
+#include "graphics/ShaderKey.hpp"
+#include "graphics/software/SoftwareRenderService.hpp"
+#include "io/MappedFile.hpp"
+#include "jobs/JobService.hpp"
+#include "memory/FrameMemoryService.hpp"
+
+static const char *cBenchmarkScenePath = "content/default.scene";
+
+// Imported meshes stay in frame memory for the whole run, so the arenas are sized for the scene's meshes
+static constexpr size_t cBenchmarkFrameMemorySize = 32 * 1024 * 1024;
+
+// Frames rendered per thread count, the first one warms up the caches and is not measured
+static constexpr Uint32 cBenchmarkFrameCount = 16;
+
+// Same constants as Scene::Draw, so both backends light the scene identically
+static SceneConstants MakeSceneConstants(const glm::vec3 &inCameraPosition, const glm::vec3 *inLightPositions) {
+    SceneConstants scene_constants = {};
+    scene_constants.camera_position = glm::vec4(inCameraPosition, 1.0f);
+    scene_constants.directional_light = {
+        glm::vec4(-0.2f, -1.0f, -0.3f, 1.0f),
+        glm::vec4(0.2f, 0.2f, 0.2f, 1.0f),
+        glm::vec4(0.5f, 0.5f, 0.5f, 1.0f),
+        glm::vec4(0.8f, 0.8f, 0.8f, 1.0f)
+    };
+
+    for (Uint32 i = 0; i < 4; i++) {
+        scene_constants.point_light[i] = {
+            glm::vec4(inLightPositions[i], 1.0f),
+            1.0f,
+            0.09f,
+            0.032f,
+            0.0f,
+            glm::vec4(0.2f, 0.2f, 0.2f, 1.0f),
+            glm::vec4(0.6f, 0.6f, 0.6f, 1.0f),
+            glm::vec4(0.7f, 0.7f, 0.7f, 1.0f)
+        };
+    }
+
+    return scene_constants;
+}
+
+bool RunSoftwareBenchmark(const char *inOutputPath, Uint32 inWidth, Uint32 inHeight) {
+    if (!FrameMemoryService::Get().Initialize(cBenchmarkFrameMemorySize)) {
+        return false;
+    }
+
+    if (!JobService::Get().Initialize({})) {
+        FrameMemoryService::Get().Shutdown();
+        return false;
+    }
+
+    SoftwareRenderService &renderer = SoftwareRenderService::Get();
+    bool is_successful = renderer.Initialize(inWidth, inHeight, &JobService::Get());
+
+    MappedFile scene_file;
+    SceneFileView view;
+    if (is_successful) {
+        is_successful = scene_file.Open(cBenchmarkScenePath) &&
+            ReadSceneFile(scene_file.GetData(), scene_file.GetSize(), view);
+
+        if (!is_successful) {
+            LOG_ERROR("Unable to load benchmark scene: %s\n", cBenchmarkScenePath);
+        }
+    }
+
+    ContentManager content;
+    eastl::vector<SoftwareMesh *> meshes;
+
+    if (is_successful) {
+        // Meshes that fail to import are left out, like Scene does
+        meshes.resize(view.mMeshCount, nullptr);
+        for (Uint32 i = 0; i < view.mMeshCount; i++) {
+            const char *path = view.mMeshes[i].mPath;
+            const MeshData *mesh_data = content.ImportMesh(path) ? content.GetImportedMesh(path) : nullptr;
+            if (mesh_data == nullptr) {
+                continue;
+            }
+
+            meshes[i] = renderer.CreateMesh(
+                const_cast<PositionNormalTextureVertex *>(mesh_data->vertices.data()),
+                static_cast<Uint32>(sizeof(PositionNormalTextureVertex) * mesh_data->vertices.size()),
+                static_cast<Uint32>(mesh_data->vertices.size()),
+                const_cast<Uint16 *>(mesh_data->indices.data()),
+                static_cast<Uint32>(sizeof(Uint16) * mesh_data->indices.size()),
+                static_cast<Uint32>(mesh_data->indices.size())
+            );
+        }
+    }
+
+    if (is_successful) {
+        for (Uint32 i = 0; i < view.mMaterialCount; i++) {
+            renderer.CreateMaterial(view.mMaterials[i]);
+        }
+
+        glm::vec3 light_positions[4] = {};
+        Uint32 light_count = eastl::min(view.mLightCount, 4u);
+        for (Uint32 i = 0; i < light_count; i++) {
+            light_positions[i] = glm::vec3(view.mLights[i].mPosition[0], view.mLights[i].mPosition[1], view.mLights[i].mPosition[2]);
+        }
+
+        Camera camera(45.0f, 0.0f, -90.0f, 5.0f);
+        camera.SetAspectRatio(static_cast<float>(inWidth), static_cast<float>(inHeight));
+
+        renderer.SetViewConstants({ camera.GetProjectionMatrix(), camera.GetViewMatrix() });
+        renderer.SetSceneConstants(MakeSceneConstants(camera.GetPosition(), light_positions));
+
+        // The scene is static, so instances are built once and every frame records the same draws
+        struct BenchmarkDraw {
+            const SoftwareMesh *mMesh;
+            bool mIsLit;
+            ShaderKey mKey;
+            DrawIndices mIndices;
+        };
+
+        eastl::vector<InstanceData> instances;
+        eastl::vector<BenchmarkDraw> draws;
+
+        for (Uint32 i = 0; i < view.mObjectCount; i++) {
+            const SceneFileObject &object = view.mObjects[i];
+            const SoftwareMesh *mesh = object.mMeshIndex < meshes.size() ? meshes[object.mMeshIndex] : nullptr;
+            if (mesh == nullptr) {
+                continue;
+            }
+
+            glm::quat rotation(object.mRotation[3], object.mRotation[0], object.mRotation[1], object.mRotation[2]);
+            glm::mat4 rotation_matrix = glm::mat4_cast(rotation);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(object.mPosition[0], object.mPosition[1], object.mPosition[2])) * rotation_matrix;
+
+            DrawIndices indices = { static_cast<Uint32>(instances.size()), 0, 0, 0 };
+            instances.push_back({ model, rotation_matrix });
+
+            if (object.mMaterialIndex < view.mMaterialCount) {
+                const Material &material = view.mMaterials[object.mMaterialIndex];
+                bool is_lambert = material.specular.r == 0.0f && material.specular.g == 0.0f && material.specular.b == 0.0f;
+
+                indices.material_index = object.mMaterialIndex;
+                draws.push_back({ mesh, true, MakeLitShaderKey(light_count, is_lambert), indices });
+            } else {
+                draws.push_back({ mesh, false, 0, indices });
+            }
+        }
+
+        for (Uint32 i = 0; i < view.mLightCount; i++) {
+            const SceneFileLight &light = view.mLights[i];
+            const SoftwareMesh *mesh = light.mMeshIndex < meshes.size() ? meshes[light.mMeshIndex] : nullptr;
+            if (mesh == nullptr) {
+                continue;
+            }
+
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(light.mPosition[0], light.mPosition[1], light.mPosition[2]));
+            model = glm::scale(model, glm::vec3(light.mScale));
+
+            draws.push_back({ mesh, false, 0, { static_cast<Uint32>(instances.size()), 0, 0, 0 } });
+            instances.push_back({ model, glm::mat4(1.0f) });
+        }
+
+        renderer.SetInstances(instances.data(), static_cast<Uint32>(instances.size()));
+
+        LOG_INFO("Software rasterizer at %ux%u, %u draws:\n", inWidth, inHeight, static_cast<Uint32>(draws.size()));
+
+        Uint32 max_thread_count = renderer.GetThreadCount();
+        for (Uint32 thread_count = 1; ; thread_count = eastl::min(thread_count * 2, max_thread_count)) {
+            renderer.SetThreadCount(thread_count);
+
+            Uint64 total_time = 0;
+            Uint64 geometry_time = 0;
+            Uint64 raster_time = 0;
+            Uint64 triangle_count = 0;
+
+            for (Uint32 frame = 0; frame < cBenchmarkFrameCount; frame++) {
+                Uint64 start_time = SDL_GetTicksNS();
+
+                renderer.BeginPass();
+                for (const BenchmarkDraw &draw : draws) {
+                    renderer.UsePipeline(draw.mIsLit ? "default_mesh" : "light_source", draw.mKey);
+                    renderer.DrawMesh(draw.mMesh, draw.mIndices);
+                }
+                renderer.EndPass();
+
+                if (frame == 0) {
+                    continue;
+                }
+
+                const SoftwareRenderStats &stats = renderer.GetStats();
+                total_time += SDL_GetTicksNS() - start_time;
+                geometry_time += stats.mGeometryTime;
+                raster_time += stats.mRasterTime;
+                triangle_count += stats.mTriangleCount;
+            }
+
+            Uint32 measured_count = cBenchmarkFrameCount - 1;
+            double seconds = static_cast<double>(total_time) / 1e9;
+
+            LOG_INFO(
+                "  %2u threads: %7.2f ms/frame (geometry %.2f, raster %.2f), %7.1f frames/s, %7.2f Mtriangles/s\n",
+                thread_count,
+                static_cast<double>(total_time) / 1e6 / measured_count,
+                static_cast<double>(geometry_time) / 1e6 / measured_count,
+                static_cast<double>(raster_time) / 1e6 / measured_count,
+                measured_count / seconds,
+                static_cast<double>(triangle_count) / 1e6 / seconds
+            );
+
+            if (thread_count == max_thread_count) {
+                break;
+            }
+        }
+
+        is_successful = renderer.SaveImage(inOutputPath);
+        if (is_successful) {
+            LOG_INFO("Software image written to %s\n", inOutputPath);
+        }
+    }
+
+    for (SoftwareMesh *mesh : meshes) {
+        if (mesh != nullptr) {
+            renderer.DestroyMesh(mesh);
+        }
+    }
+
+    // The imported meshes live in frame memory, so they have to go before it does
+    content.Unload();
+    scene_file.Close();
+    renderer.Shutdown();
+    JobService::Get().Shutdown();
+    FrameMemoryService::Get().Shutdown();
+
+    return is_successful;
+}
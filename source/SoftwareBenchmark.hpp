@@ -0,0 +1,8 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Render the default scene with the software rasterizer at every thread count from one up to the number of cores,
+// doubling each time, and log frames and triangles per second. Needs neither a window nor a GPU device, so it can run
+// on headless machines. The last image is written to inOutputPath as a BMP file.
+bool RunSoftwareBenchmark(const char *inOutputPath, Uint32 inWidth, Uint32 inHeight);
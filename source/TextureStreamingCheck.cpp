@@ -0,0 +1,289 @@
+#include "TextureStreamingCheck.hpp"
+
+#include <EASTL/vector.h>
+
+#include "macros/log.hpp"
+
+#include "graphics/TextureStreamer.hpp"
+
+// Small enough that even small textures have mips to stream
+static constexpr Uint32 cCheckTailSize = 4;
+// Longer than any phase that relies on the budget rather than the delay to evict
+static constexpr Uint32 cCheckEvictionDelay = 32;
+
+static bool RunFrame(SDL_GPUDevice *inDevice, TextureStreamer &ioStreamer) {
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(inDevice);
+    if (command_buffer == nullptr) {
+        LOG_ERROR("Unable to acquire GPU command buffer: %s\n", SDL_GetError());
+        return false;
+    }
+
+    ioStreamer.Update(command_buffer);
+
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+    if (fence == nullptr) {
+        LOG_ERROR("Unable to submit GPU command buffer: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_WaitForGPUFences(inDevice, true, &fence, 1);
+    SDL_ReleaseGPUFence(inDevice, fence);
+
+    const TextureStreamingStats &stats = ioStreamer.GetStats();
+    if (stats.mResidentSize > stats.mBudget) {
+        LOG_ERROR("Resident size of %llu bytes exceeds the budget of %llu bytes\n",
+            static_cast<unsigned long long>(stats.mResidentSize),
+            static_cast<unsigned long long>(stats.mBudget));
+        return false;
+    }
+
+    return true;
+}
+
+// Read every resident level back and compare it with the cooked data, decoded when the device can't sample BC
+static bool CompareResidentMips(SDL_GPUDevice *inDevice, const TextureStreamer &inStreamer, TextureID inTexture) {
+    const TextureFileView &view = inStreamer.GetView(inTexture);
+    Uint32 resident_mip = inStreamer.GetResidentMip(inTexture);
+
+    eastl::vector<Uint8> expected;
+    eastl::vector<Uint32> offsets;
+
+    for (Uint32 mip = resident_mip; mip < view.mMipCount; mip++) {
+        const TextureFileMip &file_mip = view.mMips[mip];
+        size_t offset = expected.size();
+        offsets.push_back(static_cast<Uint32>(offset));
+
+        if (inStreamer.IsDecoding()) {
+            expected.resize(offset + file_mip.mWidth * file_mip.mHeight * 4);
+            DecodeTextureFileMip(view.mFormat, view.GetMipData(mip), file_mip.mWidth, file_mip.mHeight, expected.data() + offset);
+        } else {
+            expected.insert(expected.end(), view.GetMipData(mip), view.GetMipData(mip) + file_mip.mSize);
+        }
+
+        // Downloads land on the same alignment the uploads use
+        expected.resize((expected.size() + cTextureFileAlignment - 1) & ~size_t(cTextureFileAlignment - 1));
+    }
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+        .size = static_cast<Uint32>(expected.size())
+    };
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(inDevice, &transfer_buffer_create_info);
+    if (transfer_buffer == nullptr) {
+        LOG_ERROR("Unable to create transfer buffer: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(inDevice);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+
+    for (Uint32 mip = resident_mip; mip < view.mMipCount; mip++) {
+        SDL_GPUTextureRegion source = {
+            .texture = inStreamer.GetTexture(inTexture),
+            .mip_level = mip - resident_mip,
+            .w = view.mMips[mip].mWidth,
+            .h = view.mMips[mip].mHeight,
+            .d = 1
+        };
+
+        SDL_GPUTextureTransferInfo destination = {
+            .transfer_buffer = transfer_buffer,
+            .offset = offsets[mip - resident_mip]
+        };
+
+        SDL_DownloadFromGPUTexture(copy_pass, &source, &destination);
+    }
+
+    SDL_EndGPUCopyPass(copy_pass);
+
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+    if (fence == nullptr) {
+        LOG_ERROR("Unable to submit GPU command buffer: %s\n", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(inDevice, transfer_buffer);
+        return false;
+    }
+
+    SDL_WaitForGPUFences(inDevice, true, &fence, 1);
+    SDL_ReleaseGPUFence(inDevice, fence);
+
+    const Uint8 *data = static_cast<const Uint8 *>(SDL_MapGPUTransferBuffer(inDevice, transfer_buffer, false));
+    if (data == nullptr) {
+        LOG_ERROR("Unable to map transfer buffer: %s\n", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(inDevice, transfer_buffer);
+        return false;
+    }
+
+    bool is_equal = true;
+    for (Uint32 mip = resident_mip; mip < view.mMipCount; mip++) {
+        Uint32 begin = offsets[mip - resident_mip];
+        Uint32 end = mip + 1 < view.mMipCount ? offsets[mip + 1 - resident_mip] : static_cast<Uint32>(expected.size());
+
+        // The padding after a mip is never written, only the mip itself has to match
+        Uint32 size = inStreamer.IsDecoding() ? view.mMips[mip].mWidth * view.mMips[mip].mHeight * 4 : view.mMips[mip].mSize;
+        SDL_assert(begin + size <= end);
+
+        if (SDL_memcmp(data + begin, expected.data() + begin, size) != 0) {
+            LOG_ERROR("Resident mip %u doesn't match the texture file\n", mip);
+            is_equal = false;
+        }
+    }
+
+    SDL_UnmapGPUTransferBuffer(inDevice, transfer_buffer);
+    SDL_ReleaseGPUTransferBuffer(inDevice, transfer_buffer);
+
+    return is_equal;
+}
+
+static bool CheckStreaming(SDL_GPUDevice *inDevice, TextureStreamer &ioStreamer, const char *inPath) {
+    TextureID texture = ioStreamer.Load(inPath);
+    if (texture == cInvalidTexture) {
+        return false;
+    }
+
+    const TextureFileView &view = ioStreamer.GetView(texture);
+    Uint32 tail_mip = ioStreamer.GetResidentMip(texture);
+    LOG_INFO("Texture %ux%u with %u mips, mips from %u on are always resident%s\n",
+        view.mWidth, view.mHeight, view.mMipCount, tail_mip, ioStreamer.IsDecoding() ? ", decoded to RGBA8" : "");
+
+    // Resident size with each mip as the finest one, recorded while streaming in
+    Uint64 resident_sizes[cTextureFileMaxMipCount] = {};
+
+    if (!RunFrame(inDevice, ioStreamer)) {
+        return false;
+    }
+
+    resident_sizes[tail_mip] = ioStreamer.GetStats().mResidentSize;
+
+    // Everything streams in one mip per frame while it's requested
+    for (Uint32 frame = 0; frame < view.mMipCount && ioStreamer.GetResidentMip(texture) > 0; frame++) {
+        ioStreamer.RequestMip(texture, 0);
+        if (!RunFrame(inDevice, ioStreamer)) {
+            return false;
+        }
+
+        resident_sizes[ioStreamer.GetResidentMip(texture)] = ioStreamer.GetStats().mResidentSize;
+    }
+
+    if (ioStreamer.GetResidentMip(texture) != 0) {
+        LOG_ERROR("Mip 0 isn't resident after requesting it for %u frames\n", view.mMipCount);
+        return false;
+    }
+
+    if (!CompareResidentMips(inDevice, ioStreamer, texture)) {
+        return false;
+    }
+
+    LOG_INFO("Streamed in %u mips, %llu bytes resident\n", tail_mip, static_cast<unsigned long long>(resident_sizes[0]));
+
+    // Without requests the streamed mips go once the delay has passed, the copies must keep the tail intact
+    for (Uint32 frame = 0; frame < cCheckEvictionDelay + 2; frame++) {
+        if (!RunFrame(inDevice, ioStreamer)) {
+            return false;
+        }
+    }
+
+    if (ioStreamer.GetResidentMip(texture) != tail_mip) {
+        LOG_ERROR("Unused mips weren't evicted after %u frames\n", cCheckEvictionDelay);
+        return false;
+    }
+
+    if (!CompareResidentMips(inDevice, ioStreamer, texture)) {
+        return false;
+    }
+
+    LOG_INFO("Evicted the streamed mips after the delay\n");
+
+    if (tail_mip < 3) {
+        LOG_INFO("Texture is too small to check the budget, cook one with at least %u mips above %ux%u\n", 3u, cCheckTailSize, cCheckTailSize);
+        return true;
+    }
+
+    // A budget that ends at mip 2 has to stop the texture there and report the pressure
+    ioStreamer.SetBudget(resident_sizes[2]);
+
+    for (Uint32 frame = 0; frame < view.mMipCount; frame++) {
+        ioStreamer.RequestMip(texture, 0);
+        if (!RunFrame(inDevice, ioStreamer)) {
+            return false;
+        }
+    }
+
+    if (ioStreamer.GetResidentMip(texture) != 2 || ioStreamer.GetStats().mBudgetPressureFrames == 0) {
+        LOG_ERROR("Texture should stop at mip 2 under budget pressure, it's at mip %u after %llu pressure frames\n",
+            ioStreamer.GetResidentMip(texture),
+            static_cast<unsigned long long>(ioStreamer.GetStats().mBudgetPressureFrames));
+        return false;
+    }
+
+    LOG_INFO("Stopped at mip 2 within a budget of %llu bytes\n", static_cast<unsigned long long>(resident_sizes[2]));
+
+    // A second texture only fits its mips by evicting the ones the first texture no longer needs, well before the
+    // delay would evict them
+    TextureID other_texture = ioStreamer.Load(inPath);
+    if (other_texture == cInvalidTexture) {
+        return false;
+    }
+
+    ioStreamer.SetBudget(resident_sizes[2] + resident_sizes[tail_mip]);
+    Uint64 eviction_count = ioStreamer.GetStats().mEvictionCount;
+
+    for (Uint32 frame = 0; frame < tail_mip; frame++) {
+        ioStreamer.RequestMip(other_texture, 0);
+        if (!RunFrame(inDevice, ioStreamer)) {
+            return false;
+        }
+    }
+
+    if (ioStreamer.GetResidentMip(other_texture) != 2 || ioStreamer.GetResidentMip(texture) != tail_mip ||
+        ioStreamer.GetStats().mEvictionCount == eviction_count) {
+        LOG_ERROR("Second texture should take the first one's mips, they are at mips %u and %u\n",
+            ioStreamer.GetResidentMip(other_texture),
+            ioStreamer.GetResidentMip(texture));
+        return false;
+    }
+
+    if (!CompareResidentMips(inDevice, ioStreamer, texture) || !CompareResidentMips(inDevice, ioStreamer, other_texture)) {
+        return false;
+    }
+
+    LOG_INFO("Second texture evicted %llu mips to fit the budget\n",
+        static_cast<unsigned long long>(ioStreamer.GetStats().mEvictionCount - eviction_count));
+
+    return true;
+}
+
+bool RunTextureStreamingCheck(const char *inPath) {
+    // The Vulkan loader is set up by the video subsystem, even without a window
+    if (!SDL_InitSubSystem(SDL_INIT_VIDEO)) {
+        LOG_ERROR("Unable to initialize video: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // No shaders are created, SPIR-V only picks the Vulkan backend
+    SDL_GPUDevice *device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, nullptr);
+    if (device == nullptr) {
+        LOG_ERROR("Unable to create GPU device: %s\n", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        return false;
+    }
+
+    LOG_INFO("Checking texture streaming on %s\n", SDL_GetGPUDeviceDriver(device));
+
+    TextureStreamingSettings settings;
+    settings.mTailSize = cCheckTailSize;
+    settings.mEvictionDelay = cCheckEvictionDelay;
+
+    TextureStreamer streamer;
+    bool is_passed = streamer.Initialize(device, settings) && CheckStreaming(device, streamer, inPath);
+
+    streamer.LogStats();
+
+    LOG_INFO("Texture streaming check %s\n", is_passed ? "PASSED" : "FAILED");
+
+    streamer.Shutdown();
+    SDL_DestroyGPUDevice(device);
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+
+    return is_passed;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Stream a cooked texture through a GPU device without a window and check the streamer against the file: every
+// mip that becomes resident has to match the cooked data, unused mips have to be evicted after the delay, the
+// budget must never be exceeded and a texture that needs room has to get it by evicting an unused one. Meant for
+// machines without a GPU, with a software Vulkan driver such as lavapipe and SDL's offscreen video driver.
+bool RunTextureStreamingCheck(const char *inPath);
@@ -31,11 +31,33 @@ struct Transform {
         return transform;
     }
 
-    inline glm::mat4 GetModelMatrix() {
-        glm::mat4 matrix = glm::mat4(1.0f);
-        matrix = glm::translate(matrix, mPosition);
-        matrix = matrix * glm::toMat4(mRotation);
-        matrix = glm::scale(matrix, mScale);
-        return matrix;
+    // Translation, rotation and scale in one matrix, built from the rotation's basis rather than by multiplying three
+    static inline glm::mat4 ComposeMatrix(const glm::vec3 &inPosition, const glm::quat &inRotation, const glm::vec3 &inScale) {
+        glm::mat3 rotation = glm::mat3_cast(inRotation);
+        return glm::mat4(
+            glm::vec4(rotation[0] * inScale.x, 0.0f),
+            glm::vec4(rotation[1] * inScale.y, 0.0f),
+            glm::vec4(rotation[2] * inScale.z, 0.0f),
+            glm::vec4(inPosition, 1.0f)
+        );
+    }
+
+    // Inverse transpose of a matrix built from rotations and scales, without a general inverse. Its columns are the
+    // rotated axes times their scale, so dividing each one by its squared length gives rotation times inverse scale.
+    // Exact as long as no non-uniform scale of a parent is applied to a rotated child, which would shear it.
+    static inline glm::mat4 ComposeNormalMatrix(const glm::mat4 &inMatrix) {
+        glm::vec3 x_axis = glm::vec3(inMatrix[0]);
+        glm::vec3 y_axis = glm::vec3(inMatrix[1]);
+        glm::vec3 z_axis = glm::vec3(inMatrix[2]);
+        return glm::mat4(
+            glm::vec4(x_axis / glm::dot(x_axis, x_axis), 0.0f),
+            glm::vec4(y_axis / glm::dot(y_axis, y_axis), 0.0f),
+            glm::vec4(z_axis / glm::dot(z_axis, z_axis), 0.0f),
+            glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
+        );
+    }
+
+    inline glm::mat4 GetModelMatrix() const {
+        return ComposeMatrix(mPosition, mRotation, mScale);
     }
 };
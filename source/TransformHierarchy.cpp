@@ -0,0 +1,181 @@
+#include "TransformHierarchy.hpp"
+
+// Move every element to its new index, the scratch buffer is swapped in
+template <typename T>
+static void Reorder(eastl::vector<T> &ioValues, const eastl::vector<Uint32> &inNewIndices, eastl::vector<T> &ioScratch) {
+    ioScratch.resize(ioValues.size());
+    for (size_t i = 0; i < ioValues.size(); i++) {
+        ioScratch[inNewIndices[i]] = ioValues[i];
+    }
+
+    ioValues.swap(ioScratch);
+}
+
+void TransformHierarchy::Reserve(Uint32 inCount) {
+    mParents.reserve(inCount);
+    mDepths.reserve(inCount);
+    mLocalPositions.reserve(inCount);
+    mLocalRotations.reserve(inCount);
+    mLocalScales.reserve(inCount);
+    mWorldMatrices.reserve(inCount);
+    mFlags.reserve(inCount);
+    mNodes.reserve(inCount);
+    mIndices.reserve(inCount);
+}
+
+void TransformHierarchy::Clear() {
+    mParents.clear();
+    mDepths.clear();
+    mLocalPositions.clear();
+    mLocalRotations.clear();
+    mLocalScales.clear();
+    mWorldMatrices.clear();
+    mFlags.clear();
+    mNodes.clear();
+    mIndices.clear();
+
+    mIsSorted = true;
+    mDirtyCount = 0;
+    mUpdatedCount = 0;
+}
+
+TransformNodeID TransformHierarchy::Create(TransformNodeID inParent, const Transform &inLocalTransform) {
+    Uint32 parent = inParent == cInvalidTransformNode ? cNoParent : mIndices[inParent];
+    Uint32 depth = parent == cNoParent ? 0 : mDepths[parent] + 1;
+
+    if (!mDepths.empty() && depth < mDepths.back()) {
+        mIsSorted = false;
+    }
+
+    TransformNodeID node = static_cast<TransformNodeID>(mIndices.size());
+    mIndices.push_back(static_cast<Uint32>(mNodes.size()));
+
+    mParents.push_back(parent);
+    mDepths.push_back(depth);
+    mLocalPositions.push_back(inLocalTransform.mPosition);
+    mLocalRotations.push_back(inLocalTransform.mRotation);
+    mLocalScales.push_back(inLocalTransform.mScale);
+    mWorldMatrices.push_back(glm::mat4(1.0f));
+    mFlags.push_back(cDirty);
+    mNodes.push_back(node);
+
+    mDirtyCount++;
+    return node;
+}
+
+void TransformHierarchy::SetLocalTransform(TransformNodeID inNode, const Transform &inLocalTransform) {
+    Uint32 index = mIndices[inNode];
+    mLocalPositions[index] = inLocalTransform.mPosition;
+    mLocalRotations[index] = inLocalTransform.mRotation;
+    mLocalScales[index] = inLocalTransform.mScale;
+
+    if ((mFlags[index] & cDirty) == 0) {
+        mFlags[index] |= cDirty;
+        mDirtyCount++;
+    }
+}
+
+Transform TransformHierarchy::GetLocalTransform(TransformNodeID inNode) const {
+    Uint32 index = mIndices[inNode];
+
+    Transform transform;
+    transform.mPosition = mLocalPositions[index];
+    transform.mRotation = mLocalRotations[index];
+    transform.mScale = mLocalScales[index];
+    return transform;
+}
+
+// Counting sort by depth, stable so siblings keep the order they were created in
+void TransformHierarchy::Sort() {
+    Uint32 node_count = static_cast<Uint32>(mNodes.size());
+
+    Uint32 max_depth = 0;
+    for (Uint32 depth : mDepths) {
+        max_depth = SDL_max(max_depth, depth);
+    }
+
+    eastl::vector<Uint32> depth_offsets(max_depth + 1, 0);
+    for (Uint32 depth : mDepths) {
+        depth_offsets[depth]++;
+    }
+
+    Uint32 offset = 0;
+    for (Uint32 &depth_offset : depth_offsets) {
+        Uint32 count = depth_offset;
+        depth_offset = offset;
+        offset += count;
+    }
+
+    eastl::vector<Uint32> new_indices(node_count);
+    for (Uint32 i = 0; i < node_count; i++) {
+        new_indices[i] = depth_offsets[mDepths[i]]++;
+    }
+
+    // Parents point at indices, so they're remapped on top of being moved
+    for (Uint32 &parent : mParents) {
+        if (parent != cNoParent) {
+            parent = new_indices[parent];
+        }
+    }
+
+    eastl::vector<Uint32> index_scratch;
+    Reorder(mParents, new_indices, index_scratch);
+    Reorder(mDepths, new_indices, index_scratch);
+    Reorder(mNodes, new_indices, index_scratch);
+
+    eastl::vector<glm::vec3> vector_scratch;
+    Reorder(mLocalPositions, new_indices, vector_scratch);
+    Reorder(mLocalScales, new_indices, vector_scratch);
+
+    eastl::vector<glm::quat> rotation_scratch;
+    Reorder(mLocalRotations, new_indices, rotation_scratch);
+
+    eastl::vector<glm::mat4> matrix_scratch;
+    Reorder(mWorldMatrices, new_indices, matrix_scratch);
+
+    eastl::vector<Uint8> flag_scratch;
+    Reorder(mFlags, new_indices, flag_scratch);
+
+    for (Uint32 i = 0; i < node_count; i++) {
+        mIndices[mNodes[i]] = i;
+    }
+
+    mIsSorted = true;
+}
+
+void TransformHierarchy::Update() {
+    if (!mIsSorted) {
+        Sort();
+    }
+
+    if (mDirtyCount == 0) {
+        // Nothing moved, only the changes reported by the last update have to be forgotten
+        if (mUpdatedCount > 0) {
+            SDL_memset(mFlags.data(), 0, mFlags.size());
+            mUpdatedCount = 0;
+        }
+
+        return;
+    }
+
+    Uint32 node_count = static_cast<Uint32>(mNodes.size());
+    Uint32 updated_count = 0;
+
+    // A parent is always visited before its children, so its flags already say whether its world matrix changed
+    for (Uint32 i = 0; i < node_count; i++) {
+        Uint32 parent = mParents[i];
+        bool is_changed = (mFlags[i] & cDirty) != 0 || (parent != cNoParent && (mFlags[parent] & cWorldChanged) != 0);
+        if (!is_changed) {
+            mFlags[i] = 0;
+            continue;
+        }
+
+        glm::mat4 local_matrix = Transform::ComposeMatrix(mLocalPositions[i], mLocalRotations[i], mLocalScales[i]);
+        mWorldMatrices[i] = parent == cNoParent ? local_matrix : mWorldMatrices[parent] * local_matrix;
+        mFlags[i] = cWorldChanged;
+        updated_count++;
+    }
+
+    mDirtyCount = 0;
+    mUpdatedCount = updated_count;
+}
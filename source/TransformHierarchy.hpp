@@ -0,0 +1,80 @@
+#pragma once
+
+#include <EASTL/vector.h>
+
+#include <SDL3/SDL.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Transform.hpp"
+
+using TransformNodeID = Uint32;
+static constexpr TransformNodeID cInvalidTransformNode = 0xffffffff;
+
+// Transforms relative to a parent and the world matrices they add up to. Nodes are kept in arrays sorted by depth,
+// so every parent comes before its children and Update propagates world matrices in one pass from front to back.
+// Setting a local transform marks the node dirty, Update only recomputes dirty nodes and the subtrees below them.
+// Node IDs stay the same when the arrays are sorted, the arrays are indexed through mIndices.
+class TransformHierarchy {
+private:
+    static constexpr Uint8 cDirty = 1 << 0;
+    static constexpr Uint8 cWorldChanged = 1 << 1;
+    static constexpr Uint32 cNoParent = 0xffffffff;
+
+    // In depth order, parents are indices into these arrays as well
+    eastl::vector<Uint32> mParents;
+    eastl::vector<Uint32> mDepths;
+    eastl::vector<glm::vec3> mLocalPositions;
+    eastl::vector<glm::quat> mLocalRotations;
+    eastl::vector<glm::vec3> mLocalScales;
+    eastl::vector<glm::mat4> mWorldMatrices;
+    eastl::vector<Uint8> mFlags;
+    eastl::vector<TransformNodeID> mNodes;
+
+    // Index of every node in the arrays above
+    eastl::vector<Uint32> mIndices;
+
+    // Nodes added under a parent deeper than the last node break the order until the next update
+    bool mIsSorted = true;
+    Uint32 mDirtyCount = 0;
+    Uint32 mUpdatedCount = 0;
+
+    void Sort();
+
+public:
+    void Reserve(Uint32 inCount);
+    void Clear();
+
+    // Add a node below a parent, or a root with cInvalidTransformNode. Its world matrix is valid after the next update.
+    TransformNodeID Create(TransformNodeID inParent, const Transform &inLocalTransform);
+
+    void SetLocalTransform(TransformNodeID inNode, const Transform &inLocalTransform);
+    Transform GetLocalTransform(TransformNodeID inNode) const;
+
+    // Recompute the world matrices of dirty nodes and everything below them
+    void Update();
+
+    inline const glm::mat4 &GetWorldMatrix(TransformNodeID inNode) const {
+        return mWorldMatrices[mIndices[inNode]];
+    }
+
+    // Whether the last update changed the node's world matrix
+    inline bool HasWorldChanged(TransformNodeID inNode) const {
+        return (mFlags[mIndices[inNode]] & cWorldChanged) != 0;
+    }
+
+    inline TransformNodeID GetParent(TransformNodeID inNode) const {
+        Uint32 parent = mParents[mIndices[inNode]];
+        return parent == cNoParent ? cInvalidTransformNode : mNodes[parent];
+    }
+
+    inline Uint32 GetNodeCount() const {
+        return static_cast<Uint32>(mNodes.size());
+    }
+
+    // Nodes whose world matrix the last update recomputed
+    inline Uint32 GetUpdatedCount() const {
+        return mUpdatedCount;
+    }
+};
@@ -0,0 +1,113 @@
+#include "TransformHierarchyBenchmark.hpp"
+
+#include <EASTL/vector.h>
+
+#include "macros/log.hpp"
+
+#include "TransformHierarchy.hpp"
+
+static constexpr Uint32 cBenchmarkFrameCount = 200;
+// Every node without a parent starts a new tree, about one in this many
+static constexpr Uint32 cBenchmarkRootInterval = 1000;
+static constexpr float cBenchmarkTolerance = 1e-3f;
+
+// Deterministic, so runs can be compared
+static Uint32 NextRandom(Uint32 &ioState) {
+    ioState ^= ioState << 13;
+    ioState ^= ioState >> 17;
+    ioState ^= ioState << 5;
+    return ioState;
+}
+
+static float NextRandomFloat(Uint32 &ioState) {
+    return static_cast<float>(NextRandom(ioState) >> 8) / static_cast<float>(1 << 24);
+}
+
+static Transform MakeRandomTransform(Uint32 &ioState) {
+    Transform transform;
+    transform.mPosition = glm::vec3(NextRandomFloat(ioState), NextRandomFloat(ioState), NextRandomFloat(ioState)) * 2.0f - 1.0f;
+    transform.mRotation = glm::angleAxis(NextRandomFloat(ioState) * 6.2831853f, glm::vec3(0.0f, 1.0f, 0.0f));
+    return transform;
+}
+
+bool RunTransformHierarchyBenchmark(Uint32 inNodeCount, float inChangedFraction) {
+    if (inNodeCount == 0) {
+        return false;
+    }
+
+    Uint32 random_state = 0x9e3779b9;
+    Uint32 changed_count = SDL_max(static_cast<Uint32>(static_cast<float>(inNodeCount) * inChangedFraction), 1u);
+
+    // Parents are picked among the nodes before, which gives a few deep chains and many shallow subtrees
+    TransformHierarchy hierarchy;
+    hierarchy.Reserve(inNodeCount);
+
+    eastl::vector<Uint32> parents(inNodeCount);
+    eastl::vector<Transform> local_transforms(inNodeCount);
+    for (Uint32 i = 0; i < inNodeCount; i++) {
+        parents[i] = i % cBenchmarkRootInterval == 0 ? cInvalidTransformNode : NextRandom(random_state) % i;
+        local_transforms[i] = MakeRandomTransform(random_state);
+        hierarchy.Create(parents[i], local_transforms[i]);
+    }
+
+    Uint64 start_time = SDL_GetTicksNS();
+    hierarchy.Update();
+    Uint64 initial_time = SDL_GetTicksNS() - start_time;
+
+    Uint64 incremental_time = 0;
+    Uint64 max_incremental_time = 0;
+    Uint64 updated_count = 0;
+    Uint64 full_time = 0;
+
+    // What recomputing everything costs, the nodes are in creation order and every parent comes before its children
+    eastl::vector<glm::mat4> full_matrices(inNodeCount);
+
+    for (Uint32 frame = 0; frame < cBenchmarkFrameCount; frame++) {
+        for (Uint32 i = 0; i < changed_count; i++) {
+            TransformNodeID node = NextRandom(random_state) % inNodeCount;
+            local_transforms[node] = MakeRandomTransform(random_state);
+            hierarchy.SetLocalTransform(node, local_transforms[node]);
+        }
+
+        start_time = SDL_GetTicksNS();
+        hierarchy.Update();
+        Uint64 frame_time = SDL_GetTicksNS() - start_time;
+
+        incremental_time += frame_time;
+        max_incremental_time = SDL_max(max_incremental_time, frame_time);
+        updated_count += hierarchy.GetUpdatedCount();
+
+        start_time = SDL_GetTicksNS();
+        for (Uint32 i = 0; i < inNodeCount; i++) {
+            glm::mat4 local_matrix = local_transforms[i].GetModelMatrix();
+            full_matrices[i] = parents[i] == cInvalidTransformNode ? local_matrix : full_matrices[parents[i]] * local_matrix;
+        }
+        full_time += SDL_GetTicksNS() - start_time;
+    }
+
+    for (Uint32 i = 0; i < inNodeCount; i++) {
+        const glm::mat4 &matrix = hierarchy.GetWorldMatrix(i);
+        for (int column = 0; column < 4; column++) {
+            glm::vec4 difference = glm::abs(matrix[column] - full_matrices[i][column]);
+            if (glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w)) > cBenchmarkTolerance) {
+                LOG_ERROR("World matrix of node %u doesn't match a full recompute\n", i);
+                return false;
+            }
+        }
+    }
+
+    double incremental_ms = static_cast<double>(incremental_time) / 1e6 / cBenchmarkFrameCount;
+    double full_ms = static_cast<double>(full_time) / 1e6 / cBenchmarkFrameCount;
+
+    LOG_INFO("Transform hierarchy of %u nodes, %u changed per frame over %u frames:\n", inNodeCount, changed_count, cBenchmarkFrameCount);
+    LOG_INFO("  initial update   %8.3f ms\n", static_cast<double>(initial_time) / 1e6);
+    LOG_INFO("  incremental      %8.3f ms/frame (max %.3f), %.0f nodes recomputed per frame\n",
+        incremental_ms,
+        static_cast<double>(max_incremental_time) / 1e6,
+        static_cast<double>(updated_count) / cBenchmarkFrameCount);
+    LOG_INFO("  full recompute   %8.3f ms/frame, %.1fx the incremental update\n",
+        full_ms,
+        incremental_ms > 0.0 ? full_ms / incremental_ms : 0.0);
+
+    return true;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Build a random hierarchy, move a fraction of its nodes every frame and log how long the incremental update takes
+// against recomputing every world matrix, checking that both end up with the same matrices. Needs nothing but the
+// CPU, so it runs before anything else is initialized.
+bool RunTransformHierarchyBenchmark(Uint32 inNodeCount, float inChangedFraction);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+
+#include "graphics/MeshHandle.hpp"
+#include "graphics/RenderService.hpp"
+#include "physics/PhysicsStreamer.hpp"
+#include "TransformHierarchy.hpp"
+
+// Laid out so it can be pushed to the vertex shader as is
+struct TransformComponent {
+    glm::mat4 mModelMatrix;
+    glm::mat4 mNormalMatrix;
+};
+
+// An entity placed through the scene's TransformHierarchy, its TransformComponent follows the node's world matrix.
+// The root is the node the scene file places, the node is the one the mesh is drawn with, which is below the root
+// when the model has a node hierarchy of its own.
+struct HierarchyComponent {
+    TransformNodeID mRoot;
+    TransformNodeID mNode;
+};
+
+struct MeshComponent {
+    MeshHandle *mMesh;
+};
+
+struct MaterialComponent {
+    MaterialID mMaterialID;
+};
+
+struct BodyComponent {
+    JPH::BodyID mBodyID;
+};
+
+// A body owned by the PhysicsStreamer, it only exists while its cell is loaded
+struct StreamedBodyComponent {
+    StreamedBodyID mStreamedBody;
+};
+
+// Bounding sphere in world space
+struct BoundsComponent {
+    glm::vec3 mCenter;
+    float mRadius;
+};
+
+// Tag for entities drawn without lighting, such as light sources
+struct UnlitComponent {};
+
+// Tag for entities that light the scene, the position is taken from the root of their HierarchyComponent
+struct LightComponent {};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Handle to an entity in a Registry, the generation detects handles to entities that have since been destroyed
+struct Entity {
+    static constexpr Uint32 cInvalidIndex = 0xffffffff;
+
+    Uint32 mIndex = cInvalidIndex;
+    Uint32 mGeneration = 0;
+
+    inline bool IsInvalid() const {
+        return mIndex == cInvalidIndex;
+    }
+
+    inline bool operator==(const Entity &inOther) const {
+        return mIndex == inOther.mIndex && mGeneration == inOther.mGeneration;
+    }
+
+    inline bool operator!=(const Entity &inOther) const {
+        return !(*this == inOther);
+    }
+};
@@ -0,0 +1,184 @@
+#include "Registry.hpp"
+
+#include "memory/MemoryService.hpp"
+
+#include <cstring>
+
+struct ComponentTypeInfo {
+    Uint32 mSize;
+    Uint32 mAlignment;
+};
+
+static ComponentTypeInfo sComponentTypes[cMaxComponents];
+static Uint32 sComponentTypeCount = 0;
+
+ComponentID RegisterComponentType(Uint32 inSize, Uint32 inAlignment) {
+    SDL_assert(sComponentTypeCount < cMaxComponents);
+
+    sComponentTypes[sComponentTypeCount] = { inSize, inAlignment };
+    return sComponentTypeCount++;
+}
+
+Uint32 GetComponentSize(ComponentID inComponentID) {
+    return sComponentTypes[inComponentID].mSize;
+}
+
+Uint32 GetComponentAlignment(ComponentID inComponentID) {
+    return sComponentTypes[inComponentID].mAlignment;
+}
+
+// Lay out the entity column followed by every component column, returns the number of bytes used
+static Uint32 LayoutChunk(ComponentMask inMask, Uint32 inCapacity, Uint32 *outColumnOffsets) {
+    Uint32 offset = sizeof(Entity) * inCapacity;
+
+    for (ComponentID id = 0; id < cMaxComponents; id++) {
+        if ((inMask & (ComponentMask(1) << id)) == 0) {
+            continue;
+        }
+
+        Uint32 alignment = GetComponentAlignment(id);
+        offset = (offset + alignment - 1) & ~(alignment - 1);
+        outColumnOffsets[id] = offset;
+        offset += GetComponentSize(id) * inCapacity;
+    }
+
+    return offset;
+}
+
+Registry::~Registry() {
+    Clear();
+}
+
+Uint32 Registry::GetOrCreateArchetype(ComponentMask inMask) {
+    auto it = mArchetypeLookup.find(inMask);
+    if (it != mArchetypeLookup.end()) {
+        return it->second;
+    }
+
+    Archetype archetype;
+    archetype.mMask = inMask;
+    SDL_zeroa(archetype.mColumnOffsets);
+
+    // Start from the capacity without padding and shrink it until the aligned layout fits
+    Uint32 row_size = sizeof(Entity);
+    for (ComponentID id = 0; id < cMaxComponents; id++) {
+        if ((inMask & (ComponentMask(1) << id)) != 0) {
+            row_size += GetComponentSize(id);
+        }
+    }
+
+    Uint32 capacity = cChunkSize / row_size;
+    while (capacity > 1 && LayoutChunk(inMask, capacity, archetype.mColumnOffsets) > cChunkSize) {
+        capacity--;
+    }
+
+    // Rows larger than a chunk still get one entity per chunk
+    SDL_assert(capacity > 0);
+    archetype.mChunkCapacity = capacity;
+    LayoutChunk(inMask, capacity, archetype.mColumnOffsets);
+
+    Uint32 index = static_cast<Uint32>(mArchetypes.size());
+    mArchetypes.push_back(archetype);
+    mArchetypeLookup[inMask] = index;
+
+    return index;
+}
+
+Entity Registry::AllocateEntity(Uint32 inArchetype, Uint8 *&outChunkData, Uint32 &outRow) {
+    Archetype &archetype = mArchetypes[inArchetype];
+
+    if (archetype.mChunks.empty() || archetype.mChunks.back().mCount == archetype.mChunkCapacity) {
+        Uint32 size = LayoutChunk(archetype.mMask, archetype.mChunkCapacity, archetype.mColumnOffsets);
+        Uint32 chunk_size = size > cChunkSize ? size : cChunkSize;
+
+        ArchetypeChunk chunk;
+        chunk.mData = static_cast<Uint8 *>(MemoryService::Get().Allocate(chunk_size, 64, MemoryTag::Containers));
+        chunk.mCount = 0;
+        archetype.mChunks.push_back(chunk);
+    }
+
+    Uint32 chunk_index = static_cast<Uint32>(archetype.mChunks.size() - 1);
+    ArchetypeChunk &chunk = archetype.mChunks[chunk_index];
+    Uint32 row = chunk.mCount++;
+
+    Entity entity;
+    if (mFreeIndices.empty()) {
+        entity.mIndex = static_cast<Uint32>(mRecords.size());
+        entity.mGeneration = 0;
+        mRecords.push_back({ 0, 0, 0, 0 });
+    } else {
+        entity.mIndex = mFreeIndices.back();
+        entity.mGeneration = mRecords[entity.mIndex].mGeneration;
+        mFreeIndices.pop_back();
+    }
+
+    mRecords[entity.mIndex] = { entity.mGeneration, inArchetype, chunk_index, row };
+    GetEntityColumn(chunk)[row] = entity;
+    mEntityCount++;
+
+    outChunkData = chunk.mData;
+    outRow = row;
+    return entity;
+}
+
+void Registry::Destroy(Entity inEntity) {
+    if (!IsValid(inEntity)) {
+        return;
+    }
+
+    EntityRecord &record = mRecords[inEntity.mIndex];
+    Archetype &archetype = mArchetypes[record.mArchetype];
+    ArchetypeChunk &chunk = archetype.mChunks[record.mChunk];
+    ArchetypeChunk &last_chunk = archetype.mChunks.back();
+    Uint32 last_row = last_chunk.mCount - 1;
+
+    // Fill the hole with the last entity of the archetype so all chunks stay densely packed
+    if (&chunk != &last_chunk || record.mRow != last_row) {
+        Entity moved = GetEntityColumn(last_chunk)[last_row];
+        GetEntityColumn(chunk)[record.mRow] = moved;
+
+        for (ComponentID id = 0; id < cMaxComponents; id++) {
+            if ((archetype.mMask & (ComponentMask(1) << id)) == 0) {
+                continue;
+            }
+
+            Uint32 size = GetComponentSize(id);
+            Uint32 offset = archetype.mColumnOffsets[id];
+            memcpy(chunk.mData + offset + size * record.mRow, last_chunk.mData + offset + size * last_row, size);
+        }
+
+        EntityRecord &moved_record = mRecords[moved.mIndex];
+        moved_record.mChunk = record.mChunk;
+        moved_record.mRow = record.mRow;
+    }
+
+    last_chunk.mCount--;
+    if (last_chunk.mCount == 0) {
+        MemoryService::Get().Free(last_chunk.mData);
+        archetype.mChunks.pop_back();
+    }
+
+    // Bump the generation so old handles to this entity become invalid
+    record.mGeneration++;
+    mFreeIndices.push_back(inEntity.mIndex);
+    mEntityCount--;
+}
+
+void Registry::Clear() {
+    for (Archetype &archetype : mArchetypes) {
+        for (ArchetypeChunk &chunk : archetype.mChunks) {
+            MemoryService::Get().Free(chunk.mData);
+        }
+    }
+
+    mArchetypes.clear();
+    mArchetypeLookup.clear();
+    mRecords.clear();
+    mFreeIndices.clear();
+    mEntityCount = 0;
+}
+
+bool Registry::IsValid(Entity inEntity) const {
+    // Destroying an entity bumps the generation of its record, so stale handles never match
+    return inEntity.mIndex < mRecords.size() && mRecords[inEntity.mIndex].mGeneration == inEntity.mGeneration;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <EASTL/vector.h>
+#include <EASTL/hash_map.h>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+
+#include <type_traits>
+
+#include "Entity.hpp"
+#include "jobs/ParallelFor.hpp"
+
+using ComponentID = Uint32;
+using ComponentMask = Uint64;
+
+static constexpr Uint32 cMaxComponents = 64;
+
+// Components are copied around with memcpy when entities move, so they have to be plain data
+ComponentID RegisterComponentType(Uint32 inSize, Uint32 inAlignment);
+Uint32 GetComponentSize(ComponentID inComponentID);
+Uint32 GetComponentAlignment(ComponentID inComponentID);
+
+template <typename T>
+inline ComponentID GetComponentID() {
+    static_assert(std::is_trivially_copyable_v<T>, "Components must be trivially copyable");
+    static const ComponentID id = RegisterComponentType(sizeof(T), alignof(T));
+    return id;
+}
+
+template <typename... Ts>
+inline ComponentMask GetComponentMask() {
+    return ((ComponentMask(1) << GetComponentID<Ts>()) | ... | ComponentMask(0));
+}
+
+// A fixed-size block holding a number of entities of one archetype, with each component stored as its own array
+struct ArchetypeChunk {
+    Uint8 *mData;
+    Uint32 mCount;
+};
+
+// All entities with exactly the same set of components
+struct Archetype {
+    ComponentMask mMask;
+    Uint32 mChunkCapacity;
+    Uint32 mColumnOffsets[cMaxComponents];
+    eastl::vector<ArchetypeChunk> mChunks;
+};
+
+// Stores entities grouped by archetype in structure-of-arrays chunks, so iterating a set of components walks
+// tightly packed arrays. Entities are created with their full set of components and keep it for their lifetime.
+class Registry {
+private:
+    static constexpr Uint32 cChunkSize = 16 * 1024;
+
+    struct EntityRecord {
+        Uint32 mGeneration;
+        Uint32 mArchetype;
+        Uint32 mChunk;
+        Uint32 mRow;
+    };
+
+    eastl::vector<Archetype> mArchetypes;
+    eastl::hash_map<ComponentMask, Uint32> mArchetypeLookup;
+
+    eastl::vector<EntityRecord> mRecords;
+    eastl::vector<Uint32> mFreeIndices;
+    size_t mEntityCount = 0;
+
+    // Chunks gathered for a parallel iteration, kept around to avoid allocating every call
+    eastl::vector<ArchetypeChunk *> mParallelChunks;
+    eastl::vector<Archetype *> mParallelArchetypes;
+
+    Uint32 GetOrCreateArchetype(ComponentMask inMask);
+    Entity AllocateEntity(Uint32 inArchetype, Uint8 *&outChunkData, Uint32 &outRow);
+
+    template <typename T>
+    static inline T *GetColumn(const Archetype &inArchetype, const ArchetypeChunk &inChunk) {
+        return reinterpret_cast<T *>(inChunk.mData + inArchetype.mColumnOffsets[GetComponentID<T>()]);
+    }
+
+    static inline Entity *GetEntityColumn(const ArchetypeChunk &inChunk) {
+        return reinterpret_cast<Entity *>(inChunk.mData);
+    }
+
+    template <typename T>
+    static inline void WriteComponent(const Archetype &inArchetype, Uint8 *inChunkData, Uint32 inRow, const T &inValue) {
+        reinterpret_cast<T *>(inChunkData + inArchetype.mColumnOffsets[GetComponentID<T>()])[inRow] = inValue;
+    }
+
+public:
+    Registry() = default;
+    ~Registry();
+
+    Registry(const Registry &) = delete;
+    Registry &operator=(const Registry &) = delete;
+
+    template <typename... Ts>
+    Entity Create(const Ts &...inComponents) {
+        Uint32 archetype_index = GetOrCreateArchetype(GetComponentMask<Ts...>());
+
+        Uint8 *chunk_data;
+        Uint32 row;
+        Entity entity = AllocateEntity(archetype_index, chunk_data, row);
+
+        const Archetype &archetype = mArchetypes[archetype_index];
+        (WriteComponent<Ts>(archetype, chunk_data, row, inComponents), ...);
+
+        return entity;
+    }
+
+    void Destroy(Entity inEntity);
+    void Clear();
+
+    bool IsValid(Entity inEntity) const;
+
+    template <typename T>
+    bool Has(Entity inEntity) const {
+        if (!IsValid(inEntity)) {
+            return false;
+        }
+
+        return (mArchetypes[mRecords[inEntity.mIndex].mArchetype].mMask & GetComponentMask<T>()) != 0;
+    }
+
+    template <typename T>
+    T &Get(Entity inEntity) {
+        SDL_assert(Has<T>(inEntity));
+
+        const EntityRecord &record = mRecords[inEntity.mIndex];
+        const Archetype &archetype = mArchetypes[record.mArchetype];
+        return GetColumn<T>(archetype, archetype.mChunks[record.mChunk])[record.mRow];
+    }
+
+    // Call a function for every entity that has at least the given components
+    template <typename... Ts, typename F>
+    void ForEach(F &&inFunction) {
+        ComponentMask mask = GetComponentMask<Ts...>();
+
+        for (Archetype &archetype : mArchetypes) {
+            if ((archetype.mMask & mask) != mask) {
+                continue;
+            }
+
+            for (ArchetypeChunk &chunk : archetype.mChunks) {
+                Entity *entities = GetEntityColumn(chunk);
+
+                for (Uint32 row = 0; row < chunk.mCount; row++) {
+                    inFunction(entities[row], GetColumn<Ts>(archetype, chunk)[row]...);
+                }
+            }
+        }
+    }
+
+    // Like ForEach, but chunks are spread over the job system. The function must be safe to call from multiple threads.
+    template <typename... Ts, typename F>
+    void ParallelForEach(JPH::JobSystem &inJobSystem, F &&inFunction) {
+        ComponentMask mask = GetComponentMask<Ts...>();
+
+        mParallelChunks.clear();
+        mParallelArchetypes.clear();
+
+        for (Archetype &archetype : mArchetypes) {
+            if ((archetype.mMask & mask) != mask) {
+                continue;
+            }
+
+            for (ArchetypeChunk &chunk : archetype.mChunks) {
+                mParallelChunks.push_back(&chunk);
+                mParallelArchetypes.push_back(&archetype);
+            }
+        }
+
+        if (mParallelChunks.empty()) {
+            return;
+        }
+
+        // Chunks are handed out one at a time, so the job count stays bounded however many entities there are
+        ParallelFor(&inJobSystem, "ForEachChunk", mParallelChunks.size(), [this, &inFunction](size_t inIndex) {
+            const Archetype &archetype = *mParallelArchetypes[inIndex];
+            const ArchetypeChunk &chunk = *mParallelChunks[inIndex];
+
+            Entity *entities = GetEntityColumn(chunk);
+
+            for (Uint32 row = 0; row < chunk.mCount; row++) {
+                inFunction(entities[row], GetColumn<Ts>(archetype, chunk)[row]...);
+            }
+        });
+    }
+
+    inline size_t GetEntityCount() const {
+        return mEntityCount;
+    }
+
+    inline size_t GetArchetypeCount() const {
+        return mArchetypes.size();
+    }
+};
@@ -2,6 +2,8 @@
 
 #include <SDL3/SDL.h>
 
+#include "TextureStreamer.hpp"
+
 struct MeshHandle {
     SDL_GPUBuffer *mVertexBuffer;
     SDL_GPUBuffer *mIndexBuffer;
@@ -9,4 +11,6 @@ struct MeshHandle {
     Uint32 mIndexSize;
     Uint32 mVertexCount;
     Uint32 mIndexCount;
+    // Streamed albedo texture, cInvalidTexture when the mesh only uses its material color
+    TextureID mAlbedoTexture;
 };
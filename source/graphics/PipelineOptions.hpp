@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Fixed-function state that differs between the engine's pipelines, the defaults describe a regular opaque mesh pipeline
+struct PipelineOptions {
+    SDL_GPUCompareOp mDepthCompareOp = SDL_GPU_COMPAREOP_LESS;
+    bool mEnableDepthWrite = true;
+
+    // Invalid uses the swapchain format
+    SDL_GPUTextureFormat mColorFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
+    bool mEnableColorWrite = true;
+    bool mIsAdditive = false;
+
+    // Single sampled pipelines render into offscreen targets instead of the main color target
+    bool mIsSingleSampled = false;
+
+    // Only feed the position attribute to the vertex shader
+    bool mIsPositionOnly = false;
+};
@@ -0,0 +1,176 @@
+#include "RenderGraph.hpp"
+
+#include "macros/log.hpp"
+
+#include <EASTL/algorithm.h>
+
+static constexpr RenderPassID cNoPass = 0xffffffff;
+
+RenderResourceID RenderGraph::CreateTexture(const char *inName, const RenderTargetDesc &inDesc, bool inIsExactSize) {
+    mResources.push_back({ inName, inDesc, inIsExactSize, false, false, nullptr, 0, cNoPass, cNoPass, cNoPass });
+    return static_cast<RenderResourceID>(mResources.size() - 1);
+}
+
+RenderResourceID RenderGraph::ImportTexture(const char *inName, SDL_GPUTexture *inTexture, Uint32 inWidth, Uint32 inHeight) {
+    RenderTargetDesc desc = {};
+    desc.mWidth = inWidth;
+    desc.mHeight = inHeight;
+
+    mResources.push_back({ inName, desc, true, true, false, inTexture, 0, cNoPass, cNoPass, cNoPass });
+    return static_cast<RenderResourceID>(mResources.size() - 1);
+}
+
+void RenderGraph::MarkOutput(RenderResourceID inResource) {
+    mResources[inResource].mIsOutput = true;
+}
+
+RenderPassID RenderGraph::AddPass(const char *inName, RenderPassFunction &&inFunction) {
+    Pass &pass = mPasses.push_back();
+    pass.mName = inName;
+    pass.mFunction = eastl::move(inFunction);
+    pass.mReferenceCount = 0;
+    pass.mIsCulled = false;
+
+    return static_cast<RenderPassID>(mPasses.size() - 1);
+}
+
+void RenderGraph::Read(RenderPassID inPass, RenderResourceID inResource) {
+    mPasses[inPass].mReads.push_back(inResource);
+}
+
+void RenderGraph::Write(RenderPassID inPass, RenderResourceID inResource) {
+    mPasses[inPass].mWrites.push_back(inResource);
+
+    // Passes are added in execution order, so the last writer is the one later readers see
+    mResources[inResource].mProducer = inPass;
+}
+
+void RenderGraph::Compile() {
+    mStats = {};
+    mStats.mPassCount = static_cast<Uint32>(mPasses.size());
+
+    // A pass is referenced by every resource it writes, a resource by every pass that reads it
+    for (Pass &pass : mPasses) {
+        pass.mReferenceCount = static_cast<Uint32>(pass.mWrites.size());
+        pass.mIsCulled = false;
+
+        for (RenderResourceID resource : pass.mReads) {
+            mResources[resource].mReaderCount++;
+        }
+    }
+
+    // Outputs are read by whoever comes after the frame
+    eastl::vector<RenderResourceID> unreferenced;
+    for (RenderResourceID i = 0; i < mResources.size(); i++) {
+        Resource &resource = mResources[i];
+        if (resource.mIsOutput) {
+            resource.mReaderCount++;
+        }
+
+        if (resource.mReaderCount == 0) {
+            unreferenced.push_back(i);
+        }
+    }
+
+    // Walk back from the unread resources, culling producers that end up without a reason to run
+    while (!unreferenced.empty()) {
+        RenderResourceID resource_id = unreferenced.back();
+        unreferenced.pop_back();
+
+        RenderPassID producer = mResources[resource_id].mProducer;
+        if (producer == cNoPass) {
+            continue;
+        }
+
+        Pass &pass = mPasses[producer];
+        if (pass.mReferenceCount == 0 || --pass.mReferenceCount > 0) {
+            continue;
+        }
+
+        pass.mIsCulled = true;
+        mStats.mCulledPassCount++;
+
+        for (RenderResourceID read : pass.mReads) {
+            if (--mResources[read].mReaderCount == 0) {
+                unreferenced.push_back(read);
+            }
+        }
+    }
+
+    // Lifetimes only count the surviving passes
+    for (RenderPassID i = 0; i < mPasses.size(); i++) {
+        const Pass &pass = mPasses[i];
+        if (pass.mIsCulled) {
+            continue;
+        }
+
+        auto use = [&](RenderResourceID inResource) {
+            Resource &resource = mResources[inResource];
+            if (resource.mFirstPass == cNoPass) {
+                resource.mFirstPass = i;
+            }
+            resource.mLastPass = i;
+        };
+
+        for (RenderResourceID resource : pass.mReads) {
+            use(resource);
+        }
+
+        for (RenderResourceID resource : pass.mWrites) {
+            use(resource);
+        }
+    }
+
+    for (const Resource &resource : mResources) {
+        if (!resource.mIsImported && resource.mFirstPass != cNoPass) {
+            mStats.mTransientCount++;
+        }
+    }
+}
+
+void RenderGraph::Execute(SDL_GPUCommandBuffer *inCommandBuffer, RenderTargetPool &inPool) {
+    // Textures released by transients that are done, handed out again before the pool is asked
+    eastl::fixed_vector<SDL_GPUTexture *, 8> released;
+
+    for (RenderPassID i = 0; i < mPasses.size(); i++) {
+        Pass &pass = mPasses[i];
+        if (pass.mIsCulled) {
+            continue;
+        }
+
+        for (Resource &resource : mResources) {
+            if (resource.mIsImported || resource.mFirstPass != i) {
+                continue;
+            }
+
+            resource.mTexture = inPool.Acquire(resource.mDesc, resource.mIsExactSize);
+            if (resource.mTexture == nullptr) {
+                LOG_ERROR("Unable to allocate %s for pass %s", resource.mName, pass.mName);
+                continue;
+            }
+
+            // The pool hands out the texture of a transient that already ended this frame first
+            if (eastl::find(released.begin(), released.end(), resource.mTexture) != released.end()) {
+                mStats.mAliasedCount++;
+            }
+        }
+
+        pass.mFunction(*this, inCommandBuffer);
+
+        for (Resource &resource : mResources) {
+            if (resource.mIsImported || resource.mLastPass != i || resource.mTexture == nullptr) {
+                continue;
+            }
+
+            inPool.Release(resource.mTexture);
+            if (!released.full()) {
+                released.push_back(resource.mTexture);
+            }
+        }
+    }
+}
+
+void RenderGraph::Reset() {
+    mResources.clear();
+    mPasses.clear();
+}
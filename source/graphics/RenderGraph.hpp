@@ -0,0 +1,99 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <EASTL/fixed_vector.h>
+#include <EASTL/functional.h>
+#include <EASTL/vector.h>
+
+#include "RenderTargetPool.hpp"
+
+using RenderResourceID = Uint32;
+using RenderPassID = Uint32;
+
+static constexpr RenderResourceID cInvalidRenderResource = 0xffffffff;
+
+class RenderGraph;
+
+// Records a pass into the frame's command buffer, the pass begins and ends its own GPU pass
+using RenderPassFunction = eastl::function<void(RenderGraph &inGraph, SDL_GPUCommandBuffer *inCommandBuffer)>;
+
+struct RenderGraphStats {
+    Uint32 mPassCount;
+    Uint32 mCulledPassCount;
+    Uint32 mTransientCount;
+    // Transients that got a texture another transient of the same frame was done with
+    Uint32 mAliasedCount;
+};
+
+// One frame of passes that declare which textures they read and write. Compiling the graph culls the passes
+// that nothing depends on and works out the lifetime of every transient texture. Executing it only holds a pooled
+// texture from a transient's first use to its last, so later transients alias the memory of earlier ones.
+// The graph is rebuilt every frame.
+class RenderGraph {
+private:
+    struct Resource {
+        const char *mName;
+        RenderTargetDesc mDesc;
+        bool mIsExactSize;
+        bool mIsImported;
+        bool mIsOutput;
+
+        SDL_GPUTexture *mTexture;
+
+        // Passes that read the resource, and the first and last surviving pass that uses it
+        Uint32 mReaderCount;
+        RenderPassID mProducer;
+        RenderPassID mFirstPass;
+        RenderPassID mLastPass;
+    };
+
+    struct Pass {
+        const char *mName;
+        RenderPassFunction mFunction;
+        eastl::fixed_vector<RenderResourceID, 4> mReads;
+        eastl::fixed_vector<RenderResourceID, 4> mWrites;
+
+        Uint32 mReferenceCount;
+        bool mIsCulled;
+    };
+
+    eastl::vector<Resource> mResources;
+    eastl::vector<Pass> mPasses;
+    RenderGraphStats mStats = {};
+
+public:
+    // A texture owned by the graph that only lives for part of the frame
+    RenderResourceID CreateTexture(const char *inName, const RenderTargetDesc &inDesc, bool inIsExactSize);
+    // A texture owned by someone else, such as the swapchain
+    RenderResourceID ImportTexture(const char *inName, SDL_GPUTexture *inTexture, Uint32 inWidth, Uint32 inHeight);
+    // Keep the passes that write the resource, even if no other pass reads it
+    void MarkOutput(RenderResourceID inResource);
+
+    RenderPassID AddPass(const char *inName, RenderPassFunction &&inFunction);
+    void Read(RenderPassID inPass, RenderResourceID inResource);
+    void Write(RenderPassID inPass, RenderResourceID inResource);
+
+    void Compile();
+    // Run the surviving passes in the order they were added, textures come from and go back to the pool
+    void Execute(SDL_GPUCommandBuffer *inCommandBuffer, RenderTargetPool &inPool);
+    void Reset();
+
+    // The texture behind a resource, only valid while a pass that uses it executes
+    inline SDL_GPUTexture *GetTexture(RenderResourceID inResource) const {
+        return mResources[inResource].mTexture;
+    }
+
+    // The size the resource was declared with, the pooled texture can be larger
+    inline Uint32 GetWidth(RenderResourceID inResource) const {
+        return mResources[inResource].mDesc.mWidth;
+    }
+
+    inline Uint32 GetHeight(RenderResourceID inResource) const {
+        return mResources[inResource].mDesc.mHeight;
+    }
+
+    inline const RenderGraphStats &GetStats() const {
+        return mStats;
+    }
+};
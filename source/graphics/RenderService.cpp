@@ -3,24 +3,34 @@
 #include "macros/log.hpp"
 
 #include "Context.hpp"
+#include "InputService.hpp"
 #include "vertices/PositionNormalTextureVertex.hpp"
 
 #include <EASTL/vector.h>
 
 #include <SDL_gpu_shadercross.h>
 
+// Frames the window size has to hold still before targets are allocated at its exact size
+static constexpr Uint32 cStableFrameCount = 30;
+
 // Shader source code
 #include "shaders/basic_triangle.vert.h"
 #include "shaders/basic_triangle.frag.h"
 #include "shaders/light_source.vert.h"
 #include "shaders/light_source.frag.h"
+#include "shaders/depth_only.vert.h"
+#include "shaders/depth_only.frag.h"
+#include "shaders/overdraw.frag.h"
 
 #include "ShaderCreateInfo.hpp"
 #include "PipelineCreateInfo.hpp"
 
 #include "RenderState.hpp"
 
-bool RenderService::Initialize(SDL_Window *inWindow) {
+#include "memory/FrameMemoryService.hpp"
+#include "memory/MemoryService.hpp"
+
+bool RenderService::Initialize(SDL_Window *inWindow, SDL_GPUSampleCount inSampleCount) {
     assert(inWindow != nullptr);
     mWindow = inWindow;
 
@@ -39,95 +49,223 @@ bool RenderService::Initialize(SDL_Window *inWindow) {
         return false;
     }
 
-    // Determine the renderer's sample count
-    mSampleCount = SDL_GPU_SAMPLECOUNT_1;
-    if (SDL_GPUTextureSupportsSampleCount(
-        mDevice,
-        SDL_GetGPUSwapchainTextureFormat(mDevice, mWindow),
-        SDL_GPU_SAMPLECOUNT_4)) {
-            // If the renderer supports 4x MSAA, use it
-            mSampleCount = SDL_GPU_SAMPLECOUNT_4;
-        }
+    mColorFormat = SDL_GetGPUSwapchainTextureFormat(mDevice, mWindow);
 
-    mDepthTexture = CreateDepthTexture(window_width, window_height);
-    if (mDepthTexture == nullptr) {
-        return false;
+    // Step down from the requested sample count until the swapchain format supports it
+    mSampleCount = inSampleCount;
+    while (mSampleCount != SDL_GPU_SAMPLECOUNT_1 && !SDL_GPUTextureSupportsSampleCount(mDevice, mColorFormat, mSampleCount)) {
+        mSampleCount = static_cast<SDL_GPUSampleCount>(mSampleCount - 1);
     }
 
+    mTargetWidth = static_cast<Uint32>(window_width);
+    mTargetHeight = static_cast<Uint32>(window_height);
+
+    // Render targets are created by the pool the first time a frame needs them
+    mTargetPool.Initialize(mDevice);
+
+    UpdateResolveSavings();
+
     if (mSampleCount != SDL_GPU_SAMPLECOUNT_1) {
-        // We don't need to error check these because MSAA is optional
-        mMSAATexture = CreateMSAATexture(window_width, window_height);
-        mResolveTexture = CreateResolveTexture(window_width, window_height);
+        LOG_INFO("Using %ux MSAA, resolving into the swapchain saves %.2f MB of memory and %.2f MB of bandwidth per frame",
+            1u << static_cast<Uint32>(mSampleCount),
+            static_cast<double>(mResolveStats.mSavedMemory) / (1024.0 * 1024.0),
+            static_cast<double>(mResolveStats.mSavedBandwidthPerFrame) / (1024.0 * 1024.0));
+    }
+
+    // Room for a typical scene, both buffers grow when needed
+    if (!mInstanceBuffer.Initialize(mDevice, sizeof(InstanceData) * 1024) ||
+        !mMaterialBuffer.Initialize(mDevice, sizeof(Material) * 64)) {
+        return false;
+    }
+
+    if (!mTextureStreamer.Initialize(mDevice)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool RenderService::CreatePipelines() {
+    // Vertex shaders read the instance buffer and take the view constants and draw indices as uniforms.
+    // The lit one is kept, lit pipelines are only built for the variants that get drawn.
+    mLitVertexShader = CreateShaderVariant(
+        SDL_GPU_SHADERSTAGE_VERTEX,
+        BASIC_TRIANGLE_VERT_SHADER_VARIANTS,
+        BASIC_TRIANGLE_VERT_SHADER_VARIANTS_COUNT,
+        0,
+        0, 2, 1, 0
+    );
+
+    if (mLitVertexShader == nullptr) {
+        return false;
     }
 
-    SDL_GPUShader *basic_triangle_vert = RenderService::Get().CreateShader(
+    SDL_GPUShader *light_source_vert = CreateShaderVariant(
         SDL_GPU_SHADERSTAGE_VERTEX,
-        (const Uint8 *)BASIC_TRIANGLE_VERT_SHADER,
-        BASIC_TRIANGLE_VERT_SHADER_SIZE,
-        0, 1, 0, 0
+        LIGHT_SOURCE_VERT_SHADER_VARIANTS,
+        LIGHT_SOURCE_VERT_SHADER_VARIANTS_COUNT,
+        0,
+        0, 2, 1, 0
     );
 
-    SDL_GPUShader *basic_triangle_frag = RenderService::Get().CreateShader(
+    SDL_GPUShader *light_source_frag = CreateShaderVariant(
         SDL_GPU_SHADERSTAGE_FRAGMENT,
-        (const Uint8 *)BASIC_TRIANGLE_FRAG_SHADER,
-        BASIC_TRIANGLE_FRAG_SHADER_SIZE,
-        0, 2, 0, 0
+        LIGHT_SOURCE_FRAG_SHADER_VARIANTS,
+        LIGHT_SOURCE_FRAG_SHADER_VARIANTS_COUNT,
+        0,
+        0, 0, 0, 0
     );
 
-    CreatePipeline("default_mesh", basic_triangle_vert, basic_triangle_frag);
+    bool is_created = CreatePipeline("light_source", light_source_vert, light_source_frag);
+
+    DestroyShader(light_source_vert);
+    DestroyShader(light_source_frag);
 
-    SDL_ReleaseGPUShader(mDevice, basic_triangle_vert);
-    SDL_ReleaseGPUShader(mDevice, basic_triangle_frag);
+    if (!is_created) {
+        return false;
+    }
 
-    SDL_GPUShader *light_source_vert = RenderService::Get().CreateShader(
+    // The depth pre-pass and the overdraw counters only need positions
+    SDL_GPUShader *depth_only_vert = CreateShaderVariant(
         SDL_GPU_SHADERSTAGE_VERTEX,
-        (const Uint8 *)LIGHT_SOURCE_VERT_SHADER,
-        LIGHT_SOURCE_VERT_SHADER_SIZE,
-        0, 1, 0, 0
+        DEPTH_ONLY_VERT_SHADER_VARIANTS,
+        DEPTH_ONLY_VERT_SHADER_VARIANTS_COUNT,
+        0,
+        0, 2, 1, 0
     );
 
-    SDL_GPUShader *light_source_frag = RenderService::Get().CreateShader(
+    SDL_GPUShader *depth_only_frag = CreateShaderVariant(
         SDL_GPU_SHADERSTAGE_FRAGMENT,
-        (const Uint8 *)LIGHT_SOURCE_FRAG_SHADER,
-        LIGHT_SOURCE_FRAG_SHADER_SIZE,
+        DEPTH_ONLY_FRAG_SHADER_VARIANTS,
+        DEPTH_ONLY_FRAG_SHADER_VARIANTS_COUNT,
+        0,
         0, 0, 0, 0
     );
 
-    CreatePipeline("light_source", light_source_vert, light_source_frag);
+    SDL_GPUShader *overdraw_frag = CreateShaderVariant(
+        SDL_GPU_SHADERSTAGE_FRAGMENT,
+        OVERDRAW_FRAG_SHADER_VARIANTS,
+        OVERDRAW_FRAG_SHADER_VARIANTS_COUNT,
+        0,
+        0, 0, 0, 0
+    );
 
-    SDL_ReleaseGPUShader(mDevice, light_source_vert);
-    SDL_ReleaseGPUShader(mDevice, light_source_frag);
+    PipelineOptions prepass_options = {
+        .mEnableColorWrite = false,
+        .mIsPositionOnly = true
+    };
 
-    return true;
+    PipelineOptions overdraw_prepass_options = {
+        .mColorFormat = SDL_GPU_TEXTUREFORMAT_R8_UNORM,
+        .mEnableColorWrite = false,
+        .mIsSingleSampled = true,
+        .mIsPositionOnly = true
+    };
+
+    PipelineOptions overdraw_options = {
+        .mColorFormat = SDL_GPU_TEXTUREFORMAT_R8_UNORM,
+        .mIsAdditive = true,
+        .mIsSingleSampled = true,
+        .mIsPositionOnly = true
+    };
+
+    PipelineOptions overdraw_equal_options = overdraw_options;
+    overdraw_equal_options.mDepthCompareOp = SDL_GPU_COMPAREOP_EQUAL;
+    overdraw_equal_options.mEnableDepthWrite = false;
+
+    is_created =
+        CreatePipeline("depth_prepass", depth_only_vert, depth_only_frag, 0, prepass_options) &&
+        CreatePipeline("overdraw_prepass", depth_only_vert, depth_only_frag, 0, overdraw_prepass_options) &&
+        CreatePipeline("overdraw", depth_only_vert, overdraw_frag, 0, overdraw_options) &&
+        CreatePipeline("overdraw_equal", depth_only_vert, overdraw_frag, 0, overdraw_equal_options);
+
+    DestroyShader(depth_only_vert);
+    DestroyShader(depth_only_frag);
+    DestroyShader(overdraw_frag);
+
+    return is_created;
+}
+
+bool RenderService::PrepareLitPipelines(ShaderKey inKey) {
+    auto it = mPipelines.find("default_mesh");
+    if (it != mPipelines.end() && it->second.find(inKey) != it->second.end()) {
+        return true;
+    }
+
+    // The lit fragment shader reads the material buffer and takes the scene constants as a uniform, textured variants
+    // sample the albedo texture
+    SDL_GPUShader *basic_triangle_frag = CreateShaderVariant(
+        SDL_GPU_SHADERSTAGE_FRAGMENT,
+        BASIC_TRIANGLE_FRAG_SHADER_VARIANTS,
+        BASIC_TRIANGLE_FRAG_SHADER_VARIANTS_COUNT,
+        inKey,
+        (inKey & cShaderKeyAlbedoTexture) ? 1 : 0, 1, 1, 0
+    );
+
+    // The equal variant shades on top of the depth pre-pass, it only passes the closest surface and leaves depth alone
+    PipelineOptions equal_options = {
+        .mDepthCompareOp = SDL_GPU_COMPAREOP_EQUAL,
+        .mEnableDepthWrite = false
+    };
+
+    bool is_created =
+        CreatePipeline("default_mesh", mLitVertexShader, basic_triangle_frag, inKey) &&
+        CreatePipeline("default_mesh_equal", mLitVertexShader, basic_triangle_frag, inKey, equal_options);
+    DestroyShader(basic_triangle_frag);
+
+    return is_created;
 }
 
 void RenderService::DestroyPipeline(const eastl::string &inName) {
     auto it = mPipelines.find(inName);
     if (it != mPipelines.end()) {
-        SDL_ReleaseGPUGraphicsPipeline(mDevice, it->second);
+        for (auto &variant : it->second) {
+            SDL_ReleaseGPUGraphicsPipeline(mDevice, variant.second);
+        }
         mPipelines.erase(it);
     }
 }
 
-void RenderService::UsePipeline(SDL_GPURenderPass *inRenderPass, const eastl::string &inName) const {
+void RenderService::UsePipeline(SDL_GPURenderPass *inRenderPass, const eastl::string &inName, ShaderKey inKey) const {
     auto it = mPipelines.find(inName);
     if (it == mPipelines.end()) {
         LOG_ERROR("Pipeline not found: %s", inName.c_str());
         return;
     }
 
-    SDL_BindGPUGraphicsPipeline(inRenderPass, it->second);
+    auto variant_it = it->second.find(inKey);
+    if (variant_it == it->second.end()) {
+        LOG_ERROR("Pipeline variant not found: %s 0x%04x", inName.c_str(), inKey);
+        return;
+    }
+
+    SDL_BindGPUGraphicsPipeline(inRenderPass, variant_it->second);
 }
 
 void RenderService::Shutdown() {
-    SDL_ReleaseGPUTexture(mDevice, mDepthTexture);
-    SDL_ReleaseGPUTexture(mDevice, mMSAATexture);
-    SDL_ReleaseGPUTexture(mDevice, mResolveTexture);
+    WaitForFrames();
+
+    if (mOverdrawTransferBuffer != nullptr) {
+        SDL_ReleaseGPUTransferBuffer(mDevice, mOverdrawTransferBuffer);
+        mOverdrawTransferBuffer = nullptr;
+    }
+
+    mRenderGraph.Reset();
+    mTargetPool.Shutdown();
 
     for (auto &pair : mPipelines) {
-        SDL_ReleaseGPUGraphicsPipeline(mDevice, pair.second);
+        for (auto &variant : pair.second) {
+            SDL_ReleaseGPUGraphicsPipeline(mDevice, variant.second);
+        }
     }
 
+    DestroyShader(mLitVertexShader);
+    mLitVertexShader = nullptr;
+
+    mInstanceBuffer.Shutdown();
+    mMaterialBuffer.Shutdown();
+    mTextureStreamer.Shutdown();
+
     if (mDevice != nullptr) {
         SDL_ReleaseWindowFromGPUDevice(mDevice, mWindow);
         SDL_DestroyGPUDevice(mDevice);
@@ -136,28 +274,67 @@ void RenderService::Shutdown() {
 }
 
 void RenderService::SetViewport(Uint32 inWidth, Uint32 inHeight) {
-    if (mDepthTexture != nullptr) {
-        DestroyTexture(mDepthTexture);
-        mDepthTexture = CreateDepthTexture(inWidth, inHeight);
+    // Resize events can repeat the current size. Restarting the stable count would send frames through the fallback
+    // resolve target again, which then has to be created for nothing.
+    if (inWidth == mTargetWidth && inHeight == mTargetHeight) {
+        return;
     }
 
-    if (mMSAATexture != nullptr) {
-        DestroyTexture(mMSAATexture);
-        mMSAATexture = CreateMSAATexture(inWidth, inHeight);
-    }
+    // Targets come from the pool, which absorbs the resize, so only the size is recorded
+    mTargetWidth = inWidth;
+    mTargetHeight = inHeight;
+    mStableFrameCount = 0;
+}
 
-    if (mResolveTexture != nullptr) {
-        DestroyTexture(mResolveTexture);
-        mResolveTexture = CreateResolveTexture(inWidth, inHeight);
+void RenderService::UpdateResolveSavings() {
+    if (mSampleCount == SDL_GPU_SAMPLECOUNT_1) {
+        mResolveStats.mSavedMemory = 0;
+        mResolveStats.mSavedBandwidthPerFrame = 0;
+        return;
     }
+
+    // Memory is only saved while no resolve texture is held, whatever path the last frame took
+    RenderTargetDesc resolve_desc = {
+        mColorFormat, SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER, SDL_GPU_SAMPLECOUNT_1, mTargetWidth, mTargetHeight
+    };
+
+    Uint64 target_size = SDL_CalculateGPUTextureFormatSize(mColorFormat, mTargetWidth, mTargetHeight, 1);
+    mResolveStats.mSavedMemory = mTargetPool.GetResidentSize(resolve_desc) == 0 ? target_size : 0;
+    mResolveStats.mSavedBandwidthPerFrame = target_size * 2;
 }
 
-bool RenderService::CreatePipeline(const eastl::string &inName, SDL_GPUShader *inVertexShader, SDL_GPUShader *inFragmentShader) {
+bool RenderService::CreatePipeline(
+    const eastl::string &inName,
+    SDL_GPUShader *inVertexShader,
+    SDL_GPUShader *inFragmentShader,
+    ShaderKey inKey,
+    const PipelineOptions &inOptions
+) {
+    if (inVertexShader == nullptr || inFragmentShader == nullptr) {
+        LOG_ERROR("Unable to create graphics pipeline %s without shaders", inName.c_str());
+        return false;
+    }
 
     SDL_GPUColorTargetDescription color_target_description = {
-        .format = SDL_GetGPUSwapchainTextureFormat(mDevice, Context::Get().GetWindow())
+        .format = inOptions.mColorFormat != SDL_GPU_TEXTUREFORMAT_INVALID ? inOptions.mColorFormat : mColorFormat
     };
 
+    // Depth-only pipelines keep the color target so they stay compatible with the pass, but never write to it
+    if (!inOptions.mEnableColorWrite) {
+        color_target_description.blend_state.enable_color_write_mask = true;
+        color_target_description.blend_state.color_write_mask = 0;
+    }
+
+    if (inOptions.mIsAdditive) {
+        color_target_description.blend_state.enable_blend = true;
+        color_target_description.blend_state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        color_target_description.blend_state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        color_target_description.blend_state.color_blend_op = SDL_GPU_BLENDOP_ADD;
+        color_target_description.blend_state.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        color_target_description.blend_state.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        color_target_description.blend_state.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+    }
+
     SDL_GPUVertexBufferDescription vertex_buffer_description = {
         .slot = 0,
         .pitch = sizeof(PositionNormalTextureVertex),
@@ -180,7 +357,7 @@ bool RenderService::CreatePipeline(const eastl::string &inName, SDL_GPUShader *i
             .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
             .offset = sizeof(float) * 3
         },
-        // Color
+        // Texture coordinates
         {
             .location = 2,
             .buffer_slot = 0,
@@ -196,16 +373,16 @@ bool RenderService::CreatePipeline(const eastl::string &inName, SDL_GPUShader *i
             .vertex_buffer_descriptions = &vertex_buffer_description,
             .num_vertex_buffers = 1,
             .vertex_attributes = vertex_attributes,
-            .num_vertex_attributes = 3,
+            .num_vertex_attributes = inOptions.mIsPositionOnly ? 1u : 3u,
         },
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
         .multisample_state = {
-            .sample_count = mSampleCount
+            .sample_count = inOptions.mIsSingleSampled ? SDL_GPU_SAMPLECOUNT_1 : mSampleCount
         },
         .depth_stencil_state = {
-            .compare_op = SDL_GPU_COMPAREOP_LESS,
+            .compare_op = inOptions.mDepthCompareOp,
             .enable_depth_test = true,
-            .enable_depth_write = true,
+            .enable_depth_write = inOptions.mEnableDepthWrite,
         },
         .target_info = {
             .color_target_descriptions = &color_target_description,
@@ -221,7 +398,7 @@ bool RenderService::CreatePipeline(const eastl::string &inName, SDL_GPUShader *i
         return false;
     }
 
-    mPipelines[inName] = pipeline;
+    mPipelines[inName][inKey] = pipeline;
     return true;
 }
 
@@ -256,78 +433,37 @@ SDL_GPUShader *RenderService::CreateShader(
     return shader;
 }
 
-void RenderService::DestroyShader(SDL_GPUShader *inShader) const {
-    if (inShader != nullptr) {
-        SDL_ReleaseGPUShader(mDevice, inShader);
-    }
-}
-
-SDL_GPUTexture *RenderService::CreateDepthTexture(Uint32 inWidth, Uint32 inHeight) {
-    SDL_GPUTextureCreateInfo create_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
-        .width = inWidth,
-        .height = inHeight,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = mSampleCount,
-    };
-
-    SDL_GPUTexture *texture = SDL_CreateGPUTexture(mDevice, &create_info);
-    if (texture == nullptr) {
-        LOG_ERROR("Unable to create depth texture: %s", SDL_GetError());
-        return nullptr;
-    }
-
-    return texture;
-}
-
-SDL_GPUTexture *RenderService::CreateMSAATexture(Uint32 inWidth, Uint32 inHeight) {
-    SDL_GPUTextureCreateInfo create_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GetGPUSwapchainTextureFormat(mDevice, Context::Get().GetWindow()),
-        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
-        .width = inWidth,
-        .height = inHeight,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = mSampleCount,
-    };
-
-    SDL_GPUTexture *texture = SDL_CreateGPUTexture(mDevice, &create_info);
-    if (texture == nullptr) {
-        LOG_ERROR("Unable to create MSAA texture: %s", SDL_GetError());
-        return nullptr;
-    }
-
-    return texture;
-}
-
-SDL_GPUTexture *RenderService::CreateResolveTexture(Uint32 inWidth, Uint32 inHeight) {
-    SDL_GPUTextureCreateInfo create_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GetGPUSwapchainTextureFormat(mDevice, Context::Get().GetWindow()),
-        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
-        .width = inWidth,
-        .height = inHeight,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .sample_count = SDL_GPU_SAMPLECOUNT_1,
-    };
-
-    SDL_GPUTexture *texture = SDL_CreateGPUTexture(mDevice, &create_info);
-    if (texture == nullptr) {
-        LOG_ERROR("Unable to create resolve texture: %s", SDL_GetError());
-        return nullptr;
+SDL_GPUShader *RenderService::CreateShaderVariant(
+    SDL_GPUShaderStage inStage,
+    const ShaderVariantCode *inVariants,
+    Uint32 inVariantCount,
+    ShaderKey inKey,
+    Uint32 inSamplerCount,
+    Uint32 inUniformBufferCount,
+    Uint32 inStorageBufferCount,
+    Uint32 inStorageTextureCount
+) const {
+    for (Uint32 i = 0; i < inVariantCount; i++) {
+        if (inVariants[i].mKey == inKey) {
+            return CreateShader(
+                inStage,
+                inVariants[i].mCode,
+                inVariants[i].mSize,
+                inSamplerCount,
+                inUniformBufferCount,
+                inStorageBufferCount,
+                inStorageTextureCount
+            );
+        }
     }
 
-    return texture;
+    LOG_ERROR("Shader variant not found: 0x%04x", inKey);
+    return nullptr;
 }
 
-void RenderService::DestroyTexture(SDL_GPUTexture *depth_texture) const {
-    if (depth_texture != nullptr) {
-        SDL_ReleaseGPUTexture(mDevice, depth_texture);
+void RenderService::DestroyShader(SDL_GPUShader *inShader) const {
+    if (inShader != nullptr) {
+        SDL_ReleaseGPUShader(mDevice, inShader);
     }
 }
 
@@ -346,18 +482,21 @@ MeshHandle *RenderService::CreateMesh(
 
     mesh->mIndexSize = inIndexSize;
     mesh->mIndexCount = inIndexCount;
+    mesh->mAlbedoTexture = cInvalidTexture;
 
     SDL_GPUBufferCreateInfo vertex_buffer_create_info = {
         .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
         .size = inVertexSize
     };
 
+    mesh->mIndexBuffer = nullptr;
     mesh->mVertexBuffer = SDL_CreateGPUBuffer(mDevice, &vertex_buffer_create_info);
     if (mesh->mVertexBuffer == nullptr) {
         LOG_ERROR("Unable to create vertex buffer: %s", SDL_GetError());
         DestroyMesh(mesh);
         return nullptr;
     }
+    MemoryService::Get().TrackGPUBuffer(inVertexSize);
 
     SDL_GPUBufferCreateInfo index_buffer_create_info = {
         .usage = SDL_GPU_BUFFERUSAGE_INDEX,
@@ -370,6 +509,7 @@ MeshHandle *RenderService::CreateMesh(
         DestroyMesh(mesh);
         return nullptr;
     }
+    MemoryService::Get().TrackGPUBuffer(inIndexSize);
 
     SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
         .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
@@ -436,10 +576,12 @@ void RenderService::DestroyMesh(MeshHandle *inMesh) const {
     if (inMesh != nullptr) {
         if (inMesh->mVertexBuffer != nullptr) {
             SDL_ReleaseGPUBuffer(mDevice, inMesh->mVertexBuffer);
+            MemoryService::Get().TrackGPUBuffer(-static_cast<Sint64>(inMesh->mVertexSize));
         }
 
         if (inMesh->mIndexBuffer != nullptr) {
             SDL_ReleaseGPUBuffer(mDevice, inMesh->mIndexBuffer);
+            MemoryService::Get().TrackGPUBuffer(-static_cast<Sint64>(inMesh->mIndexSize));
         }
 
         SDL_free(inMesh);
@@ -467,8 +609,67 @@ void RenderService::DrawMesh(SDL_GPURenderPass *inRenderPass, MeshHandle *inMesh
     }
 }
 
-RenderState *RenderService::BeginPass() {
-    RenderState *state = (RenderState *)SDL_malloc(sizeof(RenderState));
+void RenderService::BindTexture(SDL_GPURenderPass *inRenderPass, TextureID inTexture) const {
+    SDL_GPUTextureSamplerBinding binding = {
+        .texture = mTextureStreamer.GetTexture(inTexture),
+        .sampler = mTextureStreamer.GetSampler()
+    };
+
+    SDL_BindGPUFragmentSamplers(inRenderPass, 0, &binding, 1);
+}
+
+MaterialID RenderService::CreateMaterial(const Material &inMaterial) {
+    mMaterials.push_back(inMaterial);
+    mAreMaterialsDirty = true;
+
+    return static_cast<MaterialID>(mMaterials.size() - 1);
+}
+
+void RenderService::SetMaterial(MaterialID inMaterialID, const Material &inMaterial) {
+    SDL_assert(inMaterialID < mMaterials.size());
+
+    mMaterials[inMaterialID] = inMaterial;
+    mAreMaterialsDirty = true;
+}
+
+void RenderService::ClearMaterials() {
+    mMaterials.clear();
+    mAreMaterialsDirty = false;
+}
+
+void RenderService::SetInstances(const InstanceData *inInstances, Uint32 inCount) {
+    mInstances = inInstances;
+    mInstanceCount = inCount;
+}
+
+void RenderService::UploadFrameData(SDL_GPUCommandBuffer *inCommandBuffer) {
+    bool has_materials = mAreMaterialsDirty && !mMaterials.empty();
+    if (!has_materials && mInstanceCount == 0) {
+        return;
+    }
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(inCommandBuffer);
+
+    if (has_materials) {
+        if (mMaterialBuffer.Upload(copy_pass, mMaterials.data(), static_cast<Uint32>(sizeof(Material) * mMaterials.size()))) {
+            mAreMaterialsDirty = false;
+            mMaterialUploadCount++;
+        }
+    }
+
+    if (mInstanceCount > 0) {
+        mInstanceBuffer.Upload(copy_pass, mInstances, static_cast<Uint32>(sizeof(InstanceData) * mInstanceCount));
+    }
+
+    SDL_EndGPUCopyPass(copy_pass);
+
+    mInstances = nullptr;
+    mInstanceCount = 0;
+}
+
+RenderState *RenderService::BeginFrame() {
+    // The render state only lives for the duration of the frame
+    RenderState *state = FrameMemoryService::Get().Allocate<RenderState>();
     if (state == nullptr) {
         LOG_ERROR("Unable to allocate memory for render state: %s", SDL_GetError());
         return nullptr;
@@ -477,81 +678,440 @@ RenderState *RenderService::BeginPass() {
     state->mCommandBuffer = SDL_AcquireGPUCommandBuffer(mDevice);
     if (state->mCommandBuffer == nullptr) {
         LOG_ERROR("Unable to acquire GPU command buffer: %s", SDL_GetError());
-        SDL_free(state);
         return nullptr;
     }
 
     state->mSwapchainTexture = nullptr;
-    if (!SDL_AcquireGPUSwapchainTexture(state->mCommandBuffer, Context::Get().GetWindow(), &state->mSwapchainTexture, nullptr, nullptr)) {
+    state->mRenderPass = nullptr;
+
+    // Time on the GPU of the frames that finished while this one was built
+    PollFrames();
+
+    // The acquire can wait for a swapchain image, which is the GPU holding up the frame rather than the CPU
+    Uint64 acquire_start_time = SDL_GetTicksNS();
+    Uint32 swapchain_width, swapchain_height;
+    bool is_acquired = SDL_AcquireGPUSwapchainTexture(
+        state->mCommandBuffer,
+        Context::Get().GetWindow(),
+        &state->mSwapchainTexture,
+        &swapchain_width,
+        &swapchain_height);
+    mFrameWaitTime += SDL_GetTicksNS() - acquire_start_time;
+
+    if (!is_acquired) {
         LOG_ERROR("Unable to acquire GPU swapchain texture: %s", SDL_GetError());
-        SDL_free(state);
+        // Nothing was recorded yet, the command buffer goes back without being submitted
+        SDL_CancelGPUCommandBuffer(state->mCommandBuffer);
+        return nullptr;
+    }
+
+    if (state->mSwapchainTexture == nullptr) {
+        // Nothing to draw into, such as when the window is minimized
+        SDL_SubmitGPUCommandBuffer(state->mCommandBuffer);
         return nullptr;
     }
 
-    if (state->mSwapchainTexture != nullptr) {
-        SDL_zero(state->mColorTargetInfo);
-        state->mColorTargetInfo.clear_color = {0.1f, 0.1f, 0.1f, 1.0f};
+    // The frame carries its input along from here, the acquire above may have waited for a free swapchain image
+    state->mInputTime = InputService::Get().GetFrameInputTime();
+
+    // Storage buffers and textures can't be written during a render pass, so the frame's data goes up first.
+    // The mips requested while the frame was being built are streamed in for its draws.
+    mTextureStreamer.Update(state->mCommandBuffer);
+    UploadFrameData(state->mCommandBuffer);
+
+    mTargetPool.BeginFrame();
+    mRenderGraph.Reset();
+
+    if (mStableFrameCount < cStableFrameCount) {
+        mStableFrameCount++;
+    }
+
+    // Scaled frames render into the top left corner of the targets and are upscaled into the swapchain
+    float scale = mResolutionController.GetScale();
+    state->mRenderWidth = SDL_max(static_cast<Uint32>(static_cast<float>(mTargetWidth) * scale), 1u);
+    state->mRenderHeight = SDL_max(static_cast<Uint32>(static_cast<float>(mTargetHeight) * scale), 1u);
+    bool is_scaled = state->mRenderWidth != mTargetWidth || state->mRenderHeight != mTargetHeight;
+
+    // Targets are bucketed while the window is being resized and get their exact size once it stopped changing.
+    // Direct and scaled frames use the same size class, so switching between them shares the color and depth targets.
+    bool is_exact = mStableFrameCount >= cStableFrameCount;
+
+    // Rendering straight into the swapchain needs exactly sized targets. The swapchain can also lag behind a resize
+    // or change format.
+    bool is_direct = !is_scaled &&
+        is_exact &&
+        SDL_GetGPUSwapchainTextureFormat(mDevice, mWindow) == mColorFormat &&
+        swapchain_width == mTargetWidth && swapchain_height == mTargetHeight;
+
+    // Targets of the old size class are never asked for again. The resolve texture is dropped once frames go direct,
+    // unless dynamic resolution may scale the next frame and need it again.
+    bool is_resolve_unused = is_direct && !mWasDirect && !mResolutionController.IsEnabled();
+    if (is_exact != mAreTargetsExact || is_resolve_unused) {
+        mTargetPool.ReleaseUnused();
+    }
+
+    mAreTargetsExact = is_exact;
+    mWasDirect = is_direct;
 
-        // Check is MSAA is enabled
-        if (mSampleCount != SDL_GPU_SAMPLECOUNT_1) {
-            state->mColorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-            state->mColorTargetInfo.store_op = SDL_GPU_STOREOP_RESOLVE;
-            state->mColorTargetInfo.texture = mMSAATexture;
-            state->mColorTargetInfo.resolve_texture = mResolveTexture;
-            state->mColorTargetInfo.cycle = true;
-            state->mColorTargetInfo.cycle_resolve_texture = true;
+    state->mBackbuffer = mRenderGraph.ImportTexture("Backbuffer", state->mSwapchainTexture, swapchain_width, swapchain_height);
+    mRenderGraph.MarkOutput(state->mBackbuffer);
+
+    RenderTargetDesc color_desc = {
+        mColorFormat, SDL_GPU_TEXTUREUSAGE_COLOR_TARGET, mSampleCount, mTargetWidth, mTargetHeight
+    };
+    RenderTargetDesc depth_desc = {
+        SDL_GPU_TEXTUREFORMAT_D16_UNORM, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET, mSampleCount, mTargetWidth, mTargetHeight
+    };
+    RenderTargetDesc resolve_desc = {
+        mColorFormat, SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER, SDL_GPU_SAMPLECOUNT_1, mTargetWidth, mTargetHeight
+    };
+
+    state->mSceneDepth = mRenderGraph.CreateTexture("Scene depth", depth_desc, is_exact);
+
+    if (mSampleCount != SDL_GPU_SAMPLECOUNT_1) {
+        state->mSceneColor = mRenderGraph.CreateTexture("Scene color", color_desc, is_exact);
+        state->mSceneResolve = is_direct ? state->mBackbuffer : mRenderGraph.CreateTexture("Scene resolve", resolve_desc, is_exact);
+
+        if (is_direct) {
+            mResolveStats.mDirectFrameCount++;
+            mResolveStats.mSavedBandwidth += mResolveStats.mSavedBandwidthPerFrame;
         } else {
-            state->mColorTargetInfo.texture = state->mSwapchainTexture;
-            state->mColorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-            state->mColorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+            mResolveStats.mFallbackFrameCount++;
         }
+    } else {
+        state->mSceneColor = is_direct ? state->mBackbuffer : mRenderGraph.CreateTexture("Scene color", resolve_desc, is_exact);
+        state->mSceneResolve = cInvalidRenderResource;
+    }
+
+    return state;
+}
 
-        // Set up depth buffer info
-        SDL_zero(state->mDepthStencilTargetInfo);
-        state->mDepthStencilTargetInfo = {
-            .texture = mDepthTexture,
+void RenderService::AddScenePass(RenderState *inState, SceneDrawFunction &&inDraw) {
+    RenderPassID pass = mRenderGraph.AddPass("Scene", [this, inState, draw = eastl::move(inDraw)](
+        RenderGraph &inGraph,
+        SDL_GPUCommandBuffer *inCommandBuffer
+    ) {
+        SDL_zero(inState->mColorTargetInfo);
+        inState->mColorTargetInfo.texture = inGraph.GetTexture(inState->mSceneColor);
+        inState->mColorTargetInfo.clear_color = {0.1f, 0.1f, 0.1f, 1.0f};
+        inState->mColorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+
+        // Check if MSAA is enabled
+        if (inState->mSceneResolve != cInvalidRenderResource) {
+            inState->mColorTargetInfo.store_op = SDL_GPU_STOREOP_RESOLVE;
+            inState->mColorTargetInfo.resolve_texture = inGraph.GetTexture(inState->mSceneResolve);
+        } else {
+            inState->mColorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+        }
+
+        // Pooled targets aren't cycled, which would allocate new memory behind the pool's back
+        SDL_zero(inState->mDepthStencilTargetInfo);
+        inState->mDepthStencilTargetInfo = {
+            .texture = inGraph.GetTexture(inState->mSceneDepth),
             .clear_depth = 1.0f,
             .load_op = SDL_GPU_LOADOP_CLEAR,
             .store_op = SDL_GPU_STOREOP_DONT_CARE,
             .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
             .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
-            .cycle = true
         };
 
-        // Begin render pass
-        state->mRenderPass = SDL_BeginGPURenderPass(
-            state->mCommandBuffer,
-            &state->mColorTargetInfo, 1,
-            &state->mDepthStencilTargetInfo
+        inState->mRenderPass = SDL_BeginGPURenderPass(
+            inCommandBuffer,
+            &inState->mColorTargetInfo, 1,
+            &inState->mDepthStencilTargetInfo
         );
 
-        return state;
+        // Pooled targets can be larger than the window, and scaled frames only use part of the window
+        SDL_GPUViewport viewport = {
+            .x = 0.0f,
+            .y = 0.0f,
+            .w = static_cast<float>(inState->mRenderWidth),
+            .h = static_cast<float>(inState->mRenderHeight),
+            .min_depth = 0.0f,
+            .max_depth = 1.0f
+        };
+
+        SDL_Rect scissor = { 0, 0, static_cast<int>(inState->mRenderWidth), static_cast<int>(inState->mRenderHeight) };
+
+        SDL_SetGPUViewport(inState->mRenderPass, &viewport);
+        SDL_SetGPUScissor(inState->mRenderPass, &scissor);
+
+        // Bound once for the whole pass, draws select their entries through the draw indices
+        SDL_GPUBuffer *instance_buffer = mInstanceBuffer.GetBuffer();
+        SDL_GPUBuffer *material_buffer = mMaterialBuffer.GetBuffer();
+        SDL_BindGPUVertexStorageBuffers(inState->mRenderPass, 0, &instance_buffer, 1);
+        SDL_BindGPUFragmentStorageBuffers(inState->mRenderPass, 0, &material_buffer, 1);
+
+        draw(inState);
+
+        SDL_EndGPURenderPass(inState->mRenderPass);
+        inState->mRenderPass = nullptr;
+    });
+
+    mRenderGraph.Write(pass, inState->mSceneColor);
+    mRenderGraph.Write(pass, inState->mSceneDepth);
+
+    if (inState->mSceneResolve != cInvalidRenderResource) {
+        mRenderGraph.Write(pass, inState->mSceneResolve);
+    }
+}
+
+void RenderService::EndFrame(RenderState *inState) {
+    // Scaled and fallback frames are in an intermediate texture, the blit also upscales the rendered area
+    RenderResourceID scene_output = inState->mSceneResolve != cInvalidRenderResource ? inState->mSceneResolve : inState->mSceneColor;
+    if (scene_output != inState->mBackbuffer) {
+        RenderPassID pass = mRenderGraph.AddPass("Upscale", [inState, scene_output](
+            RenderGraph &inGraph,
+            SDL_GPUCommandBuffer *inCommandBuffer
+        ) {
+            SDL_GPUBlitInfo blit_info = {
+                .source = {
+                    .texture = inGraph.GetTexture(scene_output),
+                    .w = inState->mRenderWidth,
+                    .h = inState->mRenderHeight
+                },
+                .destination = {
+                    .texture = inGraph.GetTexture(inState->mBackbuffer),
+                    .w = inGraph.GetWidth(inState->mBackbuffer),
+                    .h = inGraph.GetHeight(inState->mBackbuffer)
+                },
+                .load_op = SDL_GPU_LOADOP_DONT_CARE,
+                .filter = SDL_GPU_FILTER_LINEAR
+            };
+
+            SDL_BlitGPUTexture(inCommandBuffer, &blit_info);
+        });
+
+        mRenderGraph.Read(pass, scene_output);
+        mRenderGraph.Write(pass, inState->mBackbuffer);
     }
 
-    SDL_free(state);
-    return nullptr;
+    mRenderGraph.Compile();
+    mRenderGraph.Execute(inState->mCommandBuffer, mTargetPool);
+    UpdateResolveSavings();
+
+    // Keep at most cMaxFramesInFlight frames on the GPU, a full ring waits for the oldest one
+    PollFrames();
+    if (mInFlightFrameCount == cMaxFramesInFlight) {
+        FinishOldestFrame(true);
+    }
+
+    Uint64 submit_time = SDL_GetTicksNS();
+    if (mFrameStartTime != 0) {
+        Uint64 cpu_time = submit_time - mFrameStartTime;
+        mResolutionController.UpdateCPUTime(cpu_time > mFrameWaitTime ? cpu_time - mFrameWaitTime : 0);
+        mFrameStartTime = 0;
+    }
+
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(inState->mCommandBuffer);
+    if (inState->mInputTime != 0) {
+        mInputToSubmitLatency.Add(submit_time - inState->mInputTime);
+    }
+
+    if (fence == nullptr) {
+        LOG_ERROR("Unable to submit GPU command buffer: %s", SDL_GetError());
+        return;
+    }
+
+    Uint32 index = (mFirstInFlightFrame + mInFlightFrameCount) % cMaxFramesInFlight;
+    mInFlightFrames[index] = { fence, submit_time, inState->mInputTime };
+    mInFlightFrameCount++;
 }
 
-void RenderService::EndPass(RenderState *inState) {
-    SDL_EndGPURenderPass(inState->mRenderPass);
+void RenderService::StartFrameTimer() {
+    mFrameStartTime = SDL_GetTicksNS();
+    mFrameWaitTime = 0;
+}
 
-    // Check if MSAA is enabled
-    if (mSampleCount != SDL_GPU_SAMPLECOUNT_1) {
-        // Blit the resolved MSAA texture to the swapchain texture
-        SDL_GPUBlitInfo blit_info = {
-            .source = {
-                .texture = mResolveTexture,
-                .w = static_cast<Uint32>(Context::Get().GetWindowWidth()),
-                .h = static_cast<Uint32>(Context::Get().GetWindowHeight())
-            },
-            .destination = {
-                .texture = inState->mSwapchainTexture,
-                .w = static_cast<Uint32>(Context::Get().GetWindowWidth()),
-                .h = static_cast<Uint32>(Context::Get().GetWindowHeight())
-            },
-            .load_op = SDL_GPU_LOADOP_DONT_CARE
+void RenderService::PollFrames() {
+    // Fences signal in submission order, so the first one still running ends the poll
+    while (mInFlightFrameCount > 0 && SDL_QueryGPUFence(mDevice, mInFlightFrames[mFirstInFlightFrame].mFence)) {
+        FinishOldestFrame(false);
+    }
+}
+
+void RenderService::WaitForFrames() {
+    while (mInFlightFrameCount > 0) {
+        FinishOldestFrame(true);
+    }
+}
+
+void RenderService::FinishOldestFrame(bool inWait) {
+    InFlightFrame &frame = mInFlightFrames[mFirstInFlightFrame];
+
+    // Waiting on a fence gives the exact time it signaled, a fence seen signaled by a poll may have done so earlier
+    if (inWait) {
+        Uint64 wait_start_time = SDL_GetTicksNS();
+        SDL_WaitForGPUFences(mDevice, true, &frame.mFence, 1);
+        mFrameWaitTime += SDL_GetTicksNS() - wait_start_time;
+    }
+
+    Uint64 finish_time = SDL_GetTicksNS();
+    bool is_upper_bound = !inWait;
+
+    // The GPU starts on a frame once it's submitted and the frame before it is done. Counting from the submit
+    // alone would add the time the frame sat queued, unless the previous finish is only a bound.
+    Uint64 start_time = frame.mSubmitTime;
+    if (mLastFinishTime > frame.mSubmitTime) {
+        if (mIsLastFinishExact) {
+            start_time = mLastFinishTime;
+        } else {
+            is_upper_bound = true;
+        }
+    }
+
+    mResolutionController.Update(finish_time - start_time, is_upper_bound);
+
+    if (frame.mInputTime != 0) {
+        mInputToPresentLatency.Add(finish_time - frame.mInputTime);
+    }
+
+    SDL_ReleaseGPUFence(mDevice, frame.mFence);
+    frame = {};
+    mFirstInFlightFrame = (mFirstInFlightFrame + 1) % cMaxFramesInFlight;
+    mInFlightFrameCount--;
+
+    mLastFinishTime = finish_time;
+    mIsLastFinishExact = inWait;
+}
+
+void RenderService::LogInputLatency() {
+    mInputToSubmitLatency.LogStats("Input to submit");
+    mInputToPresentLatency.LogStats("Input to present");
+    ResetInputLatency();
+}
+
+RenderState *RenderService::BeginOverdrawPass() {
+    mOverdrawWidth = mTargetWidth;
+    mOverdrawHeight = mTargetHeight;
+
+    // One byte per pixel is read back
+    Uint32 transfer_size = mOverdrawWidth * mOverdrawHeight;
+    if (transfer_size > mOverdrawTransferSize) {
+        if (mOverdrawTransferBuffer != nullptr) {
+            SDL_ReleaseGPUTransferBuffer(mDevice, mOverdrawTransferBuffer);
+        }
+
+        SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+            .size = transfer_size
         };
 
-        SDL_BlitGPUTexture(inState->mCommandBuffer, &blit_info);
+        mOverdrawTransferBuffer = SDL_CreateGPUTransferBuffer(mDevice, &transfer_buffer_create_info);
+        mOverdrawTransferSize = mOverdrawTransferBuffer != nullptr ? transfer_size : 0;
+        if (mOverdrawTransferBuffer == nullptr) {
+            LOG_ERROR("Unable to create overdraw transfer buffer: %s", SDL_GetError());
+            return nullptr;
+        }
+    }
+
+    RenderTargetDesc color_desc = {
+        SDL_GPU_TEXTUREFORMAT_R8_UNORM, SDL_GPU_TEXTUREUSAGE_COLOR_TARGET, SDL_GPU_SAMPLECOUNT_1, mOverdrawWidth, mOverdrawHeight
+    };
+    RenderTargetDesc depth_desc = {
+        SDL_GPU_TEXTUREFORMAT_D16_UNORM, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET, SDL_GPU_SAMPLECOUNT_1, mOverdrawWidth, mOverdrawHeight
+    };
+
+    mOverdrawTexture = mTargetPool.Acquire(color_desc, true);
+    mOverdrawDepthTexture = mTargetPool.Acquire(depth_desc, true);
+    if (mOverdrawTexture == nullptr || mOverdrawDepthTexture == nullptr) {
+        mTargetPool.Release(mOverdrawTexture);
+        mTargetPool.Release(mOverdrawDepthTexture);
+        return nullptr;
+    }
+
+    RenderState *state = FrameMemoryService::Get().Allocate<RenderState>();
+    if (state == nullptr) {
+        LOG_ERROR("Unable to allocate memory for render state: %s", SDL_GetError());
+        return nullptr;
     }
+
+    state->mCommandBuffer = SDL_AcquireGPUCommandBuffer(mDevice);
+    if (state->mCommandBuffer == nullptr) {
+        LOG_ERROR("Unable to acquire GPU command buffer: %s", SDL_GetError());
+        return nullptr;
+    }
+
+    state->mSwapchainTexture = nullptr;
+    state->mRenderWidth = mOverdrawWidth;
+    state->mRenderHeight = mOverdrawHeight;
+
+    SDL_zero(state->mColorTargetInfo);
+    state->mColorTargetInfo.texture = mOverdrawTexture;
+    state->mColorTargetInfo.clear_color = {0.0f, 0.0f, 0.0f, 0.0f};
+    state->mColorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
+    state->mColorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+
+    SDL_zero(state->mDepthStencilTargetInfo);
+    state->mDepthStencilTargetInfo = {
+        .texture = mOverdrawDepthTexture,
+        .clear_depth = 1.0f,
+        .load_op = SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_DONT_CARE,
+        .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+        .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+    };
+
+    state->mRenderPass = SDL_BeginGPURenderPass(
+        state->mCommandBuffer,
+        &state->mColorTargetInfo, 1,
+        &state->mDepthStencilTargetInfo
+    );
+
+    // The instances uploaded for the frame are still current, so the same draw indices work here
+    SDL_GPUBuffer *instance_buffer = mInstanceBuffer.GetBuffer();
+    SDL_BindGPUVertexStorageBuffers(state->mRenderPass, 0, &instance_buffer, 1);
+
+    return state;
+}
+
+Uint64 RenderService::EndOverdrawPass(RenderState *inState) {
+    SDL_EndGPURenderPass(inState->mRenderPass);
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(inState->mCommandBuffer);
+
+    SDL_GPUTextureRegion source = {
+        .texture = mOverdrawTexture,
+        .w = mOverdrawWidth,
+        .h = mOverdrawHeight,
+        .d = 1
+    };
+
+    SDL_GPUTextureTransferInfo destination = {
+        .transfer_buffer = mOverdrawTransferBuffer,
+        .offset = 0,
+        .pixels_per_row = mOverdrawWidth,
+        .rows_per_layer = mOverdrawHeight
+    };
+
+    SDL_DownloadFromGPUTexture(copy_pass, &source, &destination);
+    SDL_EndGPUCopyPass(copy_pass);
+
+    // Later users of the targets are ordered after this pass on the GPU
+    mTargetPool.Release(mOverdrawTexture);
+    mTargetPool.Release(mOverdrawDepthTexture);
+
+    // Measurements are rare and explicit, so stalling on the result keeps this simple
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(inState->mCommandBuffer);
+    if (fence == nullptr) {
+        LOG_ERROR("Unable to submit overdraw pass: %s", SDL_GetError());
+        return 0;
+    }
+
+    SDL_WaitForGPUFences(mDevice, true, &fence, 1);
+    SDL_ReleaseGPUFence(mDevice, fence);
+
+    const Uint8 *counts = static_cast<const Uint8 *>(SDL_MapGPUTransferBuffer(mDevice, mOverdrawTransferBuffer, false));
+    if (counts == nullptr) {
+        LOG_ERROR("Unable to map overdraw transfer buffer: %s", SDL_GetError());
+        return 0;
+    }
+
+    Uint64 fragment_count = 0;
+    for (Uint32 i = 0; i < mOverdrawWidth * mOverdrawHeight; i++) {
+        fragment_count += counts[i];
+    }
+
+    SDL_UnmapGPUTransferBuffer(mDevice, mOverdrawTransferBuffer);
+    return fragment_count;
 }
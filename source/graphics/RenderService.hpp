@@ -4,11 +4,43 @@
 
 #include <SDL3/SDL.h>
 
+#include <EASTL/functional.h>
 #include <EASTL/string.h>
 #include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+#include <EASTL/vector_map.h>
 
 #include "MeshHandle.hpp"
+#include "PipelineOptions.hpp"
+#include "RenderGraph.hpp"
 #include "RenderState.hpp"
+#include "RenderTargetPool.hpp"
+#include "ResolutionController.hpp"
+#include "ShaderVariant.hpp"
+#include "StorageBuffer.hpp"
+#include "TextureStreamer.hpp"
+#include "uniforms/InstanceData.hpp"
+#include "uniforms/Material.hpp"
+
+#include "LatencyHistogram.hpp"
+
+// Index of a material in the material table, passed to shaders as is
+using MaterialID = Uint32;
+
+// Draws the scene into the frame's color and depth targets while the scene pass records
+using SceneDrawFunction = eastl::function<void(RenderState *inState)>;
+
+// How MSAA was resolved and what resolving straight into the swapchain saved over resolving into a texture and
+// blitting it, sizes in bytes
+struct ResolveStats {
+    Uint64 mDirectFrameCount;
+    Uint64 mFallbackFrameCount;
+    // Size of the intermediate resolve texture, zero while one is resident in the target pool
+    Uint64 mSavedMemory;
+    // The blit reads the resolve texture and writes the swapchain, once per direct frame
+    Uint64 mSavedBandwidthPerFrame;
+    Uint64 mSavedBandwidth;
+};
 
 class RenderService {
 MAKE_SINGLETON(RenderService)
@@ -16,15 +48,98 @@ private:
     SDL_GPUDevice *mDevice;
     SDL_Window *mWindow;
 
-    SDL_GPUTexture *mDepthTexture;
     SDL_GPUSampleCount mSampleCount;
-    SDL_GPUTexture *mMSAATexture;
-    SDL_GPUTexture *mResolveTexture;
+    SDL_GPUTextureFormat mColorFormat;
+
+    // Targets are requested at the window size, the largest the render scale allows, and scaled frames only
+    // render into a corner of them so scale changes never reallocate
+    Uint32 mTargetWidth = 0;
+    Uint32 mTargetHeight = 0;
+    // Frames since the last resize, targets only get their exact size once the window stops changing
+    Uint32 mStableFrameCount = 0;
+    // Size class and resolve path of the last frame, the targets of the other ones are released when these change
+    bool mAreTargetsExact = false;
+    bool mWasDirect = false;
+
+    // Each frame is a render graph, its render targets come from the pool so resizes and new passes reuse textures.
+    // The scene renders or resolves straight into the swapchain when the sizes match, otherwise it goes through an
+    // intermediate texture that is upscaled into the swapchain.
+    RenderGraph mRenderGraph;
+    RenderTargetPool mTargetPool;
+    ResolveStats mResolveStats = {};
+
+    // A submitted frame whose fence hasn't been seen signaled yet
+    struct InFlightFrame {
+        SDL_GPUFence *mFence;
+        Uint64 mSubmitTime;
+        Uint64 mInputTime;
+    };
+
+    // Dynamic resolution, driven by the GPU time of each frame measured through its fence and by the CPU time of
+    // building it. The fences of the previous frames sit in a ring and are polled, only a full ring waits for the
+    // oldest frame.
+    static constexpr Uint32 cMaxFramesInFlight = 3;
+    ResolutionController mResolutionController;
+    InFlightFrame mInFlightFrames[cMaxFramesInFlight] = {};
+    Uint32 mFirstInFlightFrame = 0;
+    Uint32 mInFlightFrameCount = 0;
+    // A frame queued behind the previous one only starts on the GPU once that one is done
+    Uint64 mLastFinishTime = 0;
+    bool mIsLastFinishExact = false;
+    // CPU side of the current frame, the time spent waiting for the GPU doesn't count towards it
+    Uint64 mFrameStartTime = 0;
+    Uint64 mFrameWaitTime = 0;
+
+    // Latency from the oldest input a frame consumed. The GPU finishing the frame stands in for the present, which
+    // SDL doesn't report, so frames only seen finished at a later poll count as presented late.
+    LatencyHistogram mInputToSubmitLatency;
+    LatencyHistogram mInputToPresentLatency;
+
+    // Every pipeline has one entry per shader variant it was created with
+    eastl::unordered_map<eastl::string, eastl::vector_map<ShaderKey, SDL_GPUGraphicsPipeline *>> mPipelines;
+    // Shared by every lit pipeline, which are built per variant when a variant is first drawn
+    SDL_GPUShader *mLitVertexShader = nullptr;
 
-    eastl::unordered_map<eastl::string, SDL_GPUGraphicsPipeline *> mPipelines;
+    // Materials are kept on the CPU and only uploaded to the GPU when one of them changed
+    eastl::vector<Material> mMaterials;
+    StorageBuffer mMaterialBuffer;
+    bool mAreMaterialsDirty = false;
+    Uint64 mMaterialUploadCount = 0;
+
+    // Instances for the next pass, uploaded in one go when the pass begins
+    StorageBuffer mInstanceBuffer;
+    const InstanceData *mInstances = nullptr;
+    Uint32 mInstanceCount = 0;
+
+    // Albedo textures of the lit meshes, their mips follow the draws' requests within a memory budget
+    TextureStreamer mTextureStreamer;
+
+    // Lays down depth for the lit meshes before shading them, so every pixel is shaded once
+    bool mIsDepthPrepassEnabled = true;
+
+    // Overdraw is measured by counting fragments into a single sampled R8 target and reading it back
+    SDL_GPUTexture *mOverdrawTexture = nullptr;
+    SDL_GPUTexture *mOverdrawDepthTexture = nullptr;
+    SDL_GPUTransferBuffer *mOverdrawTransferBuffer = nullptr;
+    Uint32 mOverdrawTransferSize = 0;
+    Uint32 mOverdrawWidth = 0;
+    Uint32 mOverdrawHeight = 0;
+
+    void UpdateResolveSavings();
+    // Wait for the oldest frame in flight if asked to, then time it and release its fence
+    void FinishOldestFrame(bool inWait);
+    void UploadFrameData(SDL_GPUCommandBuffer *inCommandBuffer);
 
 public:
-    bool Initialize(SDL_Window *inWindow);
+    // Create the device and render targets, has to run on the main thread. MSAA uses the highest sample count
+    // up to the requested one that the swapchain format supports.
+    bool Initialize(SDL_Window *inWindow, SDL_GPUSampleCount inSampleCount = SDL_GPU_SAMPLECOUNT_4);
+    // Translate the shaders and build the pipelines that have no variants, can run on any thread once the device
+    // exists. Nothing in this service is locked, so no other call may run at the same time.
+    bool CreatePipelines();
+    // Build the lit pipelines of a variant unless they exist. Only variants that are drawn get built, so this is
+    // called for every variant before its draws.
+    bool PrepareLitPipelines(ShaderKey inKey);
     void Shutdown();
 
     void SetViewport(Uint32 inWidth, Uint32 inHeight);
@@ -32,10 +147,12 @@ public:
     bool CreatePipeline(
         const eastl::string &inName,
         SDL_GPUShader *inVertexShader,
-        SDL_GPUShader *inFragmentShader
+        SDL_GPUShader *inFragmentShader,
+        ShaderKey inKey = 0,
+        const PipelineOptions &inOptions = {}
     );
     void DestroyPipeline(const eastl::string &inName);
-    void UsePipeline(SDL_GPURenderPass *inRenderPass, const eastl::string &inName) const;
+    void UsePipeline(SDL_GPURenderPass *inRenderPass, const eastl::string &inName, ShaderKey inKey = 0) const;
 
     SDL_GPUShader *CreateShader(
         SDL_GPUShaderStage inStage,
@@ -48,10 +165,17 @@ public:
     ) const;
     void DestroyShader(SDL_GPUShader *inShader) const;
 
-    SDL_GPUTexture *CreateDepthTexture(Uint32 inWidth, Uint32 inHeight);
-    SDL_GPUTexture *CreateMSAATexture(Uint32 inWidth, Uint32 inHeight);
-    SDL_GPUTexture *CreateResolveTexture(Uint32 inWidth, Uint32 inHeight);
-    void DestroyTexture(SDL_GPUTexture *inTexture) const;
+    // Create the shader for one entry of a generated variant table
+    SDL_GPUShader *CreateShaderVariant(
+        SDL_GPUShaderStage inStage,
+        const ShaderVariantCode *inVariants,
+        Uint32 inVariantCount,
+        ShaderKey inKey,
+        Uint32 inSamplerCount,
+        Uint32 inUniformBufferCount,
+        Uint32 inStorageBufferCount,
+        Uint32 inStorageTextureCount
+    ) const;
 
     MeshHandle *CreateMesh(
         void *inVertexData, Uint32 inVertexSize, Uint32 inVertexCount,
@@ -59,9 +183,45 @@ public:
     ) const;
     void DestroyMesh(MeshHandle *inMesh) const;
     void DrawMesh(SDL_GPURenderPass *inRenderPass, MeshHandle *inMesh) const;
+    // Bind a streamed texture with the shared sampler for the albedo texture variants
+    void BindTexture(SDL_GPURenderPass *inRenderPass, TextureID inTexture) const;
 
-    RenderState *BeginPass();
-    void EndPass(RenderState *inState);
+    MaterialID CreateMaterial(const Material &inMaterial);
+    void SetMaterial(MaterialID inMaterialID, const Material &inMaterial);
+    void ClearMaterials();
+
+    inline const Material &GetMaterial(MaterialID inMaterialID) const {
+        return mMaterials[inMaterialID];
+    }
+
+    // Set the instances drawn in the next pass, the data has to stay alive until BeginFrame is called
+    void SetInstances(const InstanceData *inInstances, Uint32 inCount);
+
+    // Acquire the swapchain and declare the frame's targets in the render graph
+    RenderState *BeginFrame();
+    // Add the pass that draws the scene, the function runs when the graph executes in EndFrame
+    void AddScenePass(RenderState *inState, SceneDrawFunction &&inDraw);
+    // Compile and execute the graph, then submit the frame and start timing it on the GPU
+    void EndFrame(RenderState *inState);
+    // Start timing the CPU side of a frame, called before any of its work runs
+    void StartFrameTimer();
+    // Feed the frames that finished on the GPU to the resolution controller, without waiting for the others
+    void PollFrames();
+    // Wait until every submitted frame finished on the GPU
+    void WaitForFrames();
+
+    // Offscreen pass that counts fragments instead of shading them, meant to be drawn with the overdraw pipelines
+    RenderState *BeginOverdrawPass();
+    // Submit the pass, wait for the GPU and return the number of fragments that passed the depth test
+    Uint64 EndOverdrawPass(RenderState *inState);
+
+    inline void SetDepthPrepassEnabled(bool inIsEnabled) {
+        mIsDepthPrepassEnabled = inIsEnabled;
+    }
+
+    inline bool IsDepthPrepassEnabled() const {
+        return mIsDepthPrepassEnabled;
+    }
 
     inline SDL_GPUDevice *GetDevice() const {
         return mDevice;
@@ -71,15 +231,43 @@ public:
         return mSampleCount;
     }
 
-    inline SDL_GPUTexture *GetDepthTexture() const {
-        return mDepthTexture;
+    inline TextureStreamer &GetTextureStreamer() {
+        return mTextureStreamer;
+    }
+
+    inline ResolutionController &GetResolutionController() {
+        return mResolutionController;
+    }
+
+    inline const LatencyHistogram &GetInputToSubmitLatency() const {
+        return mInputToSubmitLatency;
+    }
+
+    inline const LatencyHistogram &GetInputToPresentLatency() const {
+        return mInputToPresentLatency;
+    }
+
+    inline void ResetInputLatency() {
+        mInputToSubmitLatency.Reset();
+        mInputToPresentLatency.Reset();
+    }
+
+    // Log the input latency since the last report and start over
+    void LogInputLatency();
+
+    inline const ResolveStats &GetResolveStats() const {
+        return mResolveStats;
+    }
+
+    inline const RenderGraphStats &GetRenderGraphStats() const {
+        return mRenderGraph.GetStats();
     }
 
-    inline SDL_GPUTexture *GetMSAATexture() const {
-        return mMSAATexture;
+    inline RenderTargetPoolStats GetTargetPoolStats() const {
+        return mTargetPool.GetStats();
     }
 
-    inline SDL_GPUTexture *GetResolveTexture() const {
-        return mResolveTexture;
+    inline Uint64 GetMaterialUploadCount() const {
+        return mMaterialUploadCount;
     }
 };
@@ -2,11 +2,27 @@
 
 #include <SDL3/SDL.h>
 
+#include "RenderGraph.hpp"
+
 struct RenderState {
     SDL_GPUCommandBuffer *mCommandBuffer;
     SDL_GPUTexture *mSwapchainTexture;
+    // Only valid while the pass that owns it records
     SDL_GPURenderPass *mRenderPass;
 
     SDL_GPUColorTargetInfo mColorTargetInfo;
     SDL_GPUDepthStencilTargetInfo mDepthStencilTargetInfo;
+
+    // Size of the area rendered this frame, smaller than the targets when the render scale is below one
+    Uint32 mRenderWidth;
+    Uint32 mRenderHeight;
+
+    // Timestamp of the oldest input the frame consumed, zero when it had none
+    Uint64 mInputTime;
+
+    // The frame's resources in the render graph, the resolve target is invalid without MSAA
+    RenderResourceID mBackbuffer;
+    RenderResourceID mSceneColor;
+    RenderResourceID mSceneDepth;
+    RenderResourceID mSceneResolve;
 };
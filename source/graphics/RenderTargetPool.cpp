@@ -0,0 +1,148 @@
+#include "RenderTargetPool.hpp"
+
+#include "macros/log.hpp"
+
+#include "memory/MemoryService.hpp"
+
+// Bucketed sizes are rounded up to a multiple of this
+static constexpr Uint32 cSizeBucket = 256;
+// Free targets are destroyed after this many frames without use
+static constexpr Uint64 cMaxIdleFrames = 120;
+
+static Uint32 RoundUpToBucket(Uint32 inSize) {
+    return (inSize + cSizeBucket - 1) / cSizeBucket * cSizeBucket;
+}
+
+void RenderTargetPool::Initialize(SDL_GPUDevice *inDevice) {
+    mDevice = inDevice;
+}
+
+void RenderTargetPool::Shutdown() {
+    for (Entry &entry : mEntries) {
+        Destroy(entry);
+    }
+
+    mEntries.clear();
+    mDevice = nullptr;
+}
+
+void RenderTargetPool::Destroy(Entry &inEntry) {
+    SDL_ReleaseGPUTexture(mDevice, inEntry.mTexture);
+    MemoryService::Get().TrackGPUTexture(-static_cast<Sint64>(inEntry.mSize));
+    mAllocatedBytes -= inEntry.mSize;
+}
+
+void RenderTargetPool::BeginFrame() {
+    mFrame++;
+
+    for (size_t i = 0; i < mEntries.size();) {
+        Entry &entry = mEntries[i];
+        if (!entry.mIsInUse && mFrame - entry.mLastUsedFrame > cMaxIdleFrames) {
+            Destroy(entry);
+            mEntries.erase_unsorted(mEntries.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void RenderTargetPool::ReleaseUnused() {
+    for (size_t i = 0; i < mEntries.size();) {
+        if (!mEntries[i].mIsInUse) {
+            Destroy(mEntries[i]);
+            mEntries.erase_unsorted(mEntries.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+SDL_GPUTexture *RenderTargetPool::Acquire(const RenderTargetDesc &inDesc, bool inIsExactSize) {
+    RenderTargetDesc desc = inDesc;
+    if (!inIsExactSize) {
+        desc.mWidth = RoundUpToBucket(desc.mWidth);
+        desc.mHeight = RoundUpToBucket(desc.mHeight);
+    }
+
+    for (Entry &entry : mEntries) {
+        if (!entry.mIsInUse &&
+            entry.mDesc.mFormat == desc.mFormat &&
+            entry.mDesc.mUsage == desc.mUsage &&
+            entry.mDesc.mSampleCount == desc.mSampleCount &&
+            entry.mDesc.mWidth == desc.mWidth &&
+            entry.mDesc.mHeight == desc.mHeight) {
+            entry.mIsInUse = true;
+            entry.mLastUsedFrame = mFrame;
+            mReuseCount++;
+            return entry.mTexture;
+        }
+    }
+
+    SDL_GPUTextureCreateInfo create_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = desc.mFormat,
+        .usage = desc.mUsage,
+        .width = desc.mWidth,
+        .height = desc.mHeight,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = desc.mSampleCount,
+    };
+
+    SDL_GPUTexture *texture = SDL_CreateGPUTexture(mDevice, &create_info);
+    if (texture == nullptr) {
+        LOG_ERROR("Unable to create render target: %s", SDL_GetError());
+        return nullptr;
+    }
+
+    // Every sample of a multisampled texture takes a full texel
+    Uint64 size = SDL_CalculateGPUTextureFormatSize(desc.mFormat, desc.mWidth, desc.mHeight, 1);
+    size <<= static_cast<Uint32>(desc.mSampleCount);
+
+    mEntries.push_back({ desc, texture, size, mFrame, true });
+    MemoryService::Get().TrackGPUTexture(static_cast<Sint64>(size));
+    mAllocatedBytes += size;
+    mAllocationCount++;
+
+    return texture;
+}
+
+void RenderTargetPool::Release(SDL_GPUTexture *inTexture) {
+    for (Entry &entry : mEntries) {
+        if (entry.mTexture == inTexture) {
+            entry.mIsInUse = false;
+            entry.mLastUsedFrame = mFrame;
+            return;
+        }
+    }
+}
+
+Uint64 RenderTargetPool::GetResidentSize(const RenderTargetDesc &inDesc) const {
+    Uint64 size = 0;
+    for (const Entry &entry : mEntries) {
+        if (entry.mDesc.mFormat == inDesc.mFormat &&
+            entry.mDesc.mUsage == inDesc.mUsage &&
+            entry.mDesc.mSampleCount == inDesc.mSampleCount) {
+            size += entry.mSize;
+        }
+    }
+
+    return size;
+}
+
+RenderTargetPoolStats RenderTargetPool::GetStats() const {
+    Uint32 in_use_count = 0;
+    for (const Entry &entry : mEntries) {
+        if (entry.mIsInUse) {
+            in_use_count++;
+        }
+    }
+
+    return {
+        static_cast<Uint32>(mEntries.size()),
+        in_use_count,
+        mAllocatedBytes,
+        mAllocationCount,
+        mReuseCount
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <EASTL/vector.h>
+
+struct RenderTargetDesc {
+    SDL_GPUTextureFormat mFormat;
+    SDL_GPUTextureUsageFlags mUsage;
+    SDL_GPUSampleCount mSampleCount;
+    Uint32 mWidth;
+    Uint32 mHeight;
+};
+
+struct RenderTargetPoolStats {
+    Uint32 mTextureCount;
+    Uint32 mInUseCount;
+    Uint64 mAllocatedBytes;
+    Uint64 mAllocationCount;
+    Uint64 mReuseCount;
+};
+
+// Recycles render targets between passes and frames. Sizes are rounded up to buckets, so a window that is being
+// resized keeps reusing the same textures and only renders into part of them.
+class RenderTargetPool {
+private:
+    struct Entry {
+        RenderTargetDesc mDesc;
+        SDL_GPUTexture *mTexture;
+        Uint64 mSize;
+        Uint64 mLastUsedFrame;
+        bool mIsInUse;
+    };
+
+    SDL_GPUDevice *mDevice = nullptr;
+    eastl::vector<Entry> mEntries;
+    Uint64 mFrame = 0;
+
+    Uint64 mAllocatedBytes = 0;
+    Uint64 mAllocationCount = 0;
+    Uint64 mReuseCount = 0;
+
+    void Destroy(Entry &inEntry);
+
+public:
+    void Initialize(SDL_GPUDevice *inDevice);
+    void Shutdown();
+
+    // Release the targets that weren't used for a while, call once per frame
+    void BeginFrame();
+    // Release every target that isn't in use right away, for when frames stop needing the ones they had
+    void ReleaseUnused();
+
+    // Get a free target at least as large as requested. Exact targets have the requested size, which is needed
+    // when they are resolved or rendered together with the swapchain.
+    SDL_GPUTexture *Acquire(const RenderTargetDesc &inDesc, bool inIsExactSize);
+    void Release(SDL_GPUTexture *inTexture);
+
+    // Bytes held by targets of the description's format, usage and sample count, of any size
+    Uint64 GetResidentSize(const RenderTargetDesc &inDesc) const;
+
+    RenderTargetPoolStats GetStats() const;
+};
@@ -0,0 +1,110 @@
+#include "ResolutionController.hpp"
+
+#include "macros/log.hpp"
+
+#include <cmath>
+
+// Aim slightly under the budget so small spikes don't push the frame over it
+static constexpr double cTargetFraction = 0.9;
+// Ignore deviations smaller than this fraction of the target, so the scale doesn't wobble every frame
+static constexpr double cDeadband = 0.05;
+// Largest scale change per frame, keeps the resolution from visibly popping
+static constexpr float cMaxStep = 0.05f;
+// Weight of a new sample in the smoothed frame time
+static constexpr double cSmoothing = 0.1;
+
+void ResolutionController::Update(Uint64 inFrameTime, bool inIsUpperBound) {
+    if (!inIsUpperBound) {
+        mFrameCount++;
+        if (inFrameTime <= mBudget) {
+            mFramesWithinBudget++;
+        }
+    } else if (inFrameTime <= mBudget) {
+        // The real time was even lower, so the frame was within budget as well
+        mFrameCount++;
+        mFramesWithinBudget++;
+    } else {
+        // An upper bound over the budget says nothing about the GPU
+        return;
+    }
+
+    double frame_time = static_cast<double>(inFrameTime);
+    mSmoothedFrameTime = mSmoothedFrameTime == 0.0 ? frame_time : mSmoothedFrameTime + (frame_time - mSmoothedFrameTime) * cSmoothing;
+
+    if (!mIsEnabled) {
+        return;
+    }
+
+    double target = static_cast<double>(mBudget) * cTargetFraction;
+    if (SDL_fabs(mSmoothedFrameTime - target) < target * cDeadband) {
+        return;
+    }
+
+    // GPU time scales with the pixel count, which is the square of the scale
+    float ideal_scale = mScale * static_cast<float>(std::sqrt(target / mSmoothedFrameTime));
+    float step = SDL_clamp(ideal_scale - mScale, -cMaxStep, cMaxStep);
+
+    // A frame the CPU takes longer on than the GPU isn't any shorter at a lower resolution
+    if (step < 0.0f && mSmoothedCPUTime > SDL_max(mSmoothedFrameTime, target)) {
+        return;
+    }
+    mScale = SDL_clamp(mScale + step, mMinScale, mMaxScale);
+}
+
+void ResolutionController::UpdateCPUTime(Uint64 inFrameTime) {
+    mCPUFrameCount++;
+    if (inFrameTime <= mBudget) {
+        mCPUFramesWithinBudget++;
+    }
+
+    double frame_time = static_cast<double>(inFrameTime);
+    mSmoothedCPUTime = mSmoothedCPUTime == 0.0 ? frame_time : mSmoothedCPUTime + (frame_time - mSmoothedCPUTime) * cSmoothing;
+}
+
+void ResolutionController::SetEnabled(bool inIsEnabled) {
+    mIsEnabled = inIsEnabled;
+    if (!mIsEnabled) {
+        mScale = mMaxScale;
+    }
+}
+
+void ResolutionController::SetBudget(Uint64 inBudget) {
+    mBudget = inBudget;
+    mFrameCount = 0;
+    mFramesWithinBudget = 0;
+    mCPUFrameCount = 0;
+    mCPUFramesWithinBudget = 0;
+}
+
+void ResolutionController::SetScaleRange(float inMinScale, float inMaxScale) {
+    mMinScale = SDL_clamp(inMinScale, 0.1f, 1.0f);
+    mMaxScale = SDL_clamp(inMaxScale, mMinScale, 1.0f);
+    mScale = SDL_clamp(mScale, mMinScale, mMaxScale);
+}
+
+ResolutionStats ResolutionController::GetStats() const {
+    return {
+        mScale,
+        mBudget,
+        static_cast<Uint64>(mSmoothedFrameTime),
+        mFrameCount,
+        mFramesWithinBudget,
+        static_cast<Uint64>(mSmoothedCPUTime),
+        mCPUFrameCount,
+        mCPUFramesWithinBudget
+    };
+}
+
+void ResolutionController::LogStats() const {
+    ResolutionStats stats = GetStats();
+
+    LOG_INFO("Render scale %.2f, %.2f ms budget\n", stats.mScale, static_cast<double>(stats.mBudget) / 1e6);
+    LOG_INFO("GPU frame %.2f ms, %llu of %llu frames within budget\n",
+        static_cast<double>(stats.mFrameTime) / 1e6,
+        static_cast<unsigned long long>(stats.mFramesWithinBudget),
+        static_cast<unsigned long long>(stats.mFrameCount));
+    LOG_INFO("CPU frame %.2f ms, %llu of %llu frames within budget\n",
+        static_cast<double>(stats.mCPUFrameTime) / 1e6,
+        static_cast<unsigned long long>(stats.mCPUFramesWithinBudget),
+        static_cast<unsigned long long>(stats.mCPUFrameCount));
+}
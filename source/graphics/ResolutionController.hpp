@@ -0,0 +1,62 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// How well the controller holds its budget, times in nanoseconds
+struct ResolutionStats {
+    float mScale;
+    Uint64 mBudget;
+    Uint64 mFrameTime;
+    Uint64 mFrameCount;
+    Uint64 mFramesWithinBudget;
+    Uint64 mCPUFrameTime;
+    Uint64 mCPUFrameCount;
+    Uint64 mCPUFramesWithinBudget;
+};
+
+// Picks the render scale that keeps the GPU frame time within a budget. The scale applies to both axes, so the
+// shaded pixel count follows its square. The CPU time doesn't change with the scale, it only keeps the controller
+// from lowering the resolution of a frame that the CPU holds up anyway.
+class ResolutionController {
+private:
+    bool mIsEnabled = true;
+    float mScale = 1.0f;
+    float mMinScale = 0.5f;
+    float mMaxScale = 1.0f;
+
+    Uint64 mBudget = 1000000000 / 60;
+    double mSmoothedFrameTime = 0.0;
+
+    Uint64 mFrameCount = 0;
+    Uint64 mFramesWithinBudget = 0;
+
+    double mSmoothedCPUTime = 0.0;
+    Uint64 mCPUFrameCount = 0;
+    Uint64 mCPUFramesWithinBudget = 0;
+
+public:
+    // Feed the GPU time of a finished frame. Upper bounds are frames that finished before they were checked,
+    // they can only tell the controller that there is room to grow.
+    void Update(Uint64 inFrameTime, bool inIsUpperBound);
+    // Feed the CPU time of a frame, without the time it spent waiting for the GPU
+    void UpdateCPUTime(Uint64 inFrameTime);
+
+    void SetEnabled(bool inIsEnabled);
+    void SetBudget(Uint64 inBudget);
+    void SetScaleRange(float inMinScale, float inMaxScale);
+
+    ResolutionStats GetStats() const;
+    void LogStats() const;
+
+    inline bool IsEnabled() const {
+        return mIsEnabled;
+    }
+
+    inline float GetScale() const {
+        return mScale;
+    }
+
+    inline Uint64 GetBudget() const {
+        return mBudget;
+    }
+};
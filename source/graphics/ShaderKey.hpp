@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Compact description of a shader variant, built from the feature defines the shader was compiled with.
+// The bit layout must match FEATURES in scripts/build-shaders.py.
+using ShaderKey = Uint32;
+
+static constexpr Uint32 cShaderKeyPointLightCountShift = 0;
+static constexpr Uint32 cShaderKeyPointLightCountMask = 0x7;
+static constexpr ShaderKey cShaderKeyLambert = 1 << 3;
+// The variant samples an albedo texture and takes one fragment sampler
+static constexpr ShaderKey cShaderKeyAlbedoTexture = 1 << 4;
+
+// Point light counts that basic_triangle.frag is compiled for, in increasing order
+static constexpr Uint32 cShaderPointLightCounts[] = { 0, 1, 2, 4 };
+
+// Pick the cheapest compiled point light count that still covers the given number of lights
+inline Uint32 GetShaderPointLightCount(Uint32 inLightCount) {
+    for (Uint32 count : cShaderPointLightCounts) {
+        if (count >= inLightCount) {
+            return count;
+        }
+    }
+
+    return cShaderPointLightCounts[SDL_arraysize(cShaderPointLightCounts) - 1];
+}
+
+// Lit variants always include the directional light, the scene always has one
+inline ShaderKey MakeLitShaderKey(Uint32 inPointLightCount, bool inIsLambert, bool inHasAlbedoTexture = false) {
+    ShaderKey key = (GetShaderPointLightCount(inPointLightCount) & cShaderKeyPointLightCountMask) << cShaderKeyPointLightCountShift;
+
+    if (inIsLambert) {
+        key |= cShaderKeyLambert;
+    }
+
+    if (inHasAlbedoTexture) {
+        key |= cShaderKeyAlbedoTexture;
+    }
+
+    return key;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ShaderKey.hpp"
+
+// SPIR-V of one shader variant, tables of these are generated by scripts/build-shaders.py
+struct ShaderVariantCode {
+    ShaderKey mKey;
+    const unsigned char *mCode;
+    unsigned int mSize;
+};
@@ -0,0 +1,102 @@
+#include "StorageBuffer.hpp"
+
+#include "macros/log.hpp"
+
+#include "memory/MemoryService.hpp"
+
+bool StorageBuffer::Initialize(SDL_GPUDevice *inDevice, Uint32 inInitialCapacity) {
+    mDevice = inDevice;
+    return Reserve(inInitialCapacity);
+}
+
+void StorageBuffer::Shutdown() {
+    Release();
+    mDevice = nullptr;
+}
+
+bool StorageBuffer::Reserve(Uint32 inSize) {
+    if (inSize <= mCapacity) {
+        return true;
+    }
+
+    // Grow geometrically so a slowly growing scene doesn't recreate the buffer every frame
+    Uint32 capacity = mCapacity * 2 > inSize ? mCapacity * 2 : inSize;
+
+    // The old buffers may still be in use by frames in flight, SDL defers their destruction until they are done
+    Release();
+
+    SDL_GPUBufferCreateInfo buffer_create_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        .size = capacity
+    };
+
+    mBuffer = SDL_CreateGPUBuffer(mDevice, &buffer_create_info);
+    if (mBuffer == nullptr) {
+        LOG_ERROR("Unable to create storage buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = capacity
+    };
+
+    mTransferBuffer = SDL_CreateGPUTransferBuffer(mDevice, &transfer_buffer_create_info);
+    if (mTransferBuffer == nullptr) {
+        LOG_ERROR("Unable to create transfer buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUBuffer(mDevice, mBuffer);
+        mBuffer = nullptr;
+        return false;
+    }
+
+    mCapacity = capacity;
+    MemoryService::Get().TrackGPUBuffer(static_cast<Sint64>(mCapacity) * 2);
+
+    return true;
+}
+
+void StorageBuffer::Release() {
+    if (mBuffer != nullptr) {
+        SDL_ReleaseGPUBuffer(mDevice, mBuffer);
+        SDL_ReleaseGPUTransferBuffer(mDevice, mTransferBuffer);
+        MemoryService::Get().TrackGPUBuffer(-static_cast<Sint64>(mCapacity) * 2);
+    }
+
+    mBuffer = nullptr;
+    mTransferBuffer = nullptr;
+    mCapacity = 0;
+}
+
+bool StorageBuffer::Upload(SDL_GPUCopyPass *inCopyPass, const void *inData, Uint32 inSize) {
+    if (inSize == 0) {
+        return true;
+    }
+
+    if (!Reserve(inSize)) {
+        return false;
+    }
+
+    // Cycle the transfer buffer so data of a frame that is still in flight isn't overwritten
+    void *transfer_data = SDL_MapGPUTransferBuffer(mDevice, mTransferBuffer, true);
+    if (transfer_data == nullptr) {
+        LOG_ERROR("Unable to map transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_memcpy(transfer_data, inData, inSize);
+    SDL_UnmapGPUTransferBuffer(mDevice, mTransferBuffer);
+
+    SDL_GPUTransferBufferLocation transfer_buffer_location = {
+        .transfer_buffer = mTransferBuffer,
+        .offset = 0
+    };
+
+    SDL_GPUBufferRegion buffer_region = {
+        .buffer = mBuffer,
+        .offset = 0,
+        .size = inSize
+    };
+
+    SDL_UploadToGPUBuffer(inCopyPass, &transfer_buffer_location, &buffer_region, true);
+    return true;
+}
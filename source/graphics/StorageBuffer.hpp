@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// A GPU buffer read by shaders that is refilled from the CPU through its own transfer buffer
+class StorageBuffer {
+private:
+    SDL_GPUDevice *mDevice = nullptr;
+    SDL_GPUBuffer *mBuffer = nullptr;
+    SDL_GPUTransferBuffer *mTransferBuffer = nullptr;
+    Uint32 mCapacity = 0;
+
+    bool Reserve(Uint32 inSize);
+    void Release();
+
+public:
+    bool Initialize(SDL_GPUDevice *inDevice, Uint32 inInitialCapacity);
+    void Shutdown();
+
+    // Copy data into the buffer, growing it when it doesn't fit. Has to be recorded outside of a render pass.
+    bool Upload(SDL_GPUCopyPass *inCopyPass, const void *inData, Uint32 inSize);
+
+    inline SDL_GPUBuffer *GetBuffer() const {
+        return mBuffer;
+    }
+
+    inline Uint32 GetCapacity() const {
+        return mCapacity;
+    }
+};
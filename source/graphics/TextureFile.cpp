@@ -0,0 +1,176 @@
+#include "TextureFile.hpp"
+
+#include "macros/log.hpp"
+
+static inline Uint32 GetBlockCount(Uint32 inSize) {
+    return (inSize + 3) / 4;
+}
+
+bool ReadTextureFile(const Uint8 *inData, size_t inSize, TextureFileView &outView) {
+    if (inSize < sizeof(TextureFileHeader)) {
+        LOG_ERROR("Texture file is too small\n");
+        return false;
+    }
+
+    const TextureFileHeader *header = reinterpret_cast<const TextureFileHeader *>(inData);
+    if (header->mMagic != cTextureFileMagic) {
+        LOG_ERROR("Not a texture file\n");
+        return false;
+    }
+
+    if (header->mVersion != cTextureFileVersion) {
+        LOG_ERROR("Unsupported texture file version %u, expected %u\n", header->mVersion, cTextureFileVersion);
+        return false;
+    }
+
+    if (header->mFormat != TextureFileFormat::BC1 && header->mFormat != TextureFileFormat::BC3) {
+        LOG_ERROR("Unsupported texture file format %u\n", static_cast<Uint32>(header->mFormat));
+        return false;
+    }
+
+    if (header->mWidth == 0 || header->mHeight == 0 || header->mMipCount == 0 || header->mMipCount > cTextureFileMaxMipCount) {
+        LOG_ERROR("Texture file has an invalid size of %ux%u with %u mips\n", header->mWidth, header->mHeight, header->mMipCount);
+        return false;
+    }
+
+    Uint64 table_size = Uint64(header->mMipCount) * sizeof(TextureFileMip);
+    if (header->mMipOffset % cTextureFileAlignment != 0 || header->mMipOffset > inSize || table_size > inSize - header->mMipOffset) {
+        LOG_ERROR("Texture file mip table is out of bounds\n");
+        return false;
+    }
+
+    const TextureFileMip *mips = reinterpret_cast<const TextureFileMip *>(inData + header->mMipOffset);
+    Uint32 block_size = GetTextureFileBlockSize(header->mFormat);
+
+    // Every mip halves the one before it, so the streamer can derive sizes and copy regions from the mip index
+    for (Uint32 i = 0; i < header->mMipCount; i++) {
+        const TextureFileMip &mip = mips[i];
+
+        Uint32 width = SDL_max(header->mWidth >> i, 1u);
+        Uint32 height = SDL_max(header->mHeight >> i, 1u);
+        Uint64 size = Uint64(GetBlockCount(width)) * GetBlockCount(height) * block_size;
+
+        if (mip.mWidth != width || mip.mHeight != height || mip.mSize != size) {
+            LOG_ERROR("Texture file mip %u doesn't match the size of the texture\n", i);
+            return false;
+        }
+
+        if (mip.mOffset % cTextureFileAlignment != 0 || mip.mOffset > inSize || mip.mSize > inSize - mip.mOffset) {
+            LOG_ERROR("Texture file mip %u is out of bounds\n", i);
+            return false;
+        }
+    }
+
+    outView.mFormat = header->mFormat;
+    outView.mWidth = header->mWidth;
+    outView.mHeight = header->mHeight;
+    outView.mMipCount = header->mMipCount;
+    outView.mMips = mips;
+    outView.mData = inData;
+
+    return true;
+}
+
+static inline void DecodeColor565(Uint16 inColor, Uint32 *outColor) {
+    Uint32 r = (inColor >> 11) & 0x1f;
+    Uint32 g = (inColor >> 5) & 0x3f;
+    Uint32 b = inColor & 0x1f;
+
+    outColor[0] = (r << 3) | (r >> 2);
+    outColor[1] = (g << 2) | (g >> 4);
+    outColor[2] = (b << 3) | (b >> 2);
+}
+
+// Decode the color half of a block into a 4x4 RGBA block. BC3 always uses four colors, BC1 switches to three colors
+// and transparent black when the endpoints are ordered the other way round.
+static void DecodeColorBlock(const Uint8 *inBlock, bool inIsBC1, Uint8 *outPixels) {
+    Uint16 color0 = static_cast<Uint16>(inBlock[0] | (inBlock[1] << 8));
+    Uint16 color1 = static_cast<Uint16>(inBlock[2] | (inBlock[3] << 8));
+    Uint32 indices = inBlock[4] | (inBlock[5] << 8) | (inBlock[6] << 16) | (Uint32(inBlock[7]) << 24);
+
+    Uint32 palette[4][4];
+    DecodeColor565(color0, palette[0]);
+    DecodeColor565(color1, palette[1]);
+    palette[0][3] = 255;
+    palette[1][3] = 255;
+
+    bool is_four_color = !inIsBC1 || color0 > color1;
+    for (Uint32 c = 0; c < 3; c++) {
+        if (is_four_color) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    palette[2][3] = 255;
+    palette[3][3] = is_four_color ? 255 : 0;
+
+    for (Uint32 i = 0; i < 16; i++) {
+        const Uint32 *color = palette[(indices >> (i * 2)) & 0x3];
+        for (Uint32 c = 0; c < 4; c++) {
+            outPixels[i * 4 + c] = static_cast<Uint8>(color[c]);
+        }
+    }
+}
+
+static void DecodeAlphaBlock(const Uint8 *inBlock, Uint8 *outPixels) {
+    Uint32 alpha[8];
+    alpha[0] = inBlock[0];
+    alpha[1] = inBlock[1];
+
+    if (alpha[0] > alpha[1]) {
+        for (Uint32 i = 1; i < 7; i++) {
+            alpha[i + 1] = ((7 - i) * alpha[0] + i * alpha[1]) / 7;
+        }
+    } else {
+        for (Uint32 i = 1; i < 5; i++) {
+            alpha[i + 1] = ((5 - i) * alpha[0] + i * alpha[1]) / 5;
+        }
+
+        alpha[6] = 0;
+        alpha[7] = 255;
+    }
+
+    // 16 indices of 3 bits follow the endpoints
+    Uint64 indices = 0;
+    for (Uint32 i = 0; i < 6; i++) {
+        indices |= Uint64(inBlock[2 + i]) << (i * 8);
+    }
+
+    for (Uint32 i = 0; i < 16; i++) {
+        outPixels[i * 4 + 3] = static_cast<Uint8>(alpha[(indices >> (i * 3)) & 0x7]);
+    }
+}
+
+void DecodeTextureFileMip(TextureFileFormat inFormat, const Uint8 *inData, Uint32 inWidth, Uint32 inHeight, Uint8 *outPixels) {
+    bool is_bc1 = inFormat == TextureFileFormat::BC1;
+    Uint32 block_size = GetTextureFileBlockSize(inFormat);
+    Uint32 block_count_x = GetBlockCount(inWidth);
+    Uint32 block_count_y = GetBlockCount(inHeight);
+
+    Uint8 block_pixels[16 * 4];
+
+    for (Uint32 block_y = 0; block_y < block_count_y; block_y++) {
+        for (Uint32 block_x = 0; block_x < block_count_x; block_x++) {
+            const Uint8 *block = inData + (block_y * block_count_x + block_x) * block_size;
+
+            if (is_bc1) {
+                DecodeColorBlock(block, true, block_pixels);
+            } else {
+                DecodeColorBlock(block + 8, false, block_pixels);
+                DecodeAlphaBlock(block, block_pixels);
+            }
+
+            // Mips smaller than a block only keep the pixels that are inside the texture
+            for (Uint32 y = 0; y < 4 && block_y * 4 + y < inHeight; y++) {
+                for (Uint32 x = 0; x < 4 && block_x * 4 + x < inWidth; x++) {
+                    Uint8 *pixel = outPixels + ((block_y * 4 + y) * inWidth + block_x * 4 + x) * 4;
+                    SDL_memcpy(pixel, block_pixels + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
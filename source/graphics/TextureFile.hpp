@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Cooked texture layout, written by scripts/cook-textures.py. A header and a table of mips, finest first, are
+// followed by the block compressed mip data, each mip starting on a 16 byte boundary so it can be copied straight
+// from a mapped file into a transfer buffer. Bump the version whenever a record changes.
+static constexpr Uint32 cTextureFileMagic = 0x58455443; // "CTEX"
+static constexpr Uint32 cTextureFileVersion = 1;
+static constexpr Uint32 cTextureFileAlignment = 16;
+// Enough for a 32k texture, which is larger than any device can sample
+static constexpr Uint32 cTextureFileMaxMipCount = 16;
+
+enum class TextureFileFormat : Uint32 {
+    // 4x4 blocks of 8 bytes, opaque color
+    BC1 = 1,
+    // 4x4 blocks of 16 bytes, color with interpolated alpha
+    BC3 = 2,
+};
+
+struct TextureFileHeader {
+    Uint32 mMagic;
+    Uint32 mVersion;
+    TextureFileFormat mFormat;
+    Uint32 mWidth;
+    Uint32 mHeight;
+    Uint32 mMipCount;
+    Uint64 mMipOffset;
+};
+
+struct TextureFileMip {
+    Uint64 mOffset;
+    Uint32 mSize;
+    Uint32 mWidth;
+    Uint32 mHeight;
+    Uint32 mPadding;
+};
+
+// The records are written as is, so their layout must not change without a version bump
+static_assert(sizeof(TextureFileHeader) == 32);
+static_assert(sizeof(TextureFileMip) == 24);
+
+// A cooked texture, pointing into a mapped file
+struct TextureFileView {
+    TextureFileFormat mFormat = TextureFileFormat::BC1;
+    Uint32 mWidth = 0;
+    Uint32 mHeight = 0;
+    Uint32 mMipCount = 0;
+    const TextureFileMip *mMips = nullptr;
+    const Uint8 *mData = nullptr;
+
+    inline const Uint8 *GetMipData(Uint32 inMip) const {
+        return mData + mMips[inMip].mOffset;
+    }
+};
+
+inline Uint32 GetTextureFileBlockSize(TextureFileFormat inFormat) {
+    return inFormat == TextureFileFormat::BC1 ? 8 : 16;
+}
+
+// Validate a cooked texture in memory and point the view at its mips
+bool ReadTextureFile(const Uint8 *inData, size_t inSize, TextureFileView &outView);
+
+// Decode one block compressed mip into tightly packed RGBA8 pixels, for devices that can't sample the blocks
+void DecodeTextureFileMip(TextureFileFormat inFormat, const Uint8 *inData, Uint32 inWidth, Uint32 inHeight, Uint8 *outPixels);
@@ -0,0 +1,555 @@
+#include "TextureStreamer.hpp"
+
+#include "macros/log.hpp"
+
+#include <EASTL/sort.h>
+
+#include "memory/MemoryService.hpp"
+
+static inline Uint32 AlignUpload(Uint32 inSize) {
+    return (inSize + cTextureFileAlignment - 1) & ~(cTextureFileAlignment - 1);
+}
+
+bool TextureStreamer::Initialize(SDL_GPUDevice *inDevice, const TextureStreamingSettings &inSettings) {
+    mDevice = inDevice;
+    mSettings = inSettings;
+    mStats.mBudget = mSettings.mBudget;
+
+    mIsDecoding =
+        !SDL_GPUTextureSupportsFormat(mDevice, SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER) ||
+        !SDL_GPUTextureSupportsFormat(mDevice, SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER);
+
+    if (mIsDecoding) {
+        LOG_INFO("GPU doesn't support BC textures, streamed mips are decoded to RGBA8 and take up to 8x the memory\n");
+    }
+
+    SDL_GPUSamplerCreateInfo sampler_create_info = {
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .min_lod = 0.0f,
+        // Textures are recreated with fewer levels as mips are evicted, the sampler has to cover the full chain
+        .max_lod = static_cast<float>(cTextureFileMaxMipCount),
+    };
+
+    mSampler = SDL_CreateGPUSampler(mDevice, &sampler_create_info);
+    if (mSampler == nullptr) {
+        LOG_ERROR("Unable to create texture sampler: %s\n", SDL_GetError());
+        return false;
+    }
+
+    return EnsureTransferSize(mSettings.mMaxUploadSize);
+}
+
+void TextureStreamer::Shutdown() {
+    for (Texture &texture : mTextures) {
+        ReleaseTexture(texture);
+        delete texture.mFile;
+        texture.mFile = nullptr;
+    }
+
+    mTextures.clear();
+    mFreeTextures.clear();
+
+    if (mTransferBuffer != nullptr) {
+        SDL_ReleaseGPUTransferBuffer(mDevice, mTransferBuffer);
+        mTransferBuffer = nullptr;
+        mTransferSize = 0;
+    }
+
+    if (mSampler != nullptr) {
+        SDL_ReleaseGPUSampler(mDevice, mSampler);
+        mSampler = nullptr;
+    }
+
+    mDevice = nullptr;
+}
+
+SDL_GPUTextureFormat TextureStreamer::GetGPUFormat(const Texture &inTexture) const {
+    if (mIsDecoding) {
+        return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    }
+
+    return inTexture.mView.mFormat == TextureFileFormat::BC1 ? SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM : SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+}
+
+Uint32 TextureStreamer::GetMipSize(const Texture &inTexture, Uint32 inMip) const {
+    const TextureFileMip &mip = inTexture.mView.mMips[inMip];
+    return SDL_CalculateGPUTextureFormatSize(GetGPUFormat(inTexture), mip.mWidth, mip.mHeight, 1);
+}
+
+Uint64 TextureStreamer::GetResidentSize(const Texture &inTexture, Uint32 inMip) const {
+    Uint64 size = 0;
+    for (Uint32 mip = inMip; mip < inTexture.mView.mMipCount; mip++) {
+        size += GetMipSize(inTexture, mip);
+    }
+
+    return size;
+}
+
+void TextureStreamer::WriteMip(const Texture &inTexture, Uint32 inMip, Uint8 *outData) const {
+    const TextureFileMip &mip = inTexture.mView.mMips[inMip];
+
+    if (mIsDecoding) {
+        DecodeTextureFileMip(inTexture.mView.mFormat, inTexture.mView.GetMipData(inMip), mip.mWidth, mip.mHeight, outData);
+    } else {
+        SDL_memcpy(outData, inTexture.mView.GetMipData(inMip), mip.mSize);
+    }
+}
+
+bool TextureStreamer::EnsureTransferSize(Uint32 inSize) {
+    if (mTransferBuffer != nullptr && mTransferSize >= inSize) {
+        return true;
+    }
+
+    // Released buffers stay alive until the GPU is done with them, so this is safe in the middle of a frame
+    if (mTransferBuffer != nullptr) {
+        SDL_ReleaseGPUTransferBuffer(mDevice, mTransferBuffer);
+        mTransferBuffer = nullptr;
+        mTransferSize = 0;
+    }
+
+    SDL_GPUTransferBufferCreateInfo create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = inSize
+    };
+
+    mTransferBuffer = SDL_CreateGPUTransferBuffer(mDevice, &create_info);
+    if (mTransferBuffer == nullptr) {
+        LOG_ERROR("Unable to create texture transfer buffer: %s\n", SDL_GetError());
+        return false;
+    }
+
+    mTransferSize = inSize;
+    return true;
+}
+
+SDL_GPUTexture *TextureStreamer::CreateTexture(const Texture &inTexture, Uint32 inMip) {
+    SDL_GPUTextureCreateInfo create_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = GetGPUFormat(inTexture),
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = inTexture.mView.mMips[inMip].mWidth,
+        .height = inTexture.mView.mMips[inMip].mHeight,
+        .layer_count_or_depth = 1,
+        .num_levels = inTexture.mView.mMipCount - inMip,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+    };
+
+    SDL_GPUTexture *texture = SDL_CreateGPUTexture(mDevice, &create_info);
+    if (texture == nullptr) {
+        LOG_ERROR("Unable to create streamed texture: %s\n", SDL_GetError());
+    }
+
+    return texture;
+}
+
+void TextureStreamer::ReleaseTexture(Texture &ioTexture) {
+    if (ioTexture.mTexture == nullptr) {
+        return;
+    }
+
+    SDL_ReleaseGPUTexture(mDevice, ioTexture.mTexture);
+    MemoryService::Get().TrackGPUTexture(-static_cast<Sint64>(ioTexture.mResidentSize));
+    mResidentSize -= ioTexture.mResidentSize;
+
+    ioTexture.mTexture = nullptr;
+    ioTexture.mResidentSize = 0;
+}
+
+TextureID TextureStreamer::Load(const char *inPath) {
+    FileData *file = new FileData();
+    if (!FileService::Get().MapFile(inPath, *file)) {
+        delete file;
+        return cInvalidTexture;
+    }
+
+    Texture texture = {};
+    texture.mFile = file;
+
+    if (!ReadTextureFile(file->GetData(), file->GetSize(), texture.mView)) {
+        LOG_ERROR("Unable to read texture file: %s\n", inPath);
+        delete file;
+        return cInvalidTexture;
+    }
+
+    const TextureFileView &view = texture.mView;
+
+    // The tail starts at the first mip that fits the tail size, or the last mip for textures that never get there
+    Uint32 tail_mip = view.mMipCount - 1;
+    while (tail_mip > 0 && SDL_max(view.mMips[tail_mip - 1].mWidth, view.mMips[tail_mip - 1].mHeight) <= mSettings.mTailSize) {
+        tail_mip--;
+    }
+
+    texture.mTailMip = tail_mip;
+    texture.mRequestedMip = view.mMipCount;
+    texture.mTargetMip = tail_mip;
+    texture.mLastNeededFrame = mFrame;
+
+    texture.mTexture = CreateTexture(texture, tail_mip);
+    if (texture.mTexture == nullptr) {
+        delete file;
+        return cInvalidTexture;
+    }
+
+    texture.mResidentMip = tail_mip;
+    texture.mResidentSize = GetResidentSize(texture, tail_mip);
+    mResidentSize += texture.mResidentSize;
+    MemoryService::Get().TrackGPUTexture(static_cast<Sint64>(texture.mResidentSize));
+
+    // The tail is small, it goes up right away through its own transfer buffer like a mesh does
+    Uint32 upload_size = 0;
+    for (Uint32 mip = tail_mip; mip < view.mMipCount; mip++) {
+        upload_size += AlignUpload(GetMipSize(texture, mip));
+    }
+
+    SDL_GPUTransferBufferCreateInfo transfer_buffer_create_info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = upload_size
+    };
+
+    SDL_GPUTransferBuffer *transfer_buffer = SDL_CreateGPUTransferBuffer(mDevice, &transfer_buffer_create_info);
+    if (transfer_buffer == nullptr) {
+        LOG_ERROR("Unable to create transfer buffer: %s\n", SDL_GetError());
+        ReleaseTexture(texture);
+        delete file;
+        return cInvalidTexture;
+    }
+
+    Uint8 *transfer_data = static_cast<Uint8 *>(SDL_MapGPUTransferBuffer(mDevice, transfer_buffer, false));
+    if (transfer_data == nullptr) {
+        LOG_ERROR("Unable to map transfer buffer: %s\n", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(mDevice, transfer_buffer);
+        ReleaseTexture(texture);
+        delete file;
+        return cInvalidTexture;
+    }
+
+    Uint32 offset = 0;
+    for (Uint32 mip = tail_mip; mip < view.mMipCount; mip++) {
+        WriteMip(texture, mip, transfer_data + offset);
+        offset += AlignUpload(GetMipSize(texture, mip));
+    }
+
+    SDL_UnmapGPUTransferBuffer(mDevice, transfer_buffer);
+
+    SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(mDevice);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+
+    offset = 0;
+    for (Uint32 mip = tail_mip; mip < view.mMipCount; mip++) {
+        SDL_GPUTextureTransferInfo source = {
+            .transfer_buffer = transfer_buffer,
+            .offset = offset
+        };
+
+        SDL_GPUTextureRegion destination = {
+            .texture = texture.mTexture,
+            .mip_level = mip - tail_mip,
+            .w = view.mMips[mip].mWidth,
+            .h = view.mMips[mip].mHeight,
+            .d = 1
+        };
+
+        SDL_UploadToGPUTexture(copy_pass, &source, &destination, false);
+        offset += AlignUpload(GetMipSize(texture, mip));
+    }
+
+    SDL_EndGPUCopyPass(copy_pass);
+    SDL_SubmitGPUCommandBuffer(command_buffer);
+    SDL_ReleaseGPUTransferBuffer(mDevice, transfer_buffer);
+
+    TextureID id;
+    if (!mFreeTextures.empty()) {
+        id = mFreeTextures.back();
+        mFreeTextures.pop_back();
+        mTextures[id] = texture;
+    } else {
+        id = static_cast<TextureID>(mTextures.size());
+        mTextures.push_back(texture);
+    }
+
+    return id;
+}
+
+void TextureStreamer::Destroy(TextureID inTexture) {
+    if (inTexture == cInvalidTexture) {
+        return;
+    }
+
+    Texture &texture = mTextures[inTexture];
+    ReleaseTexture(texture);
+    delete texture.mFile;
+    texture.mFile = nullptr;
+
+    mFreeTextures.push_back(inTexture);
+}
+
+void TextureStreamer::RequestMip(TextureID inTexture, Uint32 inMip) {
+    if (inTexture == cInvalidTexture) {
+        return;
+    }
+
+    Texture &texture = mTextures[inTexture];
+    texture.mRequestedMip = SDL_min(texture.mRequestedMip, SDL_min(inMip, texture.mView.mMipCount - 1));
+}
+
+void TextureStreamer::RequestScreenSize(TextureID inTexture, float inPixels) {
+    if (inTexture == cInvalidTexture) {
+        return;
+    }
+
+    // The coarsest mip that still has a texel for every pixel
+    const TextureFileView &view = mTextures[inTexture].mView;
+    Uint32 mip = 0;
+    while (mip + 1 < view.mMipCount && static_cast<float>(SDL_max(view.mMips[mip + 1].mWidth, view.mMips[mip + 1].mHeight)) >= inPixels) {
+        mip++;
+    }
+
+    RequestMip(inTexture, mip);
+}
+
+bool TextureStreamer::EvictOne(Uint64 &ioPlannedSize) {
+    // Only mips above what this frame asked for are up for eviction, the least recently needed go first
+    Texture *victim = nullptr;
+    for (Texture &texture : mTextures) {
+        if (texture.mFile == nullptr || texture.mTargetMip >= texture.mTailMip || texture.mRequestedMip <= texture.mTargetMip) {
+            continue;
+        }
+
+        if (victim == nullptr || texture.mLastNeededFrame < victim->mLastNeededFrame) {
+            victim = &texture;
+        }
+    }
+
+    if (victim == nullptr) {
+        return false;
+    }
+
+    if (victim->mTargetMip == victim->mResidentMip) {
+        mChangedTextures.push_back(static_cast<TextureID>(victim - mTextures.data()));
+    }
+
+    ioPlannedSize -= GetMipSize(*victim, victim->mTargetMip);
+    victim->mTargetMip++;
+    return true;
+}
+
+void TextureStreamer::Update(SDL_GPUCommandBuffer *inCommandBuffer) {
+    mFrame++;
+
+    mLoadCandidates.clear();
+    mChangedTextures.clear();
+
+    Uint64 planned_size = mResidentSize;
+    Uint32 texture_count = 0;
+
+    for (TextureID id = 0; id < mTextures.size(); id++) {
+        Texture &texture = mTextures[id];
+        if (texture.mFile == nullptr) {
+            continue;
+        }
+
+        texture_count++;
+        texture.mTargetMip = texture.mResidentMip;
+
+        if (texture.mRequestedMip <= texture.mResidentMip) {
+            texture.mLastNeededFrame = mFrame;
+        } else if (texture.mResidentMip < texture.mTailMip && mFrame - texture.mLastNeededFrame > mSettings.mEvictionDelay) {
+            // Nothing needed the finer mips for a while, drop them whether the budget is full or not
+            texture.mTargetMip = SDL_min(texture.mRequestedMip, texture.mTailMip);
+            planned_size -= texture.mResidentSize - GetResidentSize(texture, texture.mTargetMip);
+            mChangedTextures.push_back(id);
+        }
+
+        if (texture.mRequestedMip < texture.mResidentMip) {
+            mLoadCandidates.push_back(id);
+        }
+    }
+
+    // Textures furthest from what they should look like go first
+    eastl::sort(mLoadCandidates.begin(), mLoadCandidates.end(), [this](TextureID inA, TextureID inB) {
+        const Texture &a = mTextures[inA];
+        const Texture &b = mTextures[inB];
+        Uint32 deficit_a = a.mResidentMip - a.mRequestedMip;
+        Uint32 deficit_b = b.mResidentMip - b.mRequestedMip;
+        return deficit_a != deficit_b ? deficit_a > deficit_b : inA < inB;
+    });
+
+    // Every texture comes one mip closer per frame at most, which keeps the copies of the levels it already has
+    // to one per mip
+    Uint32 upload_size = 0;
+    bool is_under_pressure = false;
+
+    for (TextureID id : mLoadCandidates) {
+        Texture &texture = mTextures[id];
+        Uint32 mip = texture.mResidentMip - 1;
+        Uint32 size = GetMipSize(texture, mip);
+
+        if (upload_size > 0 && upload_size + size > mSettings.mMaxUploadSize) {
+            break;
+        }
+
+        while (planned_size + size > mSettings.mBudget && EvictOne(planned_size)) {
+        }
+
+        // A smaller mip of another texture may still fit
+        if (planned_size + size > mSettings.mBudget) {
+            is_under_pressure = true;
+            continue;
+        }
+
+        texture.mTargetMip = mip;
+        planned_size += size;
+        upload_size += AlignUpload(size);
+        mChangedTextures.push_back(id);
+    }
+
+    if (is_under_pressure) {
+        mStats.mBudgetPressureFrames++;
+    }
+
+    Uint8 *transfer_data = nullptr;
+    if (upload_size > 0 && EnsureTransferSize(upload_size)) {
+        transfer_data = static_cast<Uint8 *>(SDL_MapGPUTransferBuffer(mDevice, mTransferBuffer, true));
+        if (transfer_data == nullptr) {
+            LOG_ERROR("Unable to map texture transfer buffer: %s\n", SDL_GetError());
+        }
+    }
+
+    // Without a transfer buffer the loads wait for the next frame, the evictions still go ahead
+    if (transfer_data != nullptr) {
+        Uint32 offset = 0;
+        for (TextureID id : mChangedTextures) {
+            const Texture &texture = mTextures[id];
+            if (texture.mTargetMip < texture.mResidentMip) {
+                WriteMip(texture, texture.mTargetMip, transfer_data + offset);
+                offset += AlignUpload(GetMipSize(texture, texture.mTargetMip));
+            }
+        }
+
+        SDL_UnmapGPUTransferBuffer(mDevice, mTransferBuffer);
+    }
+
+    if (!mChangedTextures.empty()) {
+        SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(inCommandBuffer);
+        Uint32 offset = 0;
+
+        for (TextureID id : mChangedTextures) {
+            Texture &texture = mTextures[id];
+            bool is_loading = texture.mTargetMip < texture.mResidentMip;
+            if (is_loading && transfer_data == nullptr) {
+                continue;
+            }
+
+            Uint32 upload_offset = offset;
+            if (is_loading) {
+                offset += AlignUpload(GetMipSize(texture, texture.mTargetMip));
+            }
+
+            SDL_GPUTexture *new_texture = CreateTexture(texture, texture.mTargetMip);
+            if (new_texture == nullptr) {
+                continue;
+            }
+
+            // Levels both textures have move over on the GPU, the mip indices are relative to each texture's base
+            for (Uint32 mip = SDL_max(texture.mTargetMip, texture.mResidentMip); mip < texture.mView.mMipCount; mip++) {
+                SDL_GPUTextureLocation source = {
+                    .texture = texture.mTexture,
+                    .mip_level = mip - texture.mResidentMip
+                };
+
+                SDL_GPUTextureLocation destination = {
+                    .texture = new_texture,
+                    .mip_level = mip - texture.mTargetMip
+                };
+
+                SDL_CopyGPUTextureToTexture(
+                    copy_pass,
+                    &source,
+                    &destination,
+                    texture.mView.mMips[mip].mWidth,
+                    texture.mView.mMips[mip].mHeight,
+                    1,
+                    false
+                );
+            }
+
+            if (is_loading) {
+                SDL_GPUTextureTransferInfo source = {
+                    .transfer_buffer = mTransferBuffer,
+                    .offset = upload_offset
+                };
+
+                SDL_GPUTextureRegion destination = {
+                    .texture = new_texture,
+                    .mip_level = 0,
+                    .w = texture.mView.mMips[texture.mTargetMip].mWidth,
+                    .h = texture.mView.mMips[texture.mTargetMip].mHeight,
+                    .d = 1
+                };
+
+                SDL_UploadToGPUTexture(copy_pass, &source, &destination, false);
+
+                mStats.mUploadCount++;
+                mStats.mUploadedSize += GetMipSize(texture, texture.mTargetMip);
+            } else {
+                mStats.mEvictionCount += texture.mTargetMip - texture.mResidentMip;
+                mStats.mEvictedSize += texture.mResidentSize - GetResidentSize(texture, texture.mTargetMip);
+            }
+
+            // The old texture is only destroyed once the copies above have run
+            ReleaseTexture(texture);
+
+            texture.mTexture = new_texture;
+            texture.mResidentMip = texture.mTargetMip;
+            texture.mResidentSize = GetResidentSize(texture, texture.mResidentMip);
+            mResidentSize += texture.mResidentSize;
+            MemoryService::Get().TrackGPUTexture(static_cast<Sint64>(texture.mResidentSize));
+        }
+
+        SDL_EndGPUCopyPass(copy_pass);
+    }
+
+    // Whatever the requests still miss after this frame is pending, then the requests start over
+    mStats.mPendingUploadCount = 0;
+    mStats.mPendingUploadSize = 0;
+
+    for (TextureID id : mLoadCandidates) {
+        const Texture &texture = mTextures[id];
+        for (Uint32 mip = texture.mRequestedMip; mip < texture.mResidentMip; mip++) {
+            mStats.mPendingUploadCount++;
+            mStats.mPendingUploadSize += GetMipSize(texture, mip);
+        }
+    }
+
+    for (Texture &texture : mTextures) {
+        texture.mRequestedMip = texture.mView.mMipCount;
+    }
+
+    mStats.mTextureCount = texture_count;
+    mStats.mResidentSize = mResidentSize;
+    mStats.mBudget = mSettings.mBudget;
+}
+
+void TextureStreamer::SetBudget(Uint64 inBudget) {
+    mSettings.mBudget = inBudget;
+    mStats.mBudget = inBudget;
+}
+
+void TextureStreamer::LogStats() const {
+    LOG_INFO("Textures: %u textures, %.2f of %.2f MB resident, %u mips pending (%.2f MB), %llu uploaded (%.2f MB), %llu evicted (%.2f MB), %llu frames over budget\n",
+        mStats.mTextureCount,
+        static_cast<double>(mStats.mResidentSize) / (1024.0 * 1024.0),
+        static_cast<double>(mStats.mBudget) / (1024.0 * 1024.0),
+        mStats.mPendingUploadCount,
+        static_cast<double>(mStats.mPendingUploadSize) / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(mStats.mUploadCount),
+        static_cast<double>(mStats.mUploadedSize) / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(mStats.mEvictionCount),
+        static_cast<double>(mStats.mEvictedSize) / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(mStats.mBudgetPressureFrames));
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <EASTL/vector.h>
+
+#include "TextureFile.hpp"
+#include "io/FileService.hpp"
+
+// Index of a texture loaded by TextureStreamer, stays the same while its mips come and go
+using TextureID = Uint32;
+static constexpr TextureID cInvalidTexture = 0xffffffff;
+
+struct TextureStreamingSettings {
+    // GPU memory every texture may take together, including the mips that are always resident
+    Uint64 mBudget = 256ull * 1024 * 1024;
+    // Bytes of mip data uploaded per frame, a single mip larger than this is still uploaded on its own
+    Uint32 mMaxUploadSize = 8 * 1024 * 1024;
+    // Mips up to this size are loaded with the texture and never evicted, so there is always something to sample
+    Uint32 mTailSize = 64;
+    // Frames a mip is kept after the last frame it was needed, so turning the camera doesn't thrash
+    Uint32 mEvictionDelay = 120;
+};
+
+// Resident and pending values are current, the rest are running totals. Sizes are in bytes.
+struct TextureStreamingStats {
+    Uint32 mTextureCount;
+    Uint64 mResidentSize;
+    Uint64 mBudget;
+    // Mips that were requested but aren't resident yet
+    Uint32 mPendingUploadCount;
+    Uint64 mPendingUploadSize;
+    Uint64 mUploadCount;
+    Uint64 mUploadedSize;
+    Uint64 mEvictionCount;
+    Uint64 mEvictedSize;
+    // Frames in which a requested mip didn't fit in the budget, even after evicting every mip nothing asked for
+    Uint64 mBudgetPressureFrames;
+};
+
+// Streams the mips of cooked textures by demand. Every texture keeps its coarsest mips resident, draws request
+// finer mips for the size they cover on screen and Update makes one mip at a time resident per texture, within
+// an upload limit per frame and a memory budget. Mips that no draw asked for in a while are evicted, oldest
+// first, when the budget is full. A texture changes its resident mips by being recreated with the new number of
+// levels and copying the levels it keeps on the GPU, so draws always see a complete mip chain.
+class TextureStreamer {
+private:
+    struct Texture {
+        // Heap allocated, the file has to stay put while the texture list grows. Points into the content pack for
+        // packed textures, which are stored uncompressed so the mips upload straight from the mapping.
+        FileData *mFile;
+        TextureFileView mView;
+        SDL_GPUTexture *mTexture;
+        // Finest resident mip, and the finest mip that is always resident
+        Uint32 mResidentMip;
+        Uint32 mTailMip;
+        // Finest mip requested this frame, the mip count when nothing asked for the texture
+        Uint32 mRequestedMip;
+        // Resident mip once the changes of this frame are done
+        Uint32 mTargetMip;
+        Uint64 mLastNeededFrame;
+        Uint64 mResidentSize;
+    };
+
+    SDL_GPUDevice *mDevice = nullptr;
+    TextureStreamingSettings mSettings;
+    SDL_GPUSampler *mSampler = nullptr;
+    // Devices without block compression get the mips decoded into RGBA8 before they are uploaded
+    bool mIsDecoding = false;
+
+    eastl::vector<Texture> mTextures;
+    eastl::vector<TextureID> mFreeTextures;
+    Uint64 mFrame = 0;
+
+    // Cycled every frame that uploads, so the GPU can still read the last frame's data
+    SDL_GPUTransferBuffer *mTransferBuffer = nullptr;
+    Uint32 mTransferSize = 0;
+
+    // Scratch buffers, kept around to avoid allocating every update
+    eastl::vector<TextureID> mLoadCandidates;
+    eastl::vector<TextureID> mChangedTextures;
+
+    Uint64 mResidentSize = 0;
+    TextureStreamingStats mStats = {};
+
+    SDL_GPUTextureFormat GetGPUFormat(const Texture &inTexture) const;
+    Uint32 GetMipSize(const Texture &inTexture, Uint32 inMip) const;
+    Uint64 GetResidentSize(const Texture &inTexture, Uint32 inMip) const;
+    void WriteMip(const Texture &inTexture, Uint32 inMip, Uint8 *outData) const;
+    bool EnsureTransferSize(Uint32 inSize);
+
+    SDL_GPUTexture *CreateTexture(const Texture &inTexture, Uint32 inMip);
+    void ReleaseTexture(Texture &ioTexture);
+    bool EvictOne(Uint64 &ioPlannedSize);
+
+public:
+    bool Initialize(SDL_GPUDevice *inDevice, const TextureStreamingSettings &inSettings = {});
+    void Shutdown();
+
+    // Map a cooked texture through the FileService and upload its tail mips, the finer mips only come in once they are requested
+    TextureID Load(const char *inPath);
+    void Destroy(TextureID inTexture);
+
+    // Ask for a mip to be resident, it stays requested for the current frame only
+    void RequestMip(TextureID inTexture, Uint32 inMip);
+    // Ask for the mip that matches the number of pixels the texture covers across on screen
+    void RequestScreenSize(TextureID inTexture, float inPixels);
+
+    // Evict and upload mips for the requests of this frame, then clear the requests. Records a copy pass, so it
+    // has to happen outside of any other pass, before the frame's draws.
+    void Update(SDL_GPUCommandBuffer *inCommandBuffer);
+
+    void SetBudget(Uint64 inBudget);
+
+    // The texture with its resident mips, level 0 is GetResidentMip
+    inline SDL_GPUTexture *GetTexture(TextureID inTexture) const {
+        return mTextures[inTexture].mTexture;
+    }
+
+    inline Uint32 GetResidentMip(TextureID inTexture) const {
+        return mTextures[inTexture].mResidentMip;
+    }
+
+    inline const TextureFileView &GetView(TextureID inTexture) const {
+        return mTextures[inTexture].mView;
+    }
+
+    // Trilinear and repeating, shared by every streamed texture
+    inline SDL_GPUSampler *GetSampler() const {
+        return mSampler;
+    }
+
+    inline bool IsDecoding() const {
+        return mIsDecoding;
+    }
+
+    inline const TextureStreamingSettings &GetSettings() const {
+        return mSettings;
+    }
+
+    inline const TextureStreamingStats &GetStats() const {
+        return mStats;
+    }
+
+    // Log residency against the budget and how much streaming is behind
+    void LogStats() const;
+};
@@ -0,0 +1,514 @@
+#include "SoftwareRenderService.hpp"
+
+#include "macros/log.hpp"
+#include "jobs/ParallelFor.hpp"
+
+#include <Jolt/Math/UVec4.h>
+#include <Jolt/Math/Vec4.h>
+
+#include <EASTL/algorithm.h>
+
+#include <cmath>
+
+#include "SoftwareShading.hpp"
+
+// Tiles are square and a multiple of four pixels wide
+static constexpr int cTileSize = 64;
+// Vertices closer than this in clip space w are clipped away
+static constexpr float cNearW = 1.0e-5f;
+
+static Uint32 PackColor(const glm::vec3 &inColor) {
+    glm::vec3 color = glm::clamp(inColor, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return static_cast<Uint32>(color.r) |
+        (static_cast<Uint32>(color.g) << 8) |
+        (static_cast<Uint32>(color.b) << 16) |
+        0xff000000u;
+}
+
+// Top-left edges own the pixels exactly on them, so pixels on a shared edge are drawn once
+static inline JPH::UVec4 EdgeTest(JPH::Vec4Arg inEdge, bool inIsTopLeft) {
+    return inIsTopLeft ? JPH::Vec4::sGreaterOrEqual(inEdge, JPH::Vec4::sZero()) : JPH::Vec4::sGreater(inEdge, JPH::Vec4::sZero());
+}
+
+bool SoftwareRenderService::Initialize(Uint32 inWidth, Uint32 inHeight, JPH::JobSystem *inJobSystem) {
+    if (inWidth == 0 || inHeight == 0) {
+        LOG_ERROR("Unable to create a %ux%u software render target\n", inWidth, inHeight);
+        return false;
+    }
+
+    mJobSystem = inJobSystem;
+    mThreadCount = mJobSystem != nullptr ? static_cast<Uint32>(mJobSystem->GetMaxConcurrency()) : 1;
+
+    SetViewport(inWidth, inHeight);
+    CreatePipelines();
+
+    return true;
+}
+
+void SoftwareRenderService::Shutdown() {
+    mColor.set_capacity(0);
+    mDepth.set_capacity(0);
+    mBins.set_capacity(0);
+    mDraws.set_capacity(0);
+    mPipelines.clear();
+    mMaterials.clear();
+    mInstances.clear();
+    mJobSystem = nullptr;
+}
+
+void SoftwareRenderService::SetViewport(Uint32 inWidth, Uint32 inHeight) {
+    mWidth = inWidth;
+    mHeight = inHeight;
+    mStride = (inWidth + 3) & ~3u;
+
+    mTileCountX = (inWidth + cTileSize - 1) / cTileSize;
+    mTileCountY = (inHeight + cTileSize - 1) / cTileSize;
+
+    mColor.resize(mStride * mHeight);
+    mDepth.resize(mStride * mHeight);
+}
+
+void SoftwareRenderService::SetThreadCount(Uint32 inThreadCount) {
+    mThreadCount = inThreadCount > 0 ? inThreadCount : 1;
+}
+
+void SoftwareRenderService::CreatePipelines() {
+    mPipelines["default_mesh"] = SoftwareShadingModel::Lit;
+    mPipelines["light_source"] = SoftwareShadingModel::Unlit;
+}
+
+void SoftwareRenderService::UsePipeline(const eastl::string &inName, ShaderKey inKey) {
+    auto it = mPipelines.find(inName);
+    if (it == mPipelines.end()) {
+        LOG_ERROR("Software pipeline not found: %s\n", inName.c_str());
+        return;
+    }
+
+    mPipeline = { it->second, inKey };
+}
+
+SoftwareMesh *SoftwareRenderService::CreateMesh(
+    void *inVertexData, Uint32 inVertexSize, Uint32 inVertexCount,
+    void *inIndexData, Uint32 inIndexSize, Uint32 inIndexCount
+) const {
+    if (inVertexSize != sizeof(PositionNormalTextureVertex) * inVertexCount || inIndexSize != sizeof(Uint16) * inIndexCount) {
+        LOG_ERROR("Software meshes only take PositionNormalTextureVertex vertices and 16-bit indices\n");
+        return nullptr;
+    }
+
+    SoftwareMesh *mesh = new SoftwareMesh();
+
+    const PositionNormalTextureVertex *vertices = static_cast<const PositionNormalTextureVertex *>(inVertexData);
+    mesh->mVertices.assign(vertices, vertices + inVertexCount);
+
+    const Uint16 *indices = static_cast<const Uint16 *>(inIndexData);
+    mesh->mIndices.assign(indices, indices + inIndexCount);
+
+    return mesh;
+}
+
+void SoftwareRenderService::DestroyMesh(SoftwareMesh *inMesh) const {
+    delete inMesh;
+}
+
+void SoftwareRenderService::DrawMesh(const SoftwareMesh *inMesh, const DrawIndices &inIndices) {
+    Uint32 index_count = inMesh->mIndices.empty() ?
+        static_cast<Uint32>(inMesh->mVertices.size()) :
+        static_cast<Uint32>(inMesh->mIndices.size());
+
+    mDraws.push_back({ inMesh, mPipeline, inIndices, mTriangleCount });
+    mTriangleCount += index_count / 3;
+}
+
+Uint32 SoftwareRenderService::CreateMaterial(const Material &inMaterial) {
+    mMaterials.push_back(inMaterial);
+    return static_cast<Uint32>(mMaterials.size() - 1);
+}
+
+void SoftwareRenderService::ClearMaterials() {
+    mMaterials.clear();
+}
+
+void SoftwareRenderService::SetInstances(const InstanceData *inInstances, Uint32 inCount) {
+    mInstances.assign(inInstances, inInstances + inCount);
+}
+
+void SoftwareRenderService::SetViewConstants(const ViewConstants &inViewConstants) {
+    mViewConstants = inViewConstants;
+    mViewProjection = inViewConstants.projection * inViewConstants.view;
+}
+
+void SoftwareRenderService::SetSceneConstants(const SceneConstants &inSceneConstants) {
+    mSceneConstants = inSceneConstants;
+}
+
+void SoftwareRenderService::BeginPass() {
+    mDraws.clear();
+    mTriangleCount = 0;
+
+    // Same clear values as the GPU pass
+    eastl::fill(mColor.begin(), mColor.end(), PackColor(glm::vec3(0.1f)));
+    eastl::fill(mDepth.begin(), mDepth.end(), 1.0f);
+}
+
+void SoftwareRenderService::EndPass() {
+    Uint64 start_time = SDL_GetTicksNS();
+
+    Uint32 tile_count = mTileCountX * mTileCountY;
+    Uint32 job_count = eastl::max(eastl::min(mThreadCount, mTriangleCount), 1u);
+
+    // Bins are kept between passes so their vectors don't reallocate every frame
+    mBins.resize(eastl::max(static_cast<Uint32>(mBins.size()), job_count));
+    for (Bin &bin : mBins) {
+        bin.mTriangles.clear();
+        bin.mTiles.resize(tile_count);
+        for (eastl::vector<Uint32> &tile : bin.mTiles) {
+            tile.clear();
+        }
+    }
+
+    // Every geometry job takes a contiguous range of triangles, so reading the bins in order keeps the draw order
+    Uint32 triangles_per_job = (mTriangleCount + job_count - 1) / job_count;
+    ParallelFor(mJobSystem, "SoftwareGeometry", job_count, [this, triangles_per_job](size_t inBin) {
+        Uint32 bin = static_cast<Uint32>(inBin);
+        Uint32 begin = bin * triangles_per_job;
+        Uint32 end = eastl::min(begin + triangles_per_job, mTriangleCount);
+        ProcessTriangles(bin, begin, end);
+    });
+
+    Uint64 geometry_end_time = SDL_GetTicksNS();
+
+    // Tiles are handed out one at a time, so threads that get cheap tiles pick up more of them
+    ParallelFor(mJobSystem, "SoftwareRaster", tile_count, [this](size_t inTile) {
+        RasterizeTile(static_cast<Uint32>(inTile));
+    }, mThreadCount);
+
+    Uint64 end_time = SDL_GetTicksNS();
+
+    Uint64 rasterized_count = 0;
+    for (const Bin &bin : mBins) {
+        rasterized_count += bin.mTriangles.size();
+    }
+
+    mStats = {
+        mThreadCount,
+        mTriangleCount,
+        rasterized_count,
+        geometry_end_time - start_time,
+        end_time - geometry_end_time,
+        end_time - start_time
+    };
+}
+
+void SoftwareRenderService::ProcessTriangles(Uint32 inBin, Uint32 inBegin, Uint32 inEnd) {
+    if (inBegin >= inEnd) {
+        return;
+    }
+
+    Bin &bin = mBins[inBin];
+
+    // Find the draw that holds the first triangle of the range
+    auto it = eastl::upper_bound(mDraws.begin(), mDraws.end(), inBegin, [](Uint32 inTriangle, const Draw &inDraw) {
+        return inTriangle < inDraw.mFirstTriangle;
+    });
+    Uint32 draw_index = static_cast<Uint32>(it - mDraws.begin()) - 1;
+    Uint32 next_draw_start = draw_index + 1 < mDraws.size() ? mDraws[draw_index + 1].mFirstTriangle : inEnd;
+    glm::mat3 normal_matrix = glm::mat3(mInstances[mDraws[draw_index].mIndices.instance_index].model_inverse_transpose);
+
+    for (Uint32 triangle = inBegin; triangle < inEnd; triangle++) {
+        while (triangle >= next_draw_start) {
+            draw_index++;
+            next_draw_start = draw_index + 1 < mDraws.size() ? mDraws[draw_index + 1].mFirstTriangle : inEnd;
+            normal_matrix = glm::mat3(mInstances[mDraws[draw_index].mIndices.instance_index].model_inverse_transpose);
+        }
+
+        const Draw &draw = mDraws[draw_index];
+        const SoftwareMesh &mesh = *draw.mMesh;
+        const InstanceData &instance = mInstances[draw.mIndices.instance_index];
+        Uint32 first_index = (triangle - draw.mFirstTriangle) * 3;
+
+        // Same math as the vertex shaders
+        glm::vec4 clip[3];
+        glm::vec3 position[3];
+        glm::vec3 normal[3];
+        for (Uint32 k = 0; k < 3; k++) {
+            Uint32 index = mesh.mIndices.empty() ? first_index + k : mesh.mIndices[first_index + k];
+            const PositionNormalTextureVertex &vertex = mesh.mVertices[index];
+
+            position[k] = glm::vec3(instance.model * glm::vec4(vertex.mPosition, 1.0f));
+            clip[k] = mViewProjection * glm::vec4(position[k], 1.0f);
+            normal[k] = normal_matrix * vertex.mNormal;
+        }
+
+        // The frustum planes are linear in clip space, so a triangle with every vertex behind the same plane is out
+        auto is_outside = [&clip](auto inIsBehind) {
+            return inIsBehind(clip[0]) && inIsBehind(clip[1]) && inIsBehind(clip[2]);
+        };
+
+        if (is_outside([](const glm::vec4 &inV) { return inV.x > inV.w; }) ||
+            is_outside([](const glm::vec4 &inV) { return inV.x < -inV.w; }) ||
+            is_outside([](const glm::vec4 &inV) { return inV.y > inV.w; }) ||
+            is_outside([](const glm::vec4 &inV) { return inV.y < -inV.w; }) ||
+            is_outside([](const glm::vec4 &inV) { return inV.w < cNearW; })) {
+            continue;
+        }
+
+        if (clip[0].w >= cNearW && clip[1].w >= cNearW && clip[2].w >= cNearW) {
+            SetupTriangle(bin, draw_index, clip, position, normal);
+            continue;
+        }
+
+        // Clip against the near plane, which leaves a polygon of up to four vertices
+        glm::vec4 clipped_clip[4];
+        glm::vec3 clipped_position[4];
+        glm::vec3 clipped_normal[4];
+        Uint32 clipped_count = 0;
+
+        for (Uint32 a = 0; a < 3; a++) {
+            Uint32 b = (a + 1) % 3;
+            bool is_a_inside = clip[a].w >= cNearW;
+            bool is_b_inside = clip[b].w >= cNearW;
+
+            if (is_a_inside) {
+                clipped_clip[clipped_count] = clip[a];
+                clipped_position[clipped_count] = position[a];
+                clipped_normal[clipped_count] = normal[a];
+                clipped_count++;
+            }
+
+            if (is_a_inside != is_b_inside) {
+                float t = (cNearW - clip[a].w) / (clip[b].w - clip[a].w);
+                clipped_clip[clipped_count] = glm::mix(clip[a], clip[b], t);
+                clipped_position[clipped_count] = glm::mix(position[a], position[b], t);
+                clipped_normal[clipped_count] = glm::mix(normal[a], normal[b], t);
+                clipped_count++;
+            }
+        }
+
+        for (Uint32 i = 1; i + 1 < clipped_count; i++) {
+            glm::vec4 fan_clip[3] = { clipped_clip[0], clipped_clip[i], clipped_clip[i + 1] };
+            glm::vec3 fan_position[3] = { clipped_position[0], clipped_position[i], clipped_position[i + 1] };
+            glm::vec3 fan_normal[3] = { clipped_normal[0], clipped_normal[i], clipped_normal[i + 1] };
+            SetupTriangle(bin, draw_index, fan_clip, fan_position, fan_normal);
+        }
+    }
+}
+
+void SoftwareRenderService::SetupTriangle(
+    Bin &ioBin,
+    Uint32 inDraw,
+    const glm::vec4 *inClip,
+    const glm::vec3 *inPosition,
+    const glm::vec3 *inNormal
+) {
+    float screen_x[3];
+    float screen_y[3];
+    float inv_w[3];
+    for (Uint32 k = 0; k < 3; k++) {
+        inv_w[k] = 1.0f / inClip[k].w;
+        screen_x[k] = (inClip[k].x * inv_w[k] * 0.5f + 0.5f) * static_cast<float>(mWidth);
+        screen_y[k] = (0.5f - inClip[k].y * inv_w[k] * 0.5f) * static_cast<float>(mHeight);
+    }
+
+    // Twice the signed area, the vertex order is flipped for negative areas since nothing is culled
+    float area = (screen_y[0] - screen_y[1]) * screen_x[2] + (screen_x[1] - screen_x[0]) * screen_y[2] +
+        (screen_x[0] * screen_y[1] - screen_y[0] * screen_x[1]);
+    if (std::fabs(area) < 1.0e-8f) {
+        return;
+    }
+
+    Uint32 order[3] = { 0, 1, 2 };
+    if (area < 0.0f) {
+        order[1] = 2;
+        order[2] = 1;
+        area = -area;
+    }
+
+    float min_x = eastl::min(screen_x[0], eastl::min(screen_x[1], screen_x[2]));
+    float max_x = eastl::max(screen_x[0], eastl::max(screen_x[1], screen_x[2]));
+    float min_y = eastl::min(screen_y[0], eastl::min(screen_y[1], screen_y[2]));
+    float max_y = eastl::max(screen_y[0], eastl::max(screen_y[1], screen_y[2]));
+
+    int bounds_min_x = eastl::max(static_cast<int>(std::floor(min_x)), 0);
+    int bounds_max_x = eastl::min(static_cast<int>(std::ceil(max_x)), static_cast<int>(mWidth) - 1);
+    int bounds_min_y = eastl::max(static_cast<int>(std::floor(min_y)), 0);
+    int bounds_max_y = eastl::min(static_cast<int>(std::ceil(max_y)), static_cast<int>(mHeight) - 1);
+    if (bounds_min_x > bounds_max_x || bounds_min_y > bounds_max_y) {
+        return;
+    }
+
+    Triangle &triangle = ioBin.mTriangles.push_back();
+    float inv_area = 1.0f / area;
+
+    // Edge k is the one opposite vertex k, so it evaluates to the barycentric coordinate of that vertex
+    for (Uint32 k = 0; k < 3; k++) {
+        Uint32 a = order[(k + 1) % 3];
+        Uint32 b = order[(k + 2) % 3];
+
+        float edge_a = screen_y[a] - screen_y[b];
+        float edge_b = screen_x[b] - screen_x[a];
+        float edge_c = screen_x[a] * screen_y[b] - screen_y[a] * screen_x[b];
+
+        triangle.mEdgeA[k] = edge_a * inv_area;
+        triangle.mEdgeB[k] = edge_b * inv_area;
+        triangle.mEdgeC[k] = edge_c * inv_area;
+        triangle.mIsTopLeft[k] = edge_a > 0.0f || (edge_a == 0.0f && edge_b > 0.0f);
+
+        Uint32 vertex = order[k];
+        triangle.mDepth[k] = inClip[vertex].z * inv_w[vertex];
+        triangle.mInvW[k] = inv_w[vertex];
+        triangle.mPosition[k] = inPosition[vertex] * inv_w[vertex];
+        triangle.mNormal[k] = inNormal[vertex] * inv_w[vertex];
+    }
+
+    triangle.mMinX = bounds_min_x;
+    triangle.mMinY = bounds_min_y;
+    triangle.mMaxX = bounds_max_x;
+    triangle.mMaxY = bounds_max_y;
+    triangle.mDraw = inDraw;
+
+    Uint32 triangle_index = static_cast<Uint32>(ioBin.mTriangles.size() - 1);
+    for (int tile_y = bounds_min_y / cTileSize; tile_y <= bounds_max_y / cTileSize; tile_y++) {
+        for (int tile_x = bounds_min_x / cTileSize; tile_x <= bounds_max_x / cTileSize; tile_x++) {
+            ioBin.mTiles[tile_y * mTileCountX + tile_x].push_back(triangle_index);
+        }
+    }
+}
+
+void SoftwareRenderService::RasterizeTile(Uint32 inTile) {
+    int tile_min_x = static_cast<int>(inTile % mTileCountX) * cTileSize;
+    int tile_min_y = static_cast<int>(inTile / mTileCountX) * cTileSize;
+    int tile_max_x = eastl::min(tile_min_x + cTileSize, static_cast<int>(mWidth)) - 1;
+    int tile_max_y = eastl::min(tile_min_y + cTileSize, static_cast<int>(mHeight)) - 1;
+
+    for (const Bin &bin : mBins) {
+        for (Uint32 index : bin.mTiles[inTile]) {
+            const Triangle &triangle = bin.mTriangles[index];
+            RasterizeTriangle(
+                triangle,
+                eastl::max(triangle.mMinX, tile_min_x),
+                eastl::max(triangle.mMinY, tile_min_y),
+                eastl::min(triangle.mMaxX, tile_max_x),
+                eastl::min(triangle.mMaxY, tile_max_y)
+            );
+        }
+    }
+}
+
+void SoftwareRenderService::RasterizeTriangle(const Triangle &inTriangle, int inMinX, int inMinY, int inMaxX, int inMaxY) {
+    using JPH::UVec4;
+    using JPH::Vec4;
+
+    if (inMinX > inMaxX || inMinY > inMaxY) {
+        return;
+    }
+
+    const Draw &draw = mDraws[inTriangle.mDraw];
+    bool is_lit = draw.mPipeline.mShadingModel == SoftwareShadingModel::Lit;
+    const Material *material = draw.mIndices.material_index < mMaterials.size() ? &mMaterials[draw.mIndices.material_index] : nullptr;
+    if (is_lit && material == nullptr) {
+        return;
+    }
+
+    // Groups of four pixels start on a multiple of four, which tiles do as well, so groups never cross tiles
+    int group_min_x = inMinX & ~3;
+
+    const Vec4 lane_offsets(0.5f, 1.5f, 2.5f, 3.5f);
+    const Vec4 end_x = Vec4::sReplicate(static_cast<float>(inMaxX + 1));
+
+    Vec4 edge_a[3];
+    for (Uint32 k = 0; k < 3; k++) {
+        edge_a[k] = Vec4::sReplicate(inTriangle.mEdgeA[k]);
+    }
+
+    const Vec4 depth0 = Vec4::sReplicate(inTriangle.mDepth[0]);
+    const Vec4 depth1 = Vec4::sReplicate(inTriangle.mDepth[1]);
+    const Vec4 depth2 = Vec4::sReplicate(inTriangle.mDepth[2]);
+
+    for (int y = inMinY; y <= inMaxY; y++) {
+        float pixel_y = static_cast<float>(y) + 0.5f;
+        float *depth_row = &mDepth[y * mStride];
+        Uint32 *color_row = &mColor[y * mStride];
+
+        Vec4 edge_row[3];
+        for (Uint32 k = 0; k < 3; k++) {
+            edge_row[k] = Vec4::sReplicate(inTriangle.mEdgeB[k] * pixel_y + inTriangle.mEdgeC[k]);
+        }
+
+        for (int x = group_min_x; x <= inMaxX; x += 4) {
+            Vec4 pixel_x = Vec4::sReplicate(static_cast<float>(x)) + lane_offsets;
+
+            Vec4 b0 = edge_a[0] * pixel_x + edge_row[0];
+            Vec4 b1 = edge_a[1] * pixel_x + edge_row[1];
+            Vec4 b2 = edge_a[2] * pixel_x + edge_row[2];
+
+            UVec4 inside = UVec4::sAnd(
+                UVec4::sAnd(EdgeTest(b0, inTriangle.mIsTopLeft[0]), EdgeTest(b1, inTriangle.mIsTopLeft[1])),
+                UVec4::sAnd(EdgeTest(b2, inTriangle.mIsTopLeft[2]), Vec4::sLess(pixel_x, end_x))
+            );
+
+            if (!inside.TestAnyTrue()) {
+                continue;
+            }
+
+            // Depth is linear in screen space, so it interpolates without the perspective divide
+            Vec4 depth = b0 * depth0 + b1 * depth1 + b2 * depth2;
+            Vec4 stored_depth = Vec4::sLoadFloat4(reinterpret_cast<const JPH::Float4 *>(depth_row + x));
+            UVec4 passed = UVec4::sAnd(inside, Vec4::sLess(depth, stored_depth));
+
+            int passed_mask = passed.GetTrues();
+            if (passed_mask == 0) {
+                continue;
+            }
+
+            Vec4::sSelect(stored_depth, depth, passed).StoreFloat4(reinterpret_cast<JPH::Float4 *>(depth_row + x));
+
+            for (Uint32 lane = 0; lane < 4; lane++) {
+                if ((passed_mask & (1 << lane)) == 0) {
+                    continue;
+                }
+
+                glm::vec3 color;
+                if (is_lit) {
+                    float w0 = b0[lane];
+                    float w1 = b1[lane];
+                    float w2 = b2[lane];
+
+                    // Perspective correct interpolation of the attributes that were divided by w
+                    float w = 1.0f / (w0 * inTriangle.mInvW[0] + w1 * inTriangle.mInvW[1] + w2 * inTriangle.mInvW[2]);
+                    glm::vec3 position = (inTriangle.mPosition[0] * w0 + inTriangle.mPosition[1] * w1 + inTriangle.mPosition[2] * w2) * w;
+                    glm::vec3 normal = (inTriangle.mNormal[0] * w0 + inTriangle.mNormal[1] * w1 + inTriangle.mNormal[2] * w2) * w;
+
+                    color = ShadeLit(draw.mPipeline.mKey, mSceneConstants, *material, position, normal);
+                } else {
+                    color = ShadeUnlit();
+                }
+
+                color_row[x + lane] = PackColor(color);
+            }
+        }
+    }
+}
+
+bool SoftwareRenderService::SaveImage(const char *inPath) const {
+    SDL_Surface *surface = SDL_CreateSurfaceFrom(
+        static_cast<int>(mWidth),
+        static_cast<int>(mHeight),
+        SDL_PIXELFORMAT_RGBA32,
+        const_cast<Uint32 *>(mColor.data()),
+        static_cast<int>(mStride * sizeof(Uint32))
+    );
+
+    if (surface == nullptr) {
+        LOG_ERROR("Unable to create surface for software image: %s\n", SDL_GetError());
+        return false;
+    }
+
+    bool is_saved = SDL_SaveBMP(surface, inPath);
+    if (!is_saved) {
+        LOG_ERROR("Unable to save software image %s: %s\n", inPath, SDL_GetError());
+    }
+
+    SDL_DestroySurface(surface);
+    return is_saved;
+}
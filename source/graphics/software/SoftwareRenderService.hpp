@@ -0,0 +1,180 @@
+#pragma once
+
+#include "macros/singleton.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+
+#include <EASTL/string.h>
+#include <EASTL/unordered_map.h>
+#include <EASTL/vector.h>
+
+#include <glm/glm.hpp>
+
+#include "graphics/ShaderKey.hpp"
+#include "graphics/uniforms/DrawIndices.hpp"
+#include "graphics/uniforms/InstanceData.hpp"
+#include "graphics/uniforms/Material.hpp"
+#include "graphics/uniforms/SceneConstants.hpp"
+#include "graphics/uniforms/ViewConstants.hpp"
+#include "graphics/vertices/PositionNormalTextureVertex.hpp"
+
+struct SoftwareMesh {
+    eastl::vector<PositionNormalTextureVertex> mVertices;
+    eastl::vector<Uint16> mIndices;
+};
+
+// The shaders the software backend has C++ ports of
+enum class SoftwareShadingModel : Uint8 {
+    Lit,
+    Unlit,
+};
+
+// Timings of the last pass, in nanoseconds
+struct SoftwareRenderStats {
+    Uint32 mThreadCount;
+    Uint64 mTriangleCount;
+    // Triangles left after clipping and culling zero-area ones
+    Uint64 mRasterizedTriangleCount;
+    Uint64 mGeometryTime;
+    Uint64 mRasterTime;
+    Uint64 mFrameTime;
+};
+
+// Renders on the CPU for machines without a GPU. It mirrors the RenderService surface: meshes, pipelines selected by
+// name and shader key, an instance and material table and draws recorded between BeginPass and EndPass.
+// Draws are transformed and binned into screen tiles by one set of jobs, then every tile is depth tested and shaded
+// by another, four pixels at a time.
+class SoftwareRenderService {
+MAKE_SINGLETON(SoftwareRenderService)
+private:
+    struct Pipeline {
+        SoftwareShadingModel mShadingModel;
+        ShaderKey mKey;
+    };
+
+    struct Draw {
+        const SoftwareMesh *mMesh;
+        Pipeline mPipeline;
+        DrawIndices mIndices;
+        // Index of the draw's first triangle among all triangles of the pass
+        Uint32 mFirstTriangle;
+    };
+
+    // A triangle ready for rasterization. The edge functions are scaled by the inverse area, so they evaluate to
+    // the barycentric coordinates. Vertex attributes are divided by w for perspective correct interpolation.
+    struct Triangle {
+        float mEdgeA[3];
+        float mEdgeB[3];
+        float mEdgeC[3];
+        bool mIsTopLeft[3];
+
+        float mDepth[3];
+        float mInvW[3];
+        glm::vec3 mPosition[3];
+        glm::vec3 mNormal[3];
+
+        int mMinX;
+        int mMinY;
+        int mMaxX;
+        int mMaxY;
+        Uint32 mDraw;
+    };
+
+    // Output of one geometry job, its triangles and the triangles that touch each tile
+    struct Bin {
+        eastl::vector<Triangle> mTriangles;
+        eastl::vector<eastl::vector<Uint32>> mTiles;
+    };
+
+    JPH::JobSystem *mJobSystem = nullptr;
+    Uint32 mThreadCount = 1;
+
+    Uint32 mWidth = 0;
+    Uint32 mHeight = 0;
+    // Rows are padded to a multiple of four pixels, so four-wide groups never straddle two tiles
+    Uint32 mStride = 0;
+    Uint32 mTileCountX = 0;
+    Uint32 mTileCountY = 0;
+    eastl::vector<Uint32> mColor;
+    eastl::vector<float> mDepth;
+
+    eastl::unordered_map<eastl::string, SoftwareShadingModel> mPipelines;
+    Pipeline mPipeline = {};
+
+    eastl::vector<Material> mMaterials;
+    eastl::vector<InstanceData> mInstances;
+    ViewConstants mViewConstants = {};
+    SceneConstants mSceneConstants = {};
+    glm::mat4 mViewProjection = glm::mat4(1.0f);
+
+    eastl::vector<Draw> mDraws;
+    Uint32 mTriangleCount = 0;
+    eastl::vector<Bin> mBins;
+
+    SoftwareRenderStats mStats = {};
+
+    void ProcessTriangles(Uint32 inBin, Uint32 inBegin, Uint32 inEnd);
+    void SetupTriangle(Bin &ioBin, Uint32 inDraw, const glm::vec4 *inClip, const glm::vec3 *inPosition, const glm::vec3 *inNormal);
+    void RasterizeTile(Uint32 inTile);
+    void RasterizeTriangle(const Triangle &inTriangle, int inMinX, int inMinY, int inMaxX, int inMaxY);
+
+public:
+    bool Initialize(Uint32 inWidth, Uint32 inHeight, JPH::JobSystem *inJobSystem);
+    void Shutdown();
+
+    void SetViewport(Uint32 inWidth, Uint32 inHeight);
+    // Number of jobs each stage is split into, one runs everything on the calling thread
+    void SetThreadCount(Uint32 inThreadCount);
+
+    // Register the pipelines RenderService creates, backed by the C++ shader ports
+    void CreatePipelines();
+    void UsePipeline(const eastl::string &inName, ShaderKey inKey = 0);
+
+    SoftwareMesh *CreateMesh(
+        void *inVertexData, Uint32 inVertexSize, Uint32 inVertexCount,
+        void *inIndexData, Uint32 inIndexSize, Uint32 inIndexCount
+    ) const;
+    void DestroyMesh(SoftwareMesh *inMesh) const;
+    // The indices take the place of the uniforms pushed for each GPU draw
+    void DrawMesh(const SoftwareMesh *inMesh, const DrawIndices &inIndices);
+
+    Uint32 CreateMaterial(const Material &inMaterial);
+    void ClearMaterials();
+    void SetInstances(const InstanceData *inInstances, Uint32 inCount);
+    void SetViewConstants(const ViewConstants &inViewConstants);
+    void SetSceneConstants(const SceneConstants &inSceneConstants);
+
+    void BeginPass();
+    void EndPass();
+
+    // Write the image as a BMP file
+    bool SaveImage(const char *inPath) const;
+
+    // RGBA8 pixels, GetStride pixels per row
+    inline const Uint32 *GetPixels() const {
+        return mColor.data();
+    }
+
+    inline Uint32 GetWidth() const {
+        return mWidth;
+    }
+
+    inline Uint32 GetHeight() const {
+        return mHeight;
+    }
+
+    inline Uint32 GetStride() const {
+        return mStride;
+    }
+
+    inline Uint32 GetThreadCount() const {
+        return mThreadCount;
+    }
+
+    inline const SoftwareRenderStats &GetStats() const {
+        return mStats;
+    }
+};
@@ -0,0 +1,82 @@
+#include "SoftwareShading.hpp"
+
+#include <cmath>
+
+static glm::vec3 CalcDirectionalLight(
+    const DirectionalLight &inLight,
+    const Material &inMaterial,
+    bool inIsLambert,
+    const glm::vec3 &inNormal,
+    const glm::vec3 &inViewDir
+) {
+    glm::vec3 light_dir = glm::normalize(-glm::vec3(inLight.direction));
+    // diffuse shading
+    float diff = glm::max(glm::dot(inNormal, light_dir), 0.0f);
+    // combine results
+    glm::vec3 ambient = glm::vec3(inLight.ambient) * glm::vec3(inMaterial.diffuse);
+    glm::vec3 diffuse = glm::vec3(inLight.diffuse) * diff * glm::vec3(inMaterial.diffuse);
+    if (inIsLambert) {
+        return ambient + diffuse;
+    }
+
+    // specular shading
+    glm::vec3 halfway_dir = glm::normalize(light_dir + inViewDir);
+    float spec = std::pow(glm::max(glm::dot(inNormal, halfway_dir), 0.0f), inMaterial.shininess.x);
+    glm::vec3 specular = glm::vec3(inLight.specular) * spec * glm::vec3(inMaterial.specular);
+
+    return ambient + diffuse + specular;
+}
+
+static glm::vec3 CalcPointLight(
+    const PointLight &inLight,
+    const Material &inMaterial,
+    bool inIsLambert,
+    const glm::vec3 &inNormal,
+    const glm::vec3 &inFragPos,
+    const glm::vec3 &inViewDir
+) {
+    glm::vec3 light_dir = glm::normalize(glm::vec3(inLight.position) - inFragPos);
+    // diffuse shading
+    float diff = glm::max(glm::dot(inNormal, light_dir), 0.0f);
+    // attenuation
+    float distance = glm::length(glm::vec3(inLight.position) - inFragPos);
+    float attenuation = 1.0f / (inLight.constant + inLight.linear * distance + inLight.quadratic * (distance * distance));
+    // combine results
+    glm::vec3 ambient = glm::vec3(inLight.ambient) * glm::vec3(inMaterial.diffuse);
+    glm::vec3 diffuse = glm::vec3(inLight.diffuse) * diff * glm::vec3(inMaterial.diffuse);
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    if (inIsLambert) {
+        return ambient + diffuse;
+    }
+
+    // specular shading
+    glm::vec3 halfway_dir = glm::normalize(light_dir + inViewDir);
+    float spec = std::pow(glm::max(glm::dot(inNormal, halfway_dir), 0.0f), inMaterial.shininess.x);
+    glm::vec3 specular = glm::vec3(inLight.specular) * spec * glm::vec3(inMaterial.specular);
+    specular *= attenuation;
+
+    return ambient + diffuse + specular;
+}
+
+glm::vec3 ShadeLit(
+    ShaderKey inKey,
+    const SceneConstants &inScene,
+    const Material &inMaterial,
+    const glm::vec3 &inFragPos,
+    const glm::vec3 &inNormal
+) {
+    Uint32 point_light_count = (inKey >> cShaderKeyPointLightCountShift) & cShaderKeyPointLightCountMask;
+    bool is_lambert = (inKey & cShaderKeyLambert) != 0;
+
+    glm::vec3 norm = glm::normalize(inNormal);
+    glm::vec3 view_dir = glm::normalize(glm::vec3(inScene.camera_position) - inFragPos);
+
+    glm::vec3 result = CalcDirectionalLight(inScene.directional_light, inMaterial, is_lambert, norm, view_dir);
+
+    for (Uint32 i = 0; i < point_light_count; i++) {
+        result += CalcPointLight(inScene.point_light[i], inMaterial, is_lambert, norm, inFragPos, view_dir);
+    }
+
+    return result;
+}
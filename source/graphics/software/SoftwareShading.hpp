@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "graphics/ShaderKey.hpp"
+#include "graphics/uniforms/Material.hpp"
+#include "graphics/uniforms/SceneConstants.hpp"
+
+// C++ ports of the fragment shaders, these have to stay in sync with the GLSL in shaders/
+
+// basic_triangle.frag, the variant is selected by the key just like the compiled permutations. Software meshes have
+// no textures, so the albedo texture bit is ignored and the material color is used as is.
+glm::vec3 ShadeLit(
+    ShaderKey inKey,
+    const SceneConstants &inScene,
+    const Material &inMaterial,
+    const glm::vec3 &inFragPos,
+    const glm::vec3 &inNormal
+);
+
+// light_source.frag
+inline glm::vec3 ShadeUnlit() {
+    return glm::vec3(1.0f, 1.0f, 1.0f);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// The only data pushed for every draw, everything else is looked up in storage buffers
+struct DrawIndices {
+    Uint32 instance_index;
+    Uint32 material_index;
+    Uint32 _padding1;
+    Uint32 _padding2;
+};
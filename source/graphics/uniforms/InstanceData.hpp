@@ -0,0 +1,9 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// One entry of the instance storage buffer read by the vertex shaders
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat4 model_inverse_transpose;
+};
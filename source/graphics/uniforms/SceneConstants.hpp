@@ -0,0 +1,12 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "DirectionalLight.hpp"
+#include "PointLight.hpp"
+
+struct SceneConstants {
+    glm::vec4 camera_position;
+    DirectionalLight directional_light;
+    PointLight point_light[4];
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct ViewConstants {
+    glm::mat4 projection;
+    glm::mat4 view;
+};
@@ -0,0 +1,96 @@
+#include "ContentIOSystem.hpp"
+
+#include "FileService.hpp"
+
+// A read-only stream over a whole file in memory
+class ContentIOStream : public Assimp::IOStream {
+private:
+    FileData mFile;
+    size_t mPosition = 0;
+
+public:
+    // The file is read straight into the stream
+    inline FileData &GetFile() {
+        return mFile;
+    }
+
+    size_t Read(void *outBuffer, size_t inSize, size_t inCount) override {
+        if (inSize == 0) {
+            return 0;
+        }
+
+        // Only whole elements are read, like fread
+        size_t count = SDL_min(inCount, (mFile.GetSize() - mPosition) / inSize);
+        SDL_memcpy(outBuffer, mFile.GetData() + mPosition, count * inSize);
+        mPosition += count * inSize;
+
+        return count;
+    }
+
+    size_t Write(const void *, size_t, size_t) override {
+        return 0;
+    }
+
+    aiReturn Seek(size_t inOffset, aiOrigin inOrigin) override {
+        size_t position;
+        switch (inOrigin) {
+            case aiOrigin_SET:
+                position = inOffset;
+                break;
+            case aiOrigin_CUR:
+                position = mPosition + inOffset;
+                break;
+            case aiOrigin_END:
+                position = mFile.GetSize() - inOffset;
+                break;
+            default:
+                return aiReturn_FAILURE;
+        }
+
+        if (position > mFile.GetSize()) {
+            return aiReturn_FAILURE;
+        }
+
+        mPosition = position;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override {
+        return mPosition;
+    }
+
+    size_t FileSize() const override {
+        return mFile.GetSize();
+    }
+
+    void Flush() override {
+    }
+};
+
+bool ContentIOSystem::Exists(const char *inPath) const {
+    return FileService::Get().Exists(inPath);
+}
+
+char ContentIOSystem::getOsSeparator() const {
+    // Pack paths always use slashes, and every platform accepts them for loose files
+    return '/';
+}
+
+Assimp::IOStream *ContentIOSystem::Open(const char *inPath, const char *inMode) {
+    // Content is read-only
+    if (SDL_strchr(inMode, 'w') != nullptr || SDL_strchr(inMode, 'a') != nullptr || SDL_strchr(inMode, '+') != nullptr) {
+        return nullptr;
+    }
+
+    ContentIOStream *stream = new ContentIOStream();
+    if (!FileService::Get().ReadFile(inPath, stream->GetFile())) {
+        delete stream;
+        return nullptr;
+    }
+
+    return stream;
+}
+
+void ContentIOSystem::Close(Assimp::IOStream *inStream) {
+    delete inStream;
+}
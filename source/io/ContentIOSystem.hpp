@@ -0,0 +1,15 @@
+#pragma once
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+// Lets Assimp read through the FileService, so models and the buffers next to them come from the content pack
+// without being copied when they are stored uncompressed
+class ContentIOSystem : public Assimp::IOSystem {
+public:
+    bool Exists(const char *inPath) const override;
+    char getOsSeparator() const override;
+
+    Assimp::IOStream *Open(const char *inPath, const char *inMode = "rb") override;
+    void Close(Assimp::IOStream *inStream) override;
+};
@@ -0,0 +1,264 @@
+#include "ContentPack.hpp"
+
+#include "macros/log.hpp"
+
+static inline const char *SkipCurrentDirectory(const char *inPath) {
+    while (inPath[0] == '.' && (inPath[1] == '/' || inPath[1] == '\\')) {
+        inPath += 2;
+    }
+
+    return inPath;
+}
+
+static inline char NormalizePathChar(char inChar) {
+    return inChar == '\\' ? '/' : inChar;
+}
+
+Uint64 HashContentPackPath(const char *inPath) {
+    Uint64 hash = 0xcbf29ce484222325ull;
+    for (const char *c = SkipCurrentDirectory(inPath); *c != '\0'; c++) {
+        hash ^= static_cast<Uint8>(NormalizePathChar(*c));
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+// Paths in the pack are already normalized, only the one being looked up needs it
+static bool IsSamePath(const char *inPackPath, const char *inPath) {
+    inPath = SkipCurrentDirectory(inPath);
+    while (*inPackPath != '\0' && *inPackPath == NormalizePathChar(*inPath)) {
+        inPackPath++;
+        inPath++;
+    }
+
+    return *inPackPath == '\0' && *inPath == '\0';
+}
+
+bool ContentPack::Open(const char *inPath) {
+    Close();
+
+    // Entries are read wherever they are, not front to back
+    if (!mFile.Open(inPath, MappedFileAccess::Random)) {
+        return false;
+    }
+
+    const Uint8 *data = mFile.GetData();
+    size_t size = mFile.GetSize();
+
+    if (size < sizeof(ContentPackHeader)) {
+        LOG_ERROR("Content pack is too small: %s\n", inPath);
+        mFile.Close();
+        return false;
+    }
+
+    const ContentPackHeader *header = reinterpret_cast<const ContentPackHeader *>(data);
+    if (header->mMagic != cContentPackMagic) {
+        LOG_ERROR("Not a content pack: %s\n", inPath);
+        mFile.Close();
+        return false;
+    }
+
+    if (header->mVersion != cContentPackVersion) {
+        LOG_ERROR("Unsupported content pack version %u, expected %u\n", header->mVersion, cContentPackVersion);
+        mFile.Close();
+        return false;
+    }
+
+    Uint32 slot_count = header->mSlotCount;
+    if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || header->mEntryCount >= slot_count) {
+        LOG_ERROR("Content pack has an invalid hash table of %u slots for %u entries\n", slot_count, header->mEntryCount);
+        mFile.Close();
+        return false;
+    }
+
+    Uint64 entry_table_size = Uint64(header->mEntryCount) * sizeof(ContentPackEntry);
+    Uint64 slot_table_size = Uint64(slot_count) * sizeof(Uint32);
+    if (header->mEntryOffset % alignof(ContentPackEntry) != 0 || header->mEntryOffset > size || entry_table_size > size - header->mEntryOffset ||
+        header->mSlotOffset % alignof(Uint32) != 0 || header->mSlotOffset > size || slot_table_size > size - header->mSlotOffset ||
+        header->mPathOffset > size || header->mPathSize > size - header->mPathOffset) {
+        LOG_ERROR("Content pack tables are out of bounds\n");
+        mFile.Close();
+        return false;
+    }
+
+    const ContentPackEntry *entries = reinterpret_cast<const ContentPackEntry *>(data + header->mEntryOffset);
+    const Uint32 *slots = reinterpret_cast<const Uint32 *>(data + header->mSlotOffset);
+    const char *paths = reinterpret_cast<const char *>(data + header->mPathOffset);
+
+    // Check everything once here, so lookups and reads can trust the pack
+    for (Uint32 i = 0; i < header->mEntryCount; i++) {
+        const ContentPackEntry &entry = entries[i];
+
+        if (Uint64(entry.mPathOffset) + entry.mPathLength >= header->mPathSize || paths[entry.mPathOffset + entry.mPathLength] != '\0') {
+            LOG_ERROR("Content pack entry %u has an invalid path\n", i);
+            mFile.Close();
+            return false;
+        }
+
+        if (entry.mOffset % cContentPackAlignment != 0 || entry.mOffset > size || entry.mSize > size - entry.mOffset) {
+            LOG_ERROR("Content pack entry %s is out of bounds\n", paths + entry.mPathOffset);
+            mFile.Close();
+            return false;
+        }
+
+        bool is_valid_size = entry.mCompression == ContentPackCompression::LZ4 ||
+            (entry.mCompression == ContentPackCompression::None && entry.mSize == entry.mOriginalSize);
+        if (!is_valid_size) {
+            LOG_ERROR("Content pack entry %s has an unsupported compression %u\n", paths + entry.mPathOffset, static_cast<Uint32>(entry.mCompression));
+            mFile.Close();
+            return false;
+        }
+    }
+
+    Uint32 empty_slot_count = 0;
+    for (Uint32 i = 0; i < slot_count; i++) {
+        if (slots[i] == cContentPackEmptySlot) {
+            empty_slot_count++;
+        } else if (slots[i] >= header->mEntryCount) {
+            LOG_ERROR("Content pack hash table points past the entries\n");
+            mFile.Close();
+            return false;
+        }
+    }
+
+    // Lookups of missing paths probe until they reach an empty slot, without one they would never stop
+    if (empty_slot_count == 0) {
+        LOG_ERROR("Content pack hash table has no empty slot\n");
+        mFile.Close();
+        return false;
+    }
+
+    mHeader = header;
+    mEntries = entries;
+    mSlots = slots;
+    mPaths = paths;
+
+    return true;
+}
+
+void ContentPack::Close() {
+    mFile.Close();
+    mHeader = nullptr;
+    mEntries = nullptr;
+    mSlots = nullptr;
+    mPaths = nullptr;
+}
+
+const ContentPackEntry *ContentPack::Find(const char *inPath) const {
+    if (mHeader == nullptr) {
+        return nullptr;
+    }
+
+    Uint64 hash = HashContentPackPath(inPath);
+    Uint32 mask = mHeader->mSlotCount - 1;
+
+    // Probe until an empty slot, the table always has one
+    for (Uint32 slot = static_cast<Uint32>(hash) & mask;; slot = (slot + 1) & mask) {
+        Uint32 index = mSlots[slot];
+        if (index == cContentPackEmptySlot) {
+            return nullptr;
+        }
+
+        const ContentPackEntry &entry = mEntries[index];
+        if (entry.mHash == hash && IsSamePath(mPaths + entry.mPathOffset, inPath)) {
+            return &entry;
+        }
+    }
+}
+
+// Lengths of 15 and up continue in bytes that add up until one isn't 255
+static inline bool ReadLZ4Length(const Uint8 *&ioData, const Uint8 *inEnd, size_t &ioLength) {
+    Uint8 value;
+    do {
+        if (ioData == inEnd) {
+            return false;
+        }
+
+        value = *ioData++;
+        ioLength += value;
+    } while (value == 255);
+
+    return true;
+}
+
+// Every sequence is a token with the literal and match lengths, the literals, and a match copied from the output
+// written so far. The last sequence only has literals.
+static bool DecompressLZ4Block(const Uint8 *inData, size_t inSize, Uint8 *outData, size_t inOutputSize) {
+    const Uint8 *source = inData;
+    const Uint8 *source_end = inData + inSize;
+    Uint8 *destination = outData;
+    Uint8 *destination_end = outData + inOutputSize;
+
+    while (source < source_end) {
+        Uint8 token = *source++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !ReadLZ4Length(source, source_end, literal_length)) {
+            return false;
+        }
+
+        if (literal_length > size_t(source_end - source) || literal_length > size_t(destination_end - destination)) {
+            return false;
+        }
+
+        SDL_memcpy(destination, source, literal_length);
+        source += literal_length;
+        destination += literal_length;
+
+        if (source == source_end) {
+            break;
+        }
+
+        if (source_end - source < 2) {
+            return false;
+        }
+
+        size_t offset = source[0] | (source[1] << 8);
+        source += 2;
+
+        if (offset == 0 || offset > size_t(destination - outData)) {
+            return false;
+        }
+
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !ReadLZ4Length(source, source_end, match_length)) {
+            return false;
+        }
+
+        match_length += 4;
+        if (match_length > size_t(destination_end - destination)) {
+            return false;
+        }
+
+        // Close matches overlap the bytes they produce, those repeat a pattern and have to go byte by byte
+        const Uint8 *match = destination - offset;
+        if (offset >= match_length) {
+            SDL_memcpy(destination, match, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; i++) {
+                destination[i] = match[i];
+            }
+        }
+
+        destination += match_length;
+    }
+
+    return destination == destination_end;
+}
+
+bool ContentPack::Decompress(const ContentPackEntry &inEntry, Uint8 *outData) const {
+    const Uint8 *data = GetData(inEntry);
+
+    if (inEntry.mCompression == ContentPackCompression::None) {
+        SDL_memcpy(outData, data, inEntry.mSize);
+        return true;
+    }
+
+    if (!DecompressLZ4Block(data, inEntry.mSize, outData, inEntry.mOriginalSize)) {
+        LOG_ERROR("Content pack entry %s is corrupt\n", GetPath(inEntry));
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "MappedFile.hpp"
+
+// "CPAK" in little endian
+static constexpr Uint32 cContentPackMagic = 0x4b415043;
+static constexpr Uint32 cContentPackVersion = 1;
+// Entry data starts on a cache line, so the formats inside can be read in place
+static constexpr Uint64 cContentPackAlignment = 64;
+static constexpr Uint32 cContentPackEmptySlot = 0xffffffff;
+
+enum class ContentPackCompression : Uint32 {
+    None = 0,
+    // LZ4 block format, without the frame around it
+    LZ4 = 1
+};
+
+// A pack is the header, the entries, a hash table of entry indices, the paths and then the data of every entry.
+// Written by scripts/build-pack.py.
+struct ContentPackHeader {
+    Uint32 mMagic;
+    Uint32 mVersion;
+    Uint32 mEntryCount;
+    // Power of two, open addressing with linear probing
+    Uint32 mSlotCount;
+    Uint64 mEntryOffset;
+    Uint64 mSlotOffset;
+    Uint64 mPathOffset;
+    Uint64 mPathSize;
+};
+static_assert(sizeof(ContentPackHeader) == 48);
+
+struct ContentPackEntry {
+    // See HashContentPackPath
+    Uint64 mHash;
+    Uint64 mOffset;
+    // Size as stored in the pack, and once decompressed
+    Uint64 mSize;
+    Uint64 mOriginalSize;
+    // Into the path table, paths are null terminated
+    Uint32 mPathOffset;
+    Uint32 mPathLength;
+    ContentPackCompression mCompression;
+    Uint32 mPadding;
+};
+static_assert(sizeof(ContentPackEntry) == 48);
+
+// FNV-1a of the path with backslashes read as slashes and a leading "./" left out, so paths built on any platform
+// find the same entry
+Uint64 HashContentPackPath(const char *inPath);
+
+// A pack of content files mapped into memory as a whole. Entries are looked up by path through the hash table in
+// the pack, uncompressed entries are read in place and compressed ones are decompressed into a buffer.
+class ContentPack {
+private:
+    MappedFile mFile;
+    const ContentPackHeader *mHeader = nullptr;
+    const ContentPackEntry *mEntries = nullptr;
+    const Uint32 *mSlots = nullptr;
+    const char *mPaths = nullptr;
+
+public:
+    ContentPack() = default;
+
+    ContentPack(const ContentPack &) = delete;
+    ContentPack &operator=(const ContentPack &) = delete;
+
+    bool Open(const char *inPath);
+    void Close();
+
+    inline bool IsOpen() const {
+        return mHeader != nullptr;
+    }
+
+    // Find an entry by its path, or nullptr if the pack doesn't have it
+    const ContentPackEntry *Find(const char *inPath) const;
+
+    inline Uint32 GetEntryCount() const {
+        return mHeader != nullptr ? mHeader->mEntryCount : 0;
+    }
+
+    inline const ContentPackEntry &GetEntry(Uint32 inIndex) const {
+        return mEntries[inIndex];
+    }
+
+    inline const char *GetPath(const ContentPackEntry &inEntry) const {
+        return mPaths + inEntry.mPathOffset;
+    }
+
+    // The entry as it is stored, which is its contents for uncompressed entries
+    inline const Uint8 *GetData(const ContentPackEntry &inEntry) const {
+        return mFile.GetData() + inEntry.mOffset;
+    }
+
+    // Start reading an entry from disk before it is used
+    inline void WillNeed(const ContentPackEntry &inEntry) const {
+        mFile.WillNeed(inEntry.mOffset, inEntry.mSize);
+    }
+
+    // Decompress an entry into a buffer of its original size
+    bool Decompress(const ContentPackEntry &inEntry, Uint8 *outData) const;
+};
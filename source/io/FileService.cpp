@@ -0,0 +1,192 @@
+#include "FileService.hpp"
+
+#include "macros/log.hpp"
+
+FileData::~FileData() {
+    Reset();
+}
+
+void FileData::Reset() {
+    if (mBuffer != nullptr) {
+        SDL_free(mBuffer);
+        mBuffer = nullptr;
+    }
+
+    if (mMapping != nullptr) {
+        delete mMapping;
+        mMapping = nullptr;
+    }
+
+    mData = nullptr;
+    mSize = 0;
+}
+
+bool FileService::OpenPack(const char *inPath) {
+    if (!mPack.Open(inPath)) {
+        return false;
+    }
+
+    LOG_INFO("Opened content pack %s with %u files\n", inPath, mPack.GetEntryCount());
+    return true;
+}
+
+void FileService::ClosePack() {
+    mPack.Close();
+}
+
+eastl::string FileService::GetLoosePath(const char *inPath) const {
+    // Absolute paths, including ones with a Windows drive letter, are used as they are
+    bool is_absolute = inPath[0] == '/' || inPath[0] == '\\' || (inPath[0] != '\0' && inPath[1] == ':');
+
+    const char *base_path = SDL_GetBasePath();
+    if (is_absolute || base_path == nullptr) {
+        return inPath;
+    }
+
+    eastl::string path = base_path;
+    path += inPath;
+    return path;
+}
+
+bool FileService::Exists(const char *inPath) const {
+    return mPack.Find(inPath) != nullptr || SDL_GetPathInfo(GetLoosePath(inPath).c_str(), nullptr);
+}
+
+bool FileService::ReadPackEntry(const char *inPath, FileData &outData, bool &outIsSuccessful) {
+    const ContentPackEntry *entry = mPack.Find(inPath);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    outData.Reset();
+    outIsSuccessful = false;
+
+    if (entry->mCompression == ContentPackCompression::None) {
+        // Read ahead, the caller is about to go through the entry and the pack is mapped for random access
+        mPack.WillNeed(*entry);
+        outData.mData = mPack.GetData(*entry);
+        outData.mSize = entry->mSize;
+        mZeroCopyCount.fetch_add(1, std::memory_order_relaxed);
+        mZeroCopySize.fetch_add(outData.mSize, std::memory_order_relaxed);
+    } else {
+        Uint64 start_time = SDL_GetTicksNS();
+
+        // SDL_malloc fails on zero, empty files still get a buffer so they read as valid
+        Uint8 *buffer = static_cast<Uint8 *>(SDL_malloc(SDL_max(entry->mOriginalSize, Uint64(1))));
+        if (buffer == nullptr) {
+            LOG_ERROR("Unable to allocate %llu bytes for %s\n", static_cast<unsigned long long>(entry->mOriginalSize), inPath);
+            return true;
+        }
+
+        mPack.WillNeed(*entry);
+        if (!mPack.Decompress(*entry, buffer)) {
+            SDL_free(buffer);
+            return true;
+        }
+
+        outData.mBuffer = buffer;
+        outData.mData = buffer;
+        outData.mSize = entry->mOriginalSize;
+        mDecompressedCount.fetch_add(1, std::memory_order_relaxed);
+        mDecompressedSize.fetch_add(outData.mSize, std::memory_order_relaxed);
+        mCompressedSize.fetch_add(entry->mSize, std::memory_order_relaxed);
+        mDecompressTime.fetch_add(SDL_GetTicksNS() - start_time, std::memory_order_relaxed);
+    }
+
+    outIsSuccessful = true;
+    return true;
+}
+
+bool FileService::ReadFile(const char *inPath, FileData &outData) {
+    bool is_successful;
+    if (ReadPackEntry(inPath, outData, is_successful)) {
+        return is_successful;
+    }
+
+    Uint64 start_time = SDL_GetTicksNS();
+    outData.Reset();
+
+    eastl::string path = GetLoosePath(inPath);
+
+    size_t size;
+    void *buffer = SDL_LoadFile(path.c_str(), &size);
+    if (buffer == nullptr) {
+        LOG_ERROR("Unable to read file %s: %s\n", path.c_str(), SDL_GetError());
+        return false;
+    }
+
+    outData.mBuffer = buffer;
+    outData.mData = static_cast<const Uint8 *>(buffer);
+    outData.mSize = size;
+
+    mLooseReadCount.fetch_add(1, std::memory_order_relaxed);
+    mLooseReadSize.fetch_add(size, std::memory_order_relaxed);
+    mLooseReadTime.fetch_add(SDL_GetTicksNS() - start_time, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool FileService::MapFile(const char *inPath, FileData &outData) {
+    bool is_successful;
+    if (ReadPackEntry(inPath, outData, is_successful)) {
+        return is_successful;
+    }
+
+    outData.Reset();
+
+    // Heap allocated, so the data can move without the mapping going away
+    MappedFile *mapping = new MappedFile();
+    if (!mapping->Open(GetLoosePath(inPath).c_str())) {
+        delete mapping;
+        return false;
+    }
+
+    outData.mMapping = mapping;
+    outData.mData = mapping->GetData();
+    outData.mSize = mapping->GetSize();
+
+    // Not timed, the pages are read as they are touched
+    mLooseMapCount.fetch_add(1, std::memory_order_relaxed);
+    mLooseMapSize.fetch_add(outData.mSize, std::memory_order_relaxed);
+
+    return true;
+}
+
+FileStats FileService::GetStats() const {
+    return {
+        mPack.GetEntryCount(),
+        mZeroCopyCount.load(std::memory_order_relaxed),
+        mZeroCopySize.load(std::memory_order_relaxed),
+        mDecompressedCount.load(std::memory_order_relaxed),
+        mDecompressedSize.load(std::memory_order_relaxed),
+        mCompressedSize.load(std::memory_order_relaxed),
+        mDecompressTime.load(std::memory_order_relaxed),
+        mLooseReadCount.load(std::memory_order_relaxed),
+        mLooseReadSize.load(std::memory_order_relaxed),
+        mLooseReadTime.load(std::memory_order_relaxed),
+        mLooseMapCount.load(std::memory_order_relaxed),
+        mLooseMapSize.load(std::memory_order_relaxed)
+    };
+}
+
+static double GetThroughput(Uint64 inSize, Uint64 inTime) {
+    return static_cast<double>(inSize) / (1024.0 * 1024.0) / SDL_max(static_cast<double>(inTime) / 1e9, 1e-9);
+}
+
+void FileService::LogStats() const {
+    FileStats stats = GetStats();
+    LOG_INFO("Files: pack of %u files, %llu zero-copy reads (%.2f MB, read on touch), %llu decompressed (%.2f MB from %.2f MB at %.1f MB/s)\n",
+        stats.mPackEntryCount,
+        static_cast<unsigned long long>(stats.mZeroCopyCount),
+        static_cast<double>(stats.mZeroCopySize) / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(stats.mDecompressedCount),
+        static_cast<double>(stats.mDecompressedSize) / (1024.0 * 1024.0),
+        static_cast<double>(stats.mCompressedSize) / (1024.0 * 1024.0),
+        GetThroughput(stats.mDecompressedSize, stats.mDecompressTime));
+    LOG_INFO("Files: %llu loose reads (%.2f MB at %.1f MB/s), %llu loose maps (%.2f MB, read on touch)\n",
+        static_cast<unsigned long long>(stats.mLooseReadCount),
+        static_cast<double>(stats.mLooseReadSize) / (1024.0 * 1024.0),
+        GetThroughput(stats.mLooseReadSize, stats.mLooseReadTime),
+        static_cast<unsigned long long>(stats.mLooseMapCount),
+        static_cast<double>(stats.mLooseMapSize) / (1024.0 * 1024.0));
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+
+#include <SDL3/SDL.h>
+
+#include <EASTL/string.h>
+
+#include "macros/singleton.hpp"
+
+#include "ContentPack.hpp"
+#include "MappedFile.hpp"
+
+// The contents of a file, either pointing straight into the content pack or owning the memory they are in
+class FileData {
+private:
+    const Uint8 *mData = nullptr;
+    size_t mSize = 0;
+
+    // Set for compressed pack entries and loose files that were read, freed with SDL_free
+    void *mBuffer = nullptr;
+    // Set for loose files that were mapped
+    MappedFile *mMapping = nullptr;
+
+    friend class FileService;
+
+public:
+    FileData() = default;
+    ~FileData();
+
+    FileData(const FileData &) = delete;
+    FileData &operator=(const FileData &) = delete;
+
+    void Reset();
+
+    inline bool IsValid() const {
+        return mData != nullptr;
+    }
+
+    inline const Uint8 *GetData() const {
+        return mData;
+    }
+
+    inline size_t GetSize() const {
+        return mSize;
+    }
+};
+
+// Times are only kept for reads that go through every byte before returning, so their throughputs compare. Zero-copy
+// and mapped reads return before any page is read, their cost lands on whoever touches the data.
+struct FileStats {
+    Uint32 mPackEntryCount;
+
+    // Pack reads that were uncompressed and handed out without a copy
+    Uint64 mZeroCopyCount;
+    Uint64 mZeroCopySize;
+    // Pack reads that were decompressed into a buffer, with their size in the pack and the time spent decompressing
+    Uint64 mDecompressedCount;
+    Uint64 mDecompressedSize;
+    Uint64 mCompressedSize;
+    Uint64 mDecompressTime;
+
+    // Files that weren't in the pack and were read from disk into a buffer
+    Uint64 mLooseReadCount;
+    Uint64 mLooseReadSize;
+    Uint64 mLooseReadTime;
+    // Files that weren't in the pack and were mapped
+    Uint64 mLooseMapCount;
+    Uint64 mLooseMapSize;
+};
+
+// Reads content by path. Files come from the content pack when one is open and has them, and from disk next to the
+// executable otherwise, so content that isn't packed yet keeps working. Safe to use from any thread once the pack is open.
+class FileService {
+MAKE_SINGLETON(FileService)
+private:
+    ContentPack mPack;
+
+    std::atomic<Uint64> mZeroCopyCount = 0;
+    std::atomic<Uint64> mZeroCopySize = 0;
+    std::atomic<Uint64> mDecompressedCount = 0;
+    std::atomic<Uint64> mDecompressedSize = 0;
+    std::atomic<Uint64> mCompressedSize = 0;
+    std::atomic<Uint64> mDecompressTime = 0;
+    std::atomic<Uint64> mLooseReadCount = 0;
+    std::atomic<Uint64> mLooseReadSize = 0;
+    std::atomic<Uint64> mLooseReadTime = 0;
+    std::atomic<Uint64> mLooseMapCount = 0;
+    std::atomic<Uint64> mLooseMapSize = 0;
+
+    // Fill the data from the pack, false if the pack doesn't have the file
+    bool ReadPackEntry(const char *inPath, FileData &outData, bool &outIsSuccessful);
+
+public:
+    // Open the pack files are read from first. Has to happen before anything is read, and not while reading.
+    bool OpenPack(const char *inPath);
+    void ClosePack();
+
+    inline const ContentPack &GetPack() const {
+        return mPack;
+    }
+
+    // Where a file that isn't in the pack is read from. Relative paths are relative to the executable like the paths
+    // in the pack, so content is found no matter which directory the engine is started from.
+    eastl::string GetLoosePath(const char *inPath) const;
+
+    bool Exists(const char *inPath) const;
+
+    // Read a whole file. Uncompressed pack entries point into the pack, anything else is read into a buffer.
+    bool ReadFile(const char *inPath, FileData &outData);
+    // Like ReadFile, but loose files are mapped rather than read, for files that are only partly touched
+    bool MapFile(const char *inPath, FileData &outData);
+
+    FileStats GetStats() const;
+    // Log how much content came from the pack and from loose files. Only reads that produce a filled buffer get a
+    // throughput, --pack-benchmark compares both paths reading the same files.
+    void LogStats() const;
+};
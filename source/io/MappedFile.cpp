@@ -0,0 +1,124 @@
+#include "MappedFile.hpp"
+
+#include "macros/log.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const char *inPath, MappedFileAccess inAccess) {
+    Close();
+
+#if defined(_WIN32)
+    DWORD flags = inAccess == MappedFileAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(inPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Unable to open file: %s\n", inPath);
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        LOG_ERROR("Unable to map empty file: %s\n", inPath);
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        LOG_ERROR("Unable to create file mapping: %s\n", inPath);
+        CloseHandle(file);
+        return false;
+    }
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        LOG_ERROR("Unable to map file: %s\n", inPath);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mMapping = mapping;
+    mSize = static_cast<size_t>(file_size.QuadPart);
+#else
+    int file = open(inPath, O_RDONLY);
+    if (file < 0) {
+        LOG_ERROR("Unable to open file: %s\n", inPath);
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        LOG_ERROR("Unable to map empty file: %s\n", inPath);
+        close(file);
+        return false;
+    }
+
+    void *data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("Unable to map file: %s\n", inPath);
+        close(file);
+        return false;
+    }
+
+    // Files read front to back let the kernel read ahead aggressively, random access only reads what is asked for
+    madvise(data, static_cast<size_t>(file_stat.st_size), inAccess == MappedFileAccess::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    mFile = file;
+    mSize = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    mData = static_cast<const Uint8 *>(data);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData == nullptr) {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mData);
+    CloseHandle(mMapping);
+    CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    munmap(const_cast<Uint8 *>(mData), mSize);
+    close(mFile);
+    mFile = -1;
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
+
+void MappedFile::WillNeed(size_t inOffset, size_t inSize) const {
+    if (mData == nullptr || inOffset >= mSize || inSize == 0) {
+        return;
+    }
+
+    inSize = SDL_min(inSize, mSize - inOffset);
+
+#if defined(_WIN32)
+    WIN32_MEMORY_RANGE_ENTRY range = { const_cast<Uint8 *>(mData + inOffset), inSize };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise wants a page aligned address
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = inOffset & ~(page_size - 1);
+    madvise(const_cast<Uint8 *>(mData + start), inSize + (inOffset - start), MADV_WILLNEED);
+#endif
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// How the mapping is going to be read, so the kernel can read ahead for it
+enum class MappedFileAccess {
+    Sequential,
+    // Scattered reads of parts of the file, like the entries of a content pack. Use WillNeed to read a part ahead.
+    Random
+};
+
+// A read-only view of a whole file mapped into memory, pages are only read from disk once they are touched
+class MappedFile {
+private:
+    const Uint8 *mData = nullptr;
+    size_t mSize = 0;
+
+#if defined(_WIN32)
+    void *mFile = nullptr;
+    void *mMapping = nullptr;
+#else
+    int mFile = -1;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const char *inPath, MappedFileAccess inAccess = MappedFileAccess::Sequential);
+    void Close();
+
+    // Start reading a range of the file in the background, so touching it later doesn't fault page by page
+    void WillNeed(size_t inOffset, size_t inSize) const;
+
+    inline bool IsOpen() const {
+        return mData != nullptr;
+    }
+
+    inline const Uint8 *GetData() const {
+        return mData;
+    }
+
+    inline size_t GetSize() const {
+        return mSize;
+    }
+};
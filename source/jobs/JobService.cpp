@@ -0,0 +1,261 @@
+#include "JobService.hpp"
+
+#include "macros/log.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// The worker index of the current thread, or -1 if this is not a worker thread
+static thread_local int sWorkerIndex = -1;
+
+static void SetThreadAffinity(std::thread &inThread, int inCore) {
+#if defined(_WIN32)
+    SetThreadAffinityMask(static_cast<HANDLE>(inThread.native_handle()), DWORD_PTR(1) << inCore);
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(inCore, &cpu_set);
+    pthread_setaffinity_np(inThread.native_handle(), sizeof(cpu_set), &cpu_set);
+#else
+    (void)inThread;
+    (void)inCore;
+#endif
+}
+
+// Find the core for a worker by walking the set bits of the affinity mask
+static int GetAffinityCore(Uint64 inAffinityMask, int inWorkerIndex) {
+    int set_bits = 0;
+    for (int core = 0; core < 64; core++) {
+        if ((inAffinityMask & (Uint64(1) << core)) != 0) {
+            set_bits++;
+        }
+    }
+
+    int target = inWorkerIndex % set_bits;
+
+    for (int core = 0; core < 64; core++) {
+        if ((inAffinityMask & (Uint64(1) << core)) != 0) {
+            if (target-- == 0) {
+                return core;
+            }
+        }
+    }
+
+    return -1;
+}
+
+bool JobService::Initialize(const JobServiceCreateInfo &inCreateInfo) {
+    const JPH::uint cMaxJobs = JPH::cMaxPhysicsJobs;
+    const JPH::uint cMaxBarriers = JPH::cMaxPhysicsBarriers;
+
+    JobSystemWithBarrier::Init(cMaxBarriers);
+    mJobs.Init(cMaxJobs, cMaxJobs);
+
+    int thread_count = inCreateInfo.mThreadCount;
+    if (thread_count < 0) {
+        thread_count = SDL_GetNumLogicalCPUCores() - 1;
+    }
+
+    // Always keep at least one worker so queued jobs are guaranteed to make progress
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+
+    mQuit = false;
+    mWorkers.reserve(thread_count);
+
+    for (int i = 0; i < thread_count; i++) {
+        mWorkers.push_back(new Worker());
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        int core = inCreateInfo.mAffinityMask != 0 ? GetAffinityCore(inCreateInfo.mAffinityMask, i) : -1;
+        mWorkers[i]->mThread = std::thread([this, i] { WorkerMain(i); });
+
+        if (core >= 0) {
+            SetThreadAffinity(mWorkers[i]->mThread, core);
+        }
+    }
+
+    ResetWorkerStats();
+
+    LOG_INFO("Job service started with %d worker threads\n", thread_count);
+    return true;
+}
+
+void JobService::Shutdown() {
+    if (mWorkers.empty()) {
+        return;
+    }
+
+    // Wake up every worker so they can see the quit flag
+    mQuit = true;
+    mSemaphore.Release(static_cast<JPH::uint>(mWorkers.size()));
+
+    for (Worker *worker : mWorkers) {
+        worker->mThread.join();
+
+        // Release any jobs that never got to run
+        for (Job *job : worker->mQueue) {
+            job->Release();
+        }
+
+        delete worker;
+    }
+
+    mWorkers.clear();
+}
+
+int JobService::GetMaxConcurrency() const {
+    // Include the thread that waits on a barrier, since it also executes jobs
+    return static_cast<int>(mWorkers.size()) + 1;
+}
+
+JPH::JobSystem::JobHandle JobService::CreateJob(const char *inName, JPH::ColorArg inColor, const JobFunction &inJobFunction, JPH::uint32 inNumDependencies) {
+    // Loop until a job becomes available in the free list
+    JPH::uint32 index;
+    for (;;) {
+        index = mJobs.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+        if (index != AvailableJobs::cInvalidObjectIndex) {
+            break;
+        }
+
+        JPH_ASSERT(false, "No jobs available!");
+        std::this_thread::yield();
+    }
+
+    Job *job = &mJobs.Get(index);
+
+    // Take a reference before queueing, since the job may complete immediately
+    JobHandle handle(job);
+
+    if (inNumDependencies == 0) {
+        QueueJob(job);
+    }
+
+    return handle;
+}
+
+void JobService::FreeJob(Job *inJob) {
+    mJobs.DestructObject(inJob);
+}
+
+void JobService::QueueJob(Job *inJob) {
+    // The reference is released by the worker after executing the job
+    inJob->AddRef();
+
+    // Workers push onto their own queue, other threads spread jobs over all queues
+    int index = sWorkerIndex;
+    if (index < 0) {
+        index = static_cast<int>(mNextQueue.fetch_add(1, std::memory_order_relaxed) % mWorkers.size());
+    }
+
+    Worker *worker = mWorkers[index];
+    {
+        std::lock_guard lock(worker->mMutex);
+        worker->mQueue.push_back(inJob);
+    }
+
+    mSemaphore.Release();
+}
+
+void JobService::QueueJobs(Job **inJobs, JPH::uint inNumJobs) {
+    for (JPH::uint i = 0; i < inNumJobs; i++) {
+        QueueJob(inJobs[i]);
+    }
+}
+
+JPH::JobSystem::Job *JobService::PopJob(int inIndex, bool &outStolen) {
+    int worker_count = static_cast<int>(mWorkers.size());
+
+    // Take the most recently pushed job from our own queue, it's the most likely to be in cache
+    {
+        Worker *worker = mWorkers[inIndex];
+        std::lock_guard lock(worker->mMutex);
+        if (!worker->mQueue.empty()) {
+            Job *job = worker->mQueue.back();
+            worker->mQueue.pop_back();
+            outStolen = false;
+            return job;
+        }
+    }
+
+    // Steal the oldest job from another worker
+    for (int i = 1; i < worker_count; i++) {
+        Worker *victim = mWorkers[(inIndex + i) % worker_count];
+        std::lock_guard lock(victim->mMutex);
+        if (!victim->mQueue.empty()) {
+            Job *job = victim->mQueue.front();
+            victim->mQueue.pop_front();
+            outStolen = true;
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobService::WorkerMain(int inIndex) {
+    sWorkerIndex = inIndex;
+    Worker *worker = mWorkers[inIndex];
+
+    JPH_PROFILE_THREAD_START("Worker");
+
+    for (;;) {
+        // Every token in the semaphore matches a queued job
+        mSemaphore.Acquire();
+        if (mQuit) {
+            break;
+        }
+
+        // The job might still be on its way into a queue, so keep looking until it shows up
+        bool stolen = false;
+        Job *job = PopJob(inIndex, stolen);
+        while (job == nullptr) {
+            std::this_thread::yield();
+            job = PopJob(inIndex, stolen);
+        }
+
+        Uint64 start_time = SDL_GetTicksNS();
+        job->Execute();
+        job->Release();
+        worker->mBusyTime.fetch_add(SDL_GetTicksNS() - start_time, std::memory_order_relaxed);
+
+        worker->mJobsExecuted.fetch_add(1, std::memory_order_relaxed);
+        if (stolen) {
+            worker->mJobsStolen.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    JPH_PROFILE_THREAD_END();
+}
+
+void JobService::GetWorkerStats(eastl::vector<WorkerStats> &outStats) const {
+    Uint64 elapsed_time = SDL_GetTicksNS() - mStatsStartTime;
+
+    outStats.resize(mWorkers.size());
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        const Worker *worker = mWorkers[i];
+
+        WorkerStats &stats = outStats[i];
+        stats.mJobsExecuted = worker->mJobsExecuted.load(std::memory_order_relaxed);
+        stats.mJobsStolen = worker->mJobsStolen.load(std::memory_order_relaxed);
+        stats.mBusyTime = worker->mBusyTime.load(std::memory_order_relaxed);
+        stats.mUtilization = elapsed_time > 0 ? static_cast<float>(stats.mBusyTime) / elapsed_time : 0.0f;
+    }
+}
+
+void JobService::ResetWorkerStats() {
+    for (Worker *worker : mWorkers) {
+        worker->mJobsExecuted = 0;
+        worker->mJobsStolen = 0;
+        worker->mBusyTime = 0;
+    }
+
+    mStatsStartTime = SDL_GetTicksNS();
+}
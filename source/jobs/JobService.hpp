@@ -0,0 +1,83 @@
+#pragma once
+
+#include "macros/singleton.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+#include <Jolt/Core/Semaphore.h>
+
+#include <EASTL/deque.h>
+#include <EASTL/vector.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+struct JobServiceCreateInfo {
+    // Number of worker threads, a negative value uses one thread per core minus the main thread
+    int mThreadCount = -1;
+    // Cores the workers may be pinned to, worker N gets the Nth set bit (wrapping around), zero disables pinning
+    Uint64 mAffinityMask = 0;
+};
+
+struct WorkerStats {
+    Uint64 mJobsExecuted;
+    Uint64 mJobsStolen;
+    // Time spent executing jobs, in nanoseconds
+    Uint64 mBusyTime;
+    // Busy time divided by the time since the stats were last reset
+    float mUtilization;
+};
+
+// The engine's single pool of worker threads. Every worker owns a queue it pushes to and pops from,
+// and steals from the other queues when it runs dry. It implements JPH::JobSystem so physics shares it too.
+class JobService final : public JPH::JobSystemWithBarrier {
+MAKE_SINGLETON(JobService)
+private:
+    using AvailableJobs = JPH::FixedSizeFreeList<Job>;
+
+    struct Worker {
+        std::thread mThread;
+        std::mutex mMutex;
+        eastl::deque<Job *> mQueue;
+
+        std::atomic<Uint64> mJobsExecuted = 0;
+        std::atomic<Uint64> mJobsStolen = 0;
+        std::atomic<Uint64> mBusyTime = 0;
+    };
+
+    AvailableJobs mJobs;
+    eastl::vector<Worker *> mWorkers;
+
+    // Counts the jobs that are queued but not yet picked up by a worker
+    JPH::Semaphore mSemaphore;
+    std::atomic<bool> mQuit = false;
+    std::atomic<Uint32> mNextQueue = 0;
+
+    Uint64 mStatsStartTime = 0;
+
+    void WorkerMain(int inIndex);
+    Job *PopJob(int inIndex, bool &outStolen);
+
+protected:
+    virtual void QueueJob(Job *inJob) override;
+    virtual void QueueJobs(Job **inJobs, JPH::uint inNumJobs) override;
+    virtual void FreeJob(Job *inJob) override;
+
+public:
+    bool Initialize(const JobServiceCreateInfo &inCreateInfo);
+    void Shutdown();
+
+    virtual int GetMaxConcurrency() const override;
+    virtual JobHandle CreateJob(const char *inName, JPH::ColorArg inColor, const JobFunction &inJobFunction, JPH::uint32 inNumDependencies = 0) override;
+
+    void GetWorkerStats(eastl::vector<WorkerStats> &outStats) const;
+    void ResetWorkerStats();
+
+    inline int GetWorkerCount() const {
+        return static_cast<int>(mWorkers.size());
+    }
+};
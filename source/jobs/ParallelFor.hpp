@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+
+#include <atomic>
+
+// Jobs added to one barrier at a time. Barriers and the JobService job pool hold cMaxPhysicsJobs jobs, which
+// physics shares, so batches stay well below that.
+static constexpr Uint32 cMaxJobsPerBarrier = 256;
+
+// Wait for jobs that were already created, invalid handles are skipped. Jobs go into barriers in batches that fit.
+inline void WaitForJobs(JPH::JobSystem &inJobSystem, JPH::JobSystem::JobHandle *inHandles, size_t inCount) {
+    for (size_t begin = 0; begin < inCount; begin += cMaxJobsPerBarrier) {
+        size_t end = SDL_min(begin + cMaxJobsPerBarrier, inCount);
+
+        JPH::JobSystem::Barrier *barrier = inJobSystem.CreateBarrier();
+        for (size_t i = begin; i < end; i++) {
+            if (inHandles[i].IsValid()) {
+                barrier->AddJob(inHandles[i]);
+            }
+        }
+
+        // The waiting thread helps executing the jobs
+        inJobSystem.WaitForJobs(barrier);
+        inJobSystem.DestroyBarrier(barrier);
+    }
+}
+
+// Call the function for every index below the count, with at most one job per thread no matter how many indices
+// there are. Jobs take indices one at a time, so threads that get cheap ones pick up more of them. Runs on the
+// calling thread without a job system. The job count can be limited further. Returns the number of jobs used.
+template <typename F>
+Uint32 ParallelFor(JPH::JobSystem *inJobSystem, const char *inName, size_t inCount, const F &inFunction, Uint32 inMaxJobCount = cMaxJobsPerBarrier) {
+    Uint32 job_count = 0;
+    if (inJobSystem != nullptr) {
+        Uint32 thread_count = static_cast<Uint32>(SDL_max(inJobSystem->GetMaxConcurrency(), 1));
+        size_t max_job_count = SDL_min(SDL_min(thread_count, inMaxJobCount), cMaxJobsPerBarrier);
+        job_count = static_cast<Uint32>(SDL_min(inCount, max_job_count));
+    }
+
+    if (job_count <= 1) {
+        for (size_t i = 0; i < inCount; i++) {
+            inFunction(i);
+        }
+
+        return inCount > 0 ? 1 : 0;
+    }
+
+    std::atomic<size_t> next_index = 0;
+    auto run = [&] {
+        for (size_t i = next_index.fetch_add(1, std::memory_order_relaxed); i < inCount; i = next_index.fetch_add(1, std::memory_order_relaxed)) {
+            inFunction(i);
+        }
+    };
+
+    JPH::JobSystem::JobHandle handles[cMaxJobsPerBarrier];
+    for (Uint32 i = 0; i < job_count; i++) {
+        handles[i] = inJobSystem->CreateJob(inName, JPH::Color::sGrey, [&run] { run(); });
+    }
+
+    WaitForJobs(*inJobSystem, handles, job_count);
+    return job_count;
+}
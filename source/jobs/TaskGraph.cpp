@@ -0,0 +1,89 @@
+#include "TaskGraph.hpp"
+
+#include "ParallelFor.hpp"
+
+#include <thread>
+
+TaskID TaskGraph::AddTask(
+    const char *inName,
+    const JPH::JobSystem::JobFunction &inFunction,
+    std::initializer_list<TaskID> inDependencies,
+    bool inIsMainThread
+) {
+    TaskID task_id = static_cast<TaskID>(mTasks.size());
+
+    Task task;
+    task.mName = inName;
+    task.mFunction = inFunction;
+    task.mIsMainThread = inIsMainThread;
+    task.mDependencyCount = static_cast<Uint32>(inDependencies.size());
+    task.mStartTime = 0;
+    task.mTime = 0;
+
+    for (TaskID dependency : inDependencies) {
+        SDL_assert(dependency < task_id);
+        task.mDependencies.push_back(dependency);
+        mTasks[dependency].mDependents.push_back(task_id);
+    }
+
+    mTasks.push_back(task);
+    return task_id;
+}
+
+void TaskGraph::RunTask(TaskID inTaskID) {
+    Task &task = mTasks[inTaskID];
+
+    task.mStartTime = SDL_GetTicksNS();
+    task.mFunction();
+    task.mTime = SDL_GetTicksNS() - task.mStartTime;
+
+    // Main thread tasks are picked up by Execute, the rest are queued once their last dependency is done
+    for (TaskID dependent : task.mDependents) {
+        if (!mTasks[dependent].mIsMainThread) {
+            mHandles[dependent].RemoveDependency();
+        }
+    }
+}
+
+void TaskGraph::Execute(JPH::JobSystem &inJobSystem) {
+    mHandles.clear();
+    mHandles.resize(mTasks.size());
+
+    // Create every job with an extra dependency, so none of them can start before all handles exist
+    for (TaskID i = 0; i < mTasks.size(); i++) {
+        const Task &task = mTasks[i];
+        if (!task.mIsMainThread) {
+            mHandles[i] = inJobSystem.CreateJob(task.mName, JPH::Color::sGrey, [this, i] { RunTask(i); }, task.mDependencyCount + 1);
+        }
+    }
+
+    for (TaskID i = 0; i < mTasks.size(); i++) {
+        if (!mTasks[i].mIsMainThread) {
+            mHandles[i].RemoveDependency();
+        }
+    }
+
+    // Run the main thread tasks in order as soon as their dependencies are done
+    for (TaskID i = 0; i < mTasks.size(); i++) {
+        const Task &task = mTasks[i];
+        if (!task.mIsMainThread) {
+            continue;
+        }
+
+        for (TaskID dependency : task.mDependencies) {
+            while (!mTasks[dependency].mIsMainThread && !mHandles[dependency].IsDone()) {
+                std::this_thread::yield();
+            }
+        }
+
+        RunTask(i);
+    }
+
+    // Wait for all remaining jobs
+    WaitForJobs(inJobSystem, mHandles.data(), mHandles.size());
+}
+
+void TaskGraph::Clear() {
+    mTasks.clear();
+    mHandles.clear();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+
+#include <EASTL/fixed_vector.h>
+#include <EASTL/vector.h>
+
+#include <initializer_list>
+
+using TaskID = Uint32;
+
+// A set of tasks with dependencies between them that runs on a job system, such as a single frame.
+// Tasks have to be added after their dependencies, which keeps the insertion order a valid execution order.
+// The graph is built once and can then be executed any number of times.
+class TaskGraph {
+private:
+    struct Task {
+        const char *mName;
+        JPH::JobSystem::JobFunction mFunction;
+        bool mIsMainThread;
+
+        Uint32 mDependencyCount;
+        eastl::fixed_vector<TaskID, 4> mDependencies;
+        eastl::fixed_vector<TaskID, 4> mDependents;
+
+        // When the task started and how long it ran during the last execution, in nanoseconds
+        Uint64 mStartTime;
+        Uint64 mTime;
+    };
+
+    eastl::vector<Task> mTasks;
+    eastl::vector<JPH::JobSystem::JobHandle> mHandles;
+
+    void RunTask(TaskID inTaskID);
+
+public:
+    // Add a task, tasks on the main thread are executed by the thread that calls Execute
+    TaskID AddTask(
+        const char *inName,
+        const JPH::JobSystem::JobFunction &inFunction,
+        std::initializer_list<TaskID> inDependencies = {},
+        bool inIsMainThread = false
+    );
+
+    // Run all tasks and wait for them to complete
+    void Execute(JPH::JobSystem &inJobSystem);
+
+    void Clear();
+
+    inline const char *GetTaskName(TaskID inTaskID) const {
+        return mTasks[inTaskID].mName;
+    }
+
+    inline Uint64 GetTaskStartTime(TaskID inTaskID) const {
+        return mTasks[inTaskID].mStartTime;
+    }
+
+    inline Uint64 GetTaskTime(TaskID inTaskID) const {
+        return mTasks[inTaskID].mTime;
+    }
+
+    inline size_t GetTaskCount() const {
+        return mTasks.size();
+    }
+};
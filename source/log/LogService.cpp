@@ -0,0 +1,292 @@
+#include "LogService.hpp"
+
+#include <EASTL/sort.h>
+
+#include <chrono>
+
+// Every thread gets a buffer of this size, it has to be a power of two
+static constexpr size_t cBufferSize = 64 * 1024;
+// Records start on this boundary, which always leaves room for a padding record before the end of the buffer
+static constexpr size_t cRecordAlignment = 64;
+static constexpr size_t cMaxRecordSize = cBufferSize / 4;
+
+// Each call site gets this many messages per window, the rest are counted and dropped
+static constexpr Uint64 cRateLimitWindow = 1000000000;
+static constexpr Uint32 cRateLimitCount = 20;
+
+static constexpr auto cWriterInterval = std::chrono::milliseconds(10);
+static constexpr size_t cMaxMessageLength = 2048;
+// A run of repeated messages is reported once it hasn't grown for this long
+static constexpr Uint64 cRepeatReportDelay = 1000000000;
+
+// Single producer, single consumer ring of records. The positions only grow, so their difference is the used size.
+struct LogBuffer {
+    Uint8 *mData = nullptr;
+    // Written by the owning thread, read by the writer
+    alignas(64) std::atomic<Uint64> mWritePosition = 0;
+    // Written by the writer, read by the owning thread
+    alignas(64) std::atomic<Uint64> mReadPosition = 0;
+    // End of the record the owning thread reserved but hasn't committed yet
+    Uint64 mReservedPosition = 0;
+};
+
+static thread_local LogBuffer *tBuffer = nullptr;
+
+struct PendingMessage {
+    Uint64 mTimestamp;
+    const LogCallSite *mSite;
+    LogSeverity mSeverity;
+    Uint32 mSuppressedCount;
+    eastl::string mText;
+};
+
+bool LogService::Initialize() {
+    if (mIsRunning.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    mIsRunning.store(true, std::memory_order_release);
+    mWriterThread = std::thread([this] { RunWriter(); });
+
+    return true;
+}
+
+void LogService::Shutdown() {
+    if (!mIsRunning.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWriterMutex);
+        mWriterCondition.notify_all();
+    }
+
+    mWriterThread.join();
+
+    // Nothing writes into the buffers anymore, so whatever is left can be printed from here
+    Drain();
+    FlushRepeats();
+    fflush(stdout);
+    fflush(stderr);
+
+    // Threads still logging at this point have to be gone, such as the workers
+    std::lock_guard<std::mutex> lock(mBufferMutex);
+    for (LogBuffer *buffer : mBuffers) {
+        delete[] buffer->mData;
+        delete buffer;
+    }
+
+    mBuffers.set_capacity(0);
+    mLastMessage.set_capacity(0);
+}
+
+void LogService::Flush() {
+    if (!mIsRunning.load(std::memory_order_acquire)) {
+        fflush(stdout);
+        fflush(stderr);
+        return;
+    }
+
+    // A drain that is already running may have missed the latest records, so wait for the one after it
+    std::unique_lock<std::mutex> lock(mWriterMutex);
+    Uint64 target_count = mDrainCount + 2;
+    mIsFlushRequested = true;
+    mWriterCondition.notify_all();
+    mWriterCondition.wait(lock, [this, target_count] {
+        return mDrainCount >= target_count || !mIsRunning.load(std::memory_order_acquire);
+    });
+}
+
+LogStats LogService::GetStats() const {
+    return {
+        mWrittenCount.load(std::memory_order_relaxed),
+        mDroppedCount.load(std::memory_order_relaxed),
+        mSuppressedCount.load(std::memory_order_relaxed),
+        mDeduplicatedCount.load(std::memory_order_relaxed)
+    };
+}
+
+bool LogService::Admit(LogCallSite &ioSite, Uint64 inTime, Uint32 &outSuppressedCount) {
+    // The thread that starts a new window reports what the last one dropped
+    Uint64 window_start = ioSite.mWindowStart.load(std::memory_order_relaxed);
+    if (inTime - window_start >= cRateLimitWindow &&
+        ioSite.mWindowStart.compare_exchange_strong(window_start, inTime, std::memory_order_relaxed)) {
+        ioSite.mWindowCount.store(0, std::memory_order_relaxed);
+        outSuppressedCount = ioSite.mSuppressedCount.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (ioSite.mWindowCount.fetch_add(1, std::memory_order_relaxed) >= cRateLimitCount) {
+        ioSite.mSuppressedCount.fetch_add(1, std::memory_order_relaxed);
+        mSuppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+LogRecord *LogService::BeginRecord(size_t inPayloadSize) {
+    size_t size = (cLogPayloadOffset + inPayloadSize + cRecordAlignment - 1) & ~(cRecordAlignment - 1);
+    if (size > cMaxRecordSize) {
+        mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    LogBuffer *buffer = tBuffer;
+    if (buffer == nullptr) {
+        // The only lock a thread ever takes for logging, the first time it logs
+        buffer = new LogBuffer();
+        buffer->mData = new Uint8[cBufferSize];
+
+        std::lock_guard<std::mutex> lock(mBufferMutex);
+        mBuffers.push_back(buffer);
+        tBuffer = buffer;
+    }
+
+    Uint64 write_position = buffer->mWritePosition.load(std::memory_order_relaxed);
+    Uint64 read_position = buffer->mReadPosition.load(std::memory_order_acquire);
+
+    // Records are contiguous, one that would wrap around starts over at the beginning behind a padding record
+    size_t offset = static_cast<size_t>(write_position & (cBufferSize - 1));
+    size_t padding = offset + size > cBufferSize ? cBufferSize - offset : 0;
+
+    if (write_position + padding + size - read_position > cBufferSize) {
+        mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (padding > 0) {
+        LogRecord *padding_record = reinterpret_cast<LogRecord *>(buffer->mData + offset);
+        padding_record->mSize = static_cast<Uint32>(padding);
+        padding_record->mFormatFunction = nullptr;
+        write_position += padding;
+    }
+
+    buffer->mReservedPosition = write_position + size;
+
+    LogRecord *record = reinterpret_cast<LogRecord *>(buffer->mData + (write_position & (cBufferSize - 1)));
+    record->mSize = static_cast<Uint32>(size);
+    return record;
+}
+
+void LogService::CommitRecord() {
+    tBuffer->mWritePosition.store(tBuffer->mReservedPosition, std::memory_order_release);
+}
+
+void LogService::PrintNow(LogSeverity inSeverity, const char *inMessage) {
+    FILE *stream = inSeverity == LogSeverity::Error ? stderr : stdout;
+    fputs(inMessage, stream);
+
+    // Every message ends up on its own line, whether or not it ends with a newline
+    size_t length = strlen(inMessage);
+    if (length == 0 || inMessage[length - 1] != '\n') {
+        fputc('\n', stream);
+    }
+}
+
+void LogService::RunWriter() {
+    std::unique_lock<std::mutex> lock(mWriterMutex);
+
+    while (mIsRunning.load(std::memory_order_acquire)) {
+        mWriterCondition.wait_for(lock, cWriterInterval, [this] {
+            return mIsFlushRequested || !mIsRunning.load(std::memory_order_acquire);
+        });
+
+        bool is_flush_requested = mIsFlushRequested;
+        mIsFlushRequested = false;
+        lock.unlock();
+
+        Drain();
+        if (is_flush_requested) {
+            FlushRepeats();
+            fflush(stdout);
+            fflush(stderr);
+        }
+
+        lock.lock();
+        mDrainCount++;
+        mWriterCondition.notify_all();
+    }
+}
+
+void LogService::Drain() {
+    eastl::vector<LogBuffer *> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mBufferMutex);
+        buffers = mBuffers;
+    }
+
+    eastl::vector<PendingMessage> messages;
+    char text[cMaxMessageLength];
+
+    for (LogBuffer *buffer : buffers) {
+        Uint64 read_position = buffer->mReadPosition.load(std::memory_order_relaxed);
+        Uint64 write_position = buffer->mWritePosition.load(std::memory_order_acquire);
+
+        while (read_position < write_position) {
+            const LogRecord *record = reinterpret_cast<const LogRecord *>(buffer->mData + (read_position & (cBufferSize - 1)));
+
+            if (record->mFormatFunction != nullptr) {
+                record->mFormatFunction(text, sizeof(text), record->mFormat, reinterpret_cast<const Uint8 *>(record) + cLogPayloadOffset);
+                messages.push_back({ record->mTimestamp, record->mSite, record->mSeverity, record->mSuppressedCount, text });
+            }
+
+            read_position += record->mSize;
+        }
+
+        // The space is only handed back once the records are formatted, since their strings live in it
+        buffer->mReadPosition.store(read_position, std::memory_order_release);
+    }
+
+    // Interleave the threads' messages in the order they were logged
+    eastl::stable_sort(messages.begin(), messages.end(), [](const PendingMessage &inA, const PendingMessage &inB) {
+        return inA.mTimestamp < inB.mTimestamp;
+    });
+
+    for (const PendingMessage &message : messages) {
+        Output(message.mSite, message.mSeverity, message.mSuppressedCount, message.mText.c_str());
+    }
+
+    if (mRepeatCount > 0 && SDL_GetTicksNS() - mLastRepeatTime >= cRepeatReportDelay) {
+        FlushRepeats();
+    }
+
+    if (!messages.empty()) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+}
+
+void LogService::Output(const LogCallSite *inSite, LogSeverity inSeverity, Uint32 inSuppressedCount, const char *inMessage) {
+    if (inSite == mLastSite && inSuppressedCount == 0 && mLastMessage == inMessage) {
+        mRepeatCount++;
+        mLastRepeatTime = SDL_GetTicksNS();
+        mDeduplicatedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    FlushRepeats();
+    PrintNow(inSeverity, inMessage);
+    mWrittenCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (inSuppressedCount > 0) {
+        char note[64];
+        snprintf(note, sizeof(note), "(%u similar messages suppressed)", inSuppressedCount);
+        PrintNow(inSeverity, note);
+    }
+
+    mLastSite = inSite;
+    mLastMessage = inMessage;
+    mLastSeverity = inSeverity;
+}
+
+void LogService::FlushRepeats() {
+    if (mRepeatCount == 0) {
+        return;
+    }
+
+    char note[64];
+    snprintf(note, sizeof(note), "(last message repeated %u times)", mRepeatCount);
+    PrintNow(mLastSeverity, note);
+
+    mRepeatCount = 0;
+}
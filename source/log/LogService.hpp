@@ -0,0 +1,241 @@
+#pragma once
+
+#include "macros/singleton.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+
+enum class LogSeverity : Uint8 {
+    Info = 0,
+    Error = 1,
+};
+
+// Rate limiting state of one LOG_* statement, every statement owns a static one
+struct LogCallSite {
+    std::atomic<Uint64> mWindowStart = 0;
+    std::atomic<Uint32> mWindowCount = 0;
+    std::atomic<Uint32> mSuppressedCount = 0;
+};
+
+// Formats a record's arguments that were stored in its payload
+using LogFormatFunction = int (*)(char *outBuffer, size_t inSize, const char *inFormat, const Uint8 *inPayload);
+
+// A log statement as it sits in a thread's buffer, its arguments follow as the payload
+struct LogRecord {
+    // Size of the whole record, padding records that skip the end of the buffer have no format function
+    Uint32 mSize;
+    LogSeverity mSeverity;
+    // Messages from the same call site the rate limit dropped right before this one
+    Uint32 mSuppressedCount;
+    Uint64 mTimestamp;
+    const LogCallSite *mSite;
+    const char *mFormat;
+    LogFormatFunction mFormatFunction;
+};
+
+static constexpr size_t cLogPayloadOffset = (sizeof(LogRecord) + 15) & ~static_cast<size_t>(15);
+
+struct LogStats {
+    Uint64 mWrittenCount;
+    // Records that didn't fit in their thread's buffer
+    Uint64 mDroppedCount;
+    // Records the per call site rate limit turned away
+    Uint64 mSuppressedCount;
+    // Messages that repeated the one before them and were folded into a count
+    Uint64 mDeduplicatedCount;
+};
+
+namespace LogDetail {
+    // Arguments are stored as they are, the printf default promotions happen when they're formatted
+    template <typename T>
+    struct Argument {
+        using Stored = T;
+
+        static inline size_t GetStringSize(const T &) {
+            return 0;
+        }
+
+        static inline Stored Encode(const T &inValue, Uint8 *, size_t &) {
+            return inValue;
+        }
+
+        static inline T Decode(const Stored &inValue, const Uint8 *) {
+            return inValue;
+        }
+    };
+
+    // The string a pointer refers to may be gone by the time the record is formatted, so strings are copied into the
+    // payload and stored as their offset
+    static constexpr size_t cMaxStringLength = 1024;
+
+    template <>
+    struct Argument<const char *> {
+        using Stored = Uint32;
+
+        static inline size_t GetStringSize(const char *inValue) {
+            return inValue != nullptr ? SDL_strnlen(inValue, cMaxStringLength) + 1 : 0;
+        }
+
+        static inline Stored Encode(const char *inValue, Uint8 *ioPayload, size_t &ioOffset) {
+            if (inValue == nullptr) {
+                return 0;
+            }
+
+            size_t length = SDL_strnlen(inValue, cMaxStringLength);
+            memcpy(ioPayload + ioOffset, inValue, length);
+            ioPayload[ioOffset + length] = 0;
+
+            Stored offset = static_cast<Stored>(ioOffset);
+            ioOffset += length + 1;
+            return offset;
+        }
+
+        static inline const char *Decode(const Stored &inValue, const Uint8 *inPayload) {
+            return inValue != 0 ? reinterpret_cast<const char *>(inPayload + inValue) : "(null)";
+        }
+    };
+
+    template <>
+    struct Argument<char *> : Argument<const char *> {};
+
+    template <typename T>
+    using ArgumentOf = Argument<std::decay_t<T>>;
+
+    template <typename... Args>
+    using Payload = std::tuple<typename ArgumentOf<Args>::Stored...>;
+
+    template <typename... Args>
+    int FormatRecord(char *outBuffer, size_t inSize, const char *inFormat, const Uint8 *inPayload) {
+        if constexpr (sizeof...(Args) == 0) {
+            return snprintf(outBuffer, inSize, "%s", inFormat);
+        } else {
+            const Payload<Args...> &payload = *reinterpret_cast<const Payload<Args...> *>(inPayload);
+            return std::apply([&](const auto &... inStored) {
+                return snprintf(outBuffer, inSize, inFormat, ArgumentOf<Args>::Decode(inStored, inPayload)...);
+            }, payload);
+        }
+    }
+}
+
+struct LogBuffer;
+
+// Log statements on any thread write their format string and arguments into a buffer owned by that thread, and a
+// background thread formats and prints them. Writing never takes a lock or waits: a full buffer drops the record.
+// Each call site is rate limited, and the writer folds runs of identical messages into a repeat count.
+// Before Initialize and after Shutdown messages are printed right away.
+class LogService {
+MAKE_SINGLETON(LogService)
+private:
+    std::atomic<bool> mIsRunning = false;
+    std::atomic<LogSeverity> mMinSeverity = LogSeverity::Info;
+
+    // Buffers are registered once per thread and live until shutdown
+    std::mutex mBufferMutex;
+    eastl::vector<LogBuffer *> mBuffers;
+
+    std::thread mWriterThread;
+    std::mutex mWriterMutex;
+    std::condition_variable mWriterCondition;
+    bool mIsFlushRequested = false;
+    Uint64 mDrainCount = 0;
+
+    std::atomic<Uint64> mWrittenCount = 0;
+    std::atomic<Uint64> mDroppedCount = 0;
+    std::atomic<Uint64> mSuppressedCount = 0;
+    std::atomic<Uint64> mDeduplicatedCount = 0;
+
+    // Writer state for folding repeated messages, only touched by the writer
+    const LogCallSite *mLastSite = nullptr;
+    eastl::string mLastMessage;
+    LogSeverity mLastSeverity = LogSeverity::Info;
+    Uint32 mRepeatCount = 0;
+    Uint64 mLastRepeatTime = 0;
+
+    // Check the call site's rate limit, the count is the number of messages it dropped since the last one it let through
+    bool Admit(LogCallSite &ioSite, Uint64 inTime, Uint32 &outSuppressedCount);
+
+    // Reserve space for a record in the calling thread's buffer, nullptr when it's full
+    LogRecord *BeginRecord(size_t inPayloadSize);
+    void CommitRecord();
+
+    void PrintNow(LogSeverity inSeverity, const char *inMessage);
+    void RunWriter();
+    void Drain();
+    void Output(const LogCallSite *inSite, LogSeverity inSeverity, Uint32 inSuppressedCount, const char *inMessage);
+    void FlushRepeats();
+
+public:
+    bool Initialize();
+    // Print everything that is still queued and stop the writer, the service can't be initialized again
+    void Shutdown();
+
+    // Block until everything logged before the call has been printed, meant for crashes and asserts
+    void Flush();
+
+    inline void SetMinSeverity(LogSeverity inSeverity) {
+        mMinSeverity.store(inSeverity, std::memory_order_relaxed);
+    }
+
+    inline LogSeverity GetMinSeverity() const {
+        return mMinSeverity.load(std::memory_order_relaxed);
+    }
+
+    LogStats GetStats() const;
+
+    template <typename... Args>
+    void Write(LogCallSite &ioSite, LogSeverity inSeverity, const char *inFormat, const Args &... inArgs) {
+        if (inSeverity < mMinSeverity.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        Uint64 timestamp = SDL_GetTicksNS();
+        Uint32 suppressed_count = 0;
+        if (!Admit(ioSite, timestamp, suppressed_count)) {
+            return;
+        }
+
+        if (!mIsRunning.load(std::memory_order_acquire)) {
+            char message[1024];
+            if constexpr (sizeof...(Args) == 0) {
+                snprintf(message, sizeof(message), "%s", inFormat);
+            } else {
+                snprintf(message, sizeof(message), inFormat, inArgs...);
+            }
+
+            PrintNow(inSeverity, message);
+            return;
+        }
+
+        size_t string_size = (static_cast<size_t>(0) + ... + LogDetail::ArgumentOf<Args>::GetStringSize(inArgs));
+        LogRecord *record = BeginRecord(sizeof(LogDetail::Payload<Args...>) + string_size);
+        if (record == nullptr) {
+            return;
+        }
+
+        record->mSeverity = inSeverity;
+        record->mSuppressedCount = suppressed_count;
+        record->mTimestamp = timestamp;
+        record->mSite = &ioSite;
+        record->mFormat = inFormat;
+        record->mFormatFunction = &LogDetail::FormatRecord<Args...>;
+
+        // Braced initialization evaluates left to right, so the strings land in argument order
+        Uint8 *payload = reinterpret_cast<Uint8 *>(record) + cLogPayloadOffset;
+        [[maybe_unused]] size_t string_offset = sizeof(LogDetail::Payload<Args...>);
+        new (payload) LogDetail::Payload<Args...> { LogDetail::ArgumentOf<Args>::Encode(inArgs, payload, string_offset)... };
+
+        CommitRecord();
+    }
+};
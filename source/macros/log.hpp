@@ -2,6 +2,32 @@
 
 #include <cstdio>
 
-// Some simple logging macros
-#define LOG_INFO(...) printf(__VA_ARGS__)
-#define LOG_ERROR(...) fprintf(stderr, __VA_ARGS__)
+#include "log/LogService.hpp"
+
+// Messages below this severity are compiled out, 0 keeps everything and 1 only keeps errors
+#ifndef LOG_MIN_SEVERITY
+#define LOG_MIN_SEVERITY 0
+#endif
+
+// Logging goes through the LogService, which formats and prints on its own thread.
+// The printf is never called, it only keeps the compiler checking formats against their arguments.
+#define LOG_WRITE(severity, ...) \
+    do { \
+        static LogCallSite log_call_site; \
+        if (false) { \
+            printf(__VA_ARGS__); \
+        } \
+        LogService::Get().Write(log_call_site, severity, __VA_ARGS__); \
+    } while (0)
+
+#if LOG_MIN_SEVERITY <= 0
+#define LOG_INFO(...) LOG_WRITE(LogSeverity::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MIN_SEVERITY <= 1
+#define LOG_ERROR(...) LOG_WRITE(LogSeverity::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
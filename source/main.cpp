@@ -19,25 +19,248 @@
 #include "physics/PhysicsManager.hpp"
 #include "Camera.hpp"
 #include "Scene.hpp"
+#include "SoftwareBenchmark.hpp"
+#include "TextureStreamingCheck.hpp"
+#include "ContentPackBenchmark.hpp"
+#include "TransformHierarchyBenchmark.hpp"
+#include "RegistryBenchmark.hpp"
+#include "PhysicsSnapshotBenchmark.hpp"
+#include "AllocationCheck.hpp"
 #include "InputService.hpp"
+#include "jobs/JobService.hpp"
+#include "jobs/TaskGraph.hpp"
+#include "io/FileService.hpp"
 
-#define EASTL_DEFINE_OPERATOR_IMPL(...) void *__cdecl operator new[](size_t size, __VA_ARGS__) { return new uint8_t[size]; }
+#include <EASTL/allocator.h>
+#include <EASTL/vector.h>
 
-// One-time definitions of operator new[] for EASTL
-EASTL_DEFINE_OPERATOR_IMPL(const char*, int, unsigned, const char*, int)
-EASTL_DEFINE_OPERATOR_IMPL(size_t, size_t, const char*, int, unsigned int, const char*, int)
+#include <cstdlib>
+#include <new>
 
-#include <EASTL/vector.h>
+#include "macros/log.hpp"
+#include "memory/MemoryService.hpp"
+
+// The global new and delete operators are replaced so every C++ allocation is accounted for
+// Allocations are tagged with the scope tag of the calling thread, see MemoryTagScope
+static void *GlobalAllocate(size_t size, size_t alignment, MemoryTag tag) {
+    void *pointer = MemoryService::Get().Allocate(size, alignment, tag);
+    if (pointer == nullptr) {
+        // Exceptions are disabled, so there is no std::bad_alloc to throw
+        abort();
+    }
+
+    return pointer;
+}
+
+void *operator new(size_t size) {
+    return GlobalAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, MemoryService::GetScopeTag());
+}
+
+void *operator new[](size_t size) {
+    return GlobalAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, MemoryService::GetScopeTag());
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    return GlobalAllocate(size, static_cast<size_t>(alignment), MemoryService::GetScopeTag());
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return GlobalAllocate(size, static_cast<size_t>(alignment), MemoryService::GetScopeTag());
+}
+
+void operator delete(void *ptr) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete[](void *ptr) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { MemoryService::Get().Free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { MemoryService::Get().Free(ptr); }
+
+// One-time definitions of operator new[] for EASTL, these honour the requested alignment
+void *operator new[](size_t size, const char *, int, unsigned, const char *, int) {
+    return GlobalAllocate(size, EASTL_SYSTEM_ALLOCATOR_MIN_ALIGNMENT, MemoryTag::Containers);
+}
+
+void *operator new[](size_t size, size_t alignment, size_t alignment_offset, const char *, int, unsigned, const char *, int) {
+    SDL_assert(alignment_offset == 0);
+    return GlobalAllocate(size, alignment, MemoryTag::Containers);
+}
+
+// Built by scripts/build-pack.py, read from next to the executable like the loose files it replaces
+static const char *cContentPackName = "content.pack";
 
 static Scene scene;
+static TaskGraph frame_graph;
+
+// Started by "--allocation-check <frames>", the game exits once those frames were checked for heap allocations
+static AllocationCheck allocation_check;
+
+// Set when one of the benchmarks or the texture streaming check ran instead of the game, nothing else was
+// initialized then
+static bool is_headless = false;
+
+// Time-to-first-frame measurement, the first frame has been presented once this is zero
+static Uint64 startup_begin_time = 0;
+
+static void LogStartupBreakdown(const TaskGraph &graph) {
+    LOG_INFO("Startup phases (start, duration):\n");
+    for (TaskID i = 0; i < graph.GetTaskCount(); i++) {
+        LOG_INFO(
+            "  %-16s %8.2f ms %8.2f ms\n",
+            graph.GetTaskName(i),
+            static_cast<double>(graph.GetTaskStartTime(i) - startup_begin_time) / 1e6,
+            static_cast<double>(graph.GetTaskTime(i)) / 1e6
+        );
+    }
+}
+
+// Find a flag on the command line. Flags with a value take the argument after them, a flag missing its value counts
+// as absent.
+static bool FindArgument(int argc, char **argv, const char *inName, bool inHasValue, const char **outValue) {
+    for (int i = 1; i + (inHasValue ? 1 : 0) < argc; i++) {
+        if (SDL_strcmp(argv[i], inName) == 0) {
+            *outValue = inHasValue ? argv[i + 1] : nullptr;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A benchmark or check that runs instead of the game and exits, nothing else is initialized for it
+struct HeadlessMode {
+    const char *mFlag;
+    bool mHasValue;
+    bool (*mRun)(const char *inValue);
+};
+
+static const HeadlessMode cHeadlessModes[] = {
+    // Update a large transform hierarchy with a few nodes moving every frame
+    { "--hierarchy-benchmark", false, [](const char *) {
+        return RunTransformHierarchyBenchmark(100000, 0.01f);
+    } },
+    // Iterate a million entities with ForEach and ParallelForEach
+    { "--registry-benchmark", false, [](const char *) {
+        return RunRegistryBenchmark(1000000);
+    } },
+    // Save and restore physics snapshots of worlds with more and more bodies
+    { "--snapshot-benchmark", false, [](const char *) {
+        const Uint32 body_counts[] = { 1000, 4000, 16000, 32000 };
+        return RunPhysicsSnapshotBenchmark(body_counts, SDL_arraysize(body_counts));
+    } },
+    // Read a content pack against the loose files it was built from
+    { "--pack-benchmark", true, [](const char *inValue) {
+        return RunContentPackBenchmark(inValue);
+    } },
+    // Render on the CPU and write the image to the given BMP file
+    { "--software", true, [](const char *inValue) {
+        return RunSoftwareBenchmark(inValue, 1270, 720);
+    } },
+    // Stream a cooked texture through a windowless device
+    { "--texture-check", true, [](const char *inValue) {
+        return RunTextureStreamingCheck(inValue);
+    } },
+};
+
+// MSAA sample count from "--msaa <1|2|4|8>", defaults to 4x
+static SDL_GPUSampleCount ParseSampleCount(int argc, char **argv) {
+    const char *value;
+    if (!FindArgument(argc, argv, "--msaa", true, &value)) {
+        return SDL_GPU_SAMPLECOUNT_4;
+    }
+
+    switch (SDL_atoi(value)) {
+        case 1: return SDL_GPU_SAMPLECOUNT_1;
+        case 2: return SDL_GPU_SAMPLECOUNT_2;
+        case 4: return SDL_GPU_SAMPLECOUNT_4;
+        case 8: return SDL_GPU_SAMPLECOUNT_8;
+        default:
+            LOG_ERROR("Unsupported MSAA sample count: %s\n", value);
+            return SDL_GPU_SAMPLECOUNT_4;
+    }
+}
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
+    // Before any SDL or Jolt call, so everything they allocate goes through the engine allocator
+    if (!MemoryService::Get().Install()) {
+        return SDL_APP_FAILURE;
+    }
+
+    // Start logging next, so nothing after this waits on printing
+    LogService::Get().Initialize();
+
+    // Content is read from the pack from here on, loose files are only read for what it doesn't have
+    eastl::string pack_path = Context::Get().GetBasePath() + cContentPackName;
+    if (SDL_GetPathInfo(pack_path.c_str(), nullptr)) {
+        FileService::Get().OpenPack(pack_path.c_str());
+    } else {
+        LOG_INFO("No content pack at %s, reading loose files\n", pack_path.c_str());
+    }
+
+    for (const HeadlessMode &mode : cHeadlessModes) {
+        const char *value;
+        if (FindArgument(argc, argv, mode.mFlag, mode.mHasValue, &value)) {
+            is_headless = true;
+            return mode.mRun(value) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        }
+    }
+
+    // Unlike the modes above this runs the game itself, so its frames are the real ones
+    const char *allocation_check_value;
+    if (FindArgument(argc, argv, "--allocation-check", true, &allocation_check_value)) {
+        allocation_check.Start(static_cast<Uint32>(SDL_max(SDL_atoi(allocation_check_value), 1)));
+    }
+
+    startup_begin_time = SDL_GetTicksNS();
 
     if (!Context::Get().Initialize({ "Cube Engine", 1270, 720 })) {
         return SDL_APP_FAILURE;
     }
 
-    scene.Initialize();
+    Uint64 context_time = SDL_GetTicksNS() - startup_begin_time;
+
+    // Startup as dependent tasks: physics and content import run on workers while the main thread creates the GPU device
+    TaskGraph startup_graph;
+    bool is_device_created = false;
+    bool are_pipelines_created = false;
+
+    SDL_GPUSampleCount sample_count = ParseSampleCount(argc, argv);
+
+    TaskID device_task = startup_graph.AddTask("GPU device", [&] {
+        is_device_created = RenderService::Get().Initialize(Context::Get().GetWindow(), sample_count);
+    }, {}, true);
+
+    TaskID physics_task = startup_graph.AddTask("Physics", [] { scene.InitializePhysics(); });
+    TaskID import_task = startup_graph.AddTask("Content import", [] { scene.Prepare(); });
+
+    TaskID pipelines_task = startup_graph.AddTask("Pipelines", [&] {
+        are_pipelines_created = is_device_created && RenderService::Get().CreatePipelines();
+    }, { device_task });
+
+    // RenderService, ContentManager and the texture streamer aren't thread-safe, so the scene uploads its meshes,
+    // textures and materials only once the pipelines are done with them
+    startup_graph.AddTask("Scene", [&] {
+        if (is_device_created) {
+            scene.Initialize();
+        }
+    }, { pipelines_task, physics_task, import_task });
+
+    startup_graph.Execute(JobService::Get());
+
+    LOG_INFO("Context initialized in %.2f ms\n", static_cast<double>(context_time) / 1e6);
+    LogStartupBreakdown(startup_graph);
+
+    if (!is_device_created || !are_pipelines_created) {
+        return SDL_APP_FAILURE;
+    }
+
+    // Describe a frame as a chain of tasks, drawing stays on the main thread since it owns the swapchain
+    TaskID input_task = frame_graph.AddTask("Input", [] { scene.UpdateInput(); });
+    TaskID streaming_task = frame_graph.AddTask("Streaming", [] { scene.UpdateStreaming(); }, { input_task });
+    TaskID physics_task = frame_graph.AddTask("Physics", [] { scene.UpdatePhysics(); }, { streaming_task });
+    TaskID transforms_task = frame_graph.AddTask("Transforms", [] { scene.UpdateTransforms(); }, { physics_task });
+    frame_graph.AddTask("Draw", [] { scene.Draw(); }, { transforms_task }, true);
 
     return SDL_APP_CONTINUE;
 }
@@ -54,11 +277,19 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         );
     }
 
-    scene.Update();
-    scene.Draw();
+    frame_graph.Execute(JobService::Get());
+
+    if (startup_begin_time != 0) {
+        LOG_INFO("Time to first frame: %.2f ms\n", static_cast<double>(SDL_GetTicksNS() - startup_begin_time) / 1e6);
+        startup_begin_time = 0;
+    }
 
     Context::Get().EndFrame();
 
+    if (allocation_check.IsActive() && allocation_check.EndFrame()) {
+        return allocation_check.Report() ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
     return SDL_APP_CONTINUE;
 }
 
@@ -68,29 +299,80 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
         case SDL_EVENT_QUIT:
             return SDL_APP_SUCCESS;
         case SDL_EVENT_MOUSE_MOTION:
-            InputService::Get().SetMousePosition(event->motion.x, event->motion.y);
-            InputService::Get().SetMouseDelta(event->motion.xrel, event->motion.yrel);
+            InputService::Get().SetMousePosition(event->motion.timestamp, event->motion.x, event->motion.y);
+            InputService::Get().AddMouseDelta(event->motion.xrel, event->motion.yrel);
             break;
         case SDL_EVENT_MOUSE_BUTTON_DOWN:
             if (event->button.button == SDL_BUTTON_LEFT) {
-                InputService::Get().SetLeftMouseDown(true);
+                InputService::Get().SetLeftMouseDown(event->button.timestamp, true);
             }
 
             if (event->button.button == SDL_BUTTON_RIGHT) {
-                InputService::Get().SetRightMouseDown(true);
+                InputService::Get().SetRightMouseDown(event->button.timestamp, true);
             }
             break;
         case SDL_EVENT_MOUSE_BUTTON_UP:
             if (event->button.button == SDL_BUTTON_LEFT) {
-                InputService::Get().SetLeftMouseDown(false);
+                InputService::Get().SetLeftMouseDown(event->button.timestamp, false);
             }
 
             if (event->button.button == SDL_BUTTON_RIGHT) {
-                InputService::Get().SetRightMouseDown(false);
+                InputService::Get().SetRightMouseDown(event->button.timestamp, false);
             }
             break;
         case SDL_EVENT_MOUSE_WHEEL:
-            InputService::Get().SetScrollY(event->wheel.y);
+            InputService::Get().AddScrollY(event->wheel.timestamp, event->wheel.y);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+            // F1 toggles the depth pre-pass, F2 measures how much overdraw it saves in the current view
+            if (event->key.key == SDLK_F1 && !event->key.repeat) {
+                bool is_enabled = !RenderService::Get().IsDepthPrepassEnabled();
+                RenderService::Get().SetDepthPrepassEnabled(is_enabled);
+                LOG_INFO("Depth pre-pass %s\n", is_enabled ? "enabled" : "disabled");
+            }
+
+            if (event->key.key == SDLK_F2 && !event->key.repeat) {
+                scene.RequestOverdrawMeasurement();
+            }
+
+            // F3 toggles dynamic resolution and reports how well it held the frame budget
+            if (event->key.key == SDLK_F3 && !event->key.repeat) {
+                ResolutionController &controller = RenderService::Get().GetResolutionController();
+                controller.LogStats();
+
+                controller.SetEnabled(!controller.IsEnabled());
+                LOG_INFO("Dynamic resolution %s\n", controller.IsEnabled() ? "enabled" : "disabled");
+            }
+
+            // F4 reports the input latency since the last report
+            if (event->key.key == SDLK_F4 && !event->key.repeat) {
+                RenderService::Get().LogInputLatency();
+            }
+
+            // F5 reports the contacts of the last physics step
+            if (event->key.key == SDLK_F5 && !event->key.repeat) {
+                scene.GetPhysicsManager().LogContactStats();
+            }
+
+            // F6 reports how much of the world is streamed in and how fast it's moving
+            if (event->key.key == SDLK_F6 && !event->key.repeat) {
+                scene.GetPhysicsStreamer().LogStats();
+            }
+
+            // F7 reports texture residency against the budget and how much streaming is behind
+            if (event->key.key == SDLK_F7 && !event->key.repeat) {
+                RenderService::Get().GetTextureStreamer().LogStats();
+            }
+
+            // F8 reports how much content came from the pack and how much from loose files
+            if (event->key.key == SDLK_F8 && !event->key.repeat) {
+                FileService::Get().LogStats();
+            }
+
+            // F9 reports what the last transform update cost
+            if (event->key.key == SDLK_F9 && !event->key.repeat) {
+                scene.LogTransformStats();
+            }
             break;
     }
 
@@ -98,7 +380,25 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 }
 
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
-    scene.Shutdown();
-    Context::Get().GetContent().Unload();
-    Context::Get().Shutdown();
+    if (!is_headless) {
+        scene.Shutdown();
+        Context::Get().GetContent().Unload();
+        Context::Get().Shutdown();
+    }
+
+    // Textures point into the pack, so it goes once they are all destroyed
+    FileService::Get().ClosePack();
+
+    LogStats log_stats = LogService::Get().GetStats();
+    if (log_stats.mDroppedCount > 0 || log_stats.mSuppressedCount > 0) {
+        LOG_INFO("Log dropped %llu messages on full buffers and %llu to the rate limit\n",
+            static_cast<unsigned long long>(log_stats.mDroppedCount),
+            static_cast<unsigned long long>(log_stats.mSuppressedCount));
+    }
+
+    // The log buffers are freed here and the report below is printed directly
+    LogService::Get().Shutdown();
+
+    // Anything still reported as live at this point has leaked
+    MemoryService::Get().LogReport();
 }
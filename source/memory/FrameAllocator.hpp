@@ -0,0 +1,43 @@
+#pragma once
+
+#include <EASTL/allocator.h>
+
+#include "FrameMemoryService.hpp"
+
+// EASTL allocator that places containers in frame memory, deallocation is a no-op since the arena is reset as a whole.
+// Containers using this must not outlive the frame after the one they were filled in.
+class FrameAllocator {
+private:
+    const char *mName;
+
+public:
+    FrameAllocator(const char *inName = "FrameAllocator") : mName(inName) {}
+    FrameAllocator(const FrameAllocator &, const char *inName) : mName(inName) {}
+
+    inline void *allocate(size_t inSize, int = 0) {
+        return FrameMemoryService::Get().Allocate(inSize, EASTL_ALLOCATOR_MIN_ALIGNMENT);
+    }
+
+    inline void *allocate(size_t inSize, size_t inAlignment, size_t inOffset, int = 0) {
+        SDL_assert(inOffset == 0);
+        return FrameMemoryService::Get().Allocate(inSize, inAlignment > EASTL_ALLOCATOR_MIN_ALIGNMENT ? inAlignment : EASTL_ALLOCATOR_MIN_ALIGNMENT);
+    }
+
+    inline void deallocate(void *, size_t) {}
+
+    inline const char *get_name() const {
+        return mName;
+    }
+
+    inline void set_name(const char *inName) {
+        mName = inName;
+    }
+};
+
+inline bool operator==(const FrameAllocator &, const FrameAllocator &) {
+    return true;
+}
+
+inline bool operator!=(const FrameAllocator &, const FrameAllocator &) {
+    return false;
+}
@@ -0,0 +1,23 @@
+#include "FrameMemoryService.hpp"
+
+bool FrameMemoryService::Initialize(size_t inCapacity) {
+    for (LinearArena &arena : mArenas) {
+        if (!arena.Initialize(inCapacity)) {
+            return false;
+        }
+    }
+
+    mFrameIndex = 0;
+    return true;
+}
+
+void FrameMemoryService::Shutdown() {
+    for (LinearArena &arena : mArenas) {
+        arena.Shutdown();
+    }
+}
+
+void FrameMemoryService::BeginFrame() {
+    mFrameIndex++;
+    mArenas[mFrameIndex & 1].Reset();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "macros/singleton.hpp"
+
+#include <SDL3/SDL.h>
+
+#include "LinearArena.hpp"
+
+// Hands out transient memory that is valid for the current frame and the one after it.
+// Two arenas are alternated, and each is reset when it comes back around, which makes resetting free.
+class FrameMemoryService {
+MAKE_SINGLETON(FrameMemoryService)
+private:
+    LinearArena mArenas[2];
+    Uint32 mFrameIndex = 0;
+
+public:
+    bool Initialize(size_t inCapacity);
+    void Shutdown();
+
+    // Swap arenas and release everything that was allocated two frames ago
+    void BeginFrame();
+
+    inline void *Allocate(size_t inSize, size_t inAlignment) {
+        return mArenas[mFrameIndex & 1].Allocate(inSize, inAlignment);
+    }
+
+    template <typename T>
+    inline T *Allocate(size_t inCount = 1) {
+        return static_cast<T *>(Allocate(sizeof(T) * inCount, alignof(T)));
+    }
+
+    inline const LinearArena &GetCurrentArena() const {
+        return mArenas[mFrameIndex & 1];
+    }
+
+    // Allocations of both arenas that didn't fit and went to the heap
+    inline size_t GetTotalOverflowCount() const {
+        return mArenas[0].GetTotalOverflowCount() + mArenas[1].GetTotalOverflowCount();
+    }
+};
@@ -0,0 +1,74 @@
+#include "LinearArena.hpp"
+
+#include "macros/log.hpp"
+
+#include "MemoryService.hpp"
+
+bool LinearArena::Initialize(size_t inCapacity) {
+    mMemory = static_cast<Uint8 *>(MemoryService::Get().Allocate(inCapacity, SDL_SIMDGetAlignment(), MemoryTag::Frame));
+    if (mMemory == nullptr) {
+        LOG_ERROR("Unable to allocate linear arena of %zu bytes\n", inCapacity);
+        return false;
+    }
+
+    mCapacity = inCapacity;
+    mOffset = 0;
+    mPeakOffset = 0;
+    mTotalOverflowCount = 0;
+
+    return true;
+}
+
+void LinearArena::Shutdown() {
+    Reset();
+
+    MemoryService::Get().Free(mMemory);
+    mMemory = nullptr;
+    mCapacity = 0;
+}
+
+void *LinearArena::Allocate(size_t inSize, size_t inAlignment) {
+    SDL_assert(inAlignment != 0 && (inAlignment & (inAlignment - 1)) == 0);
+
+    // Align the address rather than the offset, so alignments larger than the base alignment also work
+    uintptr_t base = reinterpret_cast<uintptr_t>(mMemory);
+    size_t current_offset = mOffset.load(std::memory_order_relaxed);
+
+    while (mMemory != nullptr) {
+        uintptr_t aligned = (base + current_offset + inAlignment - 1) & ~(static_cast<uintptr_t>(inAlignment) - 1);
+        size_t offset = static_cast<size_t>(aligned - base);
+
+        if (offset + inSize > mCapacity) {
+            break;
+        }
+
+        // Another thread may have bumped the offset in the meantime, in which case try again from the new offset
+        if (mOffset.compare_exchange_weak(current_offset, offset + inSize, std::memory_order_relaxed)) {
+            size_t peak_offset = mPeakOffset.load(std::memory_order_relaxed);
+            while (offset + inSize > peak_offset && !mPeakOffset.compare_exchange_weak(peak_offset, offset + inSize, std::memory_order_relaxed)) {}
+
+            return mMemory + offset;
+        }
+    }
+
+    // Out of space, hand out a heap block that lives until the next reset
+    void *block = MemoryService::Get().Allocate(inSize, inAlignment, MemoryTag::Frame);
+    if (block != nullptr) {
+        std::lock_guard lock(mOverflowMutex);
+        mOverflowBlocks.push_back(block);
+        mOverflowCount++;
+        mTotalOverflowCount++;
+    }
+
+    return block;
+}
+
+void LinearArena::Reset() {
+    for (void *block : mOverflowBlocks) {
+        MemoryService::Get().Free(block);
+    }
+
+    mOverflowBlocks.clear();
+    mOverflowCount = 0;
+    mOffset = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <EASTL/vector.h>
+
+#include <atomic>
+#include <mutex>
+
+// A bump allocator over a single block of memory, individual allocations are never freed, only the whole arena is reset.
+// When the block runs out, allocations fall back to the heap and are released on the next reset.
+// Allocating is safe from any thread, resetting is not and must happen while nothing else allocates.
+class LinearArena {
+private:
+    Uint8 *mMemory = nullptr;
+    size_t mCapacity = 0;
+    std::atomic<size_t> mOffset = 0;
+    std::atomic<size_t> mPeakOffset = 0;
+
+    std::mutex mOverflowMutex;
+    eastl::vector<void *> mOverflowBlocks;
+    size_t mOverflowCount = 0;
+    size_t mTotalOverflowCount = 0;
+
+public:
+    bool Initialize(size_t inCapacity);
+    void Shutdown();
+
+    void *Allocate(size_t inSize, size_t inAlignment);
+    void Reset();
+
+    inline size_t GetCapacity() const {
+        return mCapacity;
+    }
+
+    inline size_t GetUsedSize() const {
+        return mOffset;
+    }
+
+    inline size_t GetPeakSize() const {
+        return mPeakOffset;
+    }
+
+    // Number of allocations that didn't fit and went to the heap since the last reset
+    inline size_t GetOverflowCount() const {
+        return mOverflowCount;
+    }
+
+    // Number of allocations that went to the heap since the arena was initialized
+    inline size_t GetTotalOverflowCount() const {
+        return mTotalOverflowCount;
+    }
+};
@@ -0,0 +1,240 @@
+#include "MemoryService.hpp"
+
+#include "macros/log.hpp"
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/Memory.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Stored right in front of every allocation
+struct AllocationHeader {
+    void *mBlock;
+    size_t mSize;
+    MemoryTag mTag;
+};
+
+static constexpr size_t cMinAlignment = 16;
+
+static thread_local MemoryTag sScopeTag = MemoryTag::General;
+
+static inline AllocationHeader *GetHeader(void *inPointer) {
+    return reinterpret_cast<AllocationHeader *>(static_cast<Uint8 *>(inPointer) - sizeof(AllocationHeader));
+}
+
+// SDL memory functions, everything SDL allocates is accounted to rendering
+static void *SDLCALL SDLMalloc(size_t inSize) {
+    return MemoryService::Get().Allocate(inSize, cMinAlignment, MemoryTag::Render);
+}
+
+static void *SDLCALL SDLCalloc(size_t inCount, size_t inSize) {
+    // Like calloc, a total size that doesn't fit fails instead of wrapping around to a smaller allocation
+    if (inSize != 0 && inCount > SIZE_MAX / inSize) {
+        return nullptr;
+    }
+
+    void *pointer = MemoryService::Get().Allocate(inCount * inSize, cMinAlignment, MemoryTag::Render);
+    if (pointer != nullptr) {
+        memset(pointer, 0, inCount * inSize);
+    }
+
+    return pointer;
+}
+
+static void *SDLCALL SDLRealloc(void *inPointer, size_t inSize) {
+    return MemoryService::Get().Reallocate(inPointer, inSize, MemoryTag::Render);
+}
+
+static void SDLCALL SDLFree(void *inPointer) {
+    MemoryService::Get().Free(inPointer);
+}
+
+// Jolt memory functions
+static void *JoltAllocate(size_t inSize) {
+    return MemoryService::Get().Allocate(inSize, cMinAlignment, MemoryTag::Physics);
+}
+
+static void *JoltReallocate(void *inBlock, size_t, size_t inNewSize) {
+    return MemoryService::Get().Reallocate(inBlock, inNewSize, MemoryTag::Physics);
+}
+
+static void JoltFree(void *inBlock) {
+    MemoryService::Get().Free(inBlock);
+}
+
+static void *JoltAlignedAllocate(size_t inSize, size_t inAlignment) {
+    return MemoryService::Get().Allocate(inSize, inAlignment, MemoryTag::Physics);
+}
+
+static void JoltAlignedFree(void *inBlock) {
+    MemoryService::Get().Free(inBlock);
+}
+
+bool MemoryService::Install() {
+    if (!SDL_SetMemoryFunctions(SDLMalloc, SDLCalloc, SDLRealloc, SDLFree)) {
+        return false;
+    }
+
+    JPH::Allocate = JoltAllocate;
+    JPH::Reallocate = JoltReallocate;
+    JPH::Free = JoltFree;
+    JPH::AlignedAllocate = JoltAlignedAllocate;
+    JPH::AlignedFree = JoltAlignedFree;
+
+    return true;
+}
+
+void *MemoryService::Allocate(size_t inSize, size_t inAlignment, MemoryTag inTag) {
+    if (inAlignment < cMinAlignment) {
+        inAlignment = cMinAlignment;
+    }
+
+    // Reserve enough space to both align the pointer and fit the header in front of it
+    void *block = malloc(inSize + inAlignment + sizeof(AllocationHeader));
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(block) + sizeof(AllocationHeader);
+    uintptr_t aligned = (start + inAlignment - 1) & ~(static_cast<uintptr_t>(inAlignment) - 1);
+    void *pointer = reinterpret_cast<void *>(aligned);
+
+    AllocationHeader *header = GetHeader(pointer);
+    header->mBlock = block;
+    header->mSize = inSize;
+    header->mTag = inTag;
+
+    TagCounters &counters = mCounters[static_cast<size_t>(inTag)];
+    Uint64 current = counters.mCurrentBytes.fetch_add(inSize, std::memory_order_relaxed) + inSize;
+    counters.mLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.mTotalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    Uint64 peak = counters.mPeakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !counters.mPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+
+    return pointer;
+}
+
+void *MemoryService::Reallocate(void *inPointer, size_t inSize, MemoryTag inTag) {
+    if (inPointer == nullptr) {
+        return Allocate(inSize, cMinAlignment, inTag);
+    }
+
+    // Keep the original tag, the block just changes size
+    AllocationHeader *header = GetHeader(inPointer);
+    void *pointer = Allocate(inSize, cMinAlignment, header->mTag);
+    if (pointer == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(pointer, inPointer, header->mSize < inSize ? header->mSize : inSize);
+    Free(inPointer);
+
+    return pointer;
+}
+
+void MemoryService::Free(void *inPointer) {
+    if (inPointer == nullptr) {
+        return;
+    }
+
+    AllocationHeader *header = GetHeader(inPointer);
+
+    TagCounters &counters = mCounters[static_cast<size_t>(header->mTag)];
+    counters.mCurrentBytes.fetch_sub(header->mSize, std::memory_order_relaxed);
+    counters.mLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+    free(header->mBlock);
+}
+
+void MemoryService::UpdateGPUPeak() {
+    Uint64 current = mGPUBufferBytes.load(std::memory_order_relaxed) + mGPUTextureBytes.load(std::memory_order_relaxed);
+    Uint64 peak = mGPUPeakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !mGPUPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+}
+
+void MemoryService::TrackGPUBuffer(Sint64 inBytes) {
+    mGPUBufferBytes.fetch_add(static_cast<Uint64>(inBytes), std::memory_order_relaxed);
+    UpdateGPUPeak();
+}
+
+void MemoryService::TrackGPUTexture(Sint64 inBytes) {
+    mGPUTextureBytes.fetch_add(static_cast<Uint64>(inBytes), std::memory_order_relaxed);
+    UpdateGPUPeak();
+}
+
+MemoryTagStats MemoryService::GetTagStats(MemoryTag inTag) const {
+    const TagCounters &counters = mCounters[static_cast<size_t>(inTag)];
+
+    return {
+        .mCurrentBytes = counters.mCurrentBytes.load(std::memory_order_relaxed),
+        .mPeakBytes = counters.mPeakBytes.load(std::memory_order_relaxed),
+        .mLiveAllocations = counters.mLiveAllocations.load(std::memory_order_relaxed),
+        .mTotalAllocations = counters.mTotalAllocations.load(std::memory_order_relaxed),
+        .mBudgetBytes = counters.mBudgetBytes.load(std::memory_order_relaxed),
+    };
+}
+
+GPUMemoryStats MemoryService::GetGPUStats() const {
+    return {
+        .mBufferBytes = mGPUBufferBytes.load(std::memory_order_relaxed),
+        .mTextureBytes = mGPUTextureBytes.load(std::memory_order_relaxed),
+        .mPeakBytes = mGPUPeakBytes.load(std::memory_order_relaxed),
+    };
+}
+
+void MemoryService::SetBudget(MemoryTag inTag, Uint64 inBytes) {
+    mCounters[static_cast<size_t>(inTag)].mBudgetBytes = inBytes;
+}
+
+bool MemoryService::IsOverBudget(MemoryTag inTag) const {
+    const TagCounters &counters = mCounters[static_cast<size_t>(inTag)];
+    Uint64 budget = counters.mBudgetBytes.load(std::memory_order_relaxed);
+
+    return budget != 0 && counters.mCurrentBytes.load(std::memory_order_relaxed) > budget;
+}
+
+void MemoryService::LogReport() const {
+    LOG_INFO("Memory report:\n");
+
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::Count); i++) {
+        MemoryTag tag = static_cast<MemoryTag>(i);
+        MemoryTagStats stats = GetTagStats(tag);
+
+        LOG_INFO("  %-10s current %10llu B, peak %10llu B, live %8llu, total %10llu\n",
+            GetTagName(tag),
+            static_cast<unsigned long long>(stats.mCurrentBytes),
+            static_cast<unsigned long long>(stats.mPeakBytes),
+            static_cast<unsigned long long>(stats.mLiveAllocations),
+            static_cast<unsigned long long>(stats.mTotalAllocations));
+    }
+
+    GPUMemoryStats gpu_stats = GetGPUStats();
+    LOG_INFO("  %-10s buffers %10llu B, textures %10llu B, peak %10llu B\n",
+        "GPU",
+        static_cast<unsigned long long>(gpu_stats.mBufferBytes),
+        static_cast<unsigned long long>(gpu_stats.mTextureBytes),
+        static_cast<unsigned long long>(gpu_stats.mPeakBytes));
+}
+
+const char *MemoryService::GetTagName(MemoryTag inTag) {
+    switch (inTag) {
+        case MemoryTag::General: return "General";
+        case MemoryTag::Physics: return "Physics";
+        case MemoryTag::Content: return "Content";
+        case MemoryTag::Render: return "Render";
+        case MemoryTag::Containers: return "Containers";
+        case MemoryTag::Frame: return "Frame";
+        default: return "Unknown";
+    }
+}
+
+MemoryTag MemoryService::GetScopeTag() {
+    return sScopeTag;
+}
+
+void MemoryService::SetScopeTag(MemoryTag inTag) {
+    sScopeTag = inTag;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "macros/singleton.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+
+// Subsystem that an allocation is accounted to
+enum class MemoryTag : Uint8 {
+    General,
+    Physics,
+    Content,
+    Render,
+    Containers,
+    Frame,
+    Count
+};
+
+struct MemoryTagStats {
+    Uint64 mCurrentBytes;
+    Uint64 mPeakBytes;
+    Uint64 mLiveAllocations;
+    Uint64 mTotalAllocations;
+    // Zero means the tag has no budget
+    Uint64 mBudgetBytes;
+};
+
+// Estimated from creation sizes, the driver may use more due to alignment and padding
+struct GPUMemoryStats {
+    Uint64 mBufferBytes;
+    Uint64 mTextureBytes;
+    Uint64 mPeakBytes;
+};
+
+// Every heap allocation in the engine goes through here: Jolt, EASTL, SDL and the global new/delete operators.
+// Each allocation carries a small header with its size and tag, so frees are accounted without any lookups.
+class MemoryService {
+MAKE_SINGLETON(MemoryService)
+private:
+    struct TagCounters {
+        std::atomic<Uint64> mCurrentBytes;
+        std::atomic<Uint64> mPeakBytes;
+        std::atomic<Uint64> mLiveAllocations;
+        std::atomic<Uint64> mTotalAllocations;
+        std::atomic<Uint64> mBudgetBytes;
+    };
+
+    TagCounters mCounters[static_cast<size_t>(MemoryTag::Count)] = {};
+
+    std::atomic<Uint64> mGPUBufferBytes = 0;
+    std::atomic<Uint64> mGPUTextureBytes = 0;
+    std::atomic<Uint64> mGPUPeakBytes = 0;
+
+    void UpdateGPUPeak();
+
+public:
+    // Route SDL and Jolt through the engine allocator. Called first thing in SDL_AppInit, since blocks SDL or Jolt
+    // allocate before this would later be freed by the wrong allocator.
+    bool Install();
+
+    void *Allocate(size_t inSize, size_t inAlignment, MemoryTag inTag);
+    void *Reallocate(void *inPointer, size_t inSize, MemoryTag inTag);
+    void Free(void *inPointer);
+
+    void TrackGPUBuffer(Sint64 inBytes);
+    void TrackGPUTexture(Sint64 inBytes);
+
+    MemoryTagStats GetTagStats(MemoryTag inTag) const;
+    GPUMemoryStats GetGPUStats() const;
+
+    void SetBudget(MemoryTag inTag, Uint64 inBytes);
+    bool IsOverBudget(MemoryTag inTag) const;
+
+    void LogReport() const;
+
+    static const char *GetTagName(MemoryTag inTag);
+
+    // Tag used by the global new operators on the current thread, see MemoryTagScope
+    static MemoryTag GetScopeTag();
+    static void SetScopeTag(MemoryTag inTag);
+};
+
+// Accounts all global new allocations on this thread to a tag for as long as the scope lives
+class MemoryTagScope {
+private:
+    MemoryTag mPreviousTag;
+
+public:
+    explicit MemoryTagScope(MemoryTag inTag) : mPreviousTag(MemoryService::GetScopeTag()) {
+        MemoryService::SetScopeTag(inTag);
+    }
+
+    ~MemoryTagScope() {
+        MemoryService::SetScopeTag(mPreviousTag);
+    }
+
+    MemoryTagScope(const MemoryTagScope &) = delete;
+    MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+};
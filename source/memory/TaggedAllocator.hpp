@@ -0,0 +1,48 @@
+#pragma once
+
+#include <EASTL/allocator.h>
+
+#include "MemoryService.hpp"
+
+// EASTL allocator that accounts a container's memory to a tag, for containers that live on the heap long enough to
+// be worth telling apart from the other containers
+template <MemoryTag Tag>
+class TaggedAllocator {
+private:
+    const char *mName;
+
+public:
+    TaggedAllocator(const char *inName = "TaggedAllocator") : mName(inName) {}
+    TaggedAllocator(const TaggedAllocator &, const char *inName) : mName(inName) {}
+
+    inline void *allocate(size_t inSize, int = 0) {
+        return MemoryService::Get().Allocate(inSize, EASTL_ALLOCATOR_MIN_ALIGNMENT, Tag);
+    }
+
+    inline void *allocate(size_t inSize, size_t inAlignment, size_t inOffset, int = 0) {
+        SDL_assert(inOffset == 0);
+        return MemoryService::Get().Allocate(inSize, inAlignment > EASTL_ALLOCATOR_MIN_ALIGNMENT ? inAlignment : EASTL_ALLOCATOR_MIN_ALIGNMENT, Tag);
+    }
+
+    inline void deallocate(void *inPointer, size_t) {
+        MemoryService::Get().Free(inPointer);
+    }
+
+    inline const char *get_name() const {
+        return mName;
+    }
+
+    inline void set_name(const char *inName) {
+        mName = inName;
+    }
+};
+
+template <MemoryTag Tag>
+inline bool operator==(const TaggedAllocator<Tag> &, const TaggedAllocator<Tag> &) {
+    return true;
+}
+
+template <MemoryTag Tag>
+inline bool operator!=(const TaggedAllocator<Tag> &, const TaggedAllocator<Tag> &) {
+    return false;
+}
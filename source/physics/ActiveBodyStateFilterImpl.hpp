@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/Body.h>
+#include <Jolt/Physics/StateRecorder.h>
+
+/// Only saves bodies that are currently awake, used for delta snapshots since sleeping bodies don't change
+class ActiveBodyStateFilterImpl final : public JPH::StateRecorderFilter
+{
+public:
+    virtual bool ShouldSaveBody(const JPH::Body &inBody) const override {
+        return inBody.IsActive();
+    }
+};
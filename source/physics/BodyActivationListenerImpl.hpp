@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/Mutex.h>
+#include <Jolt/Physics/Body/BodyActivationListener.h>
+
+#include <EASTL/vector.h>
+
+#include <mutex>
+
+/// Keeps track of the set of active bodies, and of the bodies that went to sleep since the last collection.
+/// Jolt calls these callbacks from job threads during PhysicsSystem::Update, hence the mutex.
+class BodyActivationListenerImpl final : public JPH::BodyActivationListener
+{
+private:
+    static constexpr JPH::uint32 cInvalidSlot = 0xffffffff;
+
+    mutable JPH::Mutex mMutex;
+
+    eastl::vector<JPH::BodyID> mActiveBodies;
+    eastl::vector<JPH::BodyID> mDeactivatedBodies;
+
+    // Position of each body in mActiveBodies, indexed by body index
+    eastl::vector<JPH::uint32> mActiveSlots;
+
+public:
+    virtual void OnBodyActivated(const JPH::BodyID &inBodyID, JPH::uint64) override {
+        std::lock_guard lock(mMutex);
+
+        JPH::uint32 index = inBodyID.GetIndex();
+        if (index >= mActiveSlots.size()) {
+            mActiveSlots.resize(index + 1, cInvalidSlot);
+        }
+
+        if (mActiveSlots[index] == cInvalidSlot) {
+            mActiveSlots[index] = static_cast<JPH::uint32>(mActiveBodies.size());
+            mActiveBodies.push_back(inBodyID);
+        }
+    }
+
+    virtual void OnBodyDeactivated(const JPH::BodyID &inBodyID, JPH::uint64) override {
+        std::lock_guard lock(mMutex);
+
+        JPH::uint32 index = inBodyID.GetIndex();
+        if (index >= mActiveSlots.size() || mActiveSlots[index] == cInvalidSlot) {
+            return;
+        }
+
+        // Swap-remove the body from the active set
+        JPH::uint32 slot = mActiveSlots[index];
+        JPH::BodyID last = mActiveBodies.back();
+        mActiveBodies[slot] = last;
+        mActiveSlots[last.GetIndex()] = slot;
+        mActiveBodies.pop_back();
+        mActiveSlots[index] = cInvalidSlot;
+
+        // The body still moved during the step it fell asleep in
+        mDeactivatedBodies.push_back(inBodyID);
+    }
+
+    /// Collect all bodies that moved since the last call, this is the active set plus the bodies that just went to sleep
+    void CollectMovedBodies(eastl::vector<JPH::BodyID> &outBodies) {
+        std::lock_guard lock(mMutex);
+
+        outBodies.clear();
+        outBodies.insert(outBodies.end(), mActiveBodies.begin(), mActiveBodies.end());
+        outBodies.insert(outBodies.end(), mDeactivatedBodies.begin(), mDeactivatedBodies.end());
+        mDeactivatedBodies.clear();
+    }
+
+    // Locks too, since bodies can be activated from other threads while the count is read
+    inline size_t GetActiveBodyCount() const {
+        std::lock_guard lock(mMutex);
+        return mActiveBodies.size();
+    }
+};
@@ -0,0 +1,232 @@
+#include "ContactListenerImpl.hpp"
+
+#include "macros/log.hpp"
+
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+
+#include <EASTL/sort.h>
+
+#include <SDL3/SDL_timer.h>
+
+#include <mutex>
+
+// Events each thread can record per step, the rest are counted as dropped
+static constexpr JPH::uint32 cThreadBufferCapacity = 16 * 1024;
+
+// Listeners are told apart by generation, so a thread never writes into a buffer of a listener that is gone
+static std::atomic<JPH::uint32> sNextGeneration = 1;
+
+struct ThreadBufferCache {
+    JPH::uint32 mGeneration = 0;
+    void *mBuffer = nullptr;
+};
+
+static thread_local ThreadBufferCache tBufferCache;
+
+static inline bool IsInLayerMask(JPH::uint32 inMask, JPH::ObjectLayer inLayer) {
+    return inLayer < 32 && (inMask & (1u << inLayer)) != 0;
+}
+
+static inline JPH::Vec3 GetPointVelocity(const JPH::Body &inBody, JPH::RVec3Arg inPoint) {
+    return inBody.IsStatic() ? JPH::Vec3::sZero() : inBody.GetPointVelocity(inPoint);
+}
+
+static inline float GetInverseMass(const JPH::Body &inBody) {
+    return inBody.IsDynamic() ? inBody.GetMotionProperties()->GetInverseMass() : 0.0f;
+}
+
+ContactListenerImpl::ContactListenerImpl() : mGeneration(sNextGeneration.fetch_add(1, std::memory_order_relaxed)) {}
+
+ContactListenerImpl::~ContactListenerImpl() {
+    for (ThreadBuffer *buffer : mBuffers) {
+        delete buffer;
+    }
+}
+
+ContactListenerImpl::ThreadBuffer &ContactListenerImpl::GetThreadBuffer() {
+    if (tBufferCache.mGeneration == mGeneration) {
+        return *static_cast<ThreadBuffer *>(tBufferCache.mBuffer);
+    }
+
+    // First contact on this thread, the buffer is sized up front so recording never allocates
+    ThreadBuffer *buffer = new ThreadBuffer();
+    buffer->mEvents.resize(cThreadBufferCapacity);
+
+    {
+        std::lock_guard lock(mBufferMutex);
+        mBuffers.push_back(buffer);
+    }
+
+    tBufferCache.mGeneration = mGeneration;
+    tBufferCache.mBuffer = buffer;
+    return *buffer;
+}
+
+void ContactListenerImpl::Record(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, ContactEventType inType) {
+    JPH::uint64 start_time = SDL_GetTicksNS();
+    ThreadBuffer &buffer = GetThreadBuffer();
+
+    if (inType == ContactEventType::Persisted && !mFilter.mReportPersisted) {
+        buffer.mFilteredCount++;
+        buffer.mTime += SDL_GetTicksNS() - start_time;
+        return;
+    }
+
+    JPH::ObjectLayer layer1 = inBody1.GetObjectLayer();
+    JPH::ObjectLayer layer2 = inBody2.GetObjectLayer();
+    if (!IsInLayerMask(mFilter.mLayerMask, layer1) && !IsInLayerMask(mFilter.mLayerMask, layer2)) {
+        buffer.mFilteredCount++;
+        buffer.mTime += SDL_GetTicksNS() - start_time;
+        return;
+    }
+
+    JPH::RVec3 point = inManifold.GetWorldSpaceContactPointOn1(0);
+    JPH::Vec3 normal = inManifold.mWorldSpaceNormal;
+
+    // The normal points from body 1 to body 2, so approaching bodies have a negative relative velocity along it
+    JPH::Vec3 relative_velocity = GetPointVelocity(inBody2, point) - GetPointVelocity(inBody1, point);
+    float closing_speed = -relative_velocity.Dot(normal);
+    float inverse_mass = GetInverseMass(inBody1) + GetInverseMass(inBody2);
+    float impulse = closing_speed > 0.0f && inverse_mass > 0.0f ? closing_speed / inverse_mass : 0.0f;
+
+    if (impulse < mFilter.mMinImpulse) {
+        buffer.mFilteredCount++;
+        buffer.mTime += SDL_GetTicksNS() - start_time;
+        return;
+    }
+
+    if (inType == ContactEventType::Added) {
+        buffer.mAddedCount++;
+    } else {
+        buffer.mPersistedCount++;
+    }
+
+    if (buffer.mCount >= cThreadBufferCapacity) {
+        buffer.mDroppedCount++;
+        buffer.mTime += SDL_GetTicksNS() - start_time;
+        return;
+    }
+
+    ContactEvent &event = buffer.mEvents[buffer.mCount++];
+    bool is_swapped = inBody2.GetID() < inBody1.GetID();
+    event.mBody1 = is_swapped ? inBody2.GetID() : inBody1.GetID();
+    event.mBody2 = is_swapped ? inBody1.GetID() : inBody2.GetID();
+    JPH::Vec3(point).StoreFloat3(&event.mPosition);
+    (is_swapped ? -normal : normal).StoreFloat3(&event.mNormal);
+    event.mImpulse = impulse;
+    event.mLayer1 = is_swapped ? layer2 : layer1;
+    event.mLayer2 = is_swapped ? layer1 : layer2;
+    event.mType = inType;
+
+    buffer.mTime += SDL_GetTicksNS() - start_time;
+}
+
+void ContactListenerImpl::OnContactAdded(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &) {
+    Record(inBody1, inBody2, inManifold, ContactEventType::Added);
+}
+
+void ContactListenerImpl::OnContactPersisted(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &) {
+    Record(inBody1, inBody2, inManifold, ContactEventType::Persisted);
+}
+
+void ContactListenerImpl::OnContactRemoved(const JPH::SubShapeIDPair &inSubShapePair) {
+    JPH::uint64 start_time = SDL_GetTicksNS();
+    ThreadBuffer &buffer = GetThreadBuffer();
+
+    // Layers can't be read here without locking the bodies, so removals are filtered when they're collected
+    buffer.mRemovedCount++;
+
+    if (buffer.mCount >= cThreadBufferCapacity) {
+        buffer.mDroppedCount++;
+        buffer.mTime += SDL_GetTicksNS() - start_time;
+        return;
+    }
+
+    JPH::BodyID body1 = inSubShapePair.GetBody1ID();
+    JPH::BodyID body2 = inSubShapePair.GetBody2ID();
+
+    ContactEvent &event = buffer.mEvents[buffer.mCount++];
+    event.mBody1 = body2 < body1 ? body2 : body1;
+    event.mBody2 = body2 < body1 ? body1 : body2;
+    event.mPosition = JPH::Float3(0.0f, 0.0f, 0.0f);
+    event.mNormal = JPH::Float3(0.0f, 0.0f, 0.0f);
+    event.mImpulse = 0.0f;
+    event.mLayer1 = JPH::cObjectLayerInvalid;
+    event.mLayer2 = JPH::cObjectLayerInvalid;
+    event.mType = ContactEventType::Removed;
+
+    buffer.mTime += SDL_GetTicksNS() - start_time;
+}
+
+void ContactListenerImpl::Collect(const JPH::BodyLockInterface &inBodyLockInterface) {
+    JPH::uint64 start_time = SDL_GetTicksNS();
+
+    mEvents.clear();
+    mStats = {};
+
+    for (ThreadBuffer *buffer : mBuffers) {
+        for (JPH::uint32 i = 0; i < buffer->mCount; i++) {
+            ContactEvent &event = buffer->mEvents[i];
+
+            if (event.mType == ContactEventType::Removed) {
+                // A body that was destroyed during the step keeps its invalid layer, its removal still matters
+                for (JPH::uint32 side = 0; side < 2; side++) {
+                    JPH::BodyLockRead lock(inBodyLockInterface, side == 0 ? event.mBody1 : event.mBody2);
+                    if (lock.Succeeded()) {
+                        (side == 0 ? event.mLayer1 : event.mLayer2) = lock.GetBody().GetObjectLayer();
+                    }
+                }
+
+                bool is_known = event.mLayer1 != JPH::cObjectLayerInvalid && event.mLayer2 != JPH::cObjectLayerInvalid;
+                if (is_known && !IsInLayerMask(mFilter.mLayerMask, event.mLayer1) && !IsInLayerMask(mFilter.mLayerMask, event.mLayer2)) {
+                    mStats.mFilteredCount++;
+                    continue;
+                }
+            }
+
+            mEvents.push_back(event);
+        }
+
+        mStats.mAddedCount += buffer->mAddedCount;
+        mStats.mPersistedCount += buffer->mPersistedCount;
+        mStats.mRemovedCount += buffer->mRemovedCount;
+        mStats.mFilteredCount += buffer->mFilteredCount;
+        mStats.mDroppedCount += buffer->mDroppedCount;
+        mStats.mListenerTime += buffer->mTime;
+
+        // The events stay allocated for the next step
+        buffer->mCount = 0;
+        buffer->mAddedCount = 0;
+        buffer->mPersistedCount = 0;
+        buffer->mRemovedCount = 0;
+        buffer->mFilteredCount = 0;
+        buffer->mDroppedCount = 0;
+        buffer->mTime = 0;
+    }
+
+    eastl::sort(mEvents.begin(), mEvents.end(), [](const ContactEvent &inA, const ContactEvent &inB) {
+        if (inA.mBody1 != inB.mBody1) {
+            return inA.mBody1 < inB.mBody1;
+        }
+
+        if (inA.mBody2 != inB.mBody2) {
+            return inA.mBody2 < inB.mBody2;
+        }
+
+        return inA.mType < inB.mType;
+    });
+
+    mStats.mMergeTime = SDL_GetTicksNS() - start_time;
+}
+
+void ContactListenerImpl::LogStats() const {
+    LOG_INFO("Contacts: %llu added, %llu persisted, %llu removed, %llu filtered, %llu dropped, listener %.3f ms, merge %.3f ms\n",
+        static_cast<unsigned long long>(mStats.mAddedCount),
+        static_cast<unsigned long long>(mStats.mPersistedCount),
+        static_cast<unsigned long long>(mStats.mRemovedCount),
+        static_cast<unsigned long long>(mStats.mFilteredCount),
+        static_cast<unsigned long long>(mStats.mDroppedCount),
+        static_cast<double>(mStats.mListenerTime) / 1e6,
+        static_cast<double>(mStats.mMergeTime) / 1e6);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/Mutex.h>
+#include <Jolt/Physics/Body/Body.h>
+#include <Jolt/Physics/Body/BodyLockInterface.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+
+#include <EASTL/vector.h>
+
+#include <atomic>
+
+enum class ContactEventType : JPH::uint8 {
+    Added,
+    Persisted,
+    Removed,
+};
+
+/// A contact as reported to gameplay. Body 1 always has the lower ID and the normal points from body 1 to body 2.
+/// Removed contacts only carry the bodies and their layers, the layers are invalid when a body no longer exists.
+struct ContactEvent {
+    JPH::BodyID mBody1;
+    JPH::BodyID mBody2;
+    JPH::Float3 mPosition;
+    JPH::Float3 mNormal;
+    /// Closing speed along the normal times the reduced mass of the pair, contacts are reported before the solver
+    /// runs so the real impulse isn't known yet
+    float mImpulse;
+    JPH::ObjectLayer mLayer1;
+    JPH::ObjectLayer mLayer2;
+    ContactEventType mType;
+};
+
+/// Which contacts are recorded, checked on the job threads before anything is written
+struct ContactEventFilter {
+    /// A contact passes when either body is in one of these layers, bit N stands for object layer N
+    JPH::uint32 mLayerMask = 0xffffffff;
+    /// Added and persisted contacts below this estimated impulse are skipped
+    float mMinImpulse = 0.0f;
+    bool mReportPersisted = true;
+};
+
+/// Counts of the last step, the listener time adds up the time spent in the callbacks on all threads
+struct ContactStats {
+    JPH::uint64 mAddedCount;
+    JPH::uint64 mPersistedCount;
+    JPH::uint64 mRemovedCount;
+    JPH::uint64 mFilteredCount;
+    /// Events that didn't fit in their thread's buffer
+    JPH::uint64 mDroppedCount;
+    JPH::uint64 mListenerTime;
+    JPH::uint64 mMergeTime;
+};
+
+/// Records contacts into a buffer per job thread during PhysicsSystem::Update, so the callbacks never contend.
+/// After the step the buffers are merged into one sorted batch on the calling thread.
+class ContactListenerImpl final : public JPH::ContactListener
+{
+private:
+    struct ThreadBuffer {
+        eastl::vector<ContactEvent> mEvents;
+        JPH::uint32 mCount = 0;
+        JPH::uint64 mAddedCount = 0;
+        JPH::uint64 mPersistedCount = 0;
+        JPH::uint64 mRemovedCount = 0;
+        JPH::uint64 mFilteredCount = 0;
+        JPH::uint64 mDroppedCount = 0;
+        JPH::uint64 mTime = 0;
+    };
+
+    /// Buffers are only ever added, which takes the lock once per thread
+    JPH::Mutex mBufferMutex;
+    eastl::vector<ThreadBuffer *> mBuffers;
+    /// Tells threads that their cached buffer belongs to an older listener
+    JPH::uint32 mGeneration = 0;
+
+    ContactEventFilter mFilter;
+
+    eastl::vector<ContactEvent> mEvents;
+    ContactStats mStats = {};
+
+    ThreadBuffer &GetThreadBuffer();
+    void Record(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, ContactEventType inType);
+
+public:
+    ContactListenerImpl();
+    virtual ~ContactListenerImpl() override;
+
+    virtual void OnContactAdded(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &ioSettings) override;
+    virtual void OnContactPersisted(const JPH::Body &inBody1, const JPH::Body &inBody2, const JPH::ContactManifold &inManifold, JPH::ContactSettings &ioSettings) override;
+    virtual void OnContactRemoved(const JPH::SubShapeIDPair &inSubShapePair) override;
+
+    /// Merge the thread buffers into the step's batch and reset them, must not overlap with a step.
+    /// Removed contacts get their layers looked up here, which is why the bodies are needed.
+    void Collect(const JPH::BodyLockInterface &inBodyLockInterface);
+
+    /// Only change the filter between steps
+    inline void SetFilter(const ContactEventFilter &inFilter) {
+        mFilter = inFilter;
+    }
+
+    inline const ContactEventFilter &GetFilter() const {
+        return mFilter;
+    }
+
+    /// Events of the last step, sorted by body pair so the order doesn't depend on thread scheduling
+    inline const eastl::vector<ContactEvent> &GetEvents() const {
+        return mEvents;
+    }
+
+    inline const ContactStats &GetStats() const {
+        return mStats;
+    }
+
+    /// Log the counts and timings of the last step
+    void LogStats() const;
+};
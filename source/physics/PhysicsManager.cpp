@@ -2,6 +2,24 @@
 
 #include <cstdarg>
 
+#include "macros/log.hpp"
+#include "jobs/JobService.hpp"
+#include "jobs/ParallelFor.hpp"
+
+#include <Jolt/Core/HashCombine.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollideShape.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+
+#include <EASTL/algorithm.h>
+
+#include <atomic>
+
+#include <SDL3/SDL_timer.h>
+
 static void TraceImpl(const char *inFMT, ...) {
 	va_list list;
 	va_start(list, inFMT);
@@ -9,14 +27,17 @@ static void TraceImpl(const char *inFMT, ...) {
 	vsnprintf(buffer, sizeof(buffer), inFMT, list);
 	va_end(list);
 
-    printf("%s\n", buffer);
+    // A va_list can't be deferred, so the message is formatted here and only printed on the log thread
+    LOG_INFO("%s\n", buffer);
 }
 
 #ifdef JPH_ENABLE_ASSERTS
 
 // Callback for asserts, connect this to your own assert handler if you have one
 static bool AssertFailedImpl(const char *inExpression, const char *inMessage, const char *inFile, JPH::uint inLine) {
-    printf("%s:%d: (%s) %s\n", inFile, inLine, inExpression, inMessage != nullptr ? inMessage : "");
+    LOG_ERROR("%s:%u: (%s) %s\n", inFile, inLine, inExpression, inMessage != nullptr ? inMessage : "");
+    // The debugger breaks right after this, so the message has to be out by then
+    LogService::Get().Flush();
 	return true;
 };
 
@@ -24,7 +45,7 @@ static bool AssertFailedImpl(const char *inExpression, const char *inMessage, co
 
 bool PhysicsManager::Initialize() {
 
-    JPH::RegisterDefaultAllocator();
+    // Jolt's allocator is installed by the MemoryService, so it isn't registered here
 
     JPH::Trace = TraceImpl;
     JPH_IF_ENABLE_ASSERTS(JPH::AssertFailed = AssertFailedImpl);
@@ -34,19 +55,40 @@ bool PhysicsManager::Initialize() {
     JPH::RegisterTypes();
 
     mTempAllocator = new JPH::TempAllocatorImpl(10 * 1024 * 1024);
-    mJobSystem = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency() - 1);
+    // Physics shares the engine's worker threads instead of spinning up its own pool
+    mJobSystem = &JobService::Get();
 
-    const JPH::uint cMaxBodies = 1024;
+    // Large enough for stress scenes loaded from disk
+    const JPH::uint cMaxBodies = 128 * 1024;
     const JPH::uint cNumBodyMutexes = 0;
-    const JPH::uint cMaxBodyPairs = 1024;
-    const JPH::uint cMaxContactConstraints = 1024;
+    const JPH::uint cMaxBodyPairs = 64 * 1024;
+    const JPH::uint cMaxContactConstraints = 64 * 1024;
 
     mPhysicsSystem.Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints, mBroadPhaseLayerInterface, mObjectVsBroadPhaseLayerFilter, mObjectLayerPairFilter);
+    mPhysicsSystem.SetBodyActivationListener(&mBodyActivationListener);
+    mPhysicsSystem.SetContactListener(&mContactListener);
 
     return true;
 }
 
 void PhysicsManager::Shutdown() {
+    mPhysicsSystem.SetBodyActivationListener(nullptr);
+    mPhysicsSystem.SetContactListener(nullptr);
+
+    JPH::BodyInterface &body_interface = mPhysicsSystem.GetBodyInterface();
+
+    // Parked bodies are already outside of the simulation, so they only need to be destroyed
+    for (BodyPool &pool : mBodyPools) {
+        if (!pool.mParkedBodies.empty()) {
+            body_interface.DestroyBodies(pool.mParkedBodies.data(), static_cast<int>(pool.mParkedBodies.size()));
+            mCounters.mBodiesDestroyed += pool.mParkedBodies.size();
+        }
+    }
+    mBodyPools.clear();
+
+    mCachedShapes.clear();
+    mShapeLookup.clear();
+
     JPH::UnregisterTypes();
 
     delete JPH::Factory::sInstance;
@@ -55,7 +97,6 @@ void PhysicsManager::Shutdown() {
     delete mTempAllocator;
     mTempAllocator = nullptr;
 
-    delete mJobSystem;
     mJobSystem = nullptr;
 }
 
@@ -80,6 +121,10 @@ JPH::BodyID PhysicsManager::CreateBox(const JPH::Vec3 &inPosition, const JPH::Ve
     JPH::BodyCreationSettings floor_settings(floor_shape, inPosition, JPH::Quat::sIdentity(), motion_type, layer);
 
     JPH::BodyID body_id = body_interface.CreateAndAddBody(floor_settings, JPH::EActivation::DontActivate);
+
+    mCounters.mBodiesCreated++;
+    mCounters.mBroadPhaseInserts++;
+
     return body_id;
 }
 
@@ -95,6 +140,9 @@ JPH::BodyID PhysicsManager::CreateBall(const JPH::Vec3 &inPosition, const float
     JPH::BodyCreationSettings ball_settings(ball_shape, inPosition, JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
     JPH::BodyID body_id = body_interface.CreateAndAddBody(ball_settings, JPH::EActivation::DontActivate);
 
+    mCounters.mBodiesCreated++;
+    mCounters.mBroadPhaseInserts++;
+
     return body_id;
 }
 
@@ -102,6 +150,189 @@ void PhysicsManager::DestroyBody(JPH::BodyID inBodyID) {
     JPH::BodyInterface &body_interface = mPhysicsSystem.GetBodyInterface();
     body_interface.RemoveBody(inBodyID);
     body_interface.DestroyBody(inBodyID);
+
+    mCounters.mBodiesDestroyed++;
+    mCounters.mBroadPhaseRemovals++;
+}
+
+JPH::ShapeRefC PhysicsManager::GetShape(PhysicsShapeType inType, const JPH::Vec3 &inSize) {
+    JPH::Float3 size;
+    inSize.StoreFloat3(&size);
+
+    JPH::uint64 hash = JPH::HashBytes(&size, sizeof(size), JPH::HashBytes(&inType, sizeof(inType)));
+
+    auto it = mShapeLookup.find(hash);
+    if (it != mShapeLookup.end()) {
+        const CachedShape &cached_shape = mCachedShapes[it->second];
+        if (cached_shape.mType == inType && cached_shape.mSize == inSize) {
+            return cached_shape.mShape;
+        }
+    }
+
+    JPH::ShapeSettings::ShapeResult shape_result;
+    if (inType == PhysicsShapeType::Sphere) {
+        JPH::SphereShapeSettings shape_settings(inSize.GetX());
+        shape_settings.SetEmbedded();
+        shape_result = shape_settings.Create();
+    } else {
+        JPH::BoxShapeSettings shape_settings(inSize);
+        shape_settings.SetEmbedded();
+        shape_result = shape_settings.Create();
+    }
+
+    if (shape_result.HasError()) {
+        LOG_ERROR("Unable to create shape: %s\n", shape_result.GetError().c_str());
+        return nullptr;
+    }
+
+    // On a hash collision the shape is simply not cached
+    if (it == mShapeLookup.end()) {
+        mShapeLookup[hash] = mCachedShapes.size();
+        mCachedShapes.push_back({ inType, inSize, shape_result.Get() });
+    }
+
+    return shape_result.Get();
+}
+
+bool PhysicsManager::CreateBodies(const JPH::BodyCreationSettings *inSettings, size_t inCount, JPH::BodyID *outBodyIDs) {
+    JPH::BodyInterface &body_interface = mPhysicsSystem.GetBodyInterface();
+
+    mBatchStaticBodies.clear();
+    mBatchDynamicBodies.clear();
+
+    for (size_t i = 0; i < inCount; i++) {
+        JPH::Body *body = body_interface.CreateBody(inSettings[i]);
+        if (body == nullptr) {
+            LOG_ERROR("Unable to create bodies: out of bodies\n");
+            if (i > 0) {
+                body_interface.DestroyBodies(outBodyIDs, static_cast<int>(i));
+            }
+            return false;
+        }
+
+        outBodyIDs[i] = body->GetID();
+
+        if (body->IsStatic()) {
+            mBatchStaticBodies.push_back(body->GetID());
+        } else {
+            mBatchDynamicBodies.push_back(body->GetID());
+        }
+    }
+
+    // Jolt may reorder the arrays while adding, so the caller's ids are left alone and copies are added instead
+    if (!mBatchStaticBodies.empty()) {
+        int count = static_cast<int>(mBatchStaticBodies.size());
+        JPH::BodyInterface::AddState state = body_interface.AddBodiesPrepare(mBatchStaticBodies.data(), count);
+        body_interface.AddBodiesFinalize(mBatchStaticBodies.data(), count, state, JPH::EActivation::DontActivate);
+    }
+
+    if (!mBatchDynamicBodies.empty()) {
+        int count = static_cast<int>(mBatchDynamicBodies.size());
+        JPH::BodyInterface::AddState state = body_interface.AddBodiesPrepare(mBatchDynamicBodies.data(), count);
+        body_interface.AddBodiesFinalize(mBatchDynamicBodies.data(), count, state, JPH::EActivation::Activate);
+    }
+
+    mCounters.mBodiesCreated += inCount;
+    mCounters.mBroadPhaseInserts += inCount;
+
+    return true;
+}
+
+BodyPoolID PhysicsManager::CreateBallPool(const float inSize, JPH::uint inPrewarmCount) {
+    JPH::SphereShapeSettings ball_shape_settings(inSize);
+    ball_shape_settings.SetEmbedded();
+
+    JPH::ShapeSettings::ShapeResult ball_shape_result = ball_shape_settings.Create();
+    JPH::ShapeRefC ball_shape = ball_shape_result.Get();
+
+    BodyPool pool;
+    pool.mSettings = JPH::BodyCreationSettings(ball_shape, JPH::Vec3::sZero(), JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic, Layers::MOVING);
+    mBodyPools.push_back(pool);
+
+    BodyPoolID pool_id = static_cast<BodyPoolID>(mBodyPools.size() - 1);
+    PrewarmPool(pool_id, inPrewarmCount);
+
+    return pool_id;
+}
+
+void PhysicsManager::PrewarmPool(BodyPoolID inPoolID, JPH::uint inCount) {
+    JPH_ASSERT(inPoolID < mBodyPools.size());
+    BodyPool &pool = mBodyPools[inPoolID];
+
+    JPH::BodyInterface &body_interface = mPhysicsSystem.GetBodyInterface();
+    pool.mParkedBodies.reserve(pool.mParkedBodies.size() + inCount);
+
+    // Bodies are created without being added, so prewarming never touches the broadphase
+    for (JPH::uint i = 0; i < inCount; i++) {
+        JPH::Body *body = body_interface.CreateBody(pool.mSettings);
+        if (body == nullptr) {
+            LOG_ERROR("Unable to prewarm body pool: out of bodies\n");
+            return;
+        }
+
+        pool.mParkedBodies.push_back(body->GetID());
+        mCounters.mBodiesCreated++;
+    }
+}
+
+JPH::BodyID PhysicsManager::AcquireBody(
+    BodyPoolID inPoolID,
+    const JPH::Vec3 &inPosition,
+    const JPH::Quat &inRotation,
+    const JPH::Vec3 &inLinearVelocity,
+    JPH::EActivation inActivation
+) {
+    JPH_ASSERT(inPoolID < mBodyPools.size());
+    BodyPool &pool = mBodyPools[inPoolID];
+
+    JPH::BodyInterface &body_interface = mPhysicsSystem.GetBodyInterface();
+    mCounters.mPoolAcquires++;
+
+    // Only create a new body when the pool has run dry
+    JPH::BodyID body_id;
+    if (pool.mParkedBodies.empty()) {
+        JPH::Body *body = body_interface.CreateBody(pool.mSettings);
+        if (body == nullptr) {
+            LOG_ERROR("Unable to acquire pooled body: out of bodies\n");
+            return JPH::BodyID();
+        }
+
+        body_id = body->GetID();
+        mCounters.mBodiesCreated++;
+    } else {
+        body_id = pool.mParkedBodies.back();
+        pool.mParkedBodies.pop_back();
+        mCounters.mPoolReuses++;
+    }
+
+    // The body is not in the broadphase yet, so its state can be reset without waking anything up
+    body_interface.SetPositionAndRotation(body_id, inPosition, inRotation, JPH::EActivation::DontActivate);
+    {
+        JPH::BodyLockWrite lock(mPhysicsSystem.GetBodyLockInterface(), body_id);
+        if (lock.Succeeded()) {
+            JPH::Body &body = lock.GetBody();
+            body.SetLinearVelocityClamped(inLinearVelocity);
+            body.SetAngularVelocity(JPH::Vec3::sZero());
+        }
+    }
+
+    body_interface.AddBody(body_id, inActivation);
+    mCounters.mBroadPhaseInserts++;
+
+    return body_id;
+}
+
+void PhysicsManager::ReleaseBody(BodyPoolID inPoolID, JPH::BodyID inBodyID) {
+    JPH_ASSERT(inPoolID < mBodyPools.size());
+    if (inBodyID.IsInvalid()) {
+        return;
+    }
+
+    // Park the body outside of the simulation instead of destroying it
+    mPhysicsSystem.GetBodyInterface().RemoveBody(inBodyID);
+    mBodyPools[inPoolID].mParkedBodies.push_back(inBodyID);
+
+    mCounters.mBroadPhaseRemovals++;
 }
 
 void PhysicsManager::Update() {
@@ -109,4 +340,241 @@ void PhysicsManager::Update() {
     const int cCollisionSteps = 1;
 
     mPhysicsSystem.Update(cDeltaTime, cCollisionSteps, mTempAllocator, mJobSystem);
+
+    // Remember which bodies moved so dependent caches only have to update those
+    mBodyActivationListener.CollectMovedBodies(mMovedBodies);
+
+    // Bodies can be created and destroyed on other threads, such as the physics streamer's, while this runs
+    mContactListener.Collect(mPhysicsSystem.GetBodyLockInterface());
+}
+
+// Queries per job, large enough that scheduling a job costs little compared to running it
+static constexpr size_t cQueriesPerJob = 256;
+
+// Collects the distinct bodies a shape touches into a fixed slice of the caller's array
+class OverlapBodyCollector final : public JPH::CollideShapeCollector {
+private:
+    JPH::BodyID *mBodies;
+    JPH::uint mMaxCount;
+    JPH::uint mCount = 0;
+
+public:
+    OverlapBodyCollector(JPH::BodyID *outBodies, JPH::uint inMaxCount) : mBodies(outBodies), mMaxCount(inMaxCount) {}
+
+    virtual void AddHit(const JPH::CollideShapeResult &inResult) override {
+        // Compound shapes report each sub shape they touch, the body only counts once
+        for (JPH::uint i = 0; i < mCount && i < mMaxCount; i++) {
+            if (mBodies[i] == inResult.mBodyID2) {
+                return;
+            }
+        }
+
+        if (mCount < mMaxCount) {
+            mBodies[mCount] = inResult.mBodyID2;
+        }
+
+        mCount++;
+    }
+
+    inline JPH::uint GetCount() const {
+        return mCount;
+    }
+};
+
+template <typename F>
+void PhysicsManager::RunQueryJobs(size_t inCount, const F &inFunction) {
+    JPH::uint64 start_time = SDL_GetTicksNS();
+    size_t slice_count = (inCount + cQueriesPerJob - 1) / cQueriesPerJob;
+
+    // The calling thread works on the batch too while it waits
+    std::atomic<JPH::uint64> hit_count = 0;
+    Uint32 job_count = ParallelFor(mJobSystem, "PhysicsQuery", slice_count, [&](size_t inSlice) {
+        size_t begin = inSlice * cQueriesPerJob;
+        size_t end = eastl::min(begin + cQueriesPerJob, inCount);
+        hit_count.fetch_add(inFunction(begin, end), std::memory_order_relaxed);
+    });
+
+    mQueryStats = {
+        static_cast<JPH::uint64>(inCount),
+        hit_count.load(std::memory_order_relaxed),
+        job_count,
+        SDL_GetTicksNS() - start_time
+    };
+}
+
+void PhysicsManager::CastRays(
+    const RayQuery *inQueries,
+    size_t inCount,
+    RayHit *outHits,
+    const JPH::BroadPhaseLayerFilter &inBroadPhaseLayerFilter,
+    const JPH::ObjectLayerFilter &inObjectLayerFilter
+) {
+    const JPH::NarrowPhaseQuery &query = mPhysicsSystem.GetNarrowPhaseQueryNoLock();
+
+    RunQueryJobs(inCount, [&](size_t inBegin, size_t inEnd) {
+        JPH::uint64 hit_count = 0;
+
+        for (size_t i = inBegin; i < inEnd; i++) {
+            JPH::RRayCast ray(inQueries[i].mOrigin, inQueries[i].mDirection);
+            JPH::RayCastResult result;
+
+            if (query.CastRay(ray, result, inBroadPhaseLayerFilter, inObjectLayerFilter)) {
+                outHits[i] = { result.mBodyID, result.mFraction };
+                hit_count++;
+            } else {
+                outHits[i] = { JPH::BodyID(), 1.0f };
+            }
+        }
+
+        return hit_count;
+    });
+}
+
+void PhysicsManager::CastShapes(
+    const ShapeCastQuery *inQueries,
+    size_t inCount,
+    ShapeCastHit *outHits,
+    const JPH::BroadPhaseLayerFilter &inBroadPhaseLayerFilter,
+    const JPH::ObjectLayerFilter &inObjectLayerFilter
+) {
+    const JPH::NarrowPhaseQuery &query = mPhysicsSystem.GetNarrowPhaseQueryNoLock();
+
+    RunQueryJobs(inCount, [&](size_t inBegin, size_t inEnd) {
+        JPH::uint64 hit_count = 0;
+        JPH::ShapeCastSettings settings;
+
+        for (size_t i = inBegin; i < inEnd; i++) {
+            const ShapeCastQuery &shape_query = inQueries[i];
+            JPH::RShapeCast shape_cast(
+                shape_query.mShape,
+                JPH::Vec3::sReplicate(1.0f),
+                JPH::RMat44::sRotationTranslation(shape_query.mRotation, shape_query.mPosition),
+                shape_query.mDirection
+            );
+
+            JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+            query.CastShape(shape_cast, settings, JPH::RVec3::sZero(), collector, inBroadPhaseLayerFilter, inObjectLayerFilter);
+
+            if (collector.HadHit()) {
+                outHits[i] = { collector.mHit.mBodyID2, collector.mHit.mFraction, JPH::Vec3(collector.mHit.mContactPointOn2) };
+                hit_count++;
+            } else {
+                outHits[i] = { JPH::BodyID(), 1.0f, JPH::Vec3::sZero() };
+            }
+        }
+
+        return hit_count;
+    });
+}
+
+void PhysicsManager::CollideShapes(
+    const OverlapQuery *inQueries,
+    size_t inCount,
+    JPH::BodyID *outBodies,
+    JPH::uint inMaxBodiesPerQuery,
+    JPH::uint *outBodyCounts,
+    const JPH::BroadPhaseLayerFilter &inBroadPhaseLayerFilter,
+    const JPH::ObjectLayerFilter &inObjectLayerFilter
+) {
+    const JPH::NarrowPhaseQuery &query = mPhysicsSystem.GetNarrowPhaseQueryNoLock();
+
+    RunQueryJobs(inCount, [&](size_t inBegin, size_t inEnd) {
+        JPH::uint64 hit_count = 0;
+        JPH::CollideShapeSettings settings;
+
+        for (size_t i = inBegin; i < inEnd; i++) {
+            const OverlapQuery &overlap_query = inQueries[i];
+            OverlapBodyCollector collector(outBodies + i * inMaxBodiesPerQuery, inMaxBodiesPerQuery);
+
+            query.CollideShape(
+                overlap_query.mShape,
+                JPH::Vec3::sReplicate(1.0f),
+                JPH::RMat44::sRotationTranslation(overlap_query.mRotation, overlap_query.mPosition),
+                settings,
+                JPH::RVec3::sZero(),
+                collector,
+                inBroadPhaseLayerFilter,
+                inObjectLayerFilter
+            );
+
+            outBodyCounts[i] = collector.GetCount();
+            hit_count += collector.GetCount();
+        }
+
+        return hit_count;
+    });
+}
+
+bool PhysicsManager::SaveSnapshot(PhysicsSnapshot &outSnapshot, bool inActiveBodiesOnly) {
+    JPH::uint64 start_time = SDL_GetTicksNS();
+
+    outSnapshot.Clear();
+    mPhysicsSystem.SaveState(
+        outSnapshot,
+        JPH::EStateRecorderState::All,
+        inActiveBodiesOnly ? &mActiveBodyStateFilter : nullptr
+    );
+
+    outSnapshot.SetSaveTime(SDL_GetTicksNS() - start_time);
+
+    if (outSnapshot.IsFailed()) {
+        LOG_ERROR("Unable to save physics snapshot: buffer of %zu bytes is too small\n", outSnapshot.GetCapacity());
+        return false;
+    }
+
+    return true;
+}
+
+bool PhysicsManager::RestoreSnapshot(PhysicsSnapshot &inSnapshot) {
+    JPH::uint64 start_time = SDL_GetTicksNS();
+
+    inSnapshot.Rewind();
+    bool result = mPhysicsSystem.RestoreState(inSnapshot);
+
+    inSnapshot.SetRestoreTime(SDL_GetTicksNS() - start_time);
+
+    if (!result) {
+        LOG_ERROR("Unable to restore physics snapshot\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool PhysicsManager::CheckDeterminism(PhysicsSnapshot &ioStartSnapshot, PhysicsSnapshot &ioEndSnapshot, int inStepCount) {
+    if (!SaveSnapshot(ioStartSnapshot)) {
+        return false;
+    }
+
+    for (int i = 0; i < inStepCount; i++) {
+        Update();
+    }
+
+    if (!SaveSnapshot(ioEndSnapshot)) {
+        return false;
+    }
+    JPH::uint64 expected_hash = ioEndSnapshot.GetHash();
+
+    // Go back in time and simulate the same steps again, which should end up in exactly the same state
+    if (!RestoreSnapshot(ioStartSnapshot)) {
+        return false;
+    }
+
+    for (int i = 0; i < inStepCount; i++) {
+        Update();
+    }
+
+    if (!SaveSnapshot(ioEndSnapshot)) {
+        return false;
+    }
+    JPH::uint64 actual_hash = ioEndSnapshot.GetHash();
+
+    if (expected_hash != actual_hash) {
+        LOG_ERROR("Physics simulation is not deterministic: %llx != %llx\n",
+            static_cast<unsigned long long>(expected_hash),
+            static_cast<unsigned long long>(actual_hash));
+        return false;
+    }
+
+    return true;
 }
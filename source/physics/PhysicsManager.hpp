@@ -10,7 +10,7 @@
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/JobSystem.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
@@ -23,20 +23,82 @@
 #include "ObjectLayerPairFilterImpl.hpp"
 #include "BPLayerInterfaceImpl.hpp"
 #include "ObjectVsBroadPhaseLayerFilterImpl.hpp"
+#include "BodyActivationListenerImpl.hpp"
+#include "ContactListenerImpl.hpp"
+#include "ActiveBodyStateFilterImpl.hpp"
+#include "PhysicsQuery.hpp"
+#include "PhysicsSnapshot.hpp"
+
+#include <EASTL/vector.h>
+#include <EASTL/hash_map.h>
 
 // Disable common warnings triggered by Jolt, you can use JPH_SUPPRESS_WARNING_PUSH / JPH_SUPPRESS_WARNING_POP to store and restore the warning state
 JPH_SUPPRESS_WARNINGS
 
+// Index of a body pool created through PhysicsManager::CreateBallPool
+using BodyPoolID = JPH::uint32;
+
+// A set of identical bodies that are parked outside of the simulation when not in use
+struct BodyPool {
+    JPH::BodyCreationSettings mSettings;
+    eastl::vector<JPH::BodyID> mParkedBodies;
+};
+
+enum class PhysicsShapeType : JPH::uint8 {
+    Box,
+    Sphere,
+};
+
+// A shape shared by all bodies created with the same parameters
+struct CachedShape {
+    PhysicsShapeType mType;
+    JPH::Vec3 mSize;
+    JPH::ShapeRefC mShape;
+};
+
+// Running totals used to see how much work body management causes
+struct PhysicsCounters {
+    JPH::uint64 mBodiesCreated;
+    JPH::uint64 mBodiesDestroyed;
+    JPH::uint64 mPoolAcquires;
+    JPH::uint64 mPoolReuses;
+    JPH::uint64 mBroadPhaseInserts;
+    JPH::uint64 mBroadPhaseRemovals;
+};
+
 class PhysicsManager {
 private:
     JPH::PhysicsSystem mPhysicsSystem;
 
+    eastl::vector<BodyPool> mBodyPools;
+
+    // Shapes by a hash of their parameters, indexing mCachedShapes
+    eastl::vector<CachedShape> mCachedShapes;
+    eastl::hash_map<JPH::uint64, size_t> mShapeLookup;
+
+    // Scratch buffers for adding a batch of bodies to the broadphase
+    eastl::vector<JPH::BodyID> mBatchStaticBodies;
+    eastl::vector<JPH::BodyID> mBatchDynamicBodies;
+    PhysicsCounters mCounters = {};
+
     JPH::JobSystem *mJobSystem;
     JPH::TempAllocator *mTempAllocator;
 
     BPLayerInterfaceImpl mBroadPhaseLayerInterface;
     ObjectVsBroadPhaseLayerFilterImpl mObjectVsBroadPhaseLayerFilter;
     ObjectLayerPairFilterImpl mObjectLayerPairFilter;
+    BodyActivationListenerImpl mBodyActivationListener;
+    ContactListenerImpl mContactListener;
+    ActiveBodyStateFilterImpl mActiveBodyStateFilter;
+
+    // Bodies that moved during the last call to Update
+    eastl::vector<JPH::BodyID> mMovedBodies;
+
+    PhysicsQueryStats mQueryStats = {};
+
+    // Split a batch of queries into jobs, small batches run on the calling thread
+    template <typename F>
+    void RunQueryJobs(size_t inCount, const F &inFunction);
 
 public:
     bool Initialize();
@@ -48,9 +110,99 @@ public:
 	JPH::BodyID CreateBall(const JPH::Vec3 &inPosition, const float inSize);
     void DestroyBody(JPH::BodyID inBodyID);
 
+    // Get a shared shape, for spheres the radius is taken from the x component of the size
+    JPH::ShapeRefC GetShape(PhysicsShapeType inType, const JPH::Vec3 &inSize);
+
+    // Create a batch of bodies and insert them into the broadphase together, dynamic bodies are activated
+    bool CreateBodies(const JPH::BodyCreationSettings *inSettings, size_t inCount, JPH::BodyID *outBodyIDs);
+
+    BodyPoolID CreateBallPool(const float inSize, JPH::uint inPrewarmCount = 0);
+    void PrewarmPool(BodyPoolID inPoolID, JPH::uint inCount);
+    JPH::BodyID AcquireBody(
+        BodyPoolID inPoolID,
+        const JPH::Vec3 &inPosition,
+        const JPH::Quat &inRotation,
+        const JPH::Vec3 &inLinearVelocity,
+        JPH::EActivation inActivation = JPH::EActivation::Activate
+    );
+    void ReleaseBody(BodyPoolID inPoolID, JPH::BodyID inBodyID);
+
     void Update();
 
+    // Batched queries against the world, split across the worker threads. Results go into arrays of one entry per
+    // query that the caller owns, so a batch doesn't allocate. Queries read the bodies without locking, so they must
+    // not overlap with Update or with bodies being added or removed.
+    void CastRays(
+        const RayQuery *inQueries,
+        size_t inCount,
+        RayHit *outHits,
+        const JPH::BroadPhaseLayerFilter &inBroadPhaseLayerFilter = {},
+        const JPH::ObjectLayerFilter &inObjectLayerFilter = {}
+    );
+    void CastShapes(
+        const ShapeCastQuery *inQueries,
+        size_t inCount,
+        ShapeCastHit *outHits,
+        const JPH::BroadPhaseLayerFilter &inBroadPhaseLayerFilter = {},
+        const JPH::ObjectLayerFilter &inObjectLayerFilter = {}
+    );
+    // Every query gets inMaxBodiesPerQuery entries in outBodies, starting at its index times that count.
+    // Bodies past that are left out, and the number that was found goes into outBodyCounts.
+    void CollideShapes(
+        const OverlapQuery *inQueries,
+        size_t inCount,
+        JPH::BodyID *outBodies,
+        JPH::uint inMaxBodiesPerQuery,
+        JPH::uint *outBodyCounts,
+        const JPH::BroadPhaseLayerFilter &inBroadPhaseLayerFilter = {},
+        const JPH::ObjectLayerFilter &inObjectLayerFilter = {}
+    );
+
+    // Save the world state into a preallocated snapshot, delta snapshots only contain the bodies that are awake
+    bool SaveSnapshot(PhysicsSnapshot &outSnapshot, bool inActiveBodiesOnly = false);
+    bool RestoreSnapshot(PhysicsSnapshot &inSnapshot);
+
+    // Simulate a number of steps twice from the same starting point and compare the resulting state hashes
+    bool CheckDeterminism(PhysicsSnapshot &ioStartSnapshot, PhysicsSnapshot &ioEndSnapshot, int inStepCount);
+
     inline JPH::BodyInterface &GetBodyInterface() {
         return mPhysicsSystem.GetBodyInterface();
     }
+
+    inline const JPH::BodyLockInterface &GetBodyLockInterface() const {
+        return mPhysicsSystem.GetBodyLockInterface();
+    }
+
+    inline const eastl::vector<JPH::BodyID> &GetMovedBodies() const {
+        return mMovedBodies;
+    }
+
+    // Contacts of the last call to Update, merged from the job threads
+    inline const eastl::vector<ContactEvent> &GetContactEvents() const {
+        return mContactListener.GetEvents();
+    }
+
+    inline const ContactStats &GetContactStats() const {
+        return mContactListener.GetStats();
+    }
+
+    inline void LogContactStats() const {
+        mContactListener.LogStats();
+    }
+
+    inline void SetContactFilter(const ContactEventFilter &inFilter) {
+        mContactListener.SetFilter(inFilter);
+    }
+
+    inline const PhysicsQueryStats &GetQueryStats() const {
+        return mQueryStats;
+    }
+
+    inline size_t GetActiveBodyCount() const {
+        return mBodyActivationListener.GetActiveBodyCount();
+    }
+
+    inline const PhysicsCounters &GetCounters() const {
+        return mCounters;
+    }
 };
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyID.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+
+// A ray from the origin along the direction, the length of the direction is the length of the ray
+struct RayQuery {
+    JPH::Vec3 mOrigin;
+    JPH::Vec3 mDirection;
+};
+
+// Closest hit of a ray, the body ID is invalid when nothing was hit
+struct RayHit {
+    JPH::BodyID mBodyID;
+    // Fraction of the direction at which the ray hit
+    float mFraction;
+};
+
+// A shape swept from its position along the direction. Shapes come from PhysicsManager::GetShape, the queries only
+// point at them so a batch can share one shape.
+struct ShapeCastQuery {
+    const JPH::Shape *mShape;
+    JPH::Vec3 mPosition;
+    JPH::Quat mRotation;
+    JPH::Vec3 mDirection;
+};
+
+// Closest hit of a shape cast, the body ID is invalid when nothing was hit
+struct ShapeCastHit {
+    JPH::BodyID mBodyID;
+    float mFraction;
+    JPH::Vec3 mContactPoint;
+};
+
+// A shape at rest, reports every body it touches
+struct OverlapQuery {
+    const JPH::Shape *mShape;
+    JPH::Vec3 mPosition;
+    JPH::Quat mRotation;
+};
+
+// Totals of the last batch, times in nanoseconds
+struct PhysicsQueryStats {
+    JPH::uint64 mQueryCount;
+    JPH::uint64 mHitCount;
+    JPH::uint32 mJobCount;
+    JPH::uint64 mTime;
+};
@@ -0,0 +1,53 @@
+#include "PhysicsSnapshot.hpp"
+
+#include <Jolt/Core/HashCombine.h>
+
+#include <cstring>
+
+PhysicsSnapshot::PhysicsSnapshot(size_t inCapacity) {
+    mData.resize(inCapacity);
+}
+
+void PhysicsSnapshot::Clear() {
+    mSize = 0;
+    mReadOffset = 0;
+    mIsFailed = false;
+}
+
+void PhysicsSnapshot::Rewind() {
+    mReadOffset = 0;
+    mIsFailed = false;
+}
+
+JPH::uint64 PhysicsSnapshot::GetHash() const {
+    return JPH::HashBytes(mData.data(), static_cast<JPH::uint>(mSize));
+}
+
+void PhysicsSnapshot::WriteBytes(const void *inData, size_t inNumBytes) {
+    if (mIsFailed || mSize + inNumBytes > mData.size()) {
+        mIsFailed = true;
+        return;
+    }
+
+    memcpy(mData.data() + mSize, inData, inNumBytes);
+    mSize += inNumBytes;
+}
+
+void PhysicsSnapshot::ReadBytes(void *outData, size_t inNumBytes) {
+    if (mIsFailed || mReadOffset + inNumBytes > mSize) {
+        mIsFailed = true;
+        memset(outData, 0, inNumBytes);
+        return;
+    }
+
+    memcpy(outData, mData.data() + mReadOffset, inNumBytes);
+    mReadOffset += inNumBytes;
+}
+
+bool PhysicsSnapshot::IsEOF() const {
+    return mReadOffset >= mSize;
+}
+
+bool PhysicsSnapshot::IsFailed() const {
+    return mIsFailed;
+}
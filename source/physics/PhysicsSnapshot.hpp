@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/StateRecorder.h>
+
+#include <EASTL/vector.h>
+
+/// A StateRecorder that writes into a buffer allocated once up front, so saving and restoring never touch the heap.
+/// If the buffer is too small, the snapshot is marked as failed instead of growing.
+class PhysicsSnapshot final : public JPH::StateRecorder
+{
+private:
+    eastl::vector<JPH::uint8> mData;
+    size_t mSize = 0;
+    size_t mReadOffset = 0;
+    bool mIsFailed = false;
+
+    JPH::uint64 mSaveTime = 0;
+    JPH::uint64 mRestoreTime = 0;
+
+public:
+    explicit PhysicsSnapshot(size_t inCapacity);
+
+    // Discard the contents so the snapshot can be written again
+    void Clear();
+    // Move the read position back to the start so the snapshot can be restored again
+    void Rewind();
+
+    JPH::uint64 GetHash() const;
+
+    virtual void WriteBytes(const void *inData, size_t inNumBytes) override;
+    virtual void ReadBytes(void *outData, size_t inNumBytes) override;
+    virtual bool IsEOF() const override;
+    virtual bool IsFailed() const override;
+
+    inline size_t GetSize() const {
+        return mSize;
+    }
+
+    inline size_t GetCapacity() const {
+        return mData.size();
+    }
+
+    inline void SetSaveTime(JPH::uint64 inTime) {
+        mSaveTime = inTime;
+    }
+
+    inline void SetRestoreTime(JPH::uint64 inTime) {
+        mRestoreTime = inTime;
+    }
+
+    // Time it took to save this snapshot, in nanoseconds
+    inline JPH::uint64 GetSaveTime() const {
+        return mSaveTime;
+    }
+
+    // Time it took to last restore this snapshot, in nanoseconds
+    inline JPH::uint64 GetRestoreTime() const {
+        return mRestoreTime;
+    }
+};
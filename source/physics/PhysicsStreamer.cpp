@@ -0,0 +1,523 @@
+#include "PhysicsStreamer.hpp"
+
+#include "macros/log.hpp"
+#include "PhysicsManager.hpp"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+#include <SDL3/SDL_timer.h>
+
+#include <cfloat>
+#include <cmath>
+
+static inline JPH::uint64 PackCell(int inX, int inZ) {
+    return (static_cast<JPH::uint64>(static_cast<JPH::uint32>(inX)) << 32) | static_cast<JPH::uint32>(inZ);
+}
+
+bool PhysicsStreamer::Initialize(PhysicsManager *inPhysicsManager, const PhysicsStreamingSettings &inSettings) {
+    if (inSettings.mCellSize <= 0.0f || inSettings.mBatchSize == 0 || inSettings.mBatchCount == 0) {
+        LOG_ERROR("Unable to initialize physics streaming: invalid settings\n");
+        return false;
+    }
+
+    mPhysicsManager = inPhysicsManager;
+    mSettings = inSettings;
+    mSettings.mUnloadRadius = eastl::max(mSettings.mUnloadRadius, mSettings.mLoadRadius);
+    mSettings.mMaxBatchesPerUpdate = eastl::max(mSettings.mMaxBatchesPerUpdate, 1u);
+
+    // Everything a batch needs is allocated up front, streaming a cell in only copies into it
+    mBatches.resize(mSettings.mBatchCount);
+    mFreeBatches.reserve(mSettings.mBatchCount);
+    mQueuedBatches.reserve(mSettings.mBatchCount);
+    mFinishedBatches.reserve(mSettings.mBatchCount);
+    mLoadingBatches.reserve(mSettings.mBatchCount);
+    mReadyBatches.reserve(mSettings.mBatchCount);
+    mDispatchBatches.reserve(mSettings.mBatchCount);
+
+    for (Batch &batch : mBatches) {
+        batch.mSettings.resize(mSettings.mBatchSize);
+        batch.mStreamedBodies.resize(mSettings.mBatchSize);
+        batch.mBodyIDs.resize(mSettings.mBatchSize);
+        batch.mAddBodyIDs.resize(mSettings.mBatchSize);
+        mFreeBatches.push_back(&batch);
+    }
+
+    mQuit = false;
+    mThread = std::thread([this] { RunStreaming(); });
+
+    return true;
+}
+
+void PhysicsStreamer::Shutdown() {
+    if (!mThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+        mCondition.notify_all();
+    }
+
+    mThread.join();
+
+    JPH::BodyInterface &body_interface = mPhysicsManager->GetBodyInterface();
+
+    // Batches that were prepared but never added still hold bodies outside of the broadphase
+    mReadyBatches.insert(mReadyBatches.end(), mFinishedBatches.begin(), mFinishedBatches.end());
+    for (Batch *batch : mReadyBatches) {
+        if (!batch->mIsFailed) {
+            if (batch->mStaticCount > 0) {
+                body_interface.AddBodiesAbort(batch->mAddBodyIDs.data(), static_cast<int>(batch->mStaticCount), batch->mStaticState);
+            }
+
+            if (batch->mCount > batch->mStaticCount) {
+                body_interface.AddBodiesAbort(
+                    batch->mAddBodyIDs.data() + batch->mStaticCount,
+                    static_cast<int>(batch->mCount - batch->mStaticCount),
+                    batch->mDynamicState
+                );
+            }
+
+            mDestroyQueue.insert(mDestroyQueue.end(), batch->mBodyIDs.begin(), batch->mBodyIDs.begin() + batch->mCount);
+        }
+    }
+
+    mUnloadBodies.clear();
+    for (StreamedBody &body : mBodies) {
+        if (!body.mBodyID.IsInvalid()) {
+            mUnloadBodies.push_back(body.mBodyID);
+            body.mBodyID = JPH::BodyID();
+        }
+    }
+
+    if (!mUnloadBodies.empty()) {
+        body_interface.RemoveBodies(mUnloadBodies.data(), static_cast<int>(mUnloadBodies.size()));
+        mDestroyQueue.insert(mDestroyQueue.end(), mUnloadBodies.begin(), mUnloadBodies.end());
+    }
+
+    mDestroyQueue.insert(mDestroyQueue.end(), mRemovedBodyIDs.begin(), mRemovedBodyIDs.end());
+
+    if (!mDestroyQueue.empty()) {
+        body_interface.DestroyBodies(mDestroyQueue.data(), static_cast<int>(mDestroyQueue.size()));
+    }
+
+    mBodies.clear();
+    mCells.clear();
+    mCellLookup.clear();
+    mLoadQueue.clear();
+    mResidentCells.clear();
+    mFreeBatches.clear();
+    mQueuedBatches.clear();
+    mFinishedBatches.clear();
+    mReadyBatches.clear();
+    mDestroyQueue.clear();
+    mUnloadBodies.clear();
+    mRemovedBodyIDs.clear();
+    mBatches.clear();
+
+    mPhysicsManager = nullptr;
+}
+
+void PhysicsStreamer::RunStreaming() {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (true) {
+        mCondition.wait(lock, [this] { return mQuit || !mQueuedBatches.empty() || !mDestroyQueue.empty(); });
+        if (mQuit) {
+            break;
+        }
+
+        mLoadingBatches.swap(mQueuedBatches);
+        mDestroyingBodies.swap(mDestroyQueue);
+        lock.unlock();
+
+        Uint64 start_time = SDL_GetTicksNS();
+
+        // Destroy first, so the freed bodies can be reused by the loads right after
+        if (!mDestroyingBodies.empty()) {
+            mPhysicsManager->GetBodyInterface().DestroyBodies(mDestroyingBodies.data(), static_cast<int>(mDestroyingBodies.size()));
+            mDestroyingBodies.clear();
+        }
+
+        for (Batch *batch : mLoadingBatches) {
+            LoadBatch(*batch);
+        }
+
+        Uint64 time = SDL_GetTicksNS() - start_time;
+
+        lock.lock();
+        mFinishedBatches.insert(mFinishedBatches.end(), mLoadingBatches.begin(), mLoadingBatches.end());
+        mLoadingBatches.clear();
+        mBackgroundTime += time;
+        mFinishedCondition.notify_all();
+    }
+}
+
+void PhysicsStreamer::LoadBatch(Batch &ioBatch) {
+    JPH::BodyInterface &body_interface = mPhysicsManager->GetBodyInterface();
+
+    for (JPH::uint i = 0; i < ioBatch.mCount; i++) {
+        JPH::Body *body = body_interface.CreateBody(ioBatch.mSettings[i]);
+        if (body == nullptr) {
+            LOG_ERROR("Unable to stream in %u bodies: out of bodies\n", ioBatch.mCount);
+            if (i > 0) {
+                body_interface.DestroyBodies(ioBatch.mBodyIDs.data(), static_cast<int>(i));
+            }
+            ioBatch.mIsFailed = true;
+            return;
+        }
+
+        ioBatch.mBodyIDs[i] = body->GetID();
+        ioBatch.mAddBodyIDs[i] = body->GetID();
+    }
+
+    // Preparing builds the broadphase nodes for the batch, which is the expensive part of adding bodies
+    JPH::uint dynamic_count = ioBatch.mCount - ioBatch.mStaticCount;
+    if (ioBatch.mStaticCount > 0) {
+        ioBatch.mStaticState = body_interface.AddBodiesPrepare(ioBatch.mAddBodyIDs.data(), static_cast<int>(ioBatch.mStaticCount));
+    }
+
+    if (dynamic_count > 0) {
+        ioBatch.mDynamicState = body_interface.AddBodiesPrepare(ioBatch.mAddBodyIDs.data() + ioBatch.mStaticCount, static_cast<int>(dynamic_count));
+    }
+}
+
+JPH::uint32 PhysicsStreamer::GetCell(int inX, int inZ) {
+    JPH::uint64 key = PackCell(inX, inZ);
+
+    auto it = mCellLookup.find(key);
+    if (it != mCellLookup.end()) {
+        return it->second;
+    }
+
+    JPH::uint32 index = static_cast<JPH::uint32>(mCells.size());
+    Cell &cell = mCells.push_back();
+    cell.mX = inX;
+    cell.mZ = inZ;
+    mCellLookup[key] = index;
+
+    return index;
+}
+
+float PhysicsStreamer::GetCellDistance(const Cell &inCell) const {
+    float min_x = static_cast<float>(inCell.mX) * mSettings.mCellSize;
+    float min_z = static_cast<float>(inCell.mZ) * mSettings.mCellSize;
+    float max_x = min_x + mSettings.mCellSize;
+    float max_z = min_z + mSettings.mCellSize;
+
+    // Distance on the XZ plane from the nearest interest point to the cell's rectangle
+    float distance_sq = FLT_MAX;
+    for (const JPH::Vec3 &point : mInterestPoints) {
+        float dx = eastl::max(eastl::max(min_x - point.GetX(), point.GetX() - max_x), 0.0f);
+        float dz = eastl::max(eastl::max(min_z - point.GetZ(), point.GetZ() - max_z), 0.0f);
+        distance_sq = eastl::min(distance_sq, dx * dx + dz * dz);
+    }
+
+    return distance_sq == FLT_MAX ? FLT_MAX : std::sqrt(distance_sq);
+}
+
+StreamedBodyID PhysicsStreamer::AddBody(const JPH::BodyCreationSettings &inSettings) {
+    int x = static_cast<int>(std::floor(static_cast<float>(inSettings.mPosition.GetX()) / mSettings.mCellSize));
+    int z = static_cast<int>(std::floor(static_cast<float>(inSettings.mPosition.GetZ()) / mSettings.mCellSize));
+    JPH::uint32 cell_index = GetCell(x, z);
+
+    StreamedBodyID id = static_cast<StreamedBodyID>(mBodies.size());
+    mBodies.push_back({ inSettings, JPH::BodyID(), cell_index });
+
+    // A body added to a loaded cell is streamed in with the next batches
+    Cell &cell = mCells[cell_index];
+    cell.mBodies.push_back(id);
+    if (cell.mIsResident && !cell.mIsQueued) {
+        cell.mIsQueued = true;
+        mLoadQueue.push_back(cell_index);
+    }
+
+    return id;
+}
+
+void PhysicsStreamer::RequestCell(JPH::uint32 inCell) {
+    Cell &cell = mCells[inCell];
+    cell.mIsResident = true;
+    cell.mDispatchedCount = 0;
+    mResidentCells.push_back(inCell);
+
+    if (!cell.mIsQueued) {
+        cell.mIsQueued = true;
+        mLoadQueue.push_back(inCell);
+    }
+}
+
+void PhysicsStreamer::UnloadCell(JPH::uint32 inCell) {
+    JPH::BodyInterface &body_interface = mPhysicsManager->GetBodyInterface();
+
+    Cell &cell = mCells[inCell];
+    cell.mIsResident = false;
+
+    for (JPH::uint32 i = 0; i < cell.mDispatchedCount; i++) {
+        StreamedBody &body = mBodies[cell.mBodies[i]];
+        if (body.mBodyID.IsInvalid()) {
+            continue;
+        }
+
+        // Dynamic bodies come back where they were left
+        if (body.mSettings.mMotionType != JPH::EMotionType::Static) {
+            body_interface.GetPositionAndRotation(body.mBodyID, body.mSettings.mPosition, body.mSettings.mRotation);
+            body.mSettings.mLinearVelocity = body_interface.GetLinearVelocity(body.mBodyID);
+            body.mSettings.mAngularVelocity = body_interface.GetAngularVelocity(body.mBodyID);
+        }
+
+        mUnloadBodies.push_back(body.mBodyID);
+        mRemovedBodies.push_back({ cell.mBodies[i], body.mBodyID });
+        body.mBodyID = JPH::BodyID();
+    }
+
+    if (cell.mDispatchedCount > 0) {
+        mStats.mCellsUnloaded++;
+    }
+
+    cell.mDispatchedCount = 0;
+}
+
+void PhysicsStreamer::FinishBatch(Batch &ioBatch) {
+    Cell &cell = mCells[ioBatch.mCell];
+    cell.mPendingBatchCount--;
+
+    if (ioBatch.mIsFailed) {
+        mStats.mFailedBatches++;
+        return;
+    }
+
+    JPH::BodyInterface &body_interface = mPhysicsManager->GetBodyInterface();
+
+    JPH::uint dynamic_count = ioBatch.mCount - ioBatch.mStaticCount;
+    if (ioBatch.mStaticCount > 0) {
+        body_interface.AddBodiesFinalize(
+            ioBatch.mAddBodyIDs.data(),
+            static_cast<int>(ioBatch.mStaticCount),
+            ioBatch.mStaticState,
+            JPH::EActivation::DontActivate
+        );
+    }
+
+    if (dynamic_count > 0) {
+        body_interface.AddBodiesFinalize(
+            ioBatch.mAddBodyIDs.data() + ioBatch.mStaticCount,
+            static_cast<int>(dynamic_count),
+            ioBatch.mDynamicState,
+            JPH::EActivation::Activate
+        );
+    }
+
+    for (JPH::uint i = 0; i < ioBatch.mCount; i++) {
+        mBodies[ioBatch.mStreamedBodies[i]].mBodyID = ioBatch.mBodyIDs[i];
+        mAddedBodies.push_back({ ioBatch.mStreamedBodies[i], ioBatch.mBodyIDs[i] });
+    }
+
+    mStats.mBodiesLoaded += ioBatch.mCount;
+    mStats.mResidentBodyCount += ioBatch.mCount;
+
+    if (cell.mPendingBatchCount == 0 && !cell.mIsQueued) {
+        mStats.mCellsLoaded++;
+    }
+}
+
+void PhysicsStreamer::DispatchBatches() {
+    size_t queue_index = 0;
+
+    while (queue_index < mLoadQueue.size()) {
+        JPH::uint32 cell_index = mLoadQueue[queue_index];
+        Cell &cell = mCells[cell_index];
+
+        // The cell went out of range again before any of it was loaded
+        if (!cell.mIsResident) {
+            cell.mIsQueued = false;
+            queue_index++;
+            continue;
+        }
+
+        if (mFreeBatches.empty()) {
+            mStats.mBatchStalls++;
+            break;
+        }
+
+        Batch *batch = mFreeBatches.back();
+        mFreeBatches.pop_back();
+
+        JPH::uint32 begin = cell.mDispatchedCount;
+        JPH::uint count = eastl::min<JPH::uint>(mSettings.mBatchSize, static_cast<JPH::uint>(cell.mBodies.size()) - begin);
+
+        // Static bodies fill the batch from the front and the rest from the back
+        JPH::uint static_index = 0;
+        JPH::uint dynamic_index = count;
+        for (JPH::uint i = 0; i < count; i++) {
+            StreamedBodyID id = cell.mBodies[begin + i];
+            const JPH::BodyCreationSettings &settings = mBodies[id].mSettings;
+
+            JPH::uint index = settings.mMotionType == JPH::EMotionType::Static ? static_index++ : --dynamic_index;
+            batch->mSettings[index] = settings;
+            batch->mStreamedBodies[index] = id;
+        }
+
+        batch->mCell = cell_index;
+        batch->mCount = count;
+        batch->mStaticCount = static_index;
+        batch->mIsFailed = false;
+        batch->mStaticState = nullptr;
+        batch->mDynamicState = nullptr;
+
+        cell.mDispatchedCount += count;
+        cell.mPendingBatchCount++;
+        if (cell.mDispatchedCount == cell.mBodies.size()) {
+            cell.mIsQueued = false;
+            queue_index++;
+        }
+
+        mDispatchBatches.push_back(batch);
+    }
+
+    mLoadQueue.erase(mLoadQueue.begin(), mLoadQueue.begin() + queue_index);
+
+    if (!mDispatchBatches.empty()) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueuedBatches.insert(mQueuedBatches.end(), mDispatchBatches.begin(), mDispatchBatches.end());
+        mCondition.notify_one();
+    }
+
+    mDispatchBatches.clear();
+}
+
+void PhysicsStreamer::Update(const JPH::Vec3 *inInterestPoints, size_t inCount) {
+    Uint64 start_time = SDL_GetTicksNS();
+
+    mAddedBodies.clear();
+    mRemovedBodies.clear();
+    Stream(inInterestPoints, inCount);
+
+    mStats.mLastUpdateTime = SDL_GetTicksNS() - start_time;
+    mStats.mMaxUpdateTime = eastl::max(mStats.mMaxUpdateTime, mStats.mLastUpdateTime);
+}
+
+void PhysicsStreamer::Prefetch(const JPH::Vec3 *inInterestPoints, size_t inCount) {
+    mAddedBodies.clear();
+    mRemovedBodies.clear();
+
+    // Every finished batch is added right away, events of all rounds are kept
+    JPH::uint max_batches = mSettings.mMaxBatchesPerUpdate;
+    mSettings.mMaxBatchesPerUpdate = mSettings.mBatchCount;
+
+    Stream(inInterestPoints, inCount);
+    while (!mLoadQueue.empty() || mFreeBatches.size() < mBatches.size()) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mFinishedCondition.wait(lock, [this] { return !mFinishedBatches.empty(); });
+        }
+
+        Stream(inInterestPoints, inCount);
+    }
+
+    mSettings.mMaxBatchesPerUpdate = max_batches;
+}
+
+void PhysicsStreamer::Stream(const JPH::Vec3 *inInterestPoints, size_t inCount) {
+    mInterestPoints.assign(inInterestPoints, inInterestPoints + inCount);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReadyBatches.insert(mReadyBatches.end(), mFinishedBatches.begin(), mFinishedBatches.end());
+        mFinishedBatches.clear();
+        mStats.mBackgroundTime = mBackgroundTime;
+
+        // The step since they were removed has reported their lost contacts, nothing reads them anymore
+        if (!mRemovedBodyIDs.empty()) {
+            mDestroyQueue.insert(mDestroyQueue.end(), mRemovedBodyIDs.begin(), mRemovedBodyIDs.end());
+            mRemovedBodyIDs.clear();
+            mCondition.notify_one();
+        }
+    }
+
+    // Only a few batches are added per update, the rest wait so a large cell doesn't cause a spike
+    size_t finish_count = eastl::min<size_t>(mReadyBatches.size(), mSettings.mMaxBatchesPerUpdate);
+    for (size_t i = 0; i < finish_count; i++) {
+        FinishBatch(*mReadyBatches[i]);
+        mFreeBatches.push_back(mReadyBatches[i]);
+    }
+    mReadyBatches.erase(mReadyBatches.begin(), mReadyBatches.begin() + finish_count);
+
+    // Cells that are still being streamed in are left alone until they're done
+    mUnloadBodies.clear();
+    for (size_t i = 0; i < mResidentCells.size();) {
+        JPH::uint32 cell_index = mResidentCells[i];
+        Cell &cell = mCells[cell_index];
+
+        bool is_busy = cell.mPendingBatchCount > 0 || (cell.mIsQueued && cell.mDispatchedCount > 0);
+        if (is_busy || GetCellDistance(cell) <= mSettings.mUnloadRadius) {
+            i++;
+            continue;
+        }
+
+        UnloadCell(cell_index);
+        mResidentCells[i] = mResidentCells.back();
+        mResidentCells.pop_back();
+    }
+
+    if (!mUnloadBodies.empty()) {
+        mPhysicsManager->GetBodyInterface().RemoveBodies(mUnloadBodies.data(), static_cast<int>(mUnloadBodies.size()));
+
+        mStats.mBodiesUnloaded += mUnloadBodies.size();
+        mStats.mResidentBodyCount -= mUnloadBodies.size();
+
+        mRemovedBodyIDs.insert(mRemovedBodyIDs.end(), mUnloadBodies.begin(), mUnloadBodies.end());
+    }
+
+    // Only cells that have bodies exist, so the ones around each point can be looked up directly
+    size_t queued_count = mLoadQueue.size();
+    for (const JPH::Vec3 &point : mInterestPoints) {
+        int min_x = static_cast<int>(std::floor((point.GetX() - mSettings.mLoadRadius) / mSettings.mCellSize));
+        int max_x = static_cast<int>(std::floor((point.GetX() + mSettings.mLoadRadius) / mSettings.mCellSize));
+        int min_z = static_cast<int>(std::floor((point.GetZ() - mSettings.mLoadRadius) / mSettings.mCellSize));
+        int max_z = static_cast<int>(std::floor((point.GetZ() + mSettings.mLoadRadius) / mSettings.mCellSize));
+
+        for (int z = min_z; z <= max_z; z++) {
+            for (int x = min_x; x <= max_x; x++) {
+                auto it = mCellLookup.find(PackCell(x, z));
+                if (it == mCellLookup.end() || mCells[it->second].mIsResident) {
+                    continue;
+                }
+
+                if (GetCellDistance(mCells[it->second]) <= mSettings.mLoadRadius) {
+                    RequestCell(it->second);
+                }
+            }
+        }
+    }
+
+    if (mLoadQueue.size() != queued_count) {
+        eastl::sort(mLoadQueue.begin(), mLoadQueue.end(), [this](JPH::uint32 inA, JPH::uint32 inB) {
+            return GetCellDistance(mCells[inA]) < GetCellDistance(mCells[inB]);
+        });
+    }
+
+    DispatchBatches();
+
+    mStats.mCellCount = static_cast<JPH::uint>(mCells.size());
+    mStats.mResidentCellCount = static_cast<JPH::uint>(mResidentCells.size());
+    mStats.mQueuedCellCount = static_cast<JPH::uint>(mLoadQueue.size());
+}
+
+void PhysicsStreamer::LogStats() const {
+    double background_ms = static_cast<double>(mStats.mBackgroundTime) / 1e6;
+    LOG_INFO("Streaming: %u of %u cells, %llu bodies resident, %u cells queued, %llu loaded and %llu unloaded (%.0f bodies/ms), %llu stalls, %llu failed, update %.3f ms (max %.3f)\n",
+        mStats.mResidentCellCount,
+        mStats.mCellCount,
+        static_cast<unsigned long long>(mStats.mResidentBodyCount),
+        mStats.mQueuedCellCount,
+        static_cast<unsigned long long>(mStats.mBodiesLoaded),
+        static_cast<unsigned long long>(mStats.mBodiesUnloaded),
+        background_ms > 0.0 ? static_cast<double>(mStats.mBodiesLoaded + mStats.mBodiesUnloaded) / background_ms : 0.0,
+        static_cast<unsigned long long>(mStats.mBatchStalls),
+        static_cast<unsigned long long>(mStats.mFailedBatches),
+        static_cast<double>(mStats.mLastUpdateTime) / 1e6,
+        static_cast<double>(mStats.mMaxUpdateTime) / 1e6);
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class PhysicsManager;
+
+// Index of a body registered with PhysicsStreamer::AddBody, stays the same while the body comes and goes
+using StreamedBodyID = JPH::uint32;
+
+struct PhysicsStreamingSettings {
+    // Width of a grid cell on the XZ plane, cells cover all heights
+    float mCellSize = 64.0f;
+    // Cells that come within this distance of an interest point are loaded
+    float mLoadRadius = 192.0f;
+    // Loaded cells are kept until every interest point is this far away, so moving along an edge doesn't thrash
+    float mUnloadRadius = 256.0f;
+    // Bodies are created in preallocated batches of this size, a cell larger than a batch takes several
+    JPH::uint mBatchSize = 1024;
+    JPH::uint mBatchCount = 16;
+    // Batches added to the broadphase per call to Update, which bounds the cost on the main thread
+    JPH::uint mMaxBatchesPerUpdate = 4;
+};
+
+// Resident counts are current, the rest are running totals. Times are in nanoseconds.
+struct PhysicsStreamingStats {
+    JPH::uint mCellCount;
+    JPH::uint mResidentCellCount;
+    JPH::uint mQueuedCellCount;
+    JPH::uint64 mResidentBodyCount;
+    JPH::uint64 mBodiesLoaded;
+    JPH::uint64 mBodiesUnloaded;
+    JPH::uint64 mCellsLoaded;
+    JPH::uint64 mCellsUnloaded;
+    // Updates that had cells waiting while every batch was in use
+    JPH::uint64 mBatchStalls;
+    JPH::uint64 mFailedBatches;
+    // Time the streaming thread spent creating and destroying bodies
+    JPH::uint64 mBackgroundTime;
+    JPH::uint64 mLastUpdateTime;
+    JPH::uint64 mMaxUpdateTime;
+};
+
+// A body that entered or left the simulation during the last call to Update
+struct StreamedBodyEvent {
+    StreamedBodyID mStreamedBody;
+    JPH::BodyID mBodyID;
+};
+
+// Partitions bodies into grid cells that are loaded around a set of interest points, such as the camera.
+// Bodies of a cell are created and prepared for the broadphase on a streaming thread in preallocated batches,
+// the main thread only adds finished batches and removes unloaded cells in bulk, a few batches per update.
+// Bodies are destroyed on the streaming thread as well, one update after they were removed, so the step in between
+// can still read them when it reports their lost contacts. Dynamic bodies keep their state while unloaded, but stay
+// in the cell they were registered in.
+class PhysicsStreamer {
+private:
+    struct StreamedBody {
+        JPH::BodyCreationSettings mSettings;
+        // Invalid while the cell isn't loaded
+        JPH::BodyID mBodyID;
+        JPH::uint32 mCell;
+    };
+
+    struct Cell {
+        int mX;
+        int mZ;
+        eastl::vector<StreamedBodyID> mBodies;
+        // Bodies handed to batches since the cell was requested, the rest still have to be loaded
+        JPH::uint32 mDispatchedCount = 0;
+        JPH::uint32 mPendingBatchCount = 0;
+        bool mIsResident = false;
+        bool mIsQueued = false;
+    };
+
+    // The bodies of one cell on their way into the simulation. Static bodies come first, so both halves
+    // can be added with their own activation mode.
+    struct Batch {
+        JPH::uint32 mCell;
+        JPH::uint mCount;
+        JPH::uint mStaticCount;
+        bool mIsFailed;
+        eastl::vector<JPH::BodyCreationSettings> mSettings;
+        eastl::vector<StreamedBodyID> mStreamedBodies;
+        eastl::vector<JPH::BodyID> mBodyIDs;
+        // Copy of the IDs for Jolt, which reorders them while adding
+        eastl::vector<JPH::BodyID> mAddBodyIDs;
+        JPH::BodyInterface::AddState mStaticState;
+        JPH::BodyInterface::AddState mDynamicState;
+    };
+
+    PhysicsManager *mPhysicsManager = nullptr;
+    PhysicsStreamingSettings mSettings;
+
+    eastl::vector<StreamedBody> mBodies;
+    eastl::vector<Cell> mCells;
+    // Cells by their packed grid coordinates, indexing mCells
+    eastl::hash_map<JPH::uint64, JPH::uint32> mCellLookup;
+
+    eastl::vector<JPH::Vec3> mInterestPoints;
+    // Cells waiting for a batch, nearest first
+    eastl::vector<JPH::uint32> mLoadQueue;
+    eastl::vector<JPH::uint32> mResidentCells;
+
+    eastl::vector<Batch> mBatches;
+    eastl::vector<Batch *> mFreeBatches;
+
+    // Shared with the streaming thread
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mFinishedCondition;
+    eastl::vector<Batch *> mQueuedBatches;
+    eastl::vector<Batch *> mFinishedBatches;
+    eastl::vector<JPH::BodyID> mDestroyQueue;
+    JPH::uint64 mBackgroundTime = 0;
+    bool mQuit = false;
+
+    // Only touched by the streaming thread
+    eastl::vector<Batch *> mLoadingBatches;
+    eastl::vector<JPH::BodyID> mDestroyingBodies;
+
+    // Scratch buffers, kept around to avoid allocating every update
+    eastl::vector<Batch *> mReadyBatches;
+    eastl::vector<Batch *> mDispatchBatches;
+    eastl::vector<JPH::BodyID> mUnloadBodies;
+    // Removed by the last update, handed to the streaming thread by the next one
+    eastl::vector<JPH::BodyID> mRemovedBodyIDs;
+
+    eastl::vector<StreamedBodyEvent> mAddedBodies;
+    eastl::vector<StreamedBodyEvent> mRemovedBodies;
+
+    PhysicsStreamingStats mStats = {};
+
+    void RunStreaming();
+    void LoadBatch(Batch &ioBatch);
+
+    JPH::uint32 GetCell(int inX, int inZ);
+    float GetCellDistance(const Cell &inCell) const;
+    void RequestCell(JPH::uint32 inCell);
+    void UnloadCell(JPH::uint32 inCell);
+    void FinishBatch(Batch &ioBatch);
+    void DispatchBatches();
+    void Stream(const JPH::Vec3 *inInterestPoints, size_t inCount);
+
+public:
+    bool Initialize(PhysicsManager *inPhysicsManager, const PhysicsStreamingSettings &inSettings = {});
+    // Removes and destroys every loaded body, must be called before the physics manager shuts down
+    void Shutdown();
+
+    // Register a body, it's only created once its cell is loaded
+    StreamedBodyID AddBody(const JPH::BodyCreationSettings &inSettings);
+
+    // Add finished batches, unload cells out of range and queue the cells that came into range.
+    // This changes the bodies in the world, so it must not overlap with PhysicsManager::Update or queries.
+    void Update(const JPH::Vec3 *inInterestPoints, size_t inCount);
+    // Like Update, but blocks until every cell in range is loaded. Meant for loading screens, where a spike is fine
+    // and the world has to be there before the first step.
+    void Prefetch(const JPH::Vec3 *inInterestPoints, size_t inCount);
+
+    inline const PhysicsStreamingSettings &GetSettings() const {
+        return mSettings;
+    }
+
+    // The body of a streamed body, invalid while its cell isn't loaded
+    inline JPH::BodyID GetBodyID(StreamedBodyID inBody) const {
+        return mBodies[inBody].mBodyID;
+    }
+
+    // Settings the body is created with, dynamic bodies have their state saved here when unloaded
+    inline const JPH::BodyCreationSettings &GetBodySettings(StreamedBodyID inBody) const {
+        return mBodies[inBody].mSettings;
+    }
+
+    inline size_t GetBodyCount() const {
+        return mBodies.size();
+    }
+
+    inline const eastl::vector<StreamedBodyEvent> &GetAddedBodies() const {
+        return mAddedBodies;
+    }
+
+    // The body IDs are no longer valid, but may not have been reused yet
+    inline const eastl::vector<StreamedBodyEvent> &GetRemovedBodies() const {
+        return mRemovedBodies;
+    }
+
+    inline const PhysicsStreamingStats &GetStats() const {
+        return mStats;
+    }
+
+    // Log how much of the world is streamed in and how fast it's moving
+    void LogStats() const;
+};